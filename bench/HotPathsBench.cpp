@@ -0,0 +1,459 @@
+// Times the CPU side of the renderer's hot paths: building the grid, sphere and cylinder meshes, drawing object
+// hierarchies of growing depth and width, the camera, and the shader setters. GL is stubbed out, so what is measured
+// is the application's own work, without a context or a driver.
+// Results are printed as a table, or with --json in Google Benchmark's JSON format, so runs of different commits can
+// be compared with its tools/compare.py.
+// Before timing, it checks a static batch of more vertices than the old restart index still draws all its triangles,
+// and exits with 1 if not.
+// Usage: HotPathsBench [--json] [--filter TEXT] [--min-time SECONDS]
+// Run from the repository root, where the shaders are read from.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Shapes.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include "IndependentMesh.h"
+#include "ComplexObject.h"
+#include "StaticBatch.h"
+#include "Camera.h"
+#include "Shader.h"
+
+// Each measurement is the best of this many runs.
+static const int REPETITIONS = 5;
+// Shortest run, in seconds, unless --min-time says otherwise: fast benchmarks repeat their body until a run lasts this long.
+static const double DEFAULT_MIN_TIME = 0.05;
+// Segments of the spheres and cylinders, as Main builds them.
+static const int SPHERE_SEGMENTS = 40;
+
+// Written by every benchmark, so the compiler can't drop the work measured.
+static volatile float sink;
+
+// Stand-ins for the GL entry points the measured code reaches through GLEW. Objects get increasing names, shaders
+// compile and link, and every other call does nothing. Entry points of GL 1.1, such as glDrawElements, are exported
+// by the GL library itself rather than loaded by GLEW: with no context current, they do nothing either.
+namespace NullGL
+{
+	static GLuint nextName = 1;
+	static std::unordered_map<std::string, GLint> uniformLocations;
+
+	static void GLAPIENTRY GenNames(GLsizei n, GLuint* names)
+	{
+		for (GLsizei i = 0; i < n; i++)
+		{
+			names[i] = nextName++;
+		}
+	}
+	static void GLAPIENTRY DeleteNames(GLsizei, const GLuint*) {}
+	static GLuint GLAPIENTRY CreateObject() { return nextName++; }
+	static GLuint GLAPIENTRY CreateShader(GLenum) { return nextName++; }
+	static void GLAPIENTRY DeleteObject(GLuint) {}
+	static void GLAPIENTRY ShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+	static void GLAPIENTRY AttachShader(GLuint, GLuint) {}
+	static void GLAPIENTRY GetObjectiv(GLuint, GLenum, GLint* value) { *value = GL_TRUE; }
+	static void GLAPIENTRY GetInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log)
+	{
+		if (length != NULL)
+		{
+			*length = 0;
+		}
+		if (size > 0)
+		{
+			log[0] = '\0';
+		}
+	}
+	static GLint GLAPIENTRY GetUniformLocation(GLuint, const GLchar* name)
+	{
+		std::unordered_map<std::string, GLint>::iterator found = uniformLocations.find(name);
+		if (found == uniformLocations.end())
+		{
+			found = uniformLocations.insert(std::make_pair(std::string(name), (GLint)uniformLocations.size())).first;
+		}
+		return found->second;
+	}
+	static void GLAPIENTRY BindName(GLuint) {}
+	static void GLAPIENTRY BindBuffer(GLenum, GLuint) {}
+	static void GLAPIENTRY BufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+	static void GLAPIENTRY BufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+	static void GLAPIENTRY VertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+	static void GLAPIENTRY VertexAttrib4fv(GLuint, const GLfloat*) {}
+	static void GLAPIENTRY Uniform1f(GLint, GLfloat) {}
+	static void GLAPIENTRY Uniform1i(GLint, GLint) {}
+	static void GLAPIENTRY Uniform4fv(GLint, GLsizei, const GLfloat*) {}
+	static void GLAPIENTRY UniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) {}
+
+	// Points GLEW's entry points at the stand-ins, in place of glewInit.
+	static void Install()
+	{
+		__glewGenBuffers = GenNames;
+		__glewGenVertexArrays = GenNames;
+		__glewDeleteBuffers = DeleteNames;
+		__glewDeleteVertexArrays = DeleteNames;
+		__glewCreateProgram = CreateObject;
+		__glewCreateShader = CreateShader;
+		__glewDeleteProgram = DeleteObject;
+		__glewDeleteShader = DeleteObject;
+		__glewShaderSource = ShaderSource;
+		__glewCompileShader = DeleteObject;
+		__glewAttachShader = AttachShader;
+		__glewLinkProgram = DeleteObject;
+		__glewGetShaderiv = GetObjectiv;
+		__glewGetProgramiv = GetObjectiv;
+		__glewGetShaderInfoLog = GetInfoLog;
+		__glewGetProgramInfoLog = GetInfoLog;
+		__glewGetUniformLocation = GetUniformLocation;
+		__glewUseProgram = BindName;
+		__glewBindVertexArray = BindName;
+		__glewEnableVertexAttribArray = BindName;
+		__glewBindBuffer = BindBuffer;
+		__glewBufferData = BufferData;
+		__glewBufferSubData = BufferSubData;
+		__glewVertexAttribPointer = VertexAttribPointer;
+		__glewVertexAttrib4fv = VertexAttrib4fv;
+		__glewUniform1f = Uniform1f;
+		__glewUniform1i = Uniform1i;
+		__glewUniform4fv = Uniform4fv;
+		__glewUniformMatrix4fv = UniformMatrix4fv;
+	}
+}
+
+struct Result
+{
+	std::string name;
+	unsigned long long iterations;
+	double realTime; // Nanoseconds per iteration
+	double cpuTime; // Nanoseconds per iteration
+	double items; // Items processed per iteration, or 0
+};
+
+static std::vector<Result> results;
+static const char* filter = NULL;
+static double minTime = DEFAULT_MIN_TIME;
+
+// Times a benchmark: its body is repeated until a run lasts minTime, and the best of REPETITIONS runs is kept.
+// items is what one iteration processes (vertices, nodes...), reported per second.
+static void Run(const std::string& name, double items, const std::function<void()>& body)
+{
+	if (filter != NULL && name.find(filter) == std::string::npos)
+	{
+		return;
+	}
+
+	unsigned long long iterations = 1;
+	Result result;
+	result.name = name;
+	result.items = items;
+	result.realTime = 1e300;
+	result.cpuTime = 1e300;
+	for (int repetition = 0; repetition < REPETITIONS; )
+	{
+		std::clock_t cpuStart = std::clock();
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			body();
+		}
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double cpuElapsed = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+		// Too short to time well: run again with enough iterations to last minTime, and throw this run away.
+		if (elapsed < minTime && iterations < (1ull << 40))
+		{
+			double scale = elapsed > 0.0 ? minTime * 1.2 / elapsed : 10.0;
+			iterations = (unsigned long long)(iterations * std::min(std::max(scale, 2.0), 10.0));
+			continue;
+		}
+
+		if (elapsed * 1e9 / iterations < result.realTime)
+		{
+			result.realTime = elapsed * 1e9 / iterations;
+			result.cpuTime = cpuElapsed * 1e9 / iterations;
+			result.iterations = iterations;
+		}
+		repetition++;
+	}
+	results.push_back(result);
+
+	if (items > 0.0)
+	{
+		fprintf(stderr, "%-40s %14.1f ns %14.1f ns %12llu %12.3f M items/s\n", name.c_str(), result.realTime, result.cpuTime, result.iterations,
+			items / result.realTime * 1e3);
+	}
+	else
+	{
+		fprintf(stderr, "%-40s %14.1f ns %14.1f ns %12llu\n", name.c_str(), result.realTime, result.cpuTime, result.iterations);
+	}
+}
+
+static void PrintJson(const char* executable)
+{
+	char date[64];
+	time_t now = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	printf("{\n  \"context\": {\n");
+	printf("    \"date\": \"%s\",\n", date);
+	// Windows paths' backslashes must be escaped in JSON
+	std::string path;
+	for (const char* c = executable; *c != '\0'; c++)
+	{
+		if (*c == '\\' || *c == '"')
+		{
+			path += '\\';
+		}
+		path += *c;
+	}
+	printf("    \"executable\": \"%s\",\n", path.c_str());
+	printf("    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef RENDER_STATS
+	printf("    \"render_stats\": true,\n");
+#else
+	printf("    \"render_stats\": false,\n");
+#endif
+	printf("    \"library_build_type\": \"release\"\n  },\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& result = results[i];
+		printf("    {\n      \"name\": \"%s\",\n      \"run_name\": \"%s\",\n      \"run_type\": \"iteration\",\n", result.name.c_str(), result.name.c_str());
+		printf("      \"repetitions\": %d,\n      \"threads\": 1,\n      \"iterations\": %llu,\n", REPETITIONS, result.iterations);
+		printf("      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n      \"time_unit\": \"ns\"", result.realTime, result.cpuTime);
+		if (result.items > 0.0)
+		{
+			printf(",\n      \"items_per_second\": %.1f", result.items / result.realTime * 1e9);
+		}
+		printf("\n    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	printf("  ]\n}\n");
+}
+
+// Builds a mesh's arrays, prepares and creates it, then destroys it, as Main's createGrid, CreateSphere and CreateCylinder do.
+template <class MeshType>
+static void CreateAndDestroy(const std::vector<GLfloat>& builtVertices, const std::vector<GLuint>& builtIndices, GLenum drawType)
+{
+	std::vector<GLfloat> vertices = builtVertices;
+	std::vector<GLuint> indices = builtIndices;
+	MeshOptimizer::Optimize(vertices, NULL, indices, drawType);
+	Handle<MeshType> mesh = MeshType::Create();
+	mesh->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+	MeshType::Destroy(mesh);
+	sink = vertices[0];
+}
+
+static void BenchmarkShapes()
+{
+	const int gridSizes[] = { 16, 64, 128, 512 };
+	for (size_t i = 0; i < sizeof(gridSizes) / sizeof(gridSizes[0]); i++)
+	{
+		int size = gridSizes[i];
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+		double vertexCount = (double)(size + 1) * (size + 1);
+		Run("Shapes::Grid/" + std::to_string(size), vertexCount, [&]() { Shapes::Grid(size, vertices, indices); sink = vertices.back(); });
+
+		// The whole of Main's createGrid: build, optimize for the GPU, create the mesh
+		Run("createGrid/" + std::to_string(size), vertexCount, [&]() {
+			std::vector<GLfloat> built;
+			std::vector<GLuint> builtIndices;
+			Shapes::Grid(size, built, builtIndices);
+			CreateAndDestroy<Mesh>(built, builtIndices, GL_LINES);
+		});
+	}
+
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	Run("Shapes::Sphere/" + std::to_string(SPHERE_SEGMENTS), 0.0, [&]() { Shapes::Sphere(SPHERE_SEGMENTS, SPHERE_SEGMENTS, vertices, indices); sink = vertices.back(); });
+	Run("CreateSphere/" + std::to_string(SPHERE_SEGMENTS), 0.0, [&]() {
+		std::vector<GLfloat> built;
+		std::vector<GLuint> builtIndices;
+		Shapes::Sphere(SPHERE_SEGMENTS, SPHERE_SEGMENTS, built, builtIndices);
+		CreateAndDestroy<IndependentMesh>(built, builtIndices, GL_TRIANGLE_STRIP);
+	});
+	Run("Shapes::Cylinder/" + std::to_string(SPHERE_SEGMENTS), 0.0, [&]() { Shapes::Cylinder(0.25, SPHERE_SEGMENTS, vertices, indices); sink = vertices.back(); });
+	Run("CreateCylinder/" + std::to_string(SPHERE_SEGMENTS), 0.0, [&]() {
+		std::vector<GLfloat> built;
+		std::vector<GLuint> builtIndices;
+		Shapes::Cylinder(0.25, SPHERE_SEGMENTS, built, builtIndices);
+		CreateAndDestroy<IndependentMesh>(built, builtIndices, GL_TRIANGLE_STRIP);
+	});
+}
+
+// Builds a tree of objects, each with width child objects down to the given depth, and a cube mesh in every object,
+// each placed by its own matrix as the letters' parts are. Returns the number of objects through count.
+static ObjectHandle CreateHierarchy(int depth, int width, GLuint uniformModel, const std::vector<GLfloat>& vertices,
+	const std::vector<GLuint>& indices, unsigned int& count)
+{
+	ObjectHandle object = ComplexObject::Create();
+	count++;
+
+	std::vector<GLfloat> meshVertices = vertices;
+	std::vector<GLuint> meshIndices = indices;
+	MeshHandle mesh = IndependentMesh::Create();
+	mesh->CreateMesh(&meshVertices[0], &meshIndices[0], meshVertices.size(), meshIndices.size());
+	glm::mat4 partModel = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+	mesh->SetModelMatrix(partModel, uniformModel);
+	object->meshList.push_back(mesh);
+
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.5f, 0.0f));
+	object->SetModelMatrix(model, uniformModel);
+
+	if (depth > 0)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			object->objectList.push_back(CreateHierarchy(depth - 1, width, uniformModel, vertices, indices, count));
+		}
+	}
+	return object;
+}
+
+static void BenchmarkRenderObject()
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	Shapes::Cube(vertices, indices);
+	const GLuint uniformModel = 0;
+
+	// Depth with two children per object, then width under a single parent
+	struct Shape { int depth; int width; };
+	const Shape shapes[] = { { 1, 2 }, { 3, 2 }, { 5, 2 }, { 7, 2 }, { 9, 2 }, { 1, 4 }, { 1, 16 }, { 1, 64 }, { 1, 256 }, { 1, 1024 } };
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+	{
+		unsigned int count = 0;
+		ObjectHandle root = CreateHierarchy(shapes[i].depth, shapes[i].width, uniformModel, vertices, indices, count);
+		glm::mat4 identity(1.0f);
+		Run("RenderObject/depth:" + std::to_string(shapes[i].depth) + "/width:" + std::to_string(shapes[i].width), count,
+			[&]() { root->RenderObject(identity, uniformModel); });
+		ComplexObject::Destroy(root);
+	}
+}
+
+static void BenchmarkCamera()
+{
+	Camera camera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f, 0.05f, 0.5f);
+	float yaw = 0.0f;
+
+	// setPose is the public way in to update, which recomputes the camera's axes
+	Run("Camera::update", 0.0, [&]() {
+		yaw = yaw < 360.0f ? yaw + 0.5f : 0.0f;
+		camera.setPose(glm::vec3(1.0f, 2.0f, 3.0f), yaw, 10.0f);
+		sink = camera.getYaw();
+	});
+	Run("Camera::calculateViewMatrix", 0.0, [&]() {
+		glm::mat4 view = camera.calculateViewMatrix();
+		sink = view[3][2];
+	});
+}
+
+static void BenchmarkShader()
+{
+	Shader shader("src/shader.vs", "src/wire.gs", "src/wire.fs");
+	shader.use();
+	glm::mat4 matrix(1.0f);
+	glm::vec4 viewport(0.0f, 0.0f, 1024.0f, 768.0f);
+	float value = 0.0f;
+
+	// The same values every time, as most of a frame's are: GLState skips the uploads
+	Run("Shader::setMatrix4Float/unchanged", 0.0, [&]() { shader.setMatrix4Float("model", &matrix); });
+	Run("Shader::setVec4/unchanged", 0.0, [&]() { shader.setVec4("viewport", viewport); });
+	Run("Shader::setFloat/unchanged", 0.0, [&]() { shader.setFloat("lineWidth", 1.5f); });
+	Run("Shader::setInt/unchanged", 0.0, [&]() { shader.setInt("renderMode", 1); });
+
+	// New values every time, as a model matrix per part is: compared, cached and uploaded
+	Run("Shader::setMatrix4Float/changed", 0.0, [&]() { matrix[3][0] += 1.0f; shader.setMatrix4Float("model", &matrix); });
+	Run("Shader::setFloat/changed", 0.0, [&]() { value += 1.0f; shader.setFloat("lineWidth", value); });
+	shader.free();
+}
+
+// Bakes as many spheres as there are in the letters into one batch, more vertices than the old restart index
+// (GL_PRIMITIVE_RESTART_FIXED_INDEX's value, 36201) allowed, and checks every triangle is still drawn: restart is on for
+// every draw, so an index equal to the restart index would cut the triangles it is in.
+static bool CheckStaticBatch()
+{
+	const int SPHERE_COUNT = 17;
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	Shapes::Sphere(SPHERE_SEGMENTS, SPHERE_SEGMENTS, vertices, indices);
+	MeshOptimizer::Optimize(vertices, NULL, indices, GL_TRIANGLE_STRIP);
+	MeshHandle sphere = IndependentMesh::Create();
+	sphere->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+
+	std::vector<unsigned int> triangles;
+	MeshOptimizer::ToTriangles(sphere->GetIndices(), 0, triangles);
+	StaticBatch batch;
+	for (int i = 0; i < SPHERE_COUNT; i++)
+	{
+		batch.Add(*sphere, glm::translate(glm::mat4(1.0f), glm::vec3(2.0f * i, 0.0f, 0.0f)));
+	}
+	Handle<Mesh> baked = batch.Build();
+
+	const std::vector<unsigned int>& bakedIndices = baked->GetIndices();
+	size_t vertexCount = baked->GetVertices().size() / 3;
+	size_t drawn = 0;
+	for (size_t i = 0; i + 2 < bakedIndices.size(); i += 3)
+	{
+		if (bakedIndices[i] < vertexCount && bakedIndices[i + 1] < vertexCount && bakedIndices[i + 2] < vertexCount
+			&& bakedIndices[i] != MeshOptimizer::RESTART_INDEX && bakedIndices[i + 1] != MeshOptimizer::RESTART_INDEX
+			&& bakedIndices[i + 2] != MeshOptimizer::RESTART_INDEX)
+		{
+			drawn++;
+		}
+	}
+	size_t expected = triangles.size() / 3 * SPHERE_COUNT;
+	bool passed = vertexCount > 36201 && drawn == expected;
+	fprintf(stderr, "StaticBatch of %d spheres: %zu vertices, %zu of %zu triangles drawn%s\n", SPHERE_COUNT, vertexCount, drawn,
+		expected, passed ? "" : " - FAILED");
+
+	Mesh::Destroy(baked);
+	IndependentMesh::Destroy(sphere);
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	bool json = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+		{
+			json = true;
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			minTime = std::max(atof(argv[++i]), 0.001);
+		}
+	}
+
+	NullGL::Install();
+
+	if (!CheckStaticBatch())
+	{
+		return 1;
+	}
+
+	// The table goes to stderr, so --json output can be redirected on its own
+	fprintf(stderr, "%-40s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+	BenchmarkShapes();
+	BenchmarkRenderObject();
+	BenchmarkCamera();
+	BenchmarkShader();
+
+	if (json)
+	{
+		PrintJson(argv[0]);
+	}
+	return 0;
+}
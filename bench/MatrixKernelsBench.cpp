@@ -0,0 +1,173 @@
+// Compares the batched MatrixKernels against the per-node glm code they replace, at every level the CPU supports.
+// Usage: MatrixKernelsBench [node count]
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "MatrixKernels.h"
+
+// Each measurement is the best of this many runs.
+static const int REPETITIONS = 20;
+
+static float Random(float low, float high)
+{
+	return low + (high - low) * (float)rand() / (float)RAND_MAX;
+}
+
+template <class Function>
+static double BestMilliseconds(Function function)
+{
+	double best = 1e30;
+	for (int i = 0; i < REPETITIONS; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+static float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				difference = std::max(difference, std::fabs(a[i][column][row] - b[i][column][row]));
+			}
+		}
+	}
+	return difference;
+}
+
+static float MaxDifference(const std::vector<AABB>& a, const std::vector<AABB>& b)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			difference = std::max(difference, std::fabs(a[i].min[axis] - b[i].min[axis]));
+			difference = std::max(difference, std::fabs(a[i].max[axis] - b[i].max[axis]));
+		}
+	}
+	return difference;
+}
+
+static void PrintRow(const char* name, size_t count, double milliseconds, double reference, float difference)
+{
+	printf("  %-8s %9.3f ms  %7.2f ns/node  x%5.2f  max diff %g\n", name, milliseconds, milliseconds * 1e6 / count, reference / milliseconds, difference);
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+	srand(1);
+
+	std::vector<glm::vec3> translations(count), scales(count);
+	std::vector<glm::quat> rotations(count);
+	std::vector<glm::mat4> children(count), reference(count), result(count);
+	std::vector<AABB> boxes(count), referenceBoxes(count), resultBoxes(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		translations[i] = glm::vec3(Random(-50.0f, 50.0f), Random(-50.0f, 50.0f), Random(-50.0f, 50.0f));
+		rotations[i] = glm::angleAxis(Random(-3.14f, 3.14f), glm::normalize(glm::vec3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), 1.0f)));
+		scales[i] = glm::vec3(Random(0.5f, 2.0f), Random(0.5f, 2.0f), Random(0.5f, 2.0f));
+		children[i] = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+
+		glm::vec3 center(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+		glm::vec3 extents(Random(0.1f, 1.0f), Random(0.1f, 1.0f), Random(0.1f, 1.0f));
+		boxes[i] = AABB(center - extents, center + extents);
+	}
+
+	glm::mat4 parent = glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(0.25f)), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+
+	std::vector<MatrixKernels::Level> levels;
+	for (int level = 0; level <= (int)MatrixKernels::GetSupportedLevel(); level++)
+	{
+		levels.push_back((MatrixKernels::Level)level);
+	}
+
+	printf("%zu nodes, best of %d runs, supported level %s\n\n", count, REPETITIONS, MatrixKernels::GetLevelName(MatrixKernels::GetSupportedLevel()));
+
+	// parent * child for every node, as when propagating a transformation down the hierarchy.
+	double glmTime = BestMilliseconds([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			reference[i] = parent * children[i];
+		}
+	});
+	printf("MultiplyByParent\n");
+	PrintRow("glm", count, glmTime, glmTime, 0.0f);
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		MatrixKernels::SetLevel(levels[l]);
+		double time = BestMilliseconds([&]() { MatrixKernels::MultiplyByParent(parent, children.data(), result.data(), count); });
+		PrintRow(MatrixKernels::GetLevelName(levels[l]), count, time, glmTime, MaxDifference(reference, result));
+	}
+
+	// a[i] * b[i], independent pairs.
+	glmTime = BestMilliseconds([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			reference[i] = children[i] * children[count - 1 - i];
+		}
+	});
+	std::vector<glm::mat4> reversed(children.rbegin(), children.rend());
+	printf("\nMultiply\n");
+	PrintRow("glm", count, glmTime, glmTime, 0.0f);
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		MatrixKernels::SetLevel(levels[l]);
+		double time = BestMilliseconds([&]() { MatrixKernels::Multiply(children.data(), reversed.data(), result.data(), count); });
+		PrintRow(MatrixKernels::GetLevelName(levels[l]), count, time, glmTime, MaxDifference(reference, result));
+	}
+
+	// Translation, rotation and scale to a matrix, as glm code usually writes it.
+	glmTime = BestMilliseconds([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			reference[i] = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+		}
+	});
+	printf("\nComposeTRS\n");
+	PrintRow("glm", count, glmTime, glmTime, 0.0f);
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		MatrixKernels::SetLevel(levels[l]);
+		double time = BestMilliseconds([&]() { MatrixKernels::ComposeTRS(translations.data(), rotations.data(), scales.data(), result.data(), count); });
+		PrintRow(MatrixKernels::GetLevelName(levels[l]), count, time, glmTime, MaxDifference(reference, result));
+	}
+
+	// Local bounds to world bounds.
+	glmTime = BestMilliseconds([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			referenceBoxes[i] = boxes[i].Transformed(children[i]);
+		}
+	});
+	printf("\nTransformAABBs\n");
+	PrintRow("glm", count, glmTime, glmTime, 0.0f);
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		MatrixKernels::SetLevel(levels[l]);
+		double time = BestMilliseconds([&]() { MatrixKernels::TransformAABBs(children.data(), boxes.data(), resultBoxes.data(), count); });
+		PrintRow(MatrixKernels::GetLevelName(levels[l]), count, time, glmTime, MaxDifference(referenceBoxes, resultBoxes));
+	}
+
+	return 0;
+}
@@ -0,0 +1,204 @@
+// Compares encoded meshes against their raw arrays: size, and decode speed against copying the raw arrays, which is
+// what loading the uncompressed layout costs once it is read.
+// It first checks that truncated and corrupt files are rejected, and exits with 1 if not.
+// Usage: MeshCodecBench [sphere segments]
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+
+// Each measurement is the best of this many runs.
+static const int REPETITIONS = 20;
+
+struct TestMesh
+{
+	const char* name;
+	GLenum drawType;
+	std::vector<GLfloat> vertices;
+	std::vector<GLfloat> colors;
+	std::vector<unsigned int> indices;
+};
+
+template <class Function>
+static double BestMilliseconds(Function function)
+{
+	double best = 1e30;
+	for (int i = 0; i < REPETITIONS; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+// A unit sphere of strips, one per latitude, as Main's CreateSphere builds them.
+static TestMesh CreateSphere(int segments)
+{
+	TestMesh mesh;
+	mesh.name = "sphere strips";
+	mesh.drawType = GL_TRIANGLE_STRIP;
+	const double pi = 3.14159265358979323846;
+	unsigned int next = 0;
+	for (int i = 0; i <= segments; i++)
+	{
+		double latitude0 = pi * (-0.5 + (double)(i - 1) / segments);
+		double latitude1 = pi * (-0.5 + (double)i / segments);
+		for (int j = 0; j <= segments; j++)
+		{
+			double longitude = 2 * pi * (double)(j - 1) / segments;
+			double x = cos(longitude), y = sin(longitude);
+			mesh.vertices.push_back((GLfloat)(x * cos(latitude0)));
+			mesh.vertices.push_back((GLfloat)(y * cos(latitude0)));
+			mesh.vertices.push_back((GLfloat)sin(latitude0));
+			mesh.indices.push_back(next++);
+			mesh.vertices.push_back((GLfloat)(x * cos(latitude1)));
+			mesh.vertices.push_back((GLfloat)(y * cos(latitude1)));
+			mesh.vertices.push_back((GLfloat)sin(latitude1));
+			mesh.indices.push_back(next++);
+		}
+		mesh.indices.push_back(MeshOptimizer::RESTART_INDEX);
+	}
+	return mesh;
+}
+
+// A wavy terrain of shared vertices with per vertex colors, the kind of triangle list a baked mesh is.
+static TestMesh CreateTerrain(int size)
+{
+	TestMesh mesh;
+	mesh.name = "colored grid";
+	mesh.drawType = GL_TRIANGLES;
+	for (int z = 0; z <= size; z++)
+	{
+		for (int x = 0; x <= size; x++)
+		{
+			float height = 0.5f * sinf(x * 0.1f) * cosf(z * 0.13f);
+			mesh.vertices.push_back(x * 0.25f);
+			mesh.vertices.push_back(height);
+			mesh.vertices.push_back(z * 0.25f);
+			mesh.colors.push_back(0.3f + height * 0.5f);
+			mesh.colors.push_back(0.6f);
+			mesh.colors.push_back(0.2f);
+			mesh.colors.push_back(0.0f);
+		}
+	}
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned int corner = z * (size + 1) + x;
+			unsigned int quad[6] = { corner, corner + size + 1, corner + 1, corner + 1, corner + size + 1, corner + size + 2 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+static size_t RawSize(const TestMesh& mesh)
+{
+	return (mesh.vertices.size() + mesh.colors.size()) * sizeof(GLfloat) + mesh.indices.size() * sizeof(unsigned int);
+}
+
+static void Run(TestMesh& mesh)
+{
+	// Meshes are stored as MeshOptimizer orders them, which is also what makes their differences small.
+	MeshOptimizer::Optimize(mesh.vertices, mesh.colors.empty() ? NULL : &mesh.colors, mesh.indices, mesh.drawType);
+
+	std::vector<unsigned char> encoded;
+	double encodeTime = BestMilliseconds([&]() { MeshCodec::Encode(mesh.vertices, mesh.colors.empty() ? NULL : &mesh.colors, mesh.indices, mesh.drawType, encoded); });
+
+	std::vector<GLfloat> vertices(mesh.vertices.size()), colors(mesh.colors.size());
+	std::vector<unsigned int> indices(mesh.indices.size());
+	bool decoded = true;
+	double decodeTime = BestMilliseconds([&]() { decoded = MeshCodec::Decode(encoded.data(), encoded.size(), vertices.data(), colors.data(), indices.data()) && decoded; });
+	double copyTime = BestMilliseconds([&]() {
+		std::copy(mesh.vertices.begin(), mesh.vertices.end(), vertices.begin());
+		std::copy(mesh.colors.begin(), mesh.colors.end(), colors.begin());
+		std::copy(mesh.indices.begin(), mesh.indices.end(), indices.begin());
+	});
+
+	// The copies above overwrote the decoded arrays; decode once more to check them.
+	decoded = MeshCodec::Decode(encoded.data(), encoded.size(), vertices.data(), colors.data(), indices.data()) && decoded;
+	float positionError = 0.0f;
+	float colorError = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		positionError = std::max(positionError, std::fabs(vertices[i] - mesh.vertices[i]));
+	}
+	for (size_t i = 0; i < colors.size(); i++)
+	{
+		colorError = std::max(colorError, std::fabs(colors[i] - mesh.colors[i]));
+	}
+	bool indicesMatch = indices == mesh.indices;
+
+	size_t raw = RawSize(mesh);
+	printf("%s: %zu vertices, %zu indices\n", mesh.name, mesh.vertices.size() / 3, mesh.indices.size());
+	printf("  size      raw %9zu bytes  encoded %9zu bytes  ratio %5.2f  (%.2f bytes/vertex)\n", raw, encoded.size(), (double)raw / encoded.size(), (double)encoded.size() / (mesh.vertices.size() / 3));
+	printf("  encode    %9.3f ms\n", encodeTime);
+	printf("  decode    %9.3f ms  %6.2f GB/s of raw arrays\n", decodeTime, raw / (decodeTime * 1e6));
+	printf("  raw copy  %9.3f ms  %6.2f GB/s\n", copyTime, raw / (copyTime * 1e6));
+	printf("  %s, max position error %g, max color error %g, indices %s\n", decoded ? "decoded" : "DECODE FAILED", positionError, colorError, indicesMatch ? "exact" : "DIFFERENT");
+}
+
+// Feeds Decode files it must reject without reading past them, since --load-mesh files can be anything: every
+// truncation of a small mesh, each of its bytes corrupted, and a mesh whose index codes run past their count.
+// Build with -fsanitize=address to have overruns reported. Returns false if a bad file decoded.
+static bool CheckCorruptInput()
+{
+	TestMesh mesh = CreateSphere(8);
+	std::vector<unsigned char> encoded;
+	MeshCodec::Encode(mesh.vertices, NULL, mesh.indices, mesh.drawType, encoded);
+	MeshCodec::MeshData decoded;
+
+	size_t truncationsDecoded = 0;
+	for (size_t size = 0; size < encoded.size(); size++)
+	{
+		std::vector<unsigned char> truncated(encoded.begin(), encoded.begin() + size);
+		truncationsDecoded += MeshCodec::Decode(truncated.data(), truncated.size(), decoded) ? 1 : 0;
+	}
+
+	// Decoding may succeed or not, depending on the byte: it must only stay within the data.
+	for (size_t i = 0; i < encoded.size(); i++)
+	{
+		std::vector<unsigned char> corrupted = encoded;
+		corrupted[i] ^= 0xFF;
+		MeshCodec::Decode(corrupted.data(), corrupted.size(), decoded);
+	}
+
+	// 16 restart indices take 16 zero bytes: a group stored as nothing, its mode the last byte. Stored instead as
+	// restart codes padded to 5 bytes each, they need more bytes than the header counts.
+	std::vector<GLfloat> vertices(3, 0.0f);
+	std::vector<unsigned int> restarts(16, MeshOptimizer::RESTART_INDEX);
+	std::vector<unsigned char> overlong;
+	MeshCodec::Encode(vertices, NULL, restarts, GL_TRIANGLE_STRIP, overlong);
+	const unsigned char paddedRestarts[16] = { 0x80, 0x80, 0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x80, 0x00, 0x80 };
+	overlong.back() = 2; // The bytes stored as they are
+	overlong.insert(overlong.end(), paddedRestarts, paddedRestarts + 16);
+	bool overlongDecoded = MeshCodec::Decode(overlong.data(), overlong.size(), decoded);
+
+	bool passed = truncationsDecoded == 0 && !overlongDecoded;
+	printf("corrupt input: %zu of %zu truncations decoded, overlong index codes %s%s\n", truncationsDecoded, encoded.size(),
+		overlongDecoded ? "decoded" : "rejected", passed ? "" : " - FAILED");
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	int segments = argc > 1 ? atoi(argv[1]) : 400;
+
+	if (!CheckCorruptInput())
+	{
+		return 1;
+	}
+
+	TestMesh sphere = CreateSphere(segments);
+	Run(sphere);
+	TestMesh terrain = CreateTerrain(segments * 2);
+	Run(terrain);
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include "AABB.h"
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+AABB::AABB()
+{
+	min = glm::vec3(FLT_MAX);
+	max = glm::vec3(-FLT_MAX);
+}
+
+AABB::AABB(const glm::vec3& min, const glm::vec3& max)
+{
+	this->min = min;
+	this->max = max;
+}
+
+bool AABB::IsEmpty() const
+{
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+void AABB::Extend(const glm::vec3& point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::Extend(const AABB& other)
+{
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+}
+
+float AABB::GetSurfaceArea() const
+{
+	if (IsEmpty())
+	{
+		return 0.0f;
+	}
+
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool AABB::Overlaps(const AABB& other) const
+{
+	return min.x <= other.max.x && max.x >= other.min.x &&
+		min.y <= other.max.y && max.y >= other.min.y &&
+		min.z <= other.max.z && max.z >= other.min.z;
+}
+
+AABB AABB::Transformed(const glm::mat4& matrix) const
+{
+	if (IsEmpty())
+	{
+		return AABB();
+	}
+
+	// Arvo's method: the transformed center, plus the extents projected on each axis through the absolute rotation/scale part.
+	glm::vec3 center = GetCenter();
+	glm::vec3 extents = GetExtents();
+
+	glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+	glm::vec3 newExtents(0.0f);
+
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			newExtents[row] += std::fabs(matrix[column][row]) * extents[column];
+		}
+	}
+
+	return AABB(newCenter - newExtents, newCenter + newExtents);
+}
+
+bool AABB::IntersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+{
+	// Slab test: intersect the ray with the three pairs of planes and keep the overlapping interval.
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (min[axis] - origin[axis]) * inverseDirection[axis];
+		float t1 = (max[axis] - origin[axis]) * inverseDirection[axis];
+
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+
+		// fmax/fmin ignore the NaN produced by 0 * infinity when the ray lies on a slab plane.
+		tMin = std::fmax(tMin, t0);
+		tMax = std::fmin(tMax, t1);
+
+		if (tMin > tMax)
+		{
+			return false;
+		}
+	}
+
+	distance = tMin;
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <glm/glm.hpp>
+
+/// <summary>
+/// An axis aligned bounding box.
+/// </summary>
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	/// <summary>
+	/// Creates an empty box, which contains nothing and grows to fit whatever is added to it.
+	/// </summary>
+	AABB();
+	AABB(const glm::vec3& min, const glm::vec3& max);
+
+	/// <summary>
+	/// Returns true if nothing was ever added to the box.
+	/// </summary>
+	bool IsEmpty() const;
+
+	/// <summary>
+	/// Grows the box to contain the point.
+	/// </summary>
+	void Extend(const glm::vec3& point);
+	/// <summary>
+	/// Grows the box to contain the other box.
+	/// </summary>
+	void Extend(const AABB& other);
+
+	glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+	/// <summary>
+	/// Returns the area of the box's surface, used to estimate the cost of a BVH node.
+	/// </summary>
+	float GetSurfaceArea() const;
+
+	/// <summary>
+	/// Returns true if the two boxes overlap or touch.
+	/// </summary>
+	bool Overlaps(const AABB& other) const;
+
+	/// <summary>
+	/// Returns the box containing this box once transformed by the matrix. Exact for the box, conservative for its content.
+	/// </summary>
+	/// <param name="matrix">An affine transformation.</param>
+	AABB Transformed(const glm::mat4& matrix) const;
+
+	/// <summary>
+	/// Intersects a ray with the box.
+	/// </summary>
+	/// <param name="origin">Origin of the ray.</param>
+	/// <param name="inverseDirection">1 / direction of the ray, per component.</param>
+	/// <param name="maxDistance">Hits further than this are ignored.</param>
+	/// <param name="distance">Set to the distance to the entry point (0 if the origin is inside) on a hit.</param>
+	/// <returns>True if the ray hits the box.</returns>
+	bool IntersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const;
+};
+
+inline bool operator==(const AABB& a, const AABB& b)
+{
+	return a.min == b.min && a.max == b.max;
+}
+
+inline bool operator!=(const AABB& a, const AABB& b)
+{
+	return !(a == b);
+}
@@ -0,0 +1,338 @@
+#include "Animation.h"
+#include <cmath>
+#include <algorithm>
+
+// SSE is always available on x86-64; other targets use the scalar loops.
+#if defined(__x86_64__) || defined(_M_X64)
+#define ANIMATION_SSE
+#include <emmintrin.h>
+#endif
+
+// Components of the interpolated values: translation x, y, z, rotation x, y, z, w, scale x, y, z.
+static const int TRANSLATION = 0;
+static const int ROTATION = 3;
+static const int SCALE = 7;
+static const int COMPONENT_COUNT = 10;
+
+void AnimationClip::AddKey(float time, const TRS& key)
+{
+	times.push_back(time);
+	keys.push_back(key);
+}
+
+Animator::Animator(TransformStore& store)
+{
+	this->store = &store;
+}
+
+Animator::~Animator()
+{
+}
+
+unsigned int Animator::AddClip(const AnimationClip& clip)
+{
+	clipFirstKeys.push_back((unsigned int)keyTimes.size());
+	clipKeyCounts.push_back((unsigned int)clip.times.size());
+	clipLoops.push_back(clip.loop);
+
+	for (size_t i = 0; i < clip.times.size(); i++)
+	{
+		const TRS& key = clip.keys[i];
+		keyTimes.push_back(clip.times[i] - clip.times[0]);
+		for (int c = 0; c < 3; c++)
+		{
+			keyTranslations[c].push_back(key.translation[c]);
+			keyScales[c].push_back(key.scale[c]);
+		}
+		keyRotations[0].push_back(key.rotation.x);
+		keyRotations[1].push_back(key.rotation.y);
+		keyRotations[2].push_back(key.rotation.z);
+		keyRotations[3].push_back(key.rotation.w);
+	}
+
+	return (unsigned int)clipFirstKeys.size() - 1;
+}
+
+void Animator::Play(unsigned int transform, unsigned int clip, float time, float speed)
+{
+	std::unordered_map<unsigned int, unsigned int>::iterator found = players.find(transform);
+	unsigned int player;
+	if (found != players.end())
+	{
+		player = found->second;
+	}
+	else
+	{
+		player = (unsigned int)playerTransforms.size();
+		players[transform] = player;
+		playerTransforms.push_back(transform);
+		playerClips.push_back(0);
+		playerTimes.push_back(0.0f);
+		playerSpeeds.push_back(0.0f);
+		playerKeys.push_back(0);
+	}
+
+	playerClips[player] = clip;
+	playerTimes[player] = time;
+	playerSpeeds[player] = speed;
+	playerKeys[player] = 0;
+}
+
+void Animator::Stop(unsigned int transform)
+{
+	std::unordered_map<unsigned int, unsigned int>::iterator found = players.find(transform);
+	if (found == players.end())
+	{
+		return;
+	}
+
+	// Move the last player into the freed entry, keeping the arrays packed.
+	unsigned int player = found->second;
+	unsigned int last = (unsigned int)playerTransforms.size() - 1;
+	players.erase(found);
+	if (player != last)
+	{
+		playerTransforms[player] = playerTransforms[last];
+		playerClips[player] = playerClips[last];
+		playerTimes[player] = playerTimes[last];
+		playerSpeeds[player] = playerSpeeds[last];
+		playerKeys[player] = playerKeys[last];
+		players[playerTransforms[player]] = player;
+	}
+
+	playerTransforms.pop_back();
+	playerClips.pop_back();
+	playerTimes.pop_back();
+	playerSpeeds.pop_back();
+	playerKeys.pop_back();
+}
+
+void Animator::StopAll()
+{
+	players.clear();
+	playerTransforms.clear();
+	playerClips.clear();
+	playerTimes.clear();
+	playerSpeeds.clear();
+	playerKeys.clear();
+}
+
+void Animator::Clear()
+{
+	StopAll();
+
+	keyTimes.clear();
+	for (int c = 0; c < 3; c++)
+	{
+		keyTranslations[c].clear();
+		keyScales[c].clear();
+	}
+	for (int c = 0; c < 4; c++)
+	{
+		keyRotations[c].clear();
+	}
+	clipFirstKeys.clear();
+	clipKeyCounts.clear();
+	clipLoops.clear();
+}
+
+bool Animator::IsPlaying(unsigned int transform) const
+{
+	return players.find(transform) != players.end();
+}
+
+void Animator::Update(float deltaTime)
+{
+	size_t count = playerTransforms.size();
+	if (count == 0)
+	{
+		return;
+	}
+
+	fromKeys.resize(count);
+	toKeys.resize(count);
+	blends.resize(count);
+	for (int c = 0; c < COMPONENT_COUNT; c++)
+	{
+		fromValues[c].resize(count);
+		toValues[c].resize(count);
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		playerTimes[i] += deltaTime * playerSpeeds[i];
+	}
+
+	FindKeys();
+
+	// Gather the keys' values into contiguous arrays, so the interpolation reads them in order.
+	const std::vector<float>* keyComponents[COMPONENT_COUNT] = {
+		&keyTranslations[0], &keyTranslations[1], &keyTranslations[2],
+		&keyRotations[0], &keyRotations[1], &keyRotations[2], &keyRotations[3],
+		&keyScales[0], &keyScales[1], &keyScales[2]
+	};
+	for (int c = 0; c < COMPONENT_COUNT; c++)
+	{
+		const float* source = keyComponents[c]->data();
+		float* from = fromValues[c].data();
+		float* to = toValues[c].data();
+		for (size_t i = 0; i < count; i++)
+		{
+			from[i] = source[fromKeys[i]];
+			to[i] = source[toKeys[i]];
+		}
+	}
+
+	Interpolate();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		TRS value(glm::vec3(fromValues[TRANSLATION][i], fromValues[TRANSLATION + 1][i], fromValues[TRANSLATION + 2][i]),
+			glm::quat(fromValues[ROTATION + 3][i], fromValues[ROTATION][i], fromValues[ROTATION + 1][i], fromValues[ROTATION + 2][i]),
+			glm::vec3(fromValues[SCALE][i], fromValues[SCALE + 1][i], fromValues[SCALE + 2][i]));
+		store->Set(playerTransforms[i], value);
+	}
+}
+
+void Animator::FindKeys()
+{
+	for (size_t i = 0; i < playerTransforms.size(); i++)
+	{
+		unsigned int clip = playerClips[i];
+		unsigned int first = clipFirstKeys[clip];
+		unsigned int keyCount = clipKeyCounts[clip];
+		const float* times = &keyTimes[first];
+		float duration = times[keyCount - 1];
+
+		if (keyCount == 1 || duration <= 0.0f)
+		{
+			fromKeys[i] = first;
+			toKeys[i] = first;
+			blends[i] = 0.0f;
+			continue;
+		}
+
+		// Bring the time back into the clip, keeping it there so it doesn't lose precision as the clip plays on.
+		float time = playerTimes[i];
+		if (clipLoops[clip])
+		{
+			time = std::fmod(time, duration);
+			if (time < 0.0f)
+			{
+				time += duration;
+			}
+		}
+		else
+		{
+			time = std::min(std::max(time, 0.0f), duration);
+		}
+		playerTimes[i] = time;
+
+		// Usually the same key as last frame or the next one; otherwise (a loop, a jump) search for it.
+		unsigned int key = playerKeys[i];
+		if (key + 1 >= keyCount || times[key] > time)
+		{
+			key = (unsigned int)(std::upper_bound(times, times + keyCount, time) - times);
+			key = key > 0 ? key - 1 : 0;
+		}
+		while (key + 2 < keyCount && times[key + 1] <= time)
+		{
+			key++;
+		}
+		key = std::min(key, keyCount - 2);
+		playerKeys[i] = key;
+
+		float span = times[key + 1] - times[key];
+		fromKeys[i] = first + key;
+		toKeys[i] = first + key + 1;
+		blends[i] = span > 0.0f ? std::min((time - times[key]) / span, 1.0f) : 0.0f;
+	}
+}
+
+void Animator::Interpolate()
+{
+	size_t count = playerTransforms.size();
+	const float* t = blends.data();
+	size_t start = 0;
+
+#ifdef ANIMATION_SSE
+	// Four players at a time. The rest, and other targets, take the scalar loop below.
+	size_t simdCount = count & ~(size_t)3;
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t i = 0; i < simdCount; i += 4)
+	{
+		__m128 blend = _mm_loadu_ps(t + i);
+
+		// Translation and scale: from + (to - from) * blend.
+		const int linear[6] = { TRANSLATION, TRANSLATION + 1, TRANSLATION + 2, SCALE, SCALE + 1, SCALE + 2 };
+		for (int j = 0; j < 6; j++)
+		{
+			float* from = fromValues[linear[j]].data() + i;
+			__m128 a = _mm_loadu_ps(from);
+			__m128 b = _mm_loadu_ps(toValues[linear[j]].data() + i);
+			_mm_storeu_ps(from, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), blend)));
+		}
+
+		// Rotation: normalized linear interpolation, flipping the target when needed to take the shortest arc.
+		__m128 a[4], b[4];
+		for (int c = 0; c < 4; c++)
+		{
+			a[c] = _mm_loadu_ps(fromValues[ROTATION + c].data() + i);
+			b[c] = _mm_loadu_ps(toValues[ROTATION + c].data() + i);
+		}
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+		__m128 toWeight = _mm_xor_ps(blend, _mm_and_ps(_mm_cmplt_ps(dot, zero), signMask));
+		__m128 fromWeight = _mm_sub_ps(one, blend);
+
+		__m128 r[4];
+		__m128 lengthSquared = zero;
+		for (int c = 0; c < 4; c++)
+		{
+			r[c] = _mm_add_ps(_mm_mul_ps(a[c], fromWeight), _mm_mul_ps(b[c], toWeight));
+			lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(r[c], r[c]));
+		}
+		// A full precision division rather than _mm_rsqrt_ps, so the rotation stays as exact as the scalar path.
+		__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+		for (int c = 0; c < 4; c++)
+		{
+			_mm_storeu_ps(fromValues[ROTATION + c].data() + i, _mm_mul_ps(r[c], inverseLength));
+		}
+	}
+	start = simdCount;
+#endif
+
+	for (size_t i = start; i < count; i++)
+	{
+		for (int c = TRANSLATION; c < TRANSLATION + 3; c++)
+		{
+			fromValues[c][i] += (toValues[c][i] - fromValues[c][i]) * t[i];
+		}
+		for (int c = SCALE; c < SCALE + 3; c++)
+		{
+			fromValues[c][i] += (toValues[c][i] - fromValues[c][i]) * t[i];
+		}
+
+		float dot = 0.0f;
+		for (int c = ROTATION; c < ROTATION + 4; c++)
+		{
+			dot += fromValues[c][i] * toValues[c][i];
+		}
+		float toWeight = dot < 0.0f ? -t[i] : t[i];
+		float fromWeight = 1.0f - t[i];
+
+		float lengthSquared = 0.0f;
+		for (int c = ROTATION; c < ROTATION + 4; c++)
+		{
+			fromValues[c][i] = fromValues[c][i] * fromWeight + toValues[c][i] * toWeight;
+			lengthSquared += fromValues[c][i] * fromValues[c][i];
+		}
+		float inverseLength = 1.0f / std::sqrt(lengthSquared);
+		for (int c = ROTATION; c < ROTATION + 4; c++)
+		{
+			fromValues[c][i] *= inverseLength;
+		}
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "TransformStore.h"
+#include <vector>
+#include <unordered_map>
+
+/// <summary>
+/// A keyframed animation of one transformation: translation, rotation and scale keys at increasing times.
+/// Between keys, translation and scale are interpolated linearly and rotation along the shortest arc.
+/// </summary>
+struct AnimationClip
+{
+	/// <summary>
+	/// Times of the keys in seconds, increasing. The clip starts at the first key and lasts until the last one.
+	/// </summary>
+	std::vector<float> times;
+	std::vector<TRS> keys;
+	/// <summary>
+	/// True to start over after the last key, false to hold it.
+	/// </summary>
+	bool loop;
+
+	AnimationClip() : loop(true) {}
+
+	/// <summary>
+	/// Appends a key. Its time must not be before the previous key's.
+	/// </summary>
+	void AddKey(float time, const TRS& key);
+};
+
+/// <summary>
+/// Plays animation clips on transformations of a TransformStore. Each frame, Update advances every playing
+/// transformation and evaluates them all in one batched pass: keys and playback state are stored as arrays of
+/// components, interpolation runs on several transformations at once with SIMD, and the results are written
+/// straight into the store, which composes the matrices later with everything else that changed.
+/// </summary>
+class Animator
+{
+	public:
+		/// <summary>
+		/// Creates an animator writing into the given store.
+		/// </summary>
+		Animator(TransformStore& store = TransformStore::Global());
+		~Animator();
+
+		/// <summary>
+		/// Adds a clip that can then be played on any number of transformations. It must have at least one key.
+		/// </summary>
+		/// <returns>The index of the clip, to pass to Play.</returns>
+		unsigned int AddClip(const AnimationClip& clip);
+
+		/// <summary>
+		/// Starts playing a clip on a transformation, replacing the clip it was playing if any.
+		/// The transformation takes the clip's values from the next Update on.
+		/// </summary>
+		/// <param name="transform">Index of the transformation in the store.</param>
+		/// <param name="clip">Index returned by AddClip.</param>
+		/// <param name="time">Time in the clip to start at, in seconds. Lets transformations sharing a clip be out of phase.</param>
+		/// <param name="speed">Playback speed, 1 for real time.</param>
+		void Play(unsigned int transform, unsigned int clip, float time = 0.0f, float speed = 1.0f);
+		/// <summary>
+		/// Stops animating the transformation, leaving it where the last Update put it.
+		/// </summary>
+		void Stop(unsigned int transform);
+		void StopAll();
+		/// <summary>
+		/// Stops every transformation and removes every clip.
+		/// </summary>
+		void Clear();
+		bool IsPlaying(unsigned int transform) const;
+		size_t GetPlayingCount() const { return playerTransforms.size(); }
+
+		/// <summary>
+		/// Advances every playing transformation by the elapsed time and writes their new values into the store.
+		/// </summary>
+		/// <param name="deltaTime">Seconds since the last update.</param>
+		void Update(float deltaTime);
+
+	private:
+		/// <summary>
+		/// Finds the keys around each player's time and how far between them it is.
+		/// </summary>
+		void FindKeys();
+		/// <summary>
+		/// Interpolates between the keys found by FindKeys, into the result arrays.
+		/// </summary>
+		void Interpolate();
+
+		TransformStore* store;
+
+		// The keys of every clip, one after the other, one array per component.
+		std::vector<float> keyTimes;
+		std::vector<float> keyTranslations[3];
+		std::vector<float> keyRotations[4];
+		std::vector<float> keyScales[3];
+
+		// Where each clip's keys start in the key arrays, how many there are, and how it plays.
+		std::vector<unsigned int> clipFirstKeys;
+		std::vector<unsigned int> clipKeyCounts;
+		std::vector<bool> clipLoops;
+
+		// One entry per playing transformation.
+		std::vector<unsigned int> playerTransforms;
+		std::vector<unsigned int> playerClips;
+		std::vector<float> playerTimes;
+		std::vector<float> playerSpeeds;
+		/// <summary>
+		/// The key before each player's time, relative to its clip's first key. Kept between updates, since time moves
+		/// forward a little each frame and the key rarely changes.
+		/// </summary>
+		std::vector<unsigned int> playerKeys;
+		/// <summary>
+		/// Index of each playing transformation's entry in the player arrays.
+		/// </summary>
+		std::unordered_map<unsigned int, unsigned int> players;
+
+		// Scratch arrays of the batched pass, one entry per player: the two keys, and how far between them.
+		std::vector<unsigned int> fromKeys;
+		std::vector<unsigned int> toKeys;
+		std::vector<float> blends;
+		// Gathered key values, then interpolated in place into the first array of each pair.
+		std::vector<float> fromValues[10];
+		std::vector<float> toValues[10];
+};
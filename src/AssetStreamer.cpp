@@ -0,0 +1,175 @@
+#include "AssetStreamer.h"
+#include "RedrawSignal.h"
+#include <GLFW/glfw3.h>
+
+AssetStreamer::AssetStreamer()
+{
+	uploadBudget = 0;
+	stats = Stats();
+	stopping = false;
+}
+
+void AssetStreamer::Start(unsigned int threadCount, size_t uploadBudget)
+{
+	this->uploadBudget = uploadBudget;
+	stopping = false;
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		loaders.push_back(std::thread(&AssetStreamer::LoadAssets, this));
+	}
+}
+
+void AssetStreamer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		queue.clear();
+	}
+	queueCondition.notify_all();
+	for (size_t i = 0; i < loaders.size(); i++)
+	{
+		loaders[i].join();
+	}
+	loaders.clear();
+	decoded.clear();
+
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		Mesh::Destroy(assets[i].mesh);
+	}
+	assets.clear();
+	uploads.clear();
+	stats = Stats();
+}
+
+unsigned int AssetStreamer::Load(const char* path)
+{
+	Asset asset;
+	asset.state = State::Loading;
+	asset.path = path;
+	asset.mesh = Mesh::Create();
+	asset.mesh->SetDataOnDisk(true);
+	asset.drawType = GL_TRIANGLES;
+	assets.push_back(asset);
+
+	Queue((unsigned int)assets.size() - 1);
+	return (unsigned int)assets.size() - 1;
+}
+
+bool AssetStreamer::Use(unsigned int asset)
+{
+	if (assets[asset].state != State::Resident)
+	{
+		return false;
+	}
+	if (!assets[asset].mesh->IsEvicted())
+	{
+		return true;
+	}
+
+	// Its data went with its buffers; read the file again.
+	assets[asset].state = State::Loading;
+	Queue(asset);
+	return false;
+}
+
+void AssetStreamer::Queue(unsigned int asset)
+{
+	Request request;
+	request.asset = asset;
+	request.path = assets[asset].path;
+	request.loaded = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(request));
+	}
+	queueCondition.notify_one();
+}
+
+void AssetStreamer::Update()
+{
+	std::vector<Request> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.swap(decoded);
+	}
+
+	// Allocating the buffers is cheap; the data goes up below, within the budget.
+	for (size_t i = 0; i < ready.size(); i++)
+	{
+		Asset& asset = assets[ready[i].asset];
+		if (!ready[i].loaded)
+		{
+			asset.state = State::Failed;
+			continue;
+		}
+		asset.drawType = ready[i].data.drawType;
+		asset.mesh->BeginUpload(ready[i].data.vertices, ready[i].data.colors, ready[i].data.indices);
+		asset.state = State::Uploading;
+		uploads.push_back(ready[i].asset);
+	}
+
+	// One mesh at a time, in the order they were decoded, so each becomes resident as soon as possible.
+	size_t budget = uploadBudget > 0 ? uploadBudget : (size_t)-1;
+	size_t uploaded = 0;
+	while (!uploads.empty() && uploaded < budget)
+	{
+		Asset& asset = assets[uploads.front()];
+		uploaded += asset.mesh->ContinueUpload(budget - uploaded);
+		if (!asset.mesh->IsUploaded())
+		{
+			break;
+		}
+		asset.state = State::Resident;
+		uploads.pop_front();
+	}
+
+	stats = Stats();
+	stats.uploadedBytes = uploaded;
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		switch (assets[i].state)
+		{
+			case State::Loading: stats.loading++; break;
+			case State::Uploading: stats.uploading++; break;
+			case State::Resident: stats.resident++; break;
+			case State::Failed: stats.failed++; break;
+		}
+	}
+
+	// The meshes made resident change the picture, and the ones left need another frame to go up
+	if (uploaded > 0 || !uploads.empty())
+	{
+		RedrawSignal::Request();
+	}
+}
+
+void AssetStreamer::LoadAssets()
+{
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			request = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		request.loaded = MeshCodec::Load(request.path.c_str(), request.data);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decoded.push_back(std::move(request));
+		}
+
+		// Wake the render loop if it is idle, so the upload starts
+		RedrawSignal::Request();
+		glfwPostEmptyEvent();
+	}
+}
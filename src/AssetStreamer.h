@@ -0,0 +1,126 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Mesh.h"
+#include "MeshCodec.h"
+
+/// <summary>
+/// Loads meshes saved with MeshCodec without holding up frames. Worker threads read and decode the files, then the
+/// GL thread uploads them into their meshes a slice at a time, no more than a budget of bytes per frame. A mesh draws
+/// nothing until all of it is uploaded: callers draw a placeholder in its place, or skip it, until it is resident.
+/// Uploads are time sliced on the main context rather than done on a shared one, which keeps every GL call on the
+/// thread GLState tracks. Meshes evicted by GPUMemory free their data too, and are read from their file again the next
+/// time they are used.
+/// Must be used on the thread owning the GL context, and stopped before the context is destroyed.
+/// </summary>
+class AssetStreamer
+{
+	public:
+		enum class State { Loading, Uploading, Resident, Failed };
+
+		/// <summary>
+		/// Assets in each state, and the bytes uploaded by the last Update.
+		/// </summary>
+		struct Stats
+		{
+			unsigned int loading;
+			unsigned int uploading;
+			unsigned int resident;
+			unsigned int failed;
+			size_t uploadedBytes;
+		};
+
+		AssetStreamer();
+
+		/// <summary>
+		/// Starts the threads reading and decoding the files.
+		/// </summary>
+		/// <param name="threadCount">Number of loading threads.</param>
+		/// <param name="uploadBudget">Most bytes uploaded per frame, 0 for no limit.</param>
+		void Start(unsigned int threadCount, size_t uploadBudget);
+		/// <summary>
+		/// Stops the loading threads and destroys the assets' meshes.
+		/// </summary>
+		void Stop();
+
+		/// <summary>
+		/// Queues a mesh file for loading.
+		/// </summary>
+		/// <param name="path">The file, written by MeshCodec::Save.</param>
+		/// <returns>The index of the asset.</returns>
+		unsigned int Load(const char* path);
+
+		/// <summary>
+		/// Starts uploading the meshes decoded since the last call, and uploads as much as the budget allows.
+		/// Call once per frame, before drawing.
+		/// </summary>
+		void Update();
+
+		unsigned int GetAssetCount() const { return (unsigned int)assets.size(); }
+		State GetState(unsigned int asset) const { return assets[asset].state; }
+		bool IsResident(unsigned int asset) const { return assets[asset].state == State::Resident; }
+		/// <summary>
+		/// Returns true if the asset can be drawn. An asset evicted since it was loaded is queued for loading again.
+		/// </summary>
+		bool Use(unsigned int asset);
+		/// <summary>
+		/// Returns the asset's mesh, which draws nothing until the asset is resident.
+		/// </summary>
+		Handle<Mesh> GetMesh(unsigned int asset) const { return assets[asset].mesh; }
+		/// <summary>
+		/// Returns the primitives the mesh is drawn as, known once its file is decoded.
+		/// </summary>
+		GLenum GetDrawType(unsigned int asset) const { return assets[asset].drawType; }
+
+		Stats GetStats() const { return stats; }
+
+	private:
+		struct Asset
+		{
+			State state;
+			std::string path;
+			Handle<Mesh> mesh;
+			GLenum drawType;
+		};
+
+		/// <summary>
+		/// A file to load, then loaded, passed between the GL and the loading threads.
+		/// </summary>
+		struct Request
+		{
+			unsigned int asset;
+			std::string path;
+			bool loaded;
+			MeshCodec::MeshData data;
+		};
+
+		/// <summary>
+		/// Reads and decodes the queued files until stopped. Runs on the loading threads.
+		/// </summary>
+		void LoadAssets();
+		/// <summary>
+		/// Queues the asset's file for the loading threads.
+		/// </summary>
+		void Queue(unsigned int asset);
+
+		std::vector<Asset> assets;
+		/// <summary>
+		/// Assets being uploaded, the one uploading now first.
+		/// </summary>
+		std::deque<unsigned int> uploads;
+		size_t uploadBudget;
+		Stats stats;
+
+		std::vector<std::thread> loaders;
+		// Guarded by mutex: the files waiting to be read, and the ones decoded but not uploaded yet.
+		std::mutex mutex;
+		std::condition_variable queueCondition;
+		std::deque<Request> queue;
+		std::vector<Request> decoded;
+		bool stopping;
+};
@@ -0,0 +1,334 @@
+#include "BVH.h"
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+// Leaves hold at most this many items, unless they can't be split.
+static const unsigned int MAX_LEAF_ITEMS = 4;
+// Number of bins the surface area heuristic evaluates per axis.
+static const int SAH_BINS = 16;
+
+BVH::BVH()
+{
+}
+
+BVH::~BVH()
+{
+}
+
+void BVH::Build(const std::vector<AABB>& itemBounds)
+{
+	this->itemBounds = itemBounds;
+	unsigned int count = (unsigned int)itemBounds.size();
+
+	nodes.clear();
+	itemOrder.resize(count);
+	itemLeaf.resize(count);
+	centroids.resize(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		itemOrder[i] = i;
+		centroids[i] = itemBounds[i].GetCenter();
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	// A binary tree with n leaves has 2n - 1 nodes.
+	nodes.reserve(2 * count);
+
+	Node root;
+	root.parent = -1;
+	root.first = 0;
+	root.count = count;
+	nodes.push_back(root);
+
+	Subdivide(0, 0, count);
+
+	centroids.clear();
+	centroids.shrink_to_fit();
+}
+
+void BVH::Subdivide(unsigned int rootNode, unsigned int rootBegin, unsigned int rootEnd)
+{
+	struct Range
+	{
+		unsigned int node, begin, end;
+	};
+
+	// Iterative, so a badly unbalanced split can't overflow the call stack.
+	std::vector<Range> stack;
+	Range start = { rootNode, rootBegin, rootEnd };
+	stack.push_back(start);
+
+	while (!stack.empty())
+	{
+		Range range = stack.back();
+		stack.pop_back();
+
+		unsigned int count = range.end - range.begin;
+
+		AABB bounds;
+		AABB centroidBounds;
+		for (unsigned int i = range.begin; i < range.end; i++)
+		{
+			bounds.Extend(itemBounds[itemOrder[i]]);
+			centroidBounds.Extend(centroids[itemOrder[i]]);
+		}
+		nodes[range.node].bounds = bounds;
+
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = bounds.GetSurfaceArea() * count; // Cost of keeping this node as a leaf.
+
+		// Only the axis along which the centroids are most spread is evaluated: nearly as good as trying all three, for a third of the cost.
+		glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+		int axis = centroidExtent.x > centroidExtent.y ? (centroidExtent.x > centroidExtent.z ? 0 : 2) : (centroidExtent.y > centroidExtent.z ? 1 : 2);
+
+		float axisMin = centroidBounds.min[axis];
+		float axisExtent = centroidExtent[axis];
+
+		if (count > MAX_LEAF_ITEMS && axisExtent > 0.0f)
+		{
+			AABB binBounds[SAH_BINS];
+			unsigned int binCounts[SAH_BINS] = {};
+			float binScale = SAH_BINS / axisExtent;
+
+			for (unsigned int i = range.begin; i < range.end; i++)
+			{
+				int bin = std::min(SAH_BINS - 1, (int)((centroids[itemOrder[i]][axis] - axisMin) * binScale));
+				binBounds[bin].Extend(itemBounds[itemOrder[i]]);
+				binCounts[bin]++;
+			}
+
+			// Sweep from the right to get the cost of every right side, then from the left to combine.
+			float rightAreas[SAH_BINS];
+			unsigned int rightCounts[SAH_BINS];
+			AABB right;
+			unsigned int rightCount = 0;
+			for (int bin = SAH_BINS - 1; bin > 0; bin--)
+			{
+				right.Extend(binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightAreas[bin] = right.GetSurfaceArea();
+				rightCounts[bin] = rightCount;
+			}
+
+			AABB left;
+			unsigned int leftCount = 0;
+			for (int split = 1; split < SAH_BINS; split++)
+			{
+				left.Extend(binBounds[split - 1]);
+				leftCount += binCounts[split - 1];
+
+				if (leftCount == 0 || rightCounts[split] == 0)
+				{
+					continue;
+				}
+
+				float cost = left.GetSurfaceArea() * leftCount + rightAreas[split] * rightCounts[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		unsigned int middle = range.begin;
+
+		if (bestAxis >= 0)
+		{
+			float binScale = SAH_BINS / axisExtent;
+			const std::vector<glm::vec3>& centers = centroids;
+
+			middle = (unsigned int)(std::partition(itemOrder.begin() + range.begin, itemOrder.begin() + range.end, [&](unsigned int item)
+			{
+				return std::min(SAH_BINS - 1, (int)((centers[item][bestAxis] - axisMin) * binScale)) < bestSplit;
+			}) - itemOrder.begin());
+		}
+		else if (count > MAX_LEAF_ITEMS * 4)
+		{
+			// No split beats a leaf (all centroids equal, for instance), but the leaf would be too big to test: split by count.
+			middle = range.begin + count / 2;
+		}
+
+		if (middle == range.begin || middle == range.end)
+		{
+			// Leaf.
+			nodes[range.node].first = range.begin;
+			nodes[range.node].count = count;
+			for (unsigned int i = range.begin; i < range.end; i++)
+			{
+				itemLeaf[itemOrder[i]] = range.node;
+			}
+			continue;
+		}
+
+		unsigned int firstChild = (unsigned int)nodes.size();
+		nodes[range.node].first = firstChild;
+		nodes[range.node].count = 0;
+
+		Node child;
+		child.parent = (int)range.node;
+		child.first = 0;
+		child.count = 0;
+		nodes.push_back(child);
+		nodes.push_back(child);
+
+		Range leftRange = { firstChild, range.begin, middle };
+		Range rightRange = { firstChild + 1, middle, range.end };
+		stack.push_back(leftRange);
+		stack.push_back(rightRange);
+	}
+}
+
+bool BVH::UpdateNodeBounds(unsigned int node)
+{
+	Node& current = nodes[node];
+	AABB bounds;
+
+	if (current.count > 0)
+	{
+		for (unsigned int i = 0; i < current.count; i++)
+		{
+			bounds.Extend(itemBounds[itemOrder[current.first + i]]);
+		}
+	}
+	else
+	{
+		bounds = nodes[current.first].bounds;
+		bounds.Extend(nodes[current.first + 1].bounds);
+	}
+
+	if (bounds == current.bounds)
+	{
+		return false;
+	}
+
+	current.bounds = bounds;
+	return true;
+}
+
+void BVH::Refit(unsigned int item, const AABB& bounds)
+{
+	itemBounds[item] = bounds;
+
+	int node = (int)itemLeaf[item];
+	while (node >= 0 && UpdateNodeBounds((unsigned int)node))
+	{
+		node = nodes[node].parent;
+	}
+}
+
+int BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const ItemTest& exactTest, float& hitDistance) const
+{
+	if (nodes.empty())
+	{
+		return -1;
+	}
+
+	// Division by zero gives infinity, which the slab test handles.
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	int closestItem = -1;
+	float closestDistance = maxDistance;
+
+	float distance;
+	if (!nodes[0].bounds.IntersectRay(origin, inverseDirection, closestDistance, distance))
+	{
+		return -1;
+	}
+
+	// Nodes waiting to be visited, with the distance at which the ray enters them.
+	struct Entry
+	{
+		unsigned int node;
+		float distance;
+	};
+	std::vector<Entry> stack;
+	stack.reserve(64);
+	Entry root = { 0, distance };
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		Entry entry = stack.back();
+		stack.pop_back();
+
+		// A closer hit was found since this node was pushed.
+		if (entry.distance > closestDistance)
+		{
+			continue;
+		}
+
+		const Node& node = nodes[entry.node];
+
+		if (node.count > 0)
+		{
+			for (unsigned int i = 0; i < node.count; i++)
+			{
+				unsigned int item = itemOrder[node.first + i];
+
+				if (!itemBounds[item].IntersectRay(origin, inverseDirection, closestDistance, distance))
+				{
+					continue;
+				}
+				if (exactTest && !exactTest(item, distance))
+				{
+					continue;
+				}
+				if (distance < closestDistance)
+				{
+					closestDistance = distance;
+					closestItem = (int)item;
+				}
+			}
+			continue;
+		}
+
+		Entry left = { node.first, 0.0f };
+		Entry right = { node.first + 1, 0.0f };
+		bool leftHit = nodes[left.node].bounds.IntersectRay(origin, inverseDirection, closestDistance, left.distance);
+		bool rightHit = nodes[right.node].bounds.IntersectRay(origin, inverseDirection, closestDistance, right.distance);
+
+		// Visit the nearer child first (pushed last), so the far one is more likely to be skipped.
+		if (leftHit && rightHit)
+		{
+			if (left.distance <= right.distance)
+			{
+				stack.push_back(right);
+				stack.push_back(left);
+			}
+			else
+			{
+				stack.push_back(left);
+				stack.push_back(right);
+			}
+		}
+		else if (leftHit)
+		{
+			stack.push_back(left);
+		}
+		else if (rightHit)
+		{
+			stack.push_back(right);
+		}
+	}
+
+	hitDistance = closestDistance;
+	return closestItem;
+}
+
+AABB BVH::GetBounds() const
+{
+	if (nodes.empty())
+	{
+		return AABB();
+	}
+	return nodes[0].bounds;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "AABB.h"
+#include <vector>
+#include <functional>
+
+/// <summary>
+/// A bounding volume hierarchy over a set of boxes ("items"), used to find the item hit by a ray without testing every item.
+/// Items keep the index they were built with. When items move, the tree is refitted in place rather than rebuilt.
+/// </summary>
+class BVH
+{
+	public:
+		/// <summary>
+		/// Exact test run on items whose box is hit by the ray. Returns true on a hit, and may lower distance to the exact hit distance.
+		/// </summary>
+		typedef std::function<bool(unsigned int item, float& distance)> ItemTest;
+
+		BVH();
+		~BVH();
+
+		/// <summary>
+		/// Builds the hierarchy over the given boxes, splitting nodes with a binned surface area heuristic.
+		/// </summary>
+		/// <param name="itemBounds">Box of each item. Item i is referred to by index i afterwards.</param>
+		void Build(const std::vector<AABB>& itemBounds);
+
+		/// <summary>
+		/// Updates the box of one item and the boxes of the nodes above it. Stops as soon as a node's box is unchanged,
+		/// so small moves only touch a few nodes. The tree shape is kept: refit quality degrades if items move very far.
+		/// </summary>
+		/// <param name="item">The item that moved.</param>
+		/// <param name="bounds">Its new box.</param>
+		void Refit(unsigned int item, const AABB& bounds);
+
+		/// <summary>
+		/// Finds the closest item hit by a ray.
+		/// </summary>
+		/// <param name="origin">Origin of the ray.</param>
+		/// <param name="direction">Direction of the ray. Doesn't need to be normalized; distances are in multiples of it.</param>
+		/// <param name="maxDistance">Hits further than this are ignored.</param>
+		/// <param name="exactTest">Optional test refining a box hit. Without it, the item boxes are the hit shapes.</param>
+		/// <param name="hitDistance">Set to the distance of the hit, if any.</param>
+		/// <returns>The index of the closest item hit, or -1.</returns>
+		int Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const ItemTest& exactTest, float& hitDistance) const;
+
+		size_t GetItemCount() const { return itemBounds.size(); }
+		const AABB& GetItemBounds(unsigned int item) const { return itemBounds[item]; }
+		/// <summary>
+		/// Returns the box around every item.
+		/// </summary>
+		AABB GetBounds() const;
+
+	private:
+		struct Node
+		{
+			AABB bounds;
+			/// <summary>
+			/// Index of the parent node, -1 for the root.
+			/// </summary>
+			int parent;
+			/// <summary>
+			/// Interior node: index of the first child, the second one follows it. Leaf: offset of the first item in itemOrder.
+			/// </summary>
+			unsigned int first;
+			/// <summary>
+			/// Number of items of a leaf, 0 for an interior node.
+			/// </summary>
+			unsigned int count;
+		};
+
+		/// <summary>
+		/// Splits the node covering itemOrder[begin, end), then its children.
+		/// </summary>
+		void Subdivide(unsigned int node, unsigned int begin, unsigned int end);
+		/// <summary>
+		/// Recomputes the box of a node from its items or children. Returns true if it changed.
+		/// </summary>
+		bool UpdateNodeBounds(unsigned int node);
+
+		std::vector<Node> nodes;
+		std::vector<AABB> itemBounds;
+		/// <summary>
+		/// Item indices, reordered so each leaf's items are contiguous.
+		/// </summary>
+		std::vector<unsigned int> itemOrder;
+		/// <summary>
+		/// The leaf holding each item.
+		/// </summary>
+		std::vector<unsigned int> itemLeaf;
+		/// <summary>
+		/// Centroids of the item boxes, only used while building.
+		/// </summary>
+		std::vector<glm::vec3> centroids;
+};
@@ -1,5 +1,6 @@
 // Modified from Ben Cook's Udemy OpenGL course https://www.udemy.com/course/graphics-with-modern-opengl/
 #include "Camera.h"
+#include "RedrawSignal.h"
 
 
 Camera::Camera(glm::vec3 position, glm::vec3 up, GLfloat yaw, GLfloat pitch, GLfloat movementSpeed, GLfloat turnSpeed){
@@ -33,18 +34,22 @@ void Camera::movementFromKeyboard(bool* keys) { // Configure IJKL key movement
 
 	if (keys[GLFW_KEY_I] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position += front * movementSpeed; // Go forward
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_J] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position -= right * movementSpeed; // Go left
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_K] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position -= front * movementSpeed; // Go backwards
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_L] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position += right * movementSpeed; // Go right
+		RedrawSignal::Request();
 	}
 
 }
@@ -55,18 +60,22 @@ void Camera::movementFromKeyboard(bool* keys, GLfloat deltatime) { // Configure
 
 	if (keys[GLFW_KEY_I] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position += front * velocity; // Go forward
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_J] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position -= right * velocity; // Go left
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_K] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position -= front * velocity; // Go backwards
+		RedrawSignal::Request();
 	}
 
 	if (keys[GLFW_KEY_L] && keys[GLFW_KEY_LEFT_SHIFT]) {
 		position += right * velocity; // Go right
+		RedrawSignal::Request();
 	}
 
 }
@@ -83,6 +92,7 @@ void Camera::pan(bool* keys, GLfloat x) { // When the right button is pressed, m
 		if (yaw < 0.0f) yaw = 360.0f;
 
 		update();
+		RedrawSignal::Request();
 	}
 
 }
@@ -98,6 +108,7 @@ void Camera::tilt(bool* keys, GLfloat y) { // When the down button is pressed, m
 		if (pitch < -50.0f) pitch = -50.0f;
 
 		update();
+		RedrawSignal::Request();
 	}
 
 }
@@ -109,10 +120,19 @@ void Camera::magnify(bool* keys, GLfloat z) { // When the down button is pressed
 		position += front * z; // Go forward
 
 		update();
+		RedrawSignal::Request();
 	}
 
 }
 
+void Camera::setPose(glm::vec3 position, GLfloat yaw, GLfloat pitch) {
+	this->position = position;
+	this->yaw = yaw;
+	this->pitch = pitch;
+
+	update();
+}
+
 glm::mat4 Camera::calculateViewMatrix() {
 	return glm::lookAt(position, position + front, up);
 }
@@ -121,6 +141,22 @@ glm::mat4 Camera::calculateViewMatrix(glm::vec3 eye, glm::vec3 target, glm::vec3
 	return glm::lookAt(eye, target, up);
 }
 
+void Camera::screenPointToRay(GLfloat cursorX, GLfloat cursorY, GLint windowWidth, GLint windowHeight,
+	const glm::mat4& projection, const glm::mat4& view, glm::vec3& origin, glm::vec3& direction) {
+
+	// Window coordinates to normalized device coordinates, where y points up
+	float ndcX = 2.0f * cursorX / windowWidth - 1.0f;
+	float ndcY = 1.0f - 2.0f * cursorY / windowHeight;
+
+	// Undo the projection and view for a point on the near plane and one on the far plane
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
 Camera::~Camera(){
 
 }
\ No newline at end of file
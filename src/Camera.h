@@ -54,6 +54,38 @@ public:
 	/// <param name="up">Where the up direction is situated</param>
 	/// <returns>A 4x4 matrix</returns>
 	glm::mat4 calculateViewMatrix(glm::vec3 eye, glm::vec3 target, glm::vec3 up);
+	/// <summary>
+	/// Gets the position of the camera
+	/// </summary>
+	glm::vec3 getPosition() const { return position; }
+	/// <summary>
+	/// Gets the side-to-side angle of the camera, in degrees
+	/// </summary>
+	GLfloat getYaw() const { return yaw; }
+	/// <summary>
+	/// Gets the up-and-down angle of the camera, in degrees
+	/// </summary>
+	GLfloat getPitch() const { return pitch; }
+	/// <summary>
+	/// Places the camera, e.g. where another camera was
+	/// </summary>
+	/// <param name="position">The position of the camera</param>
+	/// <param name="yaw">The side-to-side angle, in degrees</param>
+	/// <param name="pitch">The up-and-down angle, in degrees</param>
+	void setPose(glm::vec3 position, GLfloat yaw, GLfloat pitch);
+	/// <summary>
+	/// Unprojects a point of the window into the ray going from the camera through it, for mouse picking
+	/// </summary>
+	/// <param name="cursorX">The x position of the point, in window coordinates (0 on the left)</param>
+	/// <param name="cursorY">The y position of the point, in window coordinates (0 at the top)</param>
+	/// <param name="windowWidth">The window width</param>
+	/// <param name="windowHeight">The window height</param>
+	/// <param name="projection">The projection matrix the scene is drawn with</param>
+	/// <param name="view">The view matrix the scene is drawn with</param>
+	/// <param name="origin">Set to the start of the ray, on the near plane</param>
+	/// <param name="direction">Set to the normalized direction of the ray</param>
+	static void screenPointToRay(GLfloat cursorX, GLfloat cursorY, GLint windowWidth, GLint windowHeight,
+		const glm::mat4& projection, const glm::mat4& view, glm::vec3& origin, glm::vec3& direction);
 	
 	/// <summary>
 	/// Deconstructor
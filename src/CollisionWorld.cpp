@@ -0,0 +1,153 @@
+#include "CollisionWorld.h"
+#include "WorkerPool.h"
+
+// Below this many objects per worker, RefitAll uses fewer threads.
+static const size_t MIN_OBJECTS_PER_WORKER = 256;
+
+CollisionWorld::CollisionWorld()
+{
+	root = NULL;
+}
+
+CollisionWorld::~CollisionWorld()
+{
+}
+
+void CollisionWorld::Build(ComplexObject* root)
+{
+	this->root = root;
+	parts.clear();
+	objectFirstPart.clear();
+	objectBounds.clear();
+
+	glm::mat4 rootMatrix = root->GetWorldMatrix(glm::mat4(1.0f));
+	unsigned int next = 0;
+
+	for (unsigned int i = 0; i < root->objectList.size(); i++)
+	{
+		objectFirstPart.push_back(next);
+
+		AABB bounds;
+		VisitParts(root->objectList[i].Get(), rootMatrix, true, next, bounds);
+		objectBounds.push_back(bounds);
+	}
+	objectFirstPart.push_back(next);
+
+	broadPhase.Build(objectBounds);
+}
+
+void CollisionWorld::Refit(unsigned int object)
+{
+	if (root == NULL || object >= objectBounds.size())
+	{
+		return;
+	}
+
+	objectBounds[object] = UpdateParts(object);
+	broadPhase.Update(object, objectBounds[object]);
+}
+
+void CollisionWorld::RefitAll(WorkerPool* pool)
+{
+	if (root == NULL)
+	{
+		return;
+	}
+
+	// Objects own disjoint ranges of parts, so they can be updated in parallel.
+	WorkerPool::Task task = [this](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			objectBounds[i] = UpdateParts((unsigned int)i);
+		}
+	};
+
+	if (pool != NULL)
+	{
+		pool->ParallelFor(objectBounds.size(), task, MIN_OBJECTS_PER_WORKER);
+	}
+	else
+	{
+		task(0, objectBounds.size(), 0);
+	}
+
+	broadPhase.UpdateAll(objectBounds, pool);
+}
+
+bool CollisionWorld::IsColliding(unsigned int object) const
+{
+	if (object >= objectBounds.size())
+	{
+		return false;
+	}
+
+	const std::vector<unsigned int>& others = broadPhase.GetOverlaps(object);
+
+	for (size_t i = 0; i < others.size(); i++)
+	{
+		unsigned int other = others[i];
+
+		for (unsigned int a = objectFirstPart[object]; a < objectFirstPart[object + 1]; a++)
+		{
+			// Skip the other object's parts that can't reach this part.
+			if (!parts[a].bounds.Overlaps(objectBounds[other]))
+			{
+				continue;
+			}
+
+			for (unsigned int b = objectFirstPart[other]; b < objectFirstPart[other + 1]; b++)
+			{
+				if (parts[a].bounds.Overlaps(parts[b].bounds) && ConvexShape::Intersects(parts[a].shape, parts[b].shape))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+AABB CollisionWorld::UpdateParts(unsigned int object)
+{
+	glm::mat4 rootMatrix = root->GetWorldMatrix(glm::mat4(1.0f));
+	unsigned int next = objectFirstPart[object];
+	AABB bounds;
+
+	VisitParts(root->objectList[object].Get(), rootMatrix, false, next, bounds);
+	return bounds;
+}
+
+void CollisionWorld::VisitParts(const ComplexObject* object, const glm::mat4& parentMatrix, bool build, unsigned int& next, AABB& bounds)
+{
+	glm::mat4 objectMatrix = object->GetWorldMatrix(parentMatrix);
+
+	for (size_t i = 0; i < object->meshList.size(); i++)
+	{
+		const Mesh* mesh = object->meshList[i].Get();
+		if (mesh->GetCollisionShape() == ConvexShape::Type::None)
+		{
+			continue;
+		}
+
+		glm::mat4 world = mesh->GetWorldMatrix(objectMatrix);
+		Part part = { mesh, ConvexShape(mesh->GetCollisionShape(), mesh->GetBounds(), world), mesh->GetBounds().Transformed(world) };
+
+		if (build)
+		{
+			parts.push_back(part);
+		}
+		else
+		{
+			parts[next] = part;
+		}
+		bounds.Extend(part.bounds);
+		next++;
+	}
+
+	for (size_t i = 0; i < object->objectList.size(); i++)
+	{
+		VisitParts(object->objectList[i].Get(), objectMatrix, build, next, bounds);
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "SweepAndPrune.h"
+#include "ConvexShape.h"
+#include "ComplexObject.h"
+#include <vector>
+
+class WorkerPool;
+
+/// <summary>
+/// Detects interpenetration between the objects of a scene, so moves that push one object into another can be undone.
+/// Each child object of the root is one collision object, made of the meshes below it that have a collision shape.
+/// A sort and sweep broad phase over the objects' world boxes finds the pairs worth testing, then the parts of each
+/// pair are tested exactly with GJK.
+/// </summary>
+class CollisionWorld
+{
+	public:
+		CollisionWorld();
+		~CollisionWorld();
+
+		/// <summary>
+		/// Builds the collision data of every object below the root.
+		/// </summary>
+		/// <param name="root">The object holding the collision objects. Must outlive the collision world, and be rebuilt if the root itself moves.</param>
+		void Build(ComplexObject* root);
+
+		/// <summary>
+		/// Updates the shapes and box of one object after it moved.
+		/// </summary>
+		/// <param name="object">Index of the object in the root's object list.</param>
+		void Refit(unsigned int object);
+
+		/// <summary>
+		/// Updates every object after many of them moved, sorting the broad phase in one pass instead of object by object.
+		/// </summary>
+		/// <param name="pool">Optional workers to spread the work on.</param>
+		void RefitAll(WorkerPool* pool = NULL);
+
+		/// <summary>
+		/// Returns true if any part of the object overlaps a part of another object.
+		/// </summary>
+		/// <param name="object">Index of the object in the root's object list.</param>
+		bool IsColliding(unsigned int object) const;
+
+		/// <summary>
+		/// Returns the number of object pairs whose boxes overlap, before the exact test.
+		/// </summary>
+		size_t GetBroadPhasePairCount() const { return broadPhase.GetPairCount(); }
+
+		/// <summary>
+		/// Returns the world space box around every part of an object, as of its last refit.
+		/// </summary>
+		/// <param name="object">Index of the object in the root's object list.</param>
+		const AABB& GetObjectBounds(unsigned int object) const { return objectBounds[object]; }
+
+	private:
+		/// <summary>
+		/// One mesh with a collision shape, placed where it is drawn.
+		/// </summary>
+		struct Part
+		{
+			const Mesh* mesh;
+			ConvexShape shape;
+			AABB bounds;
+		};
+
+		/// <summary>
+		/// Recomputes the parts of one object from its meshes, starting at its first part, and returns the box around them.
+		/// </summary>
+		AABB UpdateParts(unsigned int object);
+		/// <summary>
+		/// Walks an object's meshes and children in drawing order. When building, parts are appended; otherwise the
+		/// parts starting at next are updated. Grows bounds to contain every part.
+		/// </summary>
+		void VisitParts(const ComplexObject* object, const glm::mat4& parentMatrix, bool build, unsigned int& next, AABB& bounds);
+
+		ComplexObject* root;
+		std::vector<Part> parts;
+		/// <summary>
+		/// Index of the first part of each object, plus one past the last part at the end. An object's parts are contiguous.
+		/// </summary>
+		std::vector<unsigned int> objectFirstPart;
+		SweepAndPrune broadPhase;
+		/// <summary>
+		/// Box of each object, kept to update the broad phase in one go.
+		/// </summary>
+		std::vector<AABB> objectBounds;
+};
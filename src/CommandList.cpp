@@ -0,0 +1,99 @@
+#include "CommandList.h"
+#include "GLState.h"
+#include <glm/gtc/type_ptr.hpp>
+
+CommandList::CommandList()
+{
+	commands = std::vector<Command>();
+	payload = std::vector<GLfloat>();
+}
+
+CommandList::~CommandList()
+{
+}
+
+void CommandList::Clear()
+{
+	commands.clear();
+	payload.clear();
+}
+
+void CommandList::BindVertexArray(GLuint vertexArray)
+{
+	Command command = { CommandType::BindVertexArray, vertexArray, 0, 0, 0 };
+	commands.push_back(command);
+}
+
+void CommandList::SetUniformMatrix4(GLuint location, const glm::mat4& matrix)
+{
+	Command command = { CommandType::UniformMatrix4, location, 0, 0, (unsigned int)payload.size() };
+	commands.push_back(command);
+
+	const GLfloat* values = glm::value_ptr(matrix);
+	payload.insert(payload.end(), values, values + 16);
+}
+
+void CommandList::SetUniform1(GLuint location, GLfloat value)
+{
+	Command command = { CommandType::Uniform1, location, 0, 0, (unsigned int)payload.size() };
+	commands.push_back(command);
+
+	payload.push_back(value);
+}
+
+void CommandList::SetVertexAttribute4(GLuint index, const glm::vec4& value)
+{
+	Command command = { CommandType::VertexAttribute4, index, 0, 0, (unsigned int)payload.size() };
+	commands.push_back(command);
+
+	const GLfloat* values = glm::value_ptr(value);
+	payload.insert(payload.end(), values, values + 4);
+}
+
+void CommandList::DrawElements(GLenum mode, GLsizei count)
+{
+	Command command = { CommandType::DrawElements, 0, mode, count, 0 };
+	commands.push_back(command);
+}
+
+void CommandList::Append(const CommandList& other)
+{
+	unsigned int offset = (unsigned int)payload.size();
+
+	for (size_t i = 0; i < other.commands.size(); i++)
+	{
+		Command command = other.commands[i];
+		command.payloadOffset += offset;
+		commands.push_back(command);
+	}
+
+	payload.insert(payload.end(), other.payload.begin(), other.payload.end());
+}
+
+void CommandList::Execute() const
+{
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const Command& command = commands[i];
+
+		switch (command.type)
+		{
+			case CommandType::BindVertexArray:
+				GLState::BindVertexArray(command.target);
+				break;
+			case CommandType::UniformMatrix4:
+				GLState::UniformMatrix4fv(command.target, &payload[command.payloadOffset]);
+				break;
+			case CommandType::Uniform1:
+				GLState::Uniform1f(command.target, payload[command.payloadOffset]);
+				break;
+			case CommandType::VertexAttribute4:
+				GLState::VertexAttrib4f(command.target, &payload[command.payloadOffset]);
+				break;
+			case CommandType::DrawElements:
+				// The IBO is part of the VAO state, so the draw only needs the bound vertex array.
+				GLState::DrawElements(command.mode, command.count);
+				break;
+		}
+	}
+}
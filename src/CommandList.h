@@ -0,0 +1,115 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// <summary>
+/// The kind of record held by a CommandList.
+/// </summary>
+enum class CommandType
+{
+	BindVertexArray,
+	UniformMatrix4,
+	Uniform1,
+	VertexAttribute4,
+	DrawElements
+};
+
+/// <summary>
+/// A single recorded command. Values that do not fit in the record itself (matrices, floats) live in the owning list's payload.
+/// </summary>
+struct Command
+{
+	CommandType type;
+	/// <summary>
+	/// Vertex array, uniform location or attribute index, depending on the type.
+	/// </summary>
+	GLuint target;
+	/// <summary>
+	/// Primitive type of a draw.
+	/// </summary>
+	GLenum mode;
+	/// <summary>
+	/// Index count of a draw.
+	/// </summary>
+	GLsizei count;
+	/// <summary>
+	/// Offset of this command's values inside the payload.
+	/// </summary>
+	unsigned int payloadOffset;
+};
+
+class CommandList
+{
+	public:
+		/// <summary>
+		/// Creates an empty command list. Recording into a list never touches the GL context, so lists can be filled on any thread.
+		/// </summary>
+		CommandList();
+		~CommandList();
+
+		/// <summary>
+		/// Removes every recorded command, keeping the allocated storage for the next frame.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Records the binding of a vertex array.
+		/// </summary>
+		/// <param name="vertexArray">The vertex array to bind.</param>
+		void BindVertexArray(GLuint vertexArray);
+
+		/// <summary>
+		/// Records the upload of a 4x4 matrix uniform.
+		/// </summary>
+		/// <param name="location">The location of the uniform.</param>
+		/// <param name="matrix">The matrix value, copied into the list.</param>
+		void SetUniformMatrix4(GLuint location, const glm::mat4& matrix);
+
+		/// <summary>
+		/// Records the upload of a float uniform.
+		/// </summary>
+		/// <param name="location">The location of the uniform.</param>
+		/// <param name="value">The float value.</param>
+		void SetUniform1(GLuint location, GLfloat value);
+
+		/// <summary>
+		/// Records the constant value of a vertex attribute whose array is disabled, such as a per draw color.
+		/// </summary>
+		/// <param name="index">The attribute index.</param>
+		/// <param name="value">The value, copied into the list.</param>
+		void SetVertexAttribute4(GLuint index, const glm::vec4& value);
+
+		/// <summary>
+		/// Records an indexed draw of the currently bound vertex array.
+		/// </summary>
+		/// <param name="mode">GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_LINES, GL_POINTS...</param>
+		/// <param name="count">Number of indices to draw.</param>
+		void DrawElements(GLenum mode, GLsizei count);
+
+		/// <summary>
+		/// Appends the commands of another list after the commands of this one.
+		/// </summary>
+		/// <param name="other">The list to merge in.</param>
+		void Append(const CommandList& other);
+
+		/// <summary>
+		/// Replays the recorded commands. Must be called on the thread owning the GL context.
+		/// </summary>
+		void Execute() const;
+
+		/// <summary>
+		/// Returns the number of recorded commands.
+		/// </summary>
+		size_t GetCommandCount() const { return commands.size(); }
+
+	private:
+		/// <summary>
+		/// The recorded commands, in submission order.
+		/// </summary>
+		std::vector<Command> commands;
+		/// <summary>
+		/// Values referenced by the commands.
+		/// </summary>
+		std::vector<GLfloat> payload;
+};
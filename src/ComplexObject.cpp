@@ -1,65 +1,71 @@
 #include "ComplexObject.h"
+#include "CommandList.h"
+#include "TransformStore.h"
+#include "StaticBatch.h"
+#include "RenderStats.h"
+#include <algorithm>
+
+// How long a subtree must stay unchanged before it is baked, in seconds. Long enough that a held key moving an object
+// doesn't rebake it between steps.
+static const double BAKE_SETTLE_TIME = 0.5;
 
 ComplexObject::ComplexObject()
 {
-	meshList = std::vector<Mesh*>();
+	meshList = std::vector<MeshHandle>();
 	uniformObjectModelLocation = 0;
-	objectModelMatrix = new glm::mat4(1.0f);
+	transform = TransformStore::Global().Create();
 
-	objectList = std::vector<ComplexObject*>();
+	objectList = std::vector<ObjectHandle>();
 
 	hasModelMatrix = false;
+
+	transformVersion = 0;
+	contentVersion = 0;
+	bakeVersion = 0;
+	bakeVersionTime = 0.0;
 }
 
 ComplexObject::~ComplexObject()
 {
-	// Clears the objectlist
-	for (int i = 0; i < objectList.size(); i++)
-	{
-		objectList[i]->ClearObject();
-	}
+	Unbake();
 
-	// Clean up the meshlist.
-	for (int i = 0; i < meshList.size(); i++)
+	// Destroying the meshes clears them from the GPU.
+	for (size_t i = 0; i < meshList.size(); i++)
 	{
-		meshList[i]->~Mesh();
-		delete meshList[i];
-	}
-
-	if (hasModelMatrix)
-	{
-		// If we have set the model matrix, clean it up.
-		ResetModelMatrix();
-	}
-	else
-	{
-		// If not, just clean the pointer.
-		delete objectModelMatrix;
-		objectModelMatrix = NULL;
+		IndependentMesh::Destroy(meshList[i]);
 	}
 
 	// Destroy the object list.
-	for (int i = 0; i < objectList.size(); i++)
+	for (size_t i = 0; i < objectList.size(); i++)
 	{
-		objectList[i]->~ComplexObject();
-		delete objectList[i];
+		Destroy(objectList[i]);
 	}
+
+	TransformStore::Global().Destroy(transform);
 }
 
 void ComplexObject::RenderObject()
 {
+	RENDER_STATS_SCOPE(name);
+
 	// If we have a custom transformation...
-	if (hasModelMatrix)
+	if (hasModelMatrix && bakedMesh.IsValid())
+	{
+		glm::mat4 objectModelMatrix = GetModelMatrix();
+		bakedMesh->RenderMesh(objectModelMatrix, uniformObjectModelLocation);
+	}
+	else if (hasModelMatrix)
 	{
 		// ... we apply it to our children, rendering them with it.
+		glm::mat4 objectModelMatrix = GetModelMatrix();
 		for (int i = 0; i < meshList.size(); i++)
 		{
-			meshList[i]->RenderMesh(*objectModelMatrix, uniformObjectModelLocation);
+			meshList[i]->RenderMesh(objectModelMatrix, uniformObjectModelLocation);
 		}
 
 		for (int i = 0; i < objectList.size(); i++)
 		{
-			objectList[i]->RenderObject(*objectModelMatrix, uniformObjectModelLocation);
+			objectList[i]->RenderObject(objectModelMatrix, uniformObjectModelLocation);
 		}
 	}
 	else
@@ -79,12 +85,13 @@ void ComplexObject::RenderObject()
 
 void ComplexObject::RenderObject(glm::mat4& modelMatrix, GLuint uniformModel)
 {
+	RENDER_STATS_SCOPE(name);
 	glm::mat4 model(1.0f);
 
 	if (hasModelMatrix)
 	{
 		// If we have a custom transformation, we combine it with the provided transformation.
-		model = modelMatrix * *objectModelMatrix;
+		model = modelMatrix * GetModelMatrix();
 	}
 	else
 	{
@@ -92,6 +99,12 @@ void ComplexObject::RenderObject(glm::mat4& modelMatrix, GLuint uniformModel)
 		model = modelMatrix;
 	}
 
+	if (bakedMesh.IsValid())
+	{
+		bakedMesh->RenderMesh(model, uniformModel);
+		return;
+	}
+
 	// Rendering our children
 	for (int i = 0; i < meshList.size(); i++)
 	{
@@ -105,8 +118,107 @@ void ComplexObject::RenderObject(glm::mat4& modelMatrix, GLuint uniformModel)
 	
 }
 
+void ComplexObject::RecordObject(CommandList& list, const glm::mat4& modelMatrix, GLuint uniformModel) const
+{
+	// Same composition as RenderObject(modelMatrix, uniformModel).
+	RecordObjectAt(list, GetWorldMatrix(modelMatrix), uniformModel);
+}
+
+void ComplexObject::RecordObjectAt(CommandList& list, const glm::mat4& worldMatrix, GLuint uniformModel) const
+{
+	if (bakedMesh.IsValid())
+	{
+		bakedMesh->RecordMesh(list, worldMatrix, uniformModel);
+		return;
+	}
+
+	for (size_t i = 0; i < meshList.size(); i++)
+	{
+		meshList[i]->RecordMesh(list, worldMatrix, uniformModel);
+	}
+
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		objectList[i]->RecordObject(list, worldMatrix, uniformModel);
+	}
+}
+
+bool ComplexObject::UpdateBake(double time, const glm::mat4* childMatrices)
+{
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		objectList[i]->UpdateBake(time);
+	}
+
+	bool childrenMoved = false;
+	if (childMatrices != NULL)
+	{
+		childrenMoved = bakeChildMatrices.size() != objectList.size() || !std::equal(bakeChildMatrices.begin(), bakeChildMatrices.end(), childMatrices);
+		if (childrenMoved)
+		{
+			bakeChildMatrices.assign(childMatrices, childMatrices + objectList.size());
+		}
+	}
+
+	// Something inside changed: draw the parts one by one until it stops changing
+	unsigned int version = GetBakeVersion();
+	if (version != bakeVersion || childrenMoved)
+	{
+		Unbake();
+		bakeVersion = version;
+		bakeVersionTime = time;
+	}
+
+	if (!bakedMesh.IsValid() && time - bakeVersionTime >= BAKE_SETTLE_TIME)
+	{
+		StaticBatch batch;
+		AddToBatch(batch, glm::mat4(1.0f), childMatrices);
+		if (!batch.IsEmpty())
+		{
+			bakedMesh = batch.Build();
+		}
+	}
+
+	return bakedMesh.IsValid();
+}
+
+void ComplexObject::Unbake()
+{
+	if (bakedMesh.IsValid())
+	{
+		Mesh::Destroy(bakedMesh);
+		bakedMesh = Handle<Mesh>();
+	}
+}
+
+unsigned int ComplexObject::GetBakeVersion() const
+{
+	unsigned int version = contentVersion;
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		version += objectList[i]->transformVersion + objectList[i]->GetBakeVersion();
+	}
+	return version;
+}
+
+void ComplexObject::AddToBatch(StaticBatch& batch, const glm::mat4& matrix, const glm::mat4* childMatrices) const
+{
+	for (size_t i = 0; i < meshList.size(); i++)
+	{
+		batch.Add(*meshList[i], meshList[i]->GetWorldMatrix(matrix));
+	}
+
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		glm::mat4 childMatrix = childMatrices != NULL ? matrix * childMatrices[i] : objectList[i]->GetWorldMatrix(matrix);
+		objectList[i]->AddToBatch(batch, childMatrix, NULL);
+	}
+}
+
 void ComplexObject::ClearObject()
 {
+	Unbake();
+
 	// Clears the meshlist
 	for (int i = 0; i < meshList.size(); i++)
 	{
@@ -122,101 +234,144 @@ void ComplexObject::ClearObject()
 
 void ComplexObject::SetModelMatrix(glm::mat4& matrix, GLuint uniformModelLocation)
 {
-	if (hasModelMatrix) {
-		// Removing the model matrix from gpu
-		glUniform1f((*this).uniformObjectModelLocation, 0.0f);
-	}
-
-	*objectModelMatrix = matrix;
+	TransformStore::Global().SetMatrix(transform, matrix);
 	uniformObjectModelLocation = uniformModelLocation;
 
 	hasModelMatrix = true;
+	transformVersion++;
 }
 
 void ComplexObject::ResetModelMatrix()
 {
 	hasModelMatrix = false;
 
-	// Removing the model matrix from gpu
-	glUniform1f((*this).uniformObjectModelLocation, 0.0f);
-
 	uniformObjectModelLocation = 0;
 
-	delete objectModelMatrix;
-	objectModelMatrix = NULL;
+	TransformStore::Global().Set(transform, TRS());
+	transformVersion++;
 }
 
-glm::mat4& ComplexObject::GetModelMatrix()
+const glm::mat4& ComplexObject::GetModelMatrix() const
 {
-	if (hasModelMatrix)
-		return *objectModelMatrix;
-	else
+	// Without a model matrix set, this is the identity.
+	return TransformStore::Global().GetMatrix(transform);
+}
+
+TRS ComplexObject::GetTransform() const
+{
+	return TransformStore::Global().Get(transform);
+}
+
+void ComplexObject::SetTransform(const TRS& value)
+{
+	TransformStore::Global().Set(transform, value);
+	hasModelMatrix = true;
+	transformVersion++;
+}
+
+void ComplexObject::SetColor(const glm::vec3& color)
+{
+	for (size_t i = 0; i < meshList.size(); i++)
+	{
+		meshList[i]->SetColor(color);
+	}
+	contentVersion++;
+
+	for (size_t i = 0; i < objectList.size(); i++)
 	{
-		// If no matrix has been set for this object, we return a generic identity matrix.
-		// Could throw an exception too, because if someone tries to modify that generic matrix, it wont change this object's matrix.
-		glm::mat4 model = glm::mat4(1.0f);
-		return model;
+		objectList[i]->SetColor(color);
 	}
 }
 
+void ComplexObject::SetHighlight(bool highlight)
+{
+	for (size_t i = 0; i < meshList.size(); i++)
+	{
+		meshList[i]->SetHighlight(highlight);
+	}
+	contentVersion++;
+
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		objectList[i]->SetHighlight(highlight);
+	}
+}
+
+glm::mat4 ComplexObject::GetWorldMatrix(const glm::mat4& parentMatrix) const
+{
+	return hasModelMatrix ? parentMatrix * GetModelMatrix() : parentMatrix;
+}
+
 void ComplexObject::TranslateModel(GLfloat x, GLfloat y, GLfloat z)
 {
-    glm::mat4 model = GetModelMatrix();
-    model = glm::translate(model, glm::vec3(x, y, y));
-    SetModelMatrix(model, uniformObjectModelLocation);
+    TransformStore::Global().Translate(transform, glm::vec3(x, y, z));
+    hasModelMatrix = true;
+    transformVersion++;
 }
 
 void ComplexObject::RotateModel(GLfloat x, GLfloat y, GLfloat z, GLfloat angle){
-    glm::mat4 model = GetModelMatrix();
-    model = glm::rotate(model, angle, glm::vec3(x, y, z));
-    SetModelMatrix(model, uniformObjectModelLocation);
+    TransformStore::Global().Rotate(transform, glm::angleAxis(angle, glm::normalize(glm::vec3(x, y, z))));
+    hasModelMatrix = true;
+    transformVersion++;
 }
 
 void ComplexObject::ScaleModel(GLfloat xScale, GLfloat yScale, GLfloat zScale)
 {
-    glm::mat4 model = GetModelMatrix();
-    model = glm::scale(model, glm::vec3(xScale, yScale, zScale));
-    SetModelMatrix(model, uniformObjectModelLocation);
+    TransformStore::Global().Scale(transform, glm::vec3(xScale, yScale, zScale));
+    hasModelMatrix = true;
+    transformVersion++;
 }
 
-void ComplexObject::Transform(bool* keys)
+bool ComplexObject::Transform(bool* keys)
 {
+    bool transformed = false;
+
     // Move up when capital W is pressed
     if(keys[GLFW_KEY_W] && keys[GLFW_KEY_LEFT_SHIFT])
     {
         TranslateModel(0.0f, 0.05f, 0.0f);
+        transformed = true;
     }
     // Move left when capital A is pressed
     if(keys[GLFW_KEY_A] && keys[GLFW_KEY_LEFT_SHIFT])
     {
         TranslateModel(-0.05f, 0.0f, 0.0f);
+        transformed = true;
     }
     // Move down when capital S is pressed
     if(keys[GLFW_KEY_S] && keys[GLFW_KEY_LEFT_SHIFT])
     {
         TranslateModel(0.0f, -0.05f, 0.0f);
+        transformed = true;
     }
     // Move right when capital D is pressed
     if(keys[GLFW_KEY_D] && keys[GLFW_KEY_LEFT_SHIFT])
     {
         TranslateModel(0.05f, 0.0f, 0.0f);
+        transformed = true;
     }
     // Rotate Model 5deg right
     if(keys[GLFW_KEY_D] && !keys[GLFW_KEY_LEFT_SHIFT])
     {
         RotateModel(0.0f, 1.0f, 0.0f, (5.0f*3.14159f)/180.0f);
+        transformed = true;
     }
     // Rotate Model 5deg left
     if(keys[GLFW_KEY_A] && !keys[GLFW_KEY_LEFT_SHIFT])
     {
         RotateModel(0.0f, 1.0f, 0.0f, -(5.0f*3.14159f)/180.0f);
+        transformed = true;
     }
     // Scale up with U is pressed
     if(keys[GLFW_KEY_U]){
         ScaleModel(1.01f, 1.01f, 1.01f);
+        transformed = true;
     }
     // Scale down with J is pressed
     if(keys[GLFW_KEY_J] && !keys[GLFW_KEY_LEFT_SHIFT]){
         ScaleModel(0.99f, 0.99f, 0.99f);
+        transformed = true;
     }
+
+    return transformed;
 }
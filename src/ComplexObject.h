@@ -1,18 +1,37 @@
 #pragma once
-#include "Mesh.h"
+#include "IndependentMesh.h"
+#include "Pool.h"
+#include "TransformStore.h"
 #include <vector>
+#include <string>
+#include <atomic>
 #include <GLFW/glfw3.h>
 
+class CommandList;
+class StaticBatch;
+
 class ComplexObject
 {
 	public:
 		/// <summary>
 		/// Creates a ComplexObject, an object capable of containing many meshes and many other complex objects. 
-		/// It can also have its own transformations, held in a model matrix.
+		/// It can also have its own transformations, held as translation, rotation and scale in the TransformStore.
 		/// </summary>
 		ComplexObject();
+		/// <summary>
+		/// Destroys the object's meshes and child objects along with it.
+		/// </summary>
 		~ComplexObject();
 
+		/// <summary>
+		/// Creates an empty complex object in the shared object pool.
+		/// </summary>
+		static Handle<ComplexObject> Create() { return Pool<ComplexObject>::Global().Create(); }
+		/// <summary>
+		/// Destroys a complex object created with Create, with its meshes and child objects.
+		/// </summary>
+		static void Destroy(Handle<ComplexObject> object) { Pool<ComplexObject>::Global().Destroy(object); }
+
 		/// <summary>
 		/// Renders the complex object on screen.
 		/// </summary>
@@ -25,19 +44,56 @@ class ComplexObject
 		/// <param name="uniformModel">The location of the uniform variable the Model Matrix is tied to.</param>
 		void RenderObject(glm::mat4& modelMatrix, GLuint uniformModel);
 
+		/// <summary>
+		/// Records the draws of RenderObject(modelMatrix, uniformModel) into a command list. Only reads the object, so
+		/// different objects can be recorded from different threads at the same time.
+		/// </summary>
+		/// <param name="list">The list to record into.</param>
+		/// <param name="modelMatrix">The model matrix value.</param>
+		/// <param name="uniformModel">The location of the uniform variable the Model Matrix is tied to.</param>
+		void RecordObject(CommandList& list, const glm::mat4& modelMatrix, GLuint uniformModel) const;
+		/// <summary>
+		/// Records the draws of the object placed by the given world matrix instead of its own transformation, which
+		/// isn't read. Lets the object be drawn where a snapshot of the scene says it is while it is being moved elsewhere.
+		/// </summary>
+		/// <param name="list">The list to record into.</param>
+		/// <param name="worldMatrix">The matrix placing the object in the world, parent transformations included.</param>
+		/// <param name="uniformModel">The location of the uniform variable the Model Matrix is tied to.</param>
+		void RecordObjectAt(CommandList& list, const glm::mat4& worldMatrix, GLuint uniformModel) const;
+
+		/// <summary>
+		/// Bakes the object's whole subtree into one mesh, drawn in a single call in place of its parts, once nothing in it
+		/// changed for a moment. Any change inside it (a child's transformation, a color or highlight set through the
+		/// objects) unbakes it, and it rebakes once it settles again. The object's own transformation isn't baked in:
+		/// it is still applied when drawing, so moving the whole subtree keeps it baked. Child objects keep their own
+		/// bakes, drawn while this one is unbaked.
+		/// Call once per frame, on the thread owning the GL context. Transformations edited straight in the TransformStore
+		/// (e.g. by an Animator) go unnoticed unless passed in childMatrices.
+		/// </summary>
+		/// <param name="time">The current time, in seconds.</param>
+		/// <param name="childMatrices">One matrix per child object to bake it with, in place of its own transformation,
+		/// which isn't read. Lets the subtree be baked where a snapshot of the scene says it is. May be NULL.</param>
+		/// <returns>True if the object is baked.</returns>
+		bool UpdateBake(double time, const glm::mat4* childMatrices = NULL);
+		/// <summary>
+		/// Frees the baked mesh, if any. The parts are drawn one by one until the next bake.
+		/// </summary>
+		void Unbake();
+		bool IsBaked() const { return bakedMesh.IsValid(); }
+
 		/// <summary>
 		/// Clears the object from the GPU.
 		/// </summary>
 		void ClearObject();
 
 		/// <summary>
-		/// The list of meshes inside this object.
+		/// The list of meshes inside this object. The object owns them and destroys them with itself.
 		/// </summary>
-		std::vector<Mesh*> meshList;
+		std::vector<MeshHandle> meshList;
 		/// <summary>
-		/// The list of other complex objects inside this object.
+		/// The list of other complex objects inside this object. The object owns them and destroys them with itself.
 		/// </summary>
-		std::vector<ComplexObject*> objectList;
+		std::vector<Handle<ComplexObject>> objectList;
 
 		/// <summary>
 		/// Sets the model matrix of this object, to apply custom transformations to the entire object.
@@ -54,8 +110,28 @@ class ComplexObject
 		/// <summary>
 		/// Returns the current model matrix tied to this object.
 		/// </summary>
-		/// <returns>A reference to the mat4 of values corresponding to the model matrix</returns>
-		glm::mat4& GetModelMatrix();
+		/// <returns>A reference to the mat4 of values corresponding to the model matrix, the identity if none was set.</returns>
+		const glm::mat4& GetModelMatrix() const;
+
+		/// <summary>
+		/// Returns the transformation of this object as translation, rotation and scale.
+		/// </summary>
+		TRS GetTransform() const;
+		/// <summary>
+		/// Sets the transformation of this object from translation, rotation and scale, keeping the uniform location.
+		/// </summary>
+		void SetTransform(const TRS& value);
+		/// <summary>
+		/// Returns the index of this object's transformation in the global TransformStore, for systems editing many
+		/// transformations at once such as the Animator. Edits only show once the object has a model matrix set.
+		/// </summary>
+		unsigned int GetTransformIndex() const { return transform; }
+
+		/// <summary>
+		/// Returns the transformation this object's children are drawn with under the given parent transformation.
+		/// </summary>
+		/// <param name="parentMatrix">The accumulated model matrix of the parents.</param>
+		glm::mat4 GetWorldMatrix(const glm::mat4& parentMatrix) const;
 
         /// <summary>
         // Translates model.
@@ -82,17 +158,37 @@ class ComplexObject
         // <param name="zScale">Amount to scale in the z direction.</param>
         void ScaleModel(GLfloat xScale, GLfloat yScale, GLfloat zScale);
 
+        /// <summary>
+        /// Sets the color of every mesh in this object and in its children.
+        /// </summary>
+        /// <param name="color">Red, green and blue, from 0 to 1.</param>
+        void SetColor(const glm::vec3& color);
+
+        /// <summary>
+        /// Turns the selection highlight of every mesh in this object and in its children on or off.
+        /// </summary>
+        void SetHighlight(bool highlight);
+
+        /// <summary>
+        /// Names the object, so RenderStats counts what its subtree draws under that name. Unnamed objects count only
+        /// for the named objects around them.
+        /// </summary>
+        void SetName(const std::string& name) { this->name = name; }
+        const std::string& GetName() const { return name; }
+
         /// <summary>
         // Transforms model based on keyboard input
         // </summary>
         // <param name="keys">Array of pressed keys.</param>
-        void Transform(bool* keys);
+        // <returns>True if the model was moved, rotated or scaled.</returns>
+        bool Transform(bool* keys);
 
 	private:
+		std::string name;
 		/// <summary>
-		/// The model matrix of this object.
+		/// The index of this object's transformation in the global TransformStore, which composes it into the model matrix.
 		/// </summary>
-		glm::mat4* objectModelMatrix;
+		unsigned int transform;
 		/// <summary>
 		/// The location of the uniform variable tied to this object's model matrix.
 		/// </summary>
@@ -101,5 +197,33 @@ class ComplexObject
 		/// Determines if this object has a model matrix tied to it currently. True if yes, false otherwise.
 		/// </summary>
 		bool hasModelMatrix;
+
+		/// <summary>
+		/// Returns a number that changes whenever something baked into this object's mesh does: its colors and
+		/// highlight, and its child objects' transformations and contents.
+		/// </summary>
+		unsigned int GetBakeVersion() const;
+		/// <summary>
+		/// Adds the meshes of the subtree to a batch, each transformed by its matrix relative to this object.
+		/// </summary>
+		/// <param name="matrix">This object's matrix in the batch's space.</param>
+		/// <param name="childMatrices">Matrices of the child objects, or NULL to use their own transformations.</param>
+		void AddToBatch(StaticBatch& batch, const glm::mat4& matrix, const glm::mat4* childMatrices) const;
+
+		// Counters bumped by every change of the object's own transformation, and of its colors or highlight. Changes can
+		// come from the thread moving the object while another bakes it.
+		std::atomic<unsigned int> transformVersion;
+		std::atomic<unsigned int> contentVersion;
+		/// <summary>
+		/// The subtree merged into one mesh, null while unbaked.
+		/// </summary>
+		Handle<Mesh> bakedMesh;
+		/// <summary>
+		/// The bake version UpdateBake last saw, when it first saw it, and the child matrices it was given then.
+		/// </summary>
+		unsigned int bakeVersion;
+		double bakeVersionTime;
+		std::vector<glm::mat4> bakeChildMatrices;
 };
 
+typedef Handle<ComplexObject> ObjectHandle;
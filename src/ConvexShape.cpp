@@ -0,0 +1,285 @@
+#include "ConvexShape.h"
+#include <cmath>
+#include <algorithm>
+
+// GJK converges in a handful of iterations for the shapes used here. Nearly touching curved shapes can take many more, so it gives up after this many.
+static const int GJK_MAX_ITERATIONS = 64;
+// Squared distance from the origin to the simplex, relative to the squared size of the simplex, under which the shapes touch.
+static const float GJK_EPSILON = 1e-10f;
+
+ConvexShape::ConvexShape()
+{
+	type = Type::None;
+	center = glm::vec3(0.0f);
+	extents = glm::vec3(0.0f);
+	axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+	axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+	axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+	origin = glm::vec3(0.0f);
+}
+
+ConvexShape::ConvexShape(Type type, const AABB& localBounds, const glm::mat4& world)
+{
+	this->type = type;
+	center = localBounds.GetCenter();
+	extents = localBounds.GetExtents();
+
+	for (int i = 0; i < 3; i++)
+	{
+		axes[i] = glm::vec3(world[i]);
+	}
+	origin = glm::vec3(world[3]);
+}
+
+glm::vec3 ConvexShape::Support(const glm::vec3& direction) const
+{
+	// The support point of a transformed shape is the transformed support point along the direction seen from local space,
+	// which for an affine transformation is the transpose of its linear part applied to the direction.
+	glm::vec3 local(glm::dot(axes[0], direction), glm::dot(axes[1], direction), glm::dot(axes[2], direction));
+	glm::vec3 point = center;
+
+	if (type == Type::Box)
+	{
+		point.x += local.x >= 0.0f ? extents.x : -extents.x;
+		point.y += local.y >= 0.0f ? extents.y : -extents.y;
+		point.z += local.z >= 0.0f ? extents.z : -extents.z;
+	}
+	else if (type == Type::Sphere)
+	{
+		// The ellipsoid is the unit sphere scaled by the extents, so scale the direction the same way before normalizing.
+		glm::vec3 scaled = extents * local;
+		float length = glm::length(scaled);
+		if (length > 0.0f)
+		{
+			point += extents * (scaled / length);
+		}
+	}
+
+	return origin + axes[0] * point.x + axes[1] * point.y + axes[2] * point.z;
+}
+
+// GJK keeps a simplex of up to 4 points of the Minkowski difference, and the point v of it closest to the origin.
+// The functions below find v and drop the simplex points it doesn't depend on. They follow the Voronoi region tests
+// of Ericson's Real-Time Collision Detection, with the query point at the origin.
+
+static glm::vec3 ClosestOnSegment(glm::vec3* simplex, int& count)
+{
+	glm::vec3 a = simplex[0];
+	glm::vec3 ab = simplex[1] - a;
+	float lengthSquared = glm::dot(ab, ab);
+	float t = lengthSquared > 0.0f ? -glm::dot(a, ab) / lengthSquared : 0.0f;
+
+	if (t <= 0.0f)
+	{
+		count = 1;
+		return a;
+	}
+	if (t >= 1.0f)
+	{
+		simplex[0] = simplex[1];
+		count = 1;
+		return simplex[0];
+	}
+	return a + ab * t;
+}
+
+static glm::vec3 ClosestOnTriangle(glm::vec3* simplex, int& count)
+{
+	glm::vec3 a = simplex[0];
+	glm::vec3 b = simplex[1];
+	glm::vec3 c = simplex[2];
+	glm::vec3 ab = b - a;
+	glm::vec3 ac = c - a;
+
+	float d1 = -glm::dot(ab, a);
+	float d2 = -glm::dot(ac, a);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		count = 1;
+		return a;
+	}
+
+	float d3 = -glm::dot(ab, b);
+	float d4 = -glm::dot(ac, b);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		simplex[0] = b;
+		count = 1;
+		return b;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		count = 2;
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	float d5 = -glm::dot(ab, c);
+	float d6 = -glm::dot(ac, c);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		simplex[0] = c;
+		count = 1;
+		return c;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		simplex[1] = c;
+		count = 2;
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+	{
+		simplex[0] = b;
+		simplex[1] = c;
+		count = 2;
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	float sum = va + vb + vc;
+	if (sum <= 0.0f)
+	{
+		// Degenerate (flat) triangle that the tests above didn't resolve: use its longest edge.
+		glm::vec3 bc = c - b;
+		float abLength = glm::dot(ab, ab), acLength = glm::dot(ac, ac), bcLength = glm::dot(bc, bc);
+		if (acLength >= abLength && acLength >= bcLength)
+		{
+			simplex[1] = c;
+		}
+		else if (bcLength >= abLength)
+		{
+			simplex[0] = c;
+		}
+		count = 2;
+		return ClosestOnSegment(simplex, count);
+	}
+
+	count = 3;
+	return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+static glm::vec3 ClosestOnTetrahedron(glm::vec3* simplex, int& count)
+{
+	// Each face, listed with the vertex opposite to it.
+	const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };
+
+	glm::vec3 best(0.0f);
+	float bestDistance = -1.0f;
+	glm::vec3 bestSimplex[3];
+	int bestCount = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		glm::vec3 a = simplex[faces[i][0]];
+		glm::vec3 normal = glm::cross(simplex[faces[i][1]] - a, simplex[faces[i][2]] - a);
+		float originSide = -glm::dot(normal, a);
+		float oppositeSide = glm::dot(normal, simplex[faces[i][3]] - a);
+
+		// Only faces with the origin on their outer side can hold the closest point. A flat tetrahedron has no inside,
+		// so all of its faces are candidates.
+		bool flat = oppositeSide * oppositeSide <= 1e-12f * glm::dot(normal, normal) * glm::dot(normal, normal);
+		if (!flat && originSide * oppositeSide >= 0.0f)
+		{
+			continue;
+		}
+
+		glm::vec3 face[3] = { a, simplex[faces[i][1]], simplex[faces[i][2]] };
+		int faceCount = 3;
+		glm::vec3 point = ClosestOnTriangle(face, faceCount);
+		float distance = glm::dot(point, point);
+
+		if (bestDistance < 0.0f || distance < bestDistance)
+		{
+			best = point;
+			bestDistance = distance;
+			bestCount = faceCount;
+			for (int j = 0; j < faceCount; j++)
+			{
+				bestSimplex[j] = face[j];
+			}
+		}
+	}
+
+	if (bestDistance < 0.0f)
+	{
+		// The origin is inside on every face.
+		return glm::vec3(0.0f);
+	}
+
+	count = bestCount;
+	for (int i = 0; i < bestCount; i++)
+	{
+		simplex[i] = bestSimplex[i];
+	}
+	return best;
+}
+
+bool ConvexShape::Intersects(const ConvexShape& a, const ConvexShape& b)
+{
+	if (a.type == Type::None || b.type == Type::None)
+	{
+		return false;
+	}
+
+	// GJK on the Minkowski difference a - b, which contains the origin if and only if the shapes overlap.
+	glm::vec3 direction = b.origin - a.origin;
+	if (glm::dot(direction, direction) <= 0.0f)
+	{
+		direction = glm::vec3(1.0f, 0.0f, 0.0f);
+	}
+
+	glm::vec3 simplex[4];
+	int count = 0;
+	glm::vec3 closest = a.Support(direction) - b.Support(-direction);
+	float scale = glm::dot(closest, closest);
+
+	for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++)
+	{
+		float closestSquared = glm::dot(closest, closest);
+		if (closestSquared <= GJK_EPSILON * scale)
+		{
+			// The origin is on (or numerically indistinguishable from) the simplex.
+			return true;
+		}
+
+		// The point of the difference furthest towards the origin.
+		glm::vec3 point = a.Support(-closest) - b.Support(closest);
+		if (glm::dot(closest, point) > 0.0f)
+		{
+			// Even that point is on the far side of the plane through v facing the origin: the plane separates them.
+			return false;
+		}
+
+		simplex[count++] = point;
+		scale = std::max(scale, glm::dot(point, point));
+
+		if (count == 1)
+		{
+			closest = point;
+		}
+		else if (count == 2)
+		{
+			closest = ClosestOnSegment(simplex, count);
+		}
+		else if (count == 3)
+		{
+			closest = ClosestOnTriangle(simplex, count);
+		}
+		else
+		{
+			closest = ClosestOnTetrahedron(simplex, count);
+			if (count == 4)
+			{
+				return true;
+			}
+		}
+	}
+
+	// Didn't converge, which only happens when the shapes are touching or nearly so.
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "AABB.h"
+
+/// <summary>
+/// A convex shape placed in the world by an affine transformation, for exact overlap tests between mesh parts.
+/// The shape is described in the mesh's local space by the mesh's box: either the box itself, or the ellipsoid inscribed in it.
+/// </summary>
+struct ConvexShape
+{
+	/// <summary>
+	/// The kind of shape a mesh collides as.
+	/// </summary>
+	enum class Type
+	{
+		/// <summary>
+		/// The mesh doesn't collide.
+		/// </summary>
+		None,
+		/// <summary>
+		/// The ellipsoid inscribed in the mesh's box (a sphere for a sphere mesh).
+		/// </summary>
+		Sphere,
+		/// <summary>
+		/// The mesh's box.
+		/// </summary>
+		Box
+	};
+
+	Type type;
+	/// <summary>
+	/// Center and half size of the shape, in local space.
+	/// </summary>
+	glm::vec3 center;
+	glm::vec3 extents;
+	/// <summary>
+	/// Columns of the local to world transformation: the three axes, then the translation.
+	/// </summary>
+	glm::vec3 axes[3];
+	glm::vec3 origin;
+
+	ConvexShape();
+	/// <summary>
+	/// Creates the shape of a mesh.
+	/// </summary>
+	/// <param name="type">The kind of shape.</param>
+	/// <param name="localBounds">The box of the mesh, in its local space.</param>
+	/// <param name="world">The transformation the mesh is drawn with.</param>
+	ConvexShape(Type type, const AABB& localBounds, const glm::mat4& world);
+
+	/// <summary>
+	/// Returns the point of the shape furthest along a direction, in world space.
+	/// </summary>
+	/// <param name="direction">The direction, in world space. Doesn't need to be normalized.</param>
+	glm::vec3 Support(const glm::vec3& direction) const;
+
+	/// <summary>
+	/// Returns true if two shapes overlap or touch, using GJK on their support functions.
+	/// </summary>
+	static bool Intersects(const ConvexShape& a, const ConvexShape& b);
+};
@@ -0,0 +1,118 @@
+#include "DynamicResolution.h"
+#include <cmath>
+
+const float DynamicResolution::MINIMUM_SCALE = 0.5f;
+
+// Timer queries in the ring. Results are usually available two frames later.
+static const size_t QUERY_COUNT = 4;
+// Weight of each new frame time in the smoothed one.
+static const double SMOOTHING = 0.2;
+// The scale is raised when frames take less than this fraction of the budget, and aims at TARGET_FRACTION of it when
+// it changes, so it doesn't flip between two scales.
+static const double HEADROOM_FRACTION = 0.75;
+static const double TARGET_FRACTION = 0.9;
+// Frames measured at a new scale before changing it again.
+static const unsigned int SETTLE_FRAMES = 8;
+// Largest change of the scale at once, and the step it is rounded to.
+static const float MAXIMUM_STEP = 0.15f;
+static const float SCALE_STEP = 1.0f / 32.0f;
+
+DynamicResolution::DynamicResolution()
+{
+	oldest = 0;
+	pending = 0;
+	budget = 1.0 / 60.0;
+	gpuTime = 0.0;
+	scale = 1.0f;
+	framesSinceChange = 0;
+}
+
+void DynamicResolution::BeginFrame()
+{
+	if (queries.empty())
+	{
+		queries.resize(QUERY_COUNT);
+		glGenQueries((GLsizei)queries.size(), queries.data());
+	}
+
+	// Only one query of the ring may be used at a time; waiting only happens if the GPU is a whole ring behind.
+	if (pending == queries.size())
+	{
+		ReadOldest(true);
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[(oldest + pending) % queries.size()]);
+}
+
+void DynamicResolution::EndFrame()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	pending++;
+
+	while (pending > 0 && ReadOldest(false))
+	{
+	}
+}
+
+bool DynamicResolution::ReadOldest(bool wait)
+{
+	GLuint query = queries[oldest];
+	if (!wait)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			return false;
+		}
+	}
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+	oldest = (oldest + 1) % queries.size();
+	pending--;
+
+	Adjust(nanoseconds * 1e-9);
+	return true;
+}
+
+void DynamicResolution::Adjust(double frameTime)
+{
+	gpuTime = gpuTime > 0.0 ? gpuTime + (frameTime - gpuTime) * SMOOTHING : frameTime;
+
+	framesSinceChange++;
+	if (framesSinceChange < SETTLE_FRAMES)
+	{
+		return;
+	}
+	if (gpuTime <= budget && (gpuTime >= budget * HEADROOM_FRACTION || scale >= 1.0f))
+	{
+		return;
+	}
+
+	// The pixel count, and so the GPU time, goes with the square of the scale.
+	float target = scale * (float)std::sqrt(budget * TARGET_FRACTION / gpuTime);
+	target = std::fmax(std::fmin(target, scale + MAXIMUM_STEP), scale - MAXIMUM_STEP);
+	target = std::round(target / SCALE_STEP) * SCALE_STEP;
+	target = std::fmax(std::fmin(target, 1.0f), MINIMUM_SCALE);
+	if (target == scale)
+	{
+		return;
+	}
+
+	// The frames timed from here on were mostly drawn at the old scale: restart the average at the expected time.
+	gpuTime *= (target * target) / (scale * scale);
+	scale = target;
+	framesSinceChange = 0;
+}
+
+void DynamicResolution::Clear()
+{
+	if (!queries.empty())
+	{
+		glDeleteQueries((GLsizei)queries.size(), queries.data());
+		queries.clear();
+	}
+	oldest = 0;
+	pending = 0;
+}
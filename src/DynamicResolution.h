@@ -0,0 +1,73 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+
+/// <summary>
+/// Picks the resolution scale of the scene to keep the GPU time of a frame within a budget. The GPU time of each frame
+/// is measured with a timer query, read back a few frames later so it never stalls, and the scale is lowered when the
+/// frames run over budget and raised again when they have room to spare. GPU time grows with the pixel count, that is
+/// with the square of the scale.
+/// Must be used on the thread owning the GL context, and cleared before the context is destroyed.
+/// </summary>
+class DynamicResolution
+{
+	public:
+		DynamicResolution();
+
+		/// <summary>
+		/// Sets the GPU time a frame should take, in seconds.
+		/// </summary>
+		void SetBudget(double seconds) { budget = seconds; }
+		double GetBudget() const { return budget; }
+
+		/// <summary>
+		/// Returns the scale to render at this frame, between MINIMUM_SCALE and 1, applied to both dimensions.
+		/// </summary>
+		float GetScale() const { return scale; }
+		/// <summary>
+		/// Returns the smoothed GPU time of the last frames measured, in seconds.
+		/// </summary>
+		double GetGPUTime() const { return gpuTime; }
+
+		/// <summary>
+		/// Starts timing the GPU work of the frame. Call before drawing it.
+		/// </summary>
+		void BeginFrame();
+		/// <summary>
+		/// Stops timing the frame, reads the timings that became available and adjusts the scale.
+		/// </summary>
+		void EndFrame();
+
+		/// <summary>
+		/// Deletes the queries. Call before destroying the context.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Lowest scale used, however long frames take.
+		/// </summary>
+		static const float MINIMUM_SCALE;
+
+	private:
+		/// <summary>
+		/// Reads the oldest query's result and adjusts the scale to it.
+		/// </summary>
+		/// <param name="wait">True to wait for the result, false to give up if it isn't available.</param>
+		/// <returns>True if the result was read.</returns>
+		bool ReadOldest(bool wait);
+		void Adjust(double frameTime);
+
+		// Ring of timer queries, the oldest pending one first
+		std::vector<GLuint> queries;
+		size_t oldest;
+		size_t pending;
+
+		double budget;
+		double gpuTime;
+		float scale;
+		/// <summary>
+		/// Frames measured since the scale last changed. Frames still in flight were drawn at the old scale.
+		/// </summary>
+		unsigned int framesSinceChange;
+};
@@ -0,0 +1,87 @@
+#include "FixedStepThread.h"
+#include <chrono>
+
+// After falling further behind than this many steps (a stall, a breakpoint), the missed steps are dropped instead of
+// being run back to back.
+static const int MAX_CATCH_UP_STEPS = 5;
+
+FixedStepThread::FixedStepThread()
+{
+	stepTime = 0.0;
+	stopping = false;
+	woken = false;
+}
+
+FixedStepThread::~FixedStepThread()
+{
+	Stop();
+}
+
+void FixedStepThread::Start(double stepTime, const std::function<bool()>& step)
+{
+	Stop();
+
+	this->stepTime = stepTime;
+	this->step = step;
+	stopping = false;
+	woken = false;
+	thread = std::thread(&FixedStepThread::Run, this);
+}
+
+void FixedStepThread::Stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeCondition.notify_one();
+	thread.join();
+}
+
+void FixedStepThread::Wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		woken = true;
+	}
+	wakeCondition.notify_one();
+}
+
+void FixedStepThread::Run()
+{
+	typedef std::chrono::steady_clock Clock;
+	const Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepTime));
+	Clock::time_point next = Clock::now();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping)
+	{
+		woken = false;
+		lock.unlock();
+		bool active = step();
+		lock.lock();
+
+		if (active || woken)
+		{
+			// Steps are scheduled from the previous one's start rather than its end, so the rate doesn't drift with
+			// how long they take. Steps running late are run back to back until caught up.
+			next += interval;
+			Clock::time_point now = Clock::now();
+			if (next < now - interval * MAX_CATCH_UP_STEPS)
+			{
+				next = now;
+			}
+			wakeCondition.wait_until(lock, next, [this] { return stopping; });
+		}
+		else
+		{
+			wakeCondition.wait(lock, [this] { return stopping || woken; });
+			next = Clock::now();
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/// <summary>
+/// Runs a step function on its own thread at a fixed rate, so what it simulates advances at the same speed whatever
+/// the frame rate. When a step reports that nothing is going on, the thread sleeps until woken instead of stepping
+/// an idle simulation.
+/// </summary>
+class FixedStepThread
+{
+	public:
+		FixedStepThread();
+		/// <summary>
+		/// Stops the thread if it is running.
+		/// </summary>
+		~FixedStepThread();
+
+		/// <summary>
+		/// Starts calling step every stepTime seconds on a new thread. The first step runs right away.
+		/// </summary>
+		/// <param name="stepTime">Seconds between steps.</param>
+		/// <param name="step">The step. Returns true to keep stepping, false to sleep until Wake is called.</param>
+		void Start(double stepTime, const std::function<bool()>& step);
+		/// <summary>
+		/// Waits for the current step to finish and stops the thread.
+		/// </summary>
+		void Stop();
+
+		/// <summary>
+		/// Makes a sleeping thread step again, or keeps a running one stepping after its current step. Call it from
+		/// any thread after handing the step something new to process.
+		/// </summary>
+		void Wake();
+
+		double GetStepTime() const { return stepTime; }
+
+	private:
+		void Run();
+
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wakeCondition;
+		std::function<bool()> step;
+		double stepTime;
+		// Guarded by mutex
+		bool stopping;
+		bool woken;
+};
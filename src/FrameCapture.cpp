@@ -0,0 +1,296 @@
+#include "FrameCapture.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+
+// Buffers in the ring. A read back usually finishes within two frames; the third keeps CaptureFrame from waiting on it.
+static const size_t RING_SIZE = 3;
+// Frames converted and written at most behind the render thread. Beyond that, new frames are dropped.
+static const size_t MAX_QUEUED_FRAMES = 8;
+// Longest wait on a read back, in nanoseconds. Long enough for any frame, short enough not to hang on a lost context.
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+// Chroma of pure blue or red rounds up to 256.
+static unsigned char ClampByte(int value)
+{
+	return (unsigned char)(value > 255 ? 255 : value);
+}
+
+FrameCapture::FrameCapture()
+{
+	file = NULL;
+	width = 0;
+	height = 0;
+	oldest = 0;
+	inFlight = 0;
+	stopping = false;
+	written = 0;
+	captured = 0;
+	dropped = 0;
+	captureTimeSum = 0.0;
+	captureTimeMaximum = 0.0;
+}
+
+bool FrameCapture::Start(const char* path, int width, int height, int framesPerSecond)
+{
+	Stop();
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		printf("Could not create capture file %s\n", path);
+		return false;
+	}
+
+	// Full range BT.601, the matrix the conversion in WriteFrame uses.
+	fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond);
+
+	this->width = width;
+	this->height = height;
+	oldest = 0;
+	inFlight = 0;
+	stopping = false;
+	written = 0;
+	captured = 0;
+	dropped = 0;
+	captureTimeSum = 0.0;
+	captureTimeMaximum = 0.0;
+
+	// Written by the GPU, read once by the CPU.
+	slots.resize(RING_SIZE);
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		glGenBuffers(1, &slots[i].buffer);
+		GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].buffer);
+		GPUMemory::BufferData(GL_PIXEL_PACK_BUFFER, slots[i].buffer, GPUMemoryCategory::PixelBuffer, (GLsizeiptr)width * height * 4, NULL, GL_STREAM_READ);
+		slots[i].fence = 0;
+	}
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	writer = std::thread(&FrameCapture::WriteFrames, this);
+	return true;
+}
+
+void FrameCapture::CaptureFrame(int bufferWidth, int bufferHeight)
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	double start = glfwGetTime();
+
+	// Hand over whatever finished reading back, waiting only if the whole ring is still in flight.
+	while (inFlight > 0 && CollectOldest(false))
+	{
+	}
+	if (inFlight == slots.size())
+	{
+		CollectOldest(true);
+	}
+
+	// Reading into a bound pack buffer returns at once; the copy happens on the GPU, after the frame's draws.
+	Slot& slot = slots[(oldest + inFlight) % slots.size()];
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ROW_LENGTH, width);
+	glReadPixels(0, 0, bufferWidth < width ? bufferWidth : width, bufferHeight < height ? bufferHeight : height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	inFlight++;
+	captured++;
+
+	double elapsed = glfwGetTime() - start;
+	captureTimeSum += elapsed;
+	if (elapsed > captureTimeMaximum)
+	{
+		captureTimeMaximum = elapsed;
+	}
+}
+
+bool FrameCapture::CollectOldest(bool wait)
+{
+	Slot& slot = slots[oldest];
+
+	// Flushing makes sure the fence reaches the GPU, or waiting on it could never end.
+	GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FENCE_TIMEOUT : 0);
+	if (result == GL_TIMEOUT_EXPIRED && !wait)
+	{
+		return false;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	// Drop the frame if the writer is too far behind, otherwise take a spare buffer for its pixels.
+	std::vector<unsigned char> pixels;
+	bool keep;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		keep = queue.size() < MAX_QUEUED_FRAMES;
+		if (keep && !spareFrames.empty())
+		{
+			pixels.swap(spareFrames.back());
+			spareFrames.pop_back();
+		}
+	}
+
+	if (keep)
+	{
+		GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+		keep = mapped != NULL;
+		if (keep)
+		{
+			pixels.resize((size_t)width * height * 4);
+			memcpy(pixels.data(), mapped, pixels.size());
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	if (keep)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(std::vector<unsigned char>());
+			queue.back().swap(pixels);
+		}
+		queueCondition.notify_one();
+	}
+	else
+	{
+		dropped++;
+	}
+
+	oldest = (oldest + 1) % slots.size();
+	inFlight--;
+	return true;
+}
+
+void FrameCapture::Stop()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	// Frames still reading back are waited for and written too.
+	while (inFlight > 0)
+	{
+		CollectOldest(true);
+	}
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		GLState::DeleteBuffer(slots[i].buffer);
+	}
+	slots.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queueCondition.notify_one();
+	writer.join();
+
+	fclose(file);
+	file = NULL;
+	spareFrames.clear();
+}
+
+FrameCapture::Stats FrameCapture::GetStats()
+{
+	Stats stats;
+	stats.captured = captured;
+	stats.dropped = dropped;
+	stats.averageCaptureTime = captured > 0 ? captureTimeSum / captured : 0.0;
+	stats.maximumCaptureTime = captureTimeMaximum;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.written = written;
+	return stats;
+}
+
+void FrameCapture::WriteFrames()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (queue.empty())
+		{
+			// Stopping, with every frame written.
+			return;
+		}
+
+		std::vector<unsigned char> pixels;
+		pixels.swap(queue.front());
+		queue.pop_front();
+
+		lock.unlock();
+		WriteFrame(pixels);
+		lock.lock();
+
+		written++;
+		spareFrames.push_back(std::vector<unsigned char>());
+		spareFrames.back().swap(pixels);
+	}
+}
+
+void FrameCapture::WriteFrame(const std::vector<unsigned char>& pixels)
+{
+	// 4:2:0: full resolution luma, then each chroma plane at half resolution, rounded up.
+	int chromaWidth = (width + 1) / 2;
+	int chromaHeight = (height + 1) / 2;
+	size_t lumaSize = (size_t)width * height;
+	size_t chromaSize = (size_t)chromaWidth * chromaHeight;
+	planes.resize(lumaSize + 2 * chromaSize);
+	unsigned char* luma = planes.data();
+	unsigned char* blue = luma + lumaSize;
+	unsigned char* red = blue + chromaSize;
+
+	// GL rows go bottom up, video rows top down. Full range BT.601 in 8.8 fixed point; the chroma offsets of 128 are
+	// added as 32768 before the shift, which keeps the sums positive.
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = &pixels[(size_t)(height - 1 - y) * width * 4];
+		unsigned char* lumaRow = luma + (size_t)y * width;
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* pixel = row + x * 4;
+			lumaRow[x] = (unsigned char)((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+		}
+	}
+
+	for (int y = 0; y < chromaHeight; y++)
+	{
+		int top = height - 1 - 2 * y;
+		int bottom = top > 0 ? top - 1 : top;
+		const unsigned char* rows[2] = { &pixels[(size_t)top * width * 4], &pixels[(size_t)bottom * width * 4] };
+		for (int x = 0; x < chromaWidth; x++)
+		{
+			// Average the 2x2 block, repeating the last column or row on odd sizes.
+			int left = 2 * x;
+			int right = left + 1 < width ? left + 1 : left;
+			int r = 0, g = 0, b = 0;
+			for (int i = 0; i < 2; i++)
+			{
+				const unsigned char* a = rows[i] + left * 4;
+				const unsigned char* c = rows[i] + right * 4;
+				r += a[0] + c[0];
+				g += a[1] + c[1];
+				b += a[2] + c[2];
+			}
+			r = (r + 2) >> 2;
+			g = (g + 2) >> 2;
+			b = (b + 2) >> 2;
+
+			blue[(size_t)y * chromaWidth + x] = ClampByte((-43 * r - 85 * g + 128 * b + 32768 + 128) >> 8);
+			red[(size_t)y * chromaWidth + x] = ClampByte((128 * r - 107 * g - 21 * b + 32768 + 128) >> 8);
+		}
+	}
+
+	fputs("FRAME\n", file);
+	fwrite(planes.data(), 1, planes.size(), file);
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdio>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/// <summary>
+/// Records the frames drawn into a Y4M video without stalling the GPU. Each frame is read back into the next pixel
+/// buffer object of a ring, and only mapped once its fence has signalled, a few frames later. The pixels are then
+/// converted to YUV 4:2:0 and written by a background thread. If the writer falls behind, frames are dropped rather
+/// than holding up rendering.
+/// Must be used on the thread owning the GL context, and stopped before the context is destroyed.
+/// </summary>
+class FrameCapture
+{
+	public:
+		/// <summary>
+		/// Counters of the capture so far. The capture time is what CaptureFrame costs the render thread per frame, in seconds.
+		/// </summary>
+		struct Stats
+		{
+			unsigned int captured;
+			unsigned int written;
+			unsigned int dropped;
+			double averageCaptureTime;
+			double maximumCaptureTime;
+		};
+
+		FrameCapture();
+
+		/// <summary>
+		/// Creates the video file and the read back buffers, and starts the writer thread.
+		/// </summary>
+		/// <param name="path">The Y4M file to write.</param>
+		/// <param name="width">Width of the frames, in pixels.</param>
+		/// <param name="height">Height of the frames, in pixels.</param>
+		/// <param name="framesPerSecond">Frame rate written in the file. Frames are recorded as drawn, so it should match the swap rate.</param>
+		/// <returns>False if the file couldn't be created.</returns>
+		bool Start(const char* path, int width, int height, int framesPerSecond);
+		/// <summary>
+		/// Reads the back buffer into the ring, and hands the frames whose read back finished to the writer.
+		/// Call after drawing a frame and before swapping buffers. Does nothing unless capturing.
+		/// </summary>
+		/// <param name="bufferWidth">Current width of the framebuffer. Only the part inside the video's size is read.</param>
+		/// <param name="bufferHeight">Current height of the framebuffer.</param>
+		void CaptureFrame(int bufferWidth, int bufferHeight);
+		/// <summary>
+		/// Waits for the frames still being read back and written, closes the file and frees the buffers.
+		/// </summary>
+		void Stop();
+
+		bool IsCapturing() const { return file != NULL; }
+		Stats GetStats();
+
+	private:
+		/// <summary>
+		/// A buffer of the ring and the fence of the read back into it, 0 when it is free.
+		/// </summary>
+		struct Slot
+		{
+			GLuint buffer;
+			GLsync fence;
+		};
+
+		/// <summary>
+		/// Maps the oldest slot's buffer once its read back finished and queues a copy of the pixels for the writer.
+		/// </summary>
+		/// <param name="wait">True to wait for the read back, false to give up if it isn't finished.</param>
+		/// <returns>True if the slot was freed.</returns>
+		bool CollectOldest(bool wait);
+		/// <summary>
+		/// Converts and writes the queued frames until stopped. Runs on the writer thread.
+		/// </summary>
+		void WriteFrames();
+		/// <summary>
+		/// Writes one frame of bottom-up RGBA pixels as a Y4M frame.
+		/// </summary>
+		void WriteFrame(const std::vector<unsigned char>& pixels);
+
+		FILE* file;
+		int width;
+		int height;
+
+		std::vector<Slot> slots;
+		size_t oldest;
+		size_t inFlight;
+
+		std::thread writer;
+		// Guarded by mutex: the frames waiting to be written, spare pixel buffers, and the writer's counters.
+		std::mutex mutex;
+		std::condition_variable queueCondition;
+		std::deque<std::vector<unsigned char>> queue;
+		std::vector<std::vector<unsigned char>> spareFrames;
+		bool stopping;
+		unsigned int written;
+
+		// Converted planes, on the writer thread
+		std::vector<unsigned char> planes;
+
+		unsigned int captured;
+		unsigned int dropped;
+		double captureTimeSum;
+		double captureTimeMaximum;
+};
@@ -0,0 +1,119 @@
+#include "FramePacer.h"
+#include <GLFW/glfw3.h>
+#include <cstddef>
+
+// Longest wait on a single fence, in seconds. Long enough for any frame, short enough not to hang on a lost context.
+static const double FENCE_TIMEOUT = 1.0;
+// Step of the wait on a fence between handling input events, in nanoseconds.
+static const GLuint64 POLL_INTERVAL = 500000;
+// Without a bound on frames in flight, fences beyond this many are waited on anyway, so they can't pile up.
+static const size_t MAX_TRACKED_FRAMES = 16;
+
+FramePacer::FramePacer()
+{
+	swapInterval = 1;
+	maxFramesInFlight = 0;
+	latencyCount = 0;
+	latencySum = 0.0;
+	latencyMinimum = 0.0;
+	latencyMaximum = 0.0;
+}
+
+void FramePacer::SetSwapInterval(int interval)
+{
+	swapInterval = interval;
+	glfwSwapInterval(interval);
+}
+
+void FramePacer::BeginFrame()
+{
+	// Frames already finished cost nothing to retire, and the earlier they are, the more precise their latency.
+	while (!frames.empty() && RetireOldest(false))
+	{
+	}
+
+	while (maxFramesInFlight > 0 && frames.size() >= maxFramesInFlight)
+	{
+		RetireOldest(true);
+	}
+}
+
+void FramePacer::EndFrame(double inputTime)
+{
+	FrameInFlight frame;
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.inputTime = inputTime;
+	frames.push_back(frame);
+
+	while (frames.size() > MAX_TRACKED_FRAMES)
+	{
+		RetireOldest(true);
+	}
+}
+
+bool FramePacer::RetireOldest(bool wait)
+{
+	FrameInFlight& frame = frames.front();
+
+	// Flushing makes sure the fence reaches the GPU, or waiting on it could never end.
+	GLenum result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (wait)
+	{
+		// Wait in short steps, handling input in between: GLFW timestamps nothing, so input is stamped when it is
+		// handled, and handling it while waiting keeps those stamps close to when it arrived.
+		double deadline = glfwGetTime() + FENCE_TIMEOUT;
+		while (result == GL_TIMEOUT_EXPIRED && glfwGetTime() < deadline)
+		{
+			glfwPollEvents();
+			result = glClientWaitSync(frame.fence, 0, POLL_INTERVAL);
+		}
+	}
+	else if (result == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+
+	// The frame is done (or the wait failed, in which case there is nothing better to do than to let it go).
+	if (frame.inputTime >= 0.0 && (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED))
+	{
+		double latency = glfwGetTime() - frame.inputTime;
+		if (latencyCount == 0 || latency < latencyMinimum)
+		{
+			latencyMinimum = latency;
+		}
+		if (latencyCount == 0 || latency > latencyMaximum)
+		{
+			latencyMaximum = latency;
+		}
+		latencySum += latency;
+		latencyCount++;
+	}
+
+	glDeleteSync(frame.fence);
+	frames.pop_front();
+	return true;
+}
+
+FramePacer::LatencyStats FramePacer::ConsumeLatencyStats()
+{
+	LatencyStats stats;
+	stats.count = latencyCount;
+	stats.average = latencyCount > 0 ? latencySum / latencyCount : 0.0;
+	stats.minimum = latencyMinimum;
+	stats.maximum = latencyMaximum;
+
+	latencyCount = 0;
+	latencySum = 0.0;
+	latencyMinimum = 0.0;
+	latencyMaximum = 0.0;
+	return stats;
+}
+
+void FramePacer::Clear()
+{
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		glDeleteSync(frames[i].fence);
+	}
+	frames.clear();
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <GL/glew.h>
+#include <deque>
+
+/// <summary>
+/// Controls how far the CPU runs ahead of the display, and measures the latency from input to finished frame.
+/// Each frame ends with a fence; BeginFrame waits on the oldest fences until fewer than the allowed number of frames
+/// are queued, so input sampled right after it is as fresh as the queue allows. A frame that responded to an input
+/// reports the time between that input and its fence signalling.
+/// Must be used on the thread owning the GL context, and cleared before the context is destroyed.
+/// </summary>
+class FramePacer
+{
+	public:
+		/// <summary>
+		/// Input to frame latencies collected since the last call to ConsumeLatencyStats, in seconds. Measured from when the
+		/// application handled the input event to when the GPU finished the first frame drawn after it, which with vsync is
+		/// shown at the next refresh.
+		/// </summary>
+		struct LatencyStats
+		{
+			unsigned int count;
+			double average;
+			double minimum;
+			double maximum;
+		};
+
+		FramePacer();
+
+		/// <summary>
+		/// Sets the number of vertical blanks to wait for before swapping buffers: 0 for no vsync, 1 for every refresh,
+		/// -1 for adaptive vsync where the driver supports it. Applies to the current context.
+		/// </summary>
+		void SetSwapInterval(int interval);
+		int GetSwapInterval() const { return swapInterval; }
+
+		/// <summary>
+		/// Sets how many frames may be submitted and not finished by the GPU at once. 1 gives the lowest latency,
+		/// 0 leaves it to the driver.
+		/// </summary>
+		void SetMaxFramesInFlight(unsigned int count) { maxFramesInFlight = count; }
+		unsigned int GetMaxFramesInFlight() const { return maxFramesInFlight; }
+
+		/// <summary>
+		/// Call before sampling input. Collects the frames the GPU finished, and waits for the oldest ones if too many are queued,
+		/// handling window events while it waits.
+		/// </summary>
+		void BeginFrame();
+
+		/// <summary>
+		/// Call right after swapping buffers. Marks the end of the frame's GPU work.
+		/// </summary>
+		/// <param name="inputTime">glfwGetTime() of the oldest input the frame responded to, or a negative value if none.</param>
+		void EndFrame(double inputTime);
+
+		/// <summary>
+		/// Returns the latencies of the frames finished since the last call, and starts collecting anew.
+		/// </summary>
+		LatencyStats ConsumeLatencyStats();
+
+		/// <summary>
+		/// Deletes the fences of the frames still in flight without waiting for them. Call before destroying the context.
+		/// </summary>
+		void Clear();
+
+	private:
+		struct FrameInFlight
+		{
+			GLsync fence;
+			double inputTime;
+		};
+
+		/// <summary>
+		/// Retires the oldest frame in flight, once its fence signalled, recording its latency.
+		/// </summary>
+		/// <param name="wait">True to block until the fence signals, false to only check it.</param>
+		/// <returns>True if the frame was retired.</returns>
+		bool RetireOldest(bool wait);
+
+		int swapInterval;
+		unsigned int maxFramesInFlight;
+		std::deque<FrameInFlight> frames;
+
+		unsigned int latencyCount;
+		double latencySum;
+		double latencyMinimum;
+		double latencyMaximum;
+};
@@ -0,0 +1,60 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+	// Planes with no normal keep every point.
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// Gribb and Hartmann: a clip space point is inside when -w <= x, y, z <= w, and each of those six inequalities
+	// is a plane made of the fourth row of the matrix plus or minus one of the other rows.
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	Frustum frustum;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		frustum.planes[axis * 2] = rows[3] + rows[axis];
+		frustum.planes[axis * 2 + 1] = rows[3] - rows[axis];
+	}
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(frustum.planes[i]));
+		if (length > 0.0f)
+		{
+			frustum.planes[i] /= length;
+		}
+	}
+	return frustum;
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	if (box.IsEmpty())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < 6; i++)
+	{
+		// The corner of the box furthest along the plane's normal: if even it is outside, the whole box is.
+		glm::vec3 normal(planes[i]);
+		glm::vec3 corner(normal.x >= 0.0f ? box.max.x : box.min.x,
+			normal.y >= 0.0f ? box.max.y : box.min.y,
+			normal.z >= 0.0f ? box.max.z : box.min.z);
+		if (glm::dot(normal, corner) + planes[i].w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
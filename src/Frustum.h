@@ -0,0 +1,31 @@
+#pragma once
+#include "AABB.h"
+
+/// <summary>
+/// The volume seen through a camera, as six planes facing inwards. Used to skip drawing objects outside of a view.
+/// </summary>
+struct Frustum
+{
+	/// <summary>
+	/// Planes as (normal, distance): a point p is on the inner side of a plane when dot(normal, p) + distance >= 0.
+	/// In order left, right, bottom, top, near, far.
+	/// </summary>
+	glm::vec4 planes[6];
+
+	/// <summary>
+	/// Creates a frustum containing everything.
+	/// </summary>
+	Frustum();
+
+	/// <summary>
+	/// Extracts the frustum of a camera from its projection * view matrix, with OpenGL's -1 to 1 clip depth.
+	/// The planes are in the space the matrix transforms from, usually world space.
+	/// </summary>
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns false if the box is certainly outside. Boxes near a corner of the frustum may be kept although
+	/// outside, which only costs drawing them for nothing.
+	/// </summary>
+	bool Intersects(const AABB& box) const;
+};
@@ -0,0 +1,505 @@
+#include "GLCapture.h"
+#include "GLState.h"
+#include <cstring>
+#include <algorithm>
+
+const char GLCapture::MAGIC[4] = { 'G', 'L', 'C', 'S' };
+const unsigned int GLCapture::VERSION;
+
+FILE* GLCapture::file = NULL;
+std::string GLCapture::path;
+unsigned int GLCapture::framesLeft = 0;
+unsigned int GLCapture::framesCaptured = 0;
+size_t GLCapture::bytesWritten = 0;
+bool GLCapture::failed = false;
+std::unordered_set<GLuint> GLCapture::buffers;
+std::unordered_set<GLuint> GLCapture::programs;
+std::unordered_map<GLuint, GLCapture::VertexArrayFormat> GLCapture::vertexArrays;
+
+// Most vertex attributes looked at in a vertex array. The renderer uses the first two.
+static const GLint MAX_CAPTURED_ATTRIBUTES = 16;
+// Constant vertex attribute values saved at the start, as many as GLState caches.
+static const GLuint CAPTURED_CONSTANT_ATTRIBUTES = 8;
+
+bool GLCapture::VertexAttribute::operator==(const VertexAttribute& other) const
+{
+	return index == other.index && buffer == other.buffer && size == other.size && type == other.type &&
+		normalized == other.normalized && stride == other.stride && offset == other.offset;
+}
+
+bool GLCapture::Start(const char* path, unsigned int frameCount, int width, int height)
+{
+	if (file != NULL)
+	{
+		Stop();
+	}
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		printf("Couldn't create the GL capture file %s\n", path);
+		return false;
+	}
+
+	GLCapture::path = path;
+	framesLeft = std::max(frameCount, 1u);
+	framesCaptured = 0;
+	bytesWritten = 0;
+	failed = false;
+	buffers.clear();
+	programs.clear();
+	vertexArrays.clear();
+
+	WriteBytes(MAGIC, sizeof(MAGIC));
+	WriteUint(VERSION);
+	WriteInt(width);
+	WriteInt(height);
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	WriteString(renderer != NULL ? renderer : "");
+
+	// The state set before the capture, which the frames rely on.
+	static const GLenum capabilities[] = { GL_DEPTH_TEST, GL_PRIMITIVE_RESTART, GL_SCISSOR_TEST, GL_BLEND, GL_CULL_FACE };
+	for (size_t i = 0; i < sizeof(capabilities) / sizeof(capabilities[0]); i++)
+	{
+		Enable(capabilities[i], glIsEnabled(capabilities[i]) == GL_TRUE);
+	}
+
+	GLint restartIndex = 0;
+	glGetIntegerv(GL_PRIMITIVE_RESTART_INDEX, &restartIndex);
+	WriteOp(GLCaptureOp::PrimitiveRestartIndex);
+	WriteUint((unsigned int)restartIndex);
+
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	ClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+	GLint box[4];
+	glGetIntegerv(GL_VIEWPORT, box);
+	Viewport(box[0], box[1], box[2], box[3]);
+	glGetIntegerv(GL_SCISSOR_BOX, box);
+	Scissor(box[0], box[1], box[2], box[3]);
+
+	GLint polygonModes[2] = { GL_FILL, GL_FILL };
+	glGetIntegerv(GL_POLYGON_MODE, polygonModes);
+	PolygonMode((GLenum)polygonModes[0]);
+
+	// Attribute 0 always comes from an array; the others may be constants set long before the capture.
+	for (GLuint i = 1; i < CAPTURED_CONSTANT_ATTRIBUTES; i++)
+	{
+		GLfloat value[4];
+		glGetVertexAttribfv(i, GL_CURRENT_VERTEX_ATTRIB, value);
+		VertexAttrib4f(i, value);
+	}
+
+	// GLState skips binds and uploads matching what it last did, which the file hasn't seen: make it issue them again.
+	GLState::Invalidate();
+	return true;
+}
+
+void GLCapture::Stop()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	if (fclose(file) != 0)
+	{
+		failed = true;
+	}
+	file = NULL;
+
+	if (failed)
+	{
+		printf("Couldn't write the GL capture file %s\n", path.c_str());
+	}
+	else
+	{
+		printf("Captured the GL calls of %u frames to %s (%.1f MB)\n", framesCaptured, path.c_str(), bytesWritten / (1024.0 * 1024.0));
+	}
+	buffers.clear();
+	programs.clear();
+	vertexArrays.clear();
+}
+
+void GLCapture::EndFrame()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	WriteOp(GLCaptureOp::EndFrame);
+	framesCaptured++;
+	if (--framesLeft == 0)
+	{
+		Stop();
+	}
+}
+
+void GLCapture::Enable(GLenum capability, bool enable)
+{
+	WriteOp(enable ? GLCaptureOp::Enable : GLCaptureOp::Disable);
+	WriteUint(capability);
+}
+
+void GLCapture::ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	GLfloat color[4] = { red, green, blue, alpha };
+	WriteOp(GLCaptureOp::ClearColor);
+	WriteFloats(color, 4);
+}
+
+void GLCapture::Clear(GLbitfield mask)
+{
+	WriteOp(GLCaptureOp::Clear);
+	WriteUint(mask);
+}
+
+void GLCapture::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	WriteOp(GLCaptureOp::Viewport);
+	WriteInt(x);
+	WriteInt(y);
+	WriteInt(width);
+	WriteInt(height);
+}
+
+void GLCapture::Scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	WriteOp(GLCaptureOp::Scissor);
+	WriteInt(x);
+	WriteInt(y);
+	WriteInt(width);
+	WriteInt(height);
+}
+
+void GLCapture::PolygonMode(GLenum mode)
+{
+	WriteOp(GLCaptureOp::PolygonMode);
+	WriteUint(mode);
+}
+
+void GLCapture::UseProgram(GLuint program)
+{
+	if (program != 0 && programs.find(program) == programs.end())
+	{
+		CreateProgram(program);
+	}
+	WriteOp(GLCaptureOp::UseProgram);
+	WriteUint(program);
+}
+
+void GLCapture::BindVertexArray(GLuint vertexArray)
+{
+	if (vertexArray != 0)
+	{
+		// Read the array as it is now: meshes and terrain chunks may have changed it since it was last saved.
+		VertexArrayFormat format = ReadVertexArrayFormat();
+		CreateBuffer(format.elementBuffer);
+		for (size_t i = 0; i < format.attributes.size(); i++)
+		{
+			CreateBuffer(format.attributes[i].buffer);
+		}
+
+		std::unordered_map<GLuint, VertexArrayFormat>::iterator saved = vertexArrays.find(vertexArray);
+		if (saved == vertexArrays.end())
+		{
+			WriteOp(GLCaptureOp::CreateVertexArray);
+			WriteVertexArrayFormat(vertexArray, format);
+			vertexArrays[vertexArray] = format;
+		}
+		else if (!(saved->second == format))
+		{
+			WriteOp(GLCaptureOp::VertexArrayFormat);
+			WriteVertexArrayFormat(vertexArray, format);
+			saved->second = format;
+		}
+	}
+
+	WriteOp(GLCaptureOp::BindVertexArray);
+	WriteUint(vertexArray);
+}
+
+void GLCapture::Uniform(GLCaptureOp op, GLint location, const void* values)
+{
+	int count = op == GLCaptureOp::UniformMatrix4fv ? 16 : op == GLCaptureOp::Uniform4fv ? 4 : 1;
+
+	WriteOp(op);
+	WriteInt(location);
+	for (int i = 0; i < count; i++)
+	{
+		unsigned int bits;
+		memcpy(&bits, (const unsigned char*)values + i * sizeof(bits), sizeof(bits));
+		WriteUint(bits);
+	}
+}
+
+void GLCapture::VertexAttrib4f(GLuint index, const GLfloat* value)
+{
+	WriteOp(GLCaptureOp::VertexAttrib4f);
+	WriteUint(index);
+	WriteFloats(value, 4);
+}
+
+void GLCapture::DrawElements(GLenum mode, GLsizei count)
+{
+	WriteOp(GLCaptureOp::DrawElements);
+	WriteUint(mode);
+	WriteInt(count);
+}
+
+void GLCapture::BufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage)
+{
+	if (buffers.find(buffer) == buffers.end())
+	{
+		return;
+	}
+
+	WriteOp(GLCaptureOp::BufferData);
+	WriteUint(buffer);
+	WriteUint(usage);
+	WriteUint64((unsigned long long)size);
+	WriteBytes(data != NULL ? "\1" : "\0", 1);
+	if (data != NULL)
+	{
+		WriteBytes(data, (size_t)size);
+	}
+}
+
+void GLCapture::BufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	if (buffers.find(buffer) == buffers.end())
+	{
+		return;
+	}
+
+	WriteOp(GLCaptureOp::BufferSubData);
+	WriteUint(buffer);
+	WriteUint64((unsigned long long)offset);
+	WriteUint64((unsigned long long)size);
+	WriteBytes(data, (size_t)size);
+}
+
+void GLCapture::DeleteBuffer(GLuint buffer)
+{
+	buffers.erase(buffer);
+}
+
+void GLCapture::DeleteVertexArray(GLuint vertexArray)
+{
+	vertexArrays.erase(vertexArray);
+}
+
+void GLCapture::DeleteProgram(GLuint program)
+{
+	programs.erase(program);
+}
+
+GLCapture::VertexArrayFormat GLCapture::ReadVertexArrayFormat()
+{
+	VertexArrayFormat format;
+	GLint elementBuffer = 0;
+	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+	format.elementBuffer = (GLuint)elementBuffer;
+
+	GLint attributeCount = 0;
+	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attributeCount);
+	attributeCount = std::min(attributeCount, MAX_CAPTURED_ATTRIBUTES);
+	for (GLint i = 0; i < attributeCount; i++)
+	{
+		GLint enabled = 0;
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+		if (!enabled)
+		{
+			continue;
+		}
+
+		VertexAttribute attribute;
+		GLint buffer = 0, type = 0;
+		void* pointer = NULL;
+		attribute.index = (GLuint)i;
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attribute.size);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attribute.normalized);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &attribute.stride);
+		glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &pointer);
+		attribute.buffer = (GLuint)buffer;
+		attribute.type = (GLenum)type;
+		attribute.offset = (unsigned long long)(size_t)pointer;
+		format.attributes.push_back(attribute);
+	}
+	return format;
+}
+
+void GLCapture::WriteVertexArrayFormat(GLuint vertexArray, const VertexArrayFormat& format)
+{
+	WriteUint(vertexArray);
+	WriteUint(format.elementBuffer);
+	WriteUint((unsigned int)format.attributes.size());
+	for (size_t i = 0; i < format.attributes.size(); i++)
+	{
+		const VertexAttribute& attribute = format.attributes[i];
+		WriteUint(attribute.index);
+		WriteUint(attribute.buffer);
+		WriteInt(attribute.size);
+		WriteUint(attribute.type);
+		WriteBytes(attribute.normalized ? "\1" : "\0", 1);
+		WriteInt(attribute.stride);
+		WriteUint64(attribute.offset);
+	}
+}
+
+void GLCapture::CreateBuffer(GLuint buffer)
+{
+	if (buffer == 0 || buffers.find(buffer) != buffers.end())
+	{
+		return;
+	}
+	buffers.insert(buffer);
+
+	// Read back through a target GLState doesn't track, so its cache stays right.
+	GLint size = 0, usage = GL_STATIC_DRAW;
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+	std::vector<unsigned char> data((size_t)size);
+	if (size > 0)
+	{
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, data.data());
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	WriteOp(GLCaptureOp::CreateBuffer);
+	WriteUint(buffer);
+	WriteUint((unsigned int)usage);
+	WriteUint64((unsigned long long)size);
+	WriteBytes(data.data(), data.size());
+}
+
+// Returns the number of 32 bit values of a uniform of the given type, or 0 for the types the renderer doesn't use.
+static int GetUniformComponents(GLenum type, bool& isFloat)
+{
+	isFloat = true;
+	switch (type)
+	{
+		case GL_FLOAT: return 1;
+		case GL_FLOAT_VEC2: return 2;
+		case GL_FLOAT_VEC3: return 3;
+		case GL_FLOAT_VEC4: return 4;
+		case GL_FLOAT_MAT4: return 16;
+	}
+	isFloat = false;
+	switch (type)
+	{
+		case GL_INT:
+		case GL_BOOL:
+		case GL_SAMPLER_2D:
+			return 1;
+	}
+	return 0;
+}
+
+void GLCapture::CreateProgram(GLuint program)
+{
+	programs.insert(program);
+
+	// Shaders are deleted once linked, but stay attached to their program, sources included.
+	GLuint shaders[8];
+	GLsizei shaderCount = 0;
+	glGetAttachedShaders(program, 8, &shaderCount, shaders);
+
+	WriteOp(GLCaptureOp::CreateProgram);
+	WriteUint(program);
+	WriteUint((unsigned int)shaderCount);
+	for (GLsizei i = 0; i < shaderCount; i++)
+	{
+		GLint type = 0, length = 0;
+		glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+		glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length);
+		std::string source((size_t)std::max(length, 1), '\0');
+		glGetShaderSource(shaders[i], (GLsizei)source.size(), NULL, &source[0]);
+		source.resize(strlen(source.c_str()));
+
+		WriteUint((unsigned int)type);
+		WriteString(source);
+	}
+
+	// Uniforms set before the capture keep their values; later uploads are recorded as they happen.
+	GLint uniformCount = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	WriteUint((unsigned int)uniformCount);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		char name[256];
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+		GLint location = glGetUniformLocation(program, name);
+
+		bool isFloat;
+		int components = location >= 0 ? GetUniformComponents(type, isFloat) : 0;
+		unsigned int values[16] = {};
+		if (components > 0 && isFloat)
+		{
+			glGetUniformfv(program, location, (GLfloat*)values);
+		}
+		else if (components > 0)
+		{
+			glGetUniformiv(program, location, (GLint*)values);
+		}
+
+		WriteInt(location);
+		WriteUint(type);
+		WriteString(name);
+		WriteUint((unsigned int)components);
+		for (int j = 0; j < components; j++)
+		{
+			WriteUint(values[j]);
+		}
+	}
+}
+
+void GLCapture::WriteOp(GLCaptureOp op)
+{
+	unsigned char value = (unsigned char)op;
+	WriteBytes(&value, 1);
+}
+
+void GLCapture::WriteUint(unsigned int value)
+{
+	unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+	WriteBytes(bytes, sizeof(bytes));
+}
+
+void GLCapture::WriteUint64(unsigned long long value)
+{
+	WriteUint((unsigned int)value);
+	WriteUint((unsigned int)(value >> 32));
+}
+
+void GLCapture::WriteFloats(const GLfloat* values, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		unsigned int bits;
+		memcpy(&bits, &values[i], sizeof(bits));
+		WriteUint(bits);
+	}
+}
+
+void GLCapture::WriteString(const std::string& text)
+{
+	WriteUint((unsigned int)text.size());
+	WriteBytes(text.data(), text.size());
+}
+
+void GLCapture::WriteBytes(const void* data, size_t size)
+{
+	if (size > 0 && fwrite(data, 1, size, file) != size)
+	{
+		failed = true;
+	}
+	bytesWritten += size;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+/// <summary>
+/// The records of a GL capture file, each followed by its operands.
+/// </summary>
+enum class GLCaptureOp : unsigned char
+{
+	// Resources as they were when first used in the capture. Created once, before the replay starts drawing.
+	CreateBuffer,		// u32 buffer, u32 usage, u64 size, the bytes
+	CreateVertexArray,	// u32 vertex array, then its format as in VertexArrayFormat
+	CreateProgram,		// u32 program, u32 shader count, per shader: u32 type, string source;
+						// u32 uniform count, per uniform: i32 location, u32 type, string name, u32 value count, 32 bit values
+
+	// Calls made by the captured frames, replayed every time
+	BufferData,			// u32 buffer, u32 usage, u64 size, u8 has data, the bytes if any
+	BufferSubData,		// u32 buffer, u64 offset, u64 size, the bytes
+	VertexArrayFormat,	// u32 vertex array, u32 element buffer, u32 attribute count, per attribute:
+						// u32 index, u32 buffer, i32 size, u32 type, u8 normalized, i32 stride, u64 offset
+	Enable,				// u32 capability
+	Disable,			// u32 capability
+	PrimitiveRestartIndex,	// u32 index
+	ClearColor,			// 4 floats
+	Clear,				// u32 mask
+	Viewport,			// 4 x i32
+	Scissor,			// 4 x i32
+	PolygonMode,		// u32 mode
+	UseProgram,			// u32 program
+	BindVertexArray,	// u32 vertex array
+	Uniform1f,			// i32 location, 1 float
+	Uniform1i,			// i32 location, i32
+	Uniform4fv,			// i32 location, 4 floats
+	UniformMatrix4fv,	// i32 location, 16 floats
+	VertexAttrib4f,		// u32 index, 4 floats
+	DrawElements,		// u32 mode, i32 count of unsigned int indices from the start of the element buffer
+	EndFrame,
+	Count
+};
+
+/// <summary>
+/// Records the GL calls of a number of frames into a file that the GLReplay tool plays back on its own, without the
+/// application, its window or its input. The calls are seen where the renderer makes them: GLState, and GPUMemory and
+/// the buffer updates of the meshes and terrain. The buffers, vertex arrays and programs the frames use are saved as
+/// they are when first used, contents, formats, shader sources and uniform values included, so the file holds
+/// everything needed to draw the frames again.
+/// Offscreen targets aren't captured: the replay draws every frame into a single target of the window's size.
+/// Must only be used from the thread owning the GL context.
+/// </summary>
+class GLCapture
+{
+	public:
+		/// <summary>
+		/// "GLCS", the first four bytes of a capture file, followed by the version, the size of the window, and the
+		/// renderer the capture was made on.
+		/// </summary>
+		static const char MAGIC[4];
+		static const unsigned int VERSION = 1;
+
+		/// <summary>
+		/// Starts capturing into a file, from the next GL call on.
+		/// </summary>
+		/// <param name="path">The file to write.</param>
+		/// <param name="frameCount">Number of frames to capture before stopping on its own.</param>
+		/// <param name="width">Width of the window's framebuffer.</param>
+		/// <param name="height">Height of the window's framebuffer.</param>
+		/// <returns>False if the file couldn't be created.</returns>
+		static bool Start(const char* path, unsigned int frameCount, int width, int height);
+		/// <summary>
+		/// Ends the capture and closes its file. Called by EndFrame after the last frame, or earlier to cut it short.
+		/// </summary>
+		static void Stop();
+		static bool IsCapturing() { return file != NULL; }
+
+		/// <summary>
+		/// Ends the current frame, and the capture after its last one. Call once per frame, before swapping buffers.
+		/// </summary>
+		static void EndFrame();
+
+		// Records a call. Called by GLState and the code updating buffers, only while capturing.
+		static void Enable(GLenum capability, bool enable);
+		static void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+		static void Clear(GLbitfield mask);
+		static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+		static void Scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+		static void PolygonMode(GLenum mode);
+		static void UseProgram(GLuint program);
+		static void BindVertexArray(GLuint vertexArray);
+		/// <summary>
+		/// Records a uniform upload to the current program.
+		/// </summary>
+		/// <param name="op">Uniform1f, Uniform1i, Uniform4fv or UniformMatrix4fv.</param>
+		/// <param name="values">The 1, 4 or 16 values, 32 bits each.</param>
+		static void Uniform(GLCaptureOp op, GLint location, const void* values);
+		static void VertexAttrib4f(GLuint index, const GLfloat* value);
+		static void DrawElements(GLenum mode, GLsizei count);
+		/// <summary>
+		/// Records the allocation of a buffer's storage, after it is made. Buffers not used by the capture yet are
+		/// skipped: they are saved whole when first used.
+		/// </summary>
+		static void BufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+		/// <summary>
+		/// Records an update of part of a buffer, after it is made.
+		/// </summary>
+		static void BufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+		/// <summary>
+		/// Forgets deleted objects, so a recycled name is saved again when used.
+		/// </summary>
+		static void DeleteBuffer(GLuint buffer);
+		static void DeleteVertexArray(GLuint vertexArray);
+		static void DeleteProgram(GLuint program);
+
+	private:
+		struct VertexAttribute
+		{
+			GLuint index;
+			GLuint buffer;
+			GLint size;
+			GLenum type;
+			GLint normalized;
+			GLint stride;
+			unsigned long long offset;
+
+			bool operator==(const VertexAttribute& other) const;
+		};
+
+		struct VertexArrayFormat
+		{
+			GLuint elementBuffer;
+			std::vector<VertexAttribute> attributes;
+
+			bool operator==(const VertexArrayFormat& other) const { return elementBuffer == other.elementBuffer && attributes == other.attributes; }
+		};
+
+		/// <summary>
+		/// Reads the format of the bound vertex array from GL.
+		/// </summary>
+		static VertexArrayFormat ReadVertexArrayFormat();
+		static void WriteVertexArrayFormat(GLuint vertexArray, const VertexArrayFormat& format);
+		/// <summary>
+		/// Saves the buffer's current contents, unless it was already saved.
+		/// </summary>
+		static void CreateBuffer(GLuint buffer);
+		static void CreateProgram(GLuint program);
+
+		static void WriteOp(GLCaptureOp op);
+		static void WriteUint(unsigned int value);
+		static void WriteInt(int value) { WriteUint((unsigned int)value); }
+		static void WriteUint64(unsigned long long value);
+		static void WriteFloats(const GLfloat* values, int count);
+		static void WriteString(const std::string& text);
+		static void WriteBytes(const void* data, size_t size);
+
+		static FILE* file;
+		static std::string path;
+		static unsigned int framesLeft;
+		static unsigned int framesCaptured;
+		static size_t bytesWritten;
+		/// <summary>
+		/// Set when a write fails, reported once the file is closed.
+		/// </summary>
+		static bool failed;
+
+		/// <summary>
+		/// The objects saved so far, and the format each vertex array was last saved with.
+		/// </summary>
+		static std::unordered_set<GLuint> buffers;
+		static std::unordered_set<GLuint> programs;
+		static std::unordered_map<GLuint, VertexArrayFormat> vertexArrays;
+};
@@ -0,0 +1,395 @@
+#include "GLState.h"
+#include "GPUMemory.h"
+#include "GLCapture.h"
+#include "RenderStats.h"
+#include <cstring>
+
+GLuint GLState::program = 0;
+GLuint GLState::vertexArray = 0;
+GLuint GLState::arrayBuffer = 0;
+GLenum GLState::polygonMode = GL_FILL;
+GLfloat GLState::vertexAttributes[GLState::CACHED_ATTRIBUTES][4] = {};
+bool GLState::vertexAttributeKnown[GLState::CACHED_ATTRIBUTES] = {};
+std::unordered_map<GLuint, GLuint> GLState::elementBuffers;
+std::unordered_map<GLuint, std::unordered_map<GLint, GLState::UniformValue>> GLState::uniforms;
+std::unordered_map<GLint, GLState::UniformValue>* GLState::programUniforms = NULL;
+GLStateCounters GLState::counters = {};
+
+// Marks a value as unknown, so the next call is always issued.
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+unsigned int GLStateCounters::TotalIssued() const
+{
+	unsigned int total = 0;
+	for (int i = 0; i < (int)GLCallType::Count; i++)
+	{
+		total += issued[i];
+	}
+	return total;
+}
+
+unsigned int GLStateCounters::TotalElided() const
+{
+	unsigned int total = 0;
+	for (int i = 0; i < (int)GLCallType::Count; i++)
+	{
+		total += elided[i];
+	}
+	return total;
+}
+
+void GLState::Invalidate()
+{
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	arrayBuffer = UNKNOWN;
+	polygonMode = UNKNOWN;
+	for (GLuint i = 0; i < CACHED_ATTRIBUTES; i++)
+	{
+		vertexAttributeKnown[i] = false;
+	}
+	elementBuffers.clear();
+	uniforms.clear();
+	programUniforms = NULL;
+}
+
+void GLState::UseProgram(GLuint program)
+{
+	if (GLState::program == program)
+	{
+		Count(GLCallType::UseProgram, false);
+		return;
+	}
+
+	glUseProgram(program);
+	Count(GLCallType::UseProgram, true);
+	RENDER_STATS_COUNT(CountProgramBind());
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::UseProgram(program);
+	}
+
+	GLState::program = program;
+	programUniforms = program != 0 ? &uniforms[program] : NULL;
+}
+
+void GLState::BindVertexArray(GLuint vertexArray)
+{
+	if (GLState::vertexArray == vertexArray)
+	{
+		Count(GLCallType::BindVertexArray, false);
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	Count(GLCallType::BindVertexArray, true);
+	RENDER_STATS_COUNT(CountVertexArrayBind());
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::BindVertexArray(vertexArray);
+	}
+
+	GLState::vertexArray = vertexArray;
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint* current = NULL;
+
+	if (target == GL_ARRAY_BUFFER)
+	{
+		current = &arrayBuffer;
+	}
+	else if (target == GL_ELEMENT_ARRAY_BUFFER && vertexArray != UNKNOWN)
+	{
+		// A vertex array we have never seen starts with no element buffer.
+		std::unordered_map<GLuint, GLuint>::iterator found = elementBuffers.find(vertexArray);
+		if (found == elementBuffers.end())
+		{
+			found = elementBuffers.insert(std::make_pair(vertexArray, vertexArray == 0 ? UNKNOWN : 0)).first;
+		}
+		current = &found->second;
+	}
+
+	if (current != NULL && *current == buffer)
+	{
+		Count(GLCallType::BindBuffer, false);
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	Count(GLCallType::BindBuffer, true);
+
+	if (current != NULL)
+	{
+		*current = buffer;
+	}
+}
+
+void GLState::PolygonMode(GLenum mode)
+{
+	if (polygonMode == mode)
+	{
+		Count(GLCallType::PolygonMode, false);
+		return;
+	}
+
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+	Count(GLCallType::PolygonMode, true);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::PolygonMode(mode);
+	}
+
+	polygonMode = mode;
+}
+
+void GLState::Uniform1f(GLint location, GLfloat value)
+{
+	if (!UpdateUniform(location, &value, 1))
+	{
+		return;
+	}
+
+	glUniform1f(location, value);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Uniform(GLCaptureOp::Uniform1f, location, &value);
+	}
+}
+
+void GLState::Uniform1i(GLint location, GLint value)
+{
+	// The cache holds raw bits, so an int can share it with floats.
+	GLfloat bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	if (!UpdateUniform(location, &bits, 1))
+	{
+		return;
+	}
+
+	glUniform1i(location, value);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Uniform(GLCaptureOp::Uniform1i, location, &value);
+	}
+}
+
+void GLState::Uniform4fv(GLint location, const GLfloat* value)
+{
+	if (!UpdateUniform(location, value, 4))
+	{
+		return;
+	}
+
+	glUniform4fv(location, 1, value);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Uniform(GLCaptureOp::Uniform4fv, location, value);
+	}
+}
+
+void GLState::UniformMatrix4fv(GLint location, const GLfloat* value)
+{
+	if (!UpdateUniform(location, value, 16))
+	{
+		return;
+	}
+
+	glUniformMatrix4fv(location, 1, GL_FALSE, value);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Uniform(GLCaptureOp::UniformMatrix4fv, location, value);
+	}
+}
+
+void GLState::VertexAttrib4f(GLuint index, const GLfloat* value)
+{
+	if (index < CACHED_ATTRIBUTES)
+	{
+		if (vertexAttributeKnown[index] && memcmp(vertexAttributes[index], value, sizeof(GLfloat) * 4) == 0)
+		{
+			Count(GLCallType::VertexAttribute, false);
+			return;
+		}
+
+		memcpy(vertexAttributes[index], value, sizeof(GLfloat) * 4);
+		vertexAttributeKnown[index] = true;
+	}
+
+	glVertexAttrib4fv(index, value);
+	Count(GLCallType::VertexAttribute, true);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::VertexAttrib4f(index, value);
+	}
+}
+
+void GLState::DrawElements(GLenum mode, GLsizei count)
+{
+	glDrawElements(mode, count, GL_UNSIGNED_INT, 0);
+	Count(GLCallType::Draw, true);
+	RENDER_STATS_COUNT(CountDraw(count));
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::DrawElements(mode, count);
+	}
+}
+
+void GLState::Enable(GLenum capability)
+{
+	glEnable(capability);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Enable(capability, true);
+	}
+}
+
+void GLState::Disable(GLenum capability)
+{
+	glDisable(capability);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Enable(capability, false);
+	}
+}
+
+void GLState::ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	glClearColor(red, green, blue, alpha);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::ClearColor(red, green, blue, alpha);
+	}
+}
+
+void GLState::Clear(GLbitfield mask)
+{
+	glClear(mask);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Clear(mask);
+	}
+}
+
+void GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	glViewport(x, y, width, height);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Viewport(x, y, width, height);
+	}
+}
+
+void GLState::Scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	glScissor(x, y, width, height);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::Scissor(x, y, width, height);
+	}
+}
+
+void GLState::DeleteBuffer(GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+	GPUMemory::ReleaseBuffer(buffer);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::DeleteBuffer(buffer);
+	}
+
+	// Deleting a bound buffer unbinds it.
+	if (arrayBuffer == buffer)
+	{
+		arrayBuffer = 0;
+	}
+	for (std::unordered_map<GLuint, GLuint>::iterator it = elementBuffers.begin(); it != elementBuffers.end(); ++it)
+	{
+		if (it->second == buffer)
+		{
+			it->second = 0;
+		}
+	}
+}
+
+void GLState::DeleteVertexArray(GLuint vertexArray)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::DeleteVertexArray(vertexArray);
+	}
+
+	elementBuffers.erase(vertexArray);
+	if (GLState::vertexArray == vertexArray)
+	{
+		GLState::vertexArray = 0;
+	}
+}
+
+void GLState::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::DeleteProgram(program);
+	}
+
+	if (GLState::program == program)
+	{
+		// The program stays in use until another one is bound, but its name may be recycled.
+		GLState::program = UNKNOWN;
+		programUniforms = NULL;
+	}
+	uniforms.erase(program);
+}
+
+void GLState::ResetFrameCounters()
+{
+	counters = GLStateCounters();
+}
+
+bool GLState::UpdateUniform(GLint location, const GLfloat* values, int size)
+{
+	// Uploads to location -1 are silently ignored by GL.
+	if (location < 0)
+	{
+		Count(GLCallType::Uniform, false);
+		return false;
+	}
+
+	if (programUniforms == NULL)
+	{
+		// No known program: we can't cache, so always upload.
+		Count(GLCallType::Uniform, true);
+		RENDER_STATS_COUNT(CountUniformUpload(sizeof(GLfloat) * size));
+		return true;
+	}
+
+	UniformValue& cached = (*programUniforms)[location];
+	if (cached.size == size && memcmp(cached.values, values, sizeof(GLfloat) * size) == 0)
+	{
+		Count(GLCallType::Uniform, false);
+		return false;
+	}
+
+	memcpy(cached.values, values, sizeof(GLfloat) * size);
+	cached.size = size;
+	Count(GLCallType::Uniform, true);
+	RENDER_STATS_COUNT(CountUniformUpload(sizeof(GLfloat) * size));
+	return true;
+}
+
+void GLState::Count(GLCallType type, bool issued)
+{
+	if (issued)
+	{
+		counters.issued[(int)type]++;
+	}
+	else
+	{
+		counters.elided[(int)type]++;
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <GL/glew.h>
+#include <unordered_map>
+
+/// <summary>
+/// The kinds of GL calls tracked by GLState.
+/// </summary>
+enum class GLCallType
+{
+	UseProgram,
+	BindVertexArray,
+	BindBuffer,
+	PolygonMode,
+	Uniform,
+	VertexAttribute,
+	Draw,
+	Count
+};
+
+/// <summary>
+/// Number of GL calls issued to the driver and skipped as redundant, per call type.
+/// </summary>
+struct GLStateCounters
+{
+	unsigned int issued[(int)GLCallType::Count];
+	unsigned int elided[(int)GLCallType::Count];
+
+	unsigned int TotalIssued() const;
+	unsigned int TotalElided() const;
+};
+
+/// <summary>
+/// Thin cache in front of the GL context. Every bind, polygon mode change and uniform upload of the renderer goes through here,
+/// and calls that would not change the current state are skipped. Must only be used from the thread owning the GL context,
+/// and every state change must go through it for the cache to stay valid. While GLCapture runs, the calls issued are recorded.
+/// </summary>
+class GLState
+{
+	public:
+		/// <summary>
+		/// Forgets every cached value, forcing the next calls to be issued. Call after creating a context or after third party GL code.
+		/// </summary>
+		static void Invalidate();
+
+		static void UseProgram(GLuint program);
+		static void BindVertexArray(GLuint vertexArray);
+		/// <summary>
+		/// Binds a buffer. Element array bindings are tracked per vertex array, since they are part of its state.
+		/// </summary>
+		static void BindBuffer(GLenum target, GLuint buffer);
+		static void PolygonMode(GLenum mode);
+
+		/// <summary>
+		/// Uploads a uniform to the current program, unless that program already holds the same value at that location.
+		/// </summary>
+		static void Uniform1f(GLint location, GLfloat value);
+		static void Uniform1i(GLint location, GLint value);
+		static void Uniform4fv(GLint location, const GLfloat* value);
+		static void UniformMatrix4fv(GLint location, const GLfloat* value);
+
+		/// <summary>
+		/// Sets the constant value a vertex attribute takes when its array is disabled. These values are context state,
+		/// shared by every vertex array, so one per attribute is cached.
+		/// </summary>
+		static void VertexAttrib4f(GLuint index, const GLfloat* value);
+
+		/// <summary>
+		/// Issues an indexed draw of the bound vertex array. Draws are never skipped, only counted.
+		/// </summary>
+		static void DrawElements(GLenum mode, GLsizei count);
+
+		/// <summary>
+		/// Pass-through calls for the state set once per frame or per view. They aren't cached, but go through here so
+		/// GLCapture sees them.
+		/// </summary>
+		static void Enable(GLenum capability);
+		static void Disable(GLenum capability);
+		static void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+		static void Clear(GLbitfield mask);
+		static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+		static void Scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+		/// <summary>
+		/// Deletes GL objects and drops them from the cache, so a recycled name does not inherit stale state.
+		/// </summary>
+		static void DeleteBuffer(GLuint buffer);
+		static void DeleteVertexArray(GLuint vertexArray);
+		static void DeleteProgram(GLuint program);
+
+		static GLuint GetProgram() { return program; }
+		static GLuint GetVertexArray() { return vertexArray; }
+
+		/// <summary>
+		/// Returns the counters accumulated since the last call to ResetFrameCounters.
+		/// </summary>
+		static const GLStateCounters& GetFrameCounters() { return counters; }
+		/// <summary>
+		/// Clears the counters. Call once per frame.
+		/// </summary>
+		static void ResetFrameCounters();
+
+	private:
+		/// <summary>
+		/// A cached uniform value, large enough for a 4x4 matrix.
+		/// </summary>
+		struct UniformValue
+		{
+			GLfloat values[16];
+			int size;
+		};
+
+		/// <summary>
+		/// Compares the value against the cache of the current program and updates the cache. Returns true if the upload is needed.
+		/// </summary>
+		static bool UpdateUniform(GLint location, const GLfloat* values, int size);
+		static void Count(GLCallType type, bool issued);
+
+		static GLuint program;
+		static GLuint vertexArray;
+		static GLuint arrayBuffer;
+		static GLenum polygonMode;
+		/// <summary>
+		/// Constant values of the first vertex attributes, and whether each one is known.
+		/// </summary>
+		static const GLuint CACHED_ATTRIBUTES = 8;
+		static GLfloat vertexAttributes[CACHED_ATTRIBUTES][4];
+		static bool vertexAttributeKnown[CACHED_ATTRIBUTES];
+		/// <summary>
+		/// Element array buffer bound to each vertex array.
+		/// </summary>
+		static std::unordered_map<GLuint, GLuint> elementBuffers;
+		/// <summary>
+		/// Uniform values per program, then per location. Uniforms are program state, so they survive program switches.
+		/// </summary>
+		static std::unordered_map<GLuint, std::unordered_map<GLint, UniformValue>> uniforms;
+		/// <summary>
+		/// The uniform cache of the current program, or NULL when no program is bound.
+		/// </summary>
+		static std::unordered_map<GLint, UniformValue>* programUniforms;
+		static GLStateCounters counters;
+};
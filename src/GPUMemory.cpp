@@ -0,0 +1,161 @@
+#include "GPUMemory.h"
+#include "Mesh.h"
+#include "RenderStats.h"
+#include "GLCapture.h"
+#include <algorithm>
+
+std::unordered_map<GLuint, GPUMemory::Allocation> GPUMemory::buffers;
+std::unordered_map<GLuint, GPUMemory::Allocation> GPUMemory::renderbuffers;
+size_t GPUMemory::bytes[(int)GPUMemoryCategory::Count] = {};
+size_t GPUMemory::budget = 0;
+unsigned int GPUMemory::frame = 0;
+unsigned int GPUMemory::evictedMeshes = 0;
+unsigned int GPUMemory::restoredMeshes = 0;
+std::vector<Mesh*> GPUMemory::meshes;
+std::mutex GPUMemory::restoreMutex;
+std::vector<Mesh*> GPUMemory::restoreRequests;
+
+size_t GPUMemoryStats::Total() const
+{
+	size_t total = 0;
+	for (int i = 0; i < (int)GPUMemoryCategory::Count; i++)
+	{
+		total += bytes[i];
+	}
+	return total;
+}
+
+void GPUMemory::BufferData(GLenum target, GLuint buffer, GPUMemoryCategory category, GLsizeiptr size, const void* data, GLenum usage)
+{
+	glBufferData(target, size, data, usage);
+	Account(buffers, buffer, category, (size_t)size);
+	if (data != NULL)
+	{
+		RENDER_STATS_COUNT(CountBufferUpload((size_t)size));
+	}
+	if (GLCapture::IsCapturing())
+	{
+		GLCapture::BufferData(buffer, size, data, usage);
+	}
+}
+
+void GPUMemory::RenderbufferStorage(GLuint renderbuffer, GLenum format, GLsizei width, GLsizei height)
+{
+	glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+
+	// Drivers pad 24 bit depth to 32 bits, so every format used here takes 4 bytes per pixel.
+	size_t pixelSize = 4;
+	switch (format)
+	{
+		case GL_DEPTH_COMPONENT16: pixelSize = 2; break;
+		case GL_RGBA16F: pixelSize = 8; break;
+		case GL_RGBA32F: pixelSize = 16; break;
+	}
+	Account(renderbuffers, renderbuffer, GPUMemoryCategory::Renderbuffer, (size_t)width * height * pixelSize);
+}
+
+void GPUMemory::ReleaseBuffer(GLuint buffer)
+{
+	Release(buffers, buffer);
+}
+
+void GPUMemory::ReleaseRenderbuffer(GLuint renderbuffer)
+{
+	Release(renderbuffers, renderbuffer);
+}
+
+GPUMemoryStats GPUMemory::GetStats()
+{
+	GPUMemoryStats stats;
+	for (int i = 0; i < (int)GPUMemoryCategory::Count; i++)
+	{
+		stats.bytes[i] = bytes[i];
+	}
+	stats.evictedMeshes = evictedMeshes;
+	stats.restoredMeshes = restoredMeshes;
+	return stats;
+}
+
+void GPUMemory::AddMesh(Mesh* mesh)
+{
+	mesh->memoryIndex = meshes.size();
+	meshes.push_back(mesh);
+}
+
+void GPUMemory::RemoveMesh(Mesh* mesh)
+{
+	meshes.back()->memoryIndex = mesh->memoryIndex;
+	meshes[mesh->memoryIndex] = meshes.back();
+	meshes.pop_back();
+
+	std::lock_guard<std::mutex> lock(restoreMutex);
+	restoreRequests.erase(std::remove(restoreRequests.begin(), restoreRequests.end(), mesh), restoreRequests.end());
+}
+
+void GPUMemory::RequestRestore(Mesh* mesh)
+{
+	std::lock_guard<std::mutex> lock(restoreMutex);
+	restoreRequests.push_back(mesh);
+}
+
+void GPUMemory::RestoreRequested()
+{
+	std::vector<Mesh*> requests;
+	{
+		std::lock_guard<std::mutex> lock(restoreMutex);
+		requests.swap(restoreRequests);
+	}
+
+	// A mesh recorded by several lists is requested once per list; restoring it again does nothing.
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		requests[i]->Restore();
+	}
+}
+
+void GPUMemory::EndFrame()
+{
+	size_t total = GetStats().Total();
+	if (budget > 0 && total > budget)
+	{
+		std::vector<Mesh*> candidates;
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			if (meshes[i]->CanEvict() && meshes[i]->GetLastDrawnFrame() != frame)
+			{
+				candidates.push_back(meshes[i]);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Mesh* a, const Mesh* b) { return a->GetLastDrawnFrame() < b->GetLastDrawnFrame(); });
+
+		for (size_t i = 0; i < candidates.size() && total > budget; i++)
+		{
+			total -= std::min(total, candidates[i]->GetDataSize());
+			candidates[i]->Evict();
+			evictedMeshes++;
+		}
+	}
+
+	frame++;
+}
+
+void GPUMemory::Account(std::unordered_map<GLuint, Allocation>& allocations, GLuint name, GPUMemoryCategory category, size_t size)
+{
+	// Allocating again replaces the previous storage.
+	Release(allocations, name);
+	Allocation allocation;
+	allocation.category = category;
+	allocation.bytes = size;
+	allocations[name] = allocation;
+	bytes[(int)category] += size;
+}
+
+void GPUMemory::Release(std::unordered_map<GLuint, Allocation>& allocations, GLuint name)
+{
+	std::unordered_map<GLuint, Allocation>::iterator it = allocations.find(name);
+	if (it != allocations.end())
+	{
+		bytes[(int)it->second.category] -= it->second.bytes;
+		allocations.erase(it);
+	}
+}
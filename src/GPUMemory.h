@@ -0,0 +1,132 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+class Mesh;
+
+/// <summary>
+/// The kinds of GPU memory accounted by GPUMemory.
+/// </summary>
+enum class GPUMemoryCategory
+{
+	VertexBuffer,
+	IndexBuffer,
+	PixelBuffer,
+	Renderbuffer,
+	Count
+};
+
+/// <summary>
+/// GPU memory in use per category, and the meshes evicted and restored since the start.
+/// </summary>
+struct GPUMemoryStats
+{
+	size_t bytes[(int)GPUMemoryCategory::Count];
+	unsigned int evictedMeshes;
+	unsigned int restoredMeshes;
+
+	size_t Total() const;
+};
+
+/// <summary>
+/// Accounts for the GPU memory of every buffer and renderbuffer, and keeps it within a budget by evicting the meshes
+/// drawn least recently. An evicted mesh frees its buffers but keeps its data on the CPU, or in its file for meshes
+/// loaded from one, and is uploaded again the next time it is drawn. Meshes drawn in the current frame are never
+/// evicted: a scene needing more than the budget in a single frame goes over it rather than uploading the same
+/// meshes every frame.
+/// Must only be used from the thread owning the GL context, except for RequestRestore.
+/// </summary>
+class GPUMemory
+{
+	public:
+		/// <summary>
+		/// Allocates the storage of the buffer bound to the target, and accounts for it. Replaces glBufferData.
+		/// </summary>
+		/// <param name="buffer">The buffer bound to the target.</param>
+		/// <param name="category">What the buffer holds, which may differ from the target it is filled through.</param>
+		static void BufferData(GLenum target, GLuint buffer, GPUMemoryCategory category, GLsizeiptr size, const void* data, GLenum usage);
+		/// <summary>
+		/// Allocates the storage of the bound renderbuffer, and accounts for it. Replaces glRenderbufferStorage.
+		/// </summary>
+		/// <param name="renderbuffer">The renderbuffer bound to GL_RENDERBUFFER.</param>
+		static void RenderbufferStorage(GLuint renderbuffer, GLenum format, GLsizei width, GLsizei height);
+		/// <summary>
+		/// Forgets a buffer about to be deleted. Called by GLState::DeleteBuffer.
+		/// </summary>
+		static void ReleaseBuffer(GLuint buffer);
+		/// <summary>
+		/// Forgets a renderbuffer about to be deleted.
+		/// </summary>
+		static void ReleaseRenderbuffer(GLuint renderbuffer);
+
+		/// <summary>
+		/// Sets the most memory the buffers and renderbuffers should use, 0 for no limit.
+		/// </summary>
+		static void SetBudget(size_t bytes) { budget = bytes; }
+		static size_t GetBudget() { return budget; }
+		static GPUMemoryStats GetStats();
+
+		/// <summary>
+		/// Adds a mesh to the ones that can be evicted. Called by the mesh's constructor.
+		/// </summary>
+		static void AddMesh(Mesh* mesh);
+		/// <summary>
+		/// Removes a mesh from the ones that can be evicted. Called by the mesh's destructor.
+		/// </summary>
+		static void RemoveMesh(Mesh* mesh);
+
+		/// <summary>
+		/// Returns the number of the current frame, which meshes remember when they are drawn.
+		/// </summary>
+		static unsigned int GetFrame() { return frame; }
+		/// <summary>
+		/// Asks for an evicted mesh to be uploaded again by the next call to RestoreRequested. Used by meshes recorded
+		/// into command lists, which can't upload from the recording threads. Can be called from any thread.
+		/// </summary>
+		static void RequestRestore(Mesh* mesh);
+		/// <summary>
+		/// Uploads the meshes requested since the last call. Call after recording command lists, before executing them.
+		/// </summary>
+		static void RestoreRequested();
+		/// <summary>
+		/// Evicts the meshes drawn least recently, but not in this frame, until the memory used is within the budget,
+		/// then starts the next frame. Call once per frame, after drawing.
+		/// </summary>
+		static void EndFrame();
+
+		/// <summary>
+		/// Counts a mesh uploaded again after being evicted. Called by Mesh::Restore.
+		/// </summary>
+		static void CountRestore() { restoredMeshes++; }
+
+	private:
+		struct Allocation
+		{
+			GPUMemoryCategory category;
+			size_t bytes;
+		};
+
+		static void Account(std::unordered_map<GLuint, Allocation>& allocations, GLuint name, GPUMemoryCategory category, size_t bytes);
+		static void Release(std::unordered_map<GLuint, Allocation>& allocations, GLuint name);
+
+		/// <summary>
+		/// Allocations per name. Buffers and renderbuffers have their own names, which may be the same.
+		/// </summary>
+		static std::unordered_map<GLuint, Allocation> buffers;
+		static std::unordered_map<GLuint, Allocation> renderbuffers;
+		static size_t bytes[(int)GPUMemoryCategory::Count];
+		static size_t budget;
+		static unsigned int frame;
+		static unsigned int evictedMeshes;
+		static unsigned int restoredMeshes;
+
+		/// <summary>
+		/// Every living mesh. Each mesh knows its position, so it is removed in constant time.
+		/// </summary>
+		static std::vector<Mesh*> meshes;
+		static std::mutex restoreMutex;
+		static std::vector<Mesh*> restoreRequests; // Guarded by restoreMutex
+};
@@ -1,125 +1,88 @@
 #include "IndependentMesh.h"
+#include "CommandList.h"
+#include "GLState.h"
 
 IndependentMesh::IndependentMesh() : Mesh()
 {
-	modelMatrix = new glm::mat4(1.0f);
+	modelMatrix = glm::mat4(1.0f);
     uniformModelLocation = 0;
 }
 
 IndependentMesh::~IndependentMesh()
 {
-    // Removing the model matrix from gpu
-    glUniform1f((*this).uniformModelLocation, 0.0f);
-
-	delete modelMatrix;
 }
 
 void IndependentMesh::RenderMesh()
 {
-    // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
-
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-    // Reassigning the uniform variable. So now we want to assign a matrix, 4x4, with float values.
-    glUniformMatrix4fv(uniformModelLocation, // Value to change
-        1, // How many matrices to pass
-        GL_FALSE, // Transpose?
-        glm::value_ptr(*modelMatrix)); // Our value. Can't pass our value directly. We need to use a pointer.
-
-    // Drawing our triangles.
-    glDrawElements(GL_TRIANGLES, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
-
-    // Removing the model matrix from gpu
-    glUniform1f(uniformModelLocation, 0.0f);
-
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    RenderMesh(GL_TRIANGLES);
 }
 
 void IndependentMesh::RenderMesh(GLenum drawType)
 {
-    // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
+    if (!PrepareDraw())
+    {
+        return;
+    }
 
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    // We want to work with our created VAO. The IBO is part of its state.
+    GLState::BindVertexArray(VAO);
+    ApplyColor();
 
-    // Reassigning the uniform variable. So now we want to assign a matrix, 4x4, with float values.
-    glUniformMatrix4fv(uniformModelLocation, // Value to change
-        1, // How many matrices to pass
-        GL_FALSE, // Transpose?
-        glm::value_ptr(*modelMatrix)); // Our value. Can't pass our value directly. We need to use a pointer.
+    // Uploading our model matrix. Skipped if the uniform already holds it.
+    GLState::UniformMatrix4fv(uniformModelLocation, glm::value_ptr(modelMatrix));
 
     // Drawing our triangles.
-    glDrawElements(drawType, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
-
-    // Removing the model matrix from gpu
-    glUniform1f(uniformModelLocation, 0.0f);
-
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::DrawElements(drawType, indexCount);
 }
 
 void IndependentMesh::RenderMesh(glm::mat4& matrix, GLuint uniformModelLocation)
 {
-    // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
+    if (!PrepareDraw())
+    {
+        return;
+    }
 
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    // We want to work with our created VAO.
+    GLState::BindVertexArray(VAO);
+    ApplyColor();
 
     // We apply the parent transformation first, then our own.
-    glm::mat4 model = matrix * *modelMatrix;
-
-    // Reassigning the uniform variable. So now we want to assign a matrix, 4x4, with float values.
-    glUniformMatrix4fv(uniformModelLocation, // Value to change
-        1, // How many matrices to pass
-        GL_FALSE, // Transpose?
-        glm::value_ptr(model)); // Our value. Can't pass our value directly. We need to use a pointer.
+    glm::mat4 model = matrix * modelMatrix;
+    GLState::UniformMatrix4fv(uniformModelLocation, glm::value_ptr(model));
 
     // Drawing our triangles.
-    glDrawElements(GL_TRIANGLE_STRIP, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
-
-    // Removing the model matrix from gpu
-    glUniform1f(uniformModelLocation, 0.0f);
-
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::DrawElements(GL_TRIANGLE_STRIP, indexCount);
 }
 
-void IndependentMesh::SetModelMatrix(glm::mat4& matrix, GLuint uniformModelLocation)
+void IndependentMesh::RecordMesh(CommandList& list, const glm::mat4& matrix, GLuint uniformModelLocation)
 {
-    // Removing the model matrix from gpu
-    glUniform1f((*this).uniformModelLocation, 0.0f);
+    if (!PrepareRecord())
+    {
+        return;
+    }
 
-	*modelMatrix = matrix;
+    // We apply the parent transformation first, then our own.
+    list.BindVertexArray(VAO);
+    if (CBO == 0)
+    {
+        list.SetVertexAttribute4(COLOR_LOCATION, color);
+    }
+    list.SetUniformMatrix4(uniformModelLocation, matrix * modelMatrix);
+    list.DrawElements(GL_TRIANGLE_STRIP, indexCount);
+}
+
+void IndependentMesh::SetModelMatrix(glm::mat4& matrix, GLuint uniformModelLocation)
+{
+	modelMatrix = matrix;
     this->uniformModelLocation = uniformModelLocation;
 }
 
 glm::mat4& IndependentMesh::GetModelMatrix()
 {
-	return *modelMatrix;
+	return modelMatrix;
+}
+
+glm::mat4 IndependentMesh::GetWorldMatrix(const glm::mat4& parentMatrix) const
+{
+    return parentMatrix * modelMatrix;
 }
@@ -13,6 +13,15 @@ class IndependentMesh : public Mesh
 		IndependentMesh();
 		~IndependentMesh();
 
+		/// <summary>
+		/// Creates an empty independent mesh in the shared pool. Fill it with CreateMesh.
+		/// </summary>
+		static Handle<IndependentMesh> Create() { return Pool<IndependentMesh>::Global().Create(); }
+		/// <summary>
+		/// Destroys an independent mesh created with Create, freeing its GPU buffers.
+		/// </summary>
+		static void Destroy(Handle<IndependentMesh> mesh) { Pool<IndependentMesh>::Global().Destroy(mesh); }
+
 		/// <summary>
 		/// Draw the mesh on screen.
 		/// </summary>
@@ -28,6 +37,14 @@ class IndependentMesh : public Mesh
 		/// <param name="uniformModelLocation">The location of the matrix in the GPU.</param>
 		void RenderMesh(glm::mat4& matrix, GLuint uniformModelLocation);
 
+		/// <summary>
+		/// Records the draw of RenderMesh(matrix, uniformModelLocation) into a command list, combining its model matrix with the one specified.
+		/// </summary>
+		/// <param name="list">The list to record into.</param>
+		/// <param name="matrix">The matrix to apply to this mesh.</param>
+		/// <param name="uniformModelLocation">The location of the matrix in the GPU.</param>
+		void RecordMesh(CommandList& list, const glm::mat4& matrix, GLuint uniformModelLocation);
+
 		/// <summary>
 		/// Sets this mesh's custom model matrix.
 		/// </summary>
@@ -35,14 +52,28 @@ class IndependentMesh : public Mesh
 		/// <param name="uniformModelLocation">The location tied to the matrix.</param>
 		void SetModelMatrix(glm::mat4& matrix, GLuint uniformModelLocation);
 		glm::mat4& GetModelMatrix();
+
+		/// <summary>
+		/// Independent meshes are drawn as triangle strips.
+		/// </summary>
+		GLenum GetDrawType() const { return GL_TRIANGLE_STRIP; }
+
+		/// <summary>
+		/// Returns the parent transformation combined with this mesh's model matrix.
+		/// </summary>
+		glm::mat4 GetWorldMatrix(const glm::mat4& parentMatrix) const;
 	private:
 		/// <summary>
 		/// The model matrix of this mesh.
 		/// </summary>
-		glm::mat4* modelMatrix;
+		glm::mat4 modelMatrix;
 		/// <summary>
 		/// The location of the model matrix of this mesh.
 		/// </summary>
 		GLuint uniformModelLocation;
 };
 
+/// <summary>
+/// The meshes held by complex objects.
+/// </summary>
+typedef Handle<IndependentMesh> MeshHandle;
@@ -1,4 +1,10 @@
 #include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <mutex>
+#include <string>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -11,16 +17,69 @@
 #include "Window.h"
 #include "IndependentMesh.h"
 #include "ComplexObject.h"
+#include "CommandList.h"
+#include "WorkerPool.h"
+#include "GLState.h"
+#include "ScenePicker.h"
+#include "CollisionWorld.h"
+#include "Animation.h"
+#include "SceneView.h"
+#include "FramePacer.h"
+#include "RedrawSignal.h"
+#include "SceneSnapshot.h"
+#include "TripleBuffer.h"
+#include "FixedStepThread.h"
+#include "FrameCapture.h"
+#include "RenderTarget.h"
+#include "DynamicResolution.h"
+#include "Terrain.h"
+#include "MeshOptimizer.h"
+#include "MeshCodec.h"
+#include "AssetStreamer.h"
+#include "GPUMemory.h"
+#include "RenderStats.h"
+#include "GLCapture.h"
+#include "Shapes.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 float toRadians(float deg);
 /// <summary>
+/// Returns true if the given flag was passed on the command line.
+/// </summary>
+bool HasArgument(int argc, char* argv[], const char* flag);
+/// <summary>
+/// Returns the integer following the given flag on the command line, or the default value if the flag isn't there.
+/// </summary>
+int GetArgumentValue(int argc, char* argv[], const char* flag, int defaultValue);
+/// <summary>
+/// Returns the text following the given flag on the command line, or the default value if the flag isn't there.
+/// </summary>
+const char* GetArgumentString(int argc, char* argv[], const char* flag, const char* defaultValue);
+/// <summary>
+/// Prints how many GL calls the last frame issued and how many GLState skipped as redundant.
+/// </summary>
+void PrintGLStateCounters(const GLStateCounters& counters);
+/// <summary>
+/// Prints the last frame's render statistics as a line of JSON, and shows its totals in the window's title bar.
+/// </summary>
+/// <param name="frameNumber">The number of the frame.</param>
+void ShowRenderStats(unsigned int frameNumber);
+/// <summary>
 /// Creates a square grid by creating vertices for the given amount of squares (basically a 2d array).
 /// Links all the vertices with 2-pair indices that can be used with GL_LINES to draw the triangle. 
 /// </summary>
 /// <param name="squareCount">Integer describing amount of squares user wishes to be created. </param>
 void createGrid(int squareCount);
+/// <summary>
+/// Reorders a mesh's indices and vertices for the GPU before it is created. The first mesh of each kind has its
+/// statistics before and after printed with --mesh-stats, and is saved to the --export-meshes directory.
+/// </summary>
+/// <param name="vertices">The vertices, 3 floats each.</param>
+/// <param name="indices">The indices.</param>
+/// <param name="drawType">The primitives the indices describe.</param>
+/// <param name="name">The kind of mesh, printed with its statistics.</param>
+void PrepareMesh(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, GLenum drawType, const char* name);
 
 // Character creation methods
 
@@ -32,30 +91,113 @@ void createGrid(int squareCount);
 
 
 // Letter Creation Methods
-ComplexObject* CreateLetterM(GLuint uniformModel);
-ComplexObject* CreateLetterU(GLuint uniformModel);
-ComplexObject* CreateLetterL(GLuint uniformModel);
-ComplexObject* CreateLetterE(GLuint uniformModel);
-ComplexObject* CreateLetterT(GLuint uniformModel);
+ObjectHandle CreateLetterM(GLuint uniformModel);
+ObjectHandle CreateLetterU(GLuint uniformModel);
+ObjectHandle CreateLetterL(GLuint uniformModel);
+ObjectHandle CreateLetterE(GLuint uniformModel);
+ObjectHandle CreateLetterT(GLuint uniformModel);
 void CreateLetters(Shader* shader);
 
 // Create Axes
 void CreateAxes(Shader* shader);
 
 // Utility methods for object creation
-IndependentMesh* CreateCylinder(double radius);
-IndependentMesh* CreateCube();
-IndependentMesh* CreateSphere();
-IndependentMesh* CreateVertical(GLuint uniformModel);
-IndependentMesh* CreateHorizontal(GLuint uniformModel);
+MeshHandle CreateCylinder(double radius);
+MeshHandle CreateCube();
+MeshHandle CreateSphere();
+MeshHandle CreateVertical(GLuint uniformModel);
+MeshHandle CreateHorizontal(GLuint uniformModel);
 
 // Select model to transfrom with keyboard
-void SelectModel();
+void SelectModel(bool* keys);
+
+/// <summary>
+/// Returns the ray under the last mouse click, if the mouse was clicked since the last call, in whichever view was clicked.
+/// </summary>
+/// <param name="origin">Set to the start of the ray.</param>
+/// <param name="direction">Set to the normalized direction of the ray.</param>
+/// <returns>True if there was a click in a view.</returns>
+bool GetClickRay(glm::vec3& origin, glm::vec3& direction);
+
+/// <summary>
+/// Selects the letter hit by a ray, if any.
+/// </summary>
+void PickModel(const glm::vec3& origin, const glm::vec3& direction);
+
+/// <summary>
+/// Highlights the given letter, and only it.
+/// </summary>
+void HighlightSelectedModel(unsigned int selected);
+
+/// <summary>
+/// Gathers the input since the last call and hands it to the simulation, waking it if there is anything to process.
+/// </summary>
+void SubmitInput();
+
+/// <summary>
+/// Advances the simulation by one step: applies the input, moves the camera, the world and the letters, and publishes
+/// a snapshot for the renderer. Runs on the simulation thread.
+/// </summary>
+/// <returns>True while something is moving, false once the simulation can sleep until new input.</returns>
+bool SimulateStep();
+
+/// <summary>
+/// Copies the simulation's state into a snapshot and publishes it to the renderer.
+/// </summary>
+void PublishSnapshot();
+
+/// <summary>
+/// Keeps the letters baked into single meshes while they stand still where the snapshot puts them: all of them into one
+/// mesh, or, while one of them moves, each letter into its own.
+/// </summary>
+/// <param name="letters">The complex object holding the letters.</param>
+/// <param name="snapshot">Where the letters are.</param>
+/// <returns>True if the letters are baked together.</returns>
+bool BakeLetters(ComplexObject* letters, const SceneSnapshot& snapshot);
+
+/// <summary>
+/// Records the draws of every letter into one command list per letter, spread over the workers. Each view then replays
+/// the lists of the letters it sees, so the letters are only recorded once however many views there are.
+/// When the letters are baked together, they are recorded as a single draw into a single list.
+/// </summary>
+/// <param name="pool">The workers recording the lists.</param>
+/// <param name="lists">The lists to fill, resized to one per letter.</param>
+/// <param name="letters">The complex object holding the letters.</param>
+/// <param name="snapshot">Where to draw the letters.</param>
+/// <param name="uniformModel">Location of the model matrix uniform.</param>
+void RecordLetters(WorkerPool& pool, std::vector<CommandList>& lists, ComplexObject* letters, const SceneSnapshot& snapshot, GLuint uniformModel);
+
+/// <summary>
+/// Starts the letters hopping and spinning in place, one after the other, remembering where they stood.
+/// </summary>
+void StartLetterAnimation();
+/// <summary>
+/// Stops the letter animation and puts the letters back where they stood when it started.
+/// </summary>
+void StopLetterAnimation();
+
+/// <summary>
+/// Lays out the views of the current layout and points their cameras: the main, interactive camera first,
+/// then fixed cameras looking at the letters from above, the front and the side.
+/// </summary>
+/// <param name="mainView">View matrix of the main camera.</param>
+/// <param name="letterBounds">World space bounds of each letter.</param>
+void UpdateViews(const glm::mat4& mainView, const std::vector<AABB>& letterBounds);
+
+/// <summary>
+/// Draws the meshes loaded with --load-mesh in a row behind the letters, each scaled to the same size. Meshes still
+/// loading or uploading, or evicted and read again, are drawn as a grey cube. Expects the scene shader in use.
+/// </summary>
+/// <param name="view">The view drawn, whose frustum skips the meshes it can't see.</param>
+/// <param name="uniformModel">Location of the scene shader's model matrix uniform.</param>
+/// <param name="lineShader">Draws the meshes of lines and points, which the scene shader's geometry shader, taking
+/// triangles, can't. Left in use if any is drawn.</param>
+void DrawStreamedMeshes(const SceneView& view, GLuint uniformModel, Shader& lineShader);
 
 // Global Variables
 const int WIDTH = 1024, HEIGHT = 768;
-std::vector<Mesh*> meshList;
-std::vector<ComplexObject*> objectList;
+std::vector<Handle<Mesh>> meshList;
+std::vector<ObjectHandle> objectList;
 Camera camera = Camera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f, 0.05f, 0.5f); // Initialize camera
 Window window;
 const float BASE_WORLD_XANGLE = -5.0f;
@@ -66,111 +208,301 @@ float currentWorldYAngle = BASE_WORLD_YANGLE;
 float currentYPos = BASE_WORLD_Y_POS - 1.0f;
 float worldRotationIncrement = 0.5f;
 float worldPosIncrement = 0.01f;
+const int CAPTURE_FRAME_RATE = 60; // Frame rate written in --capture videos, matching a 60 Hz display with vsync
+const int DEFAULT_GL_CAPTURE_FRAMES = 100; // Frames recorded by --gl-capture, unless --gl-capture-frames says otherwise
+const double IDLE_WAIT_TIMEOUT = 0.5; // Longest sleep between checks while nothing needs redrawing, in seconds
+
+// The simulation runs on its own thread at a fixed rate. It owns the camera, the world rotation, the letters'
+// transformations, the selection, picking, collisions and the animation; the renderer only reads the snapshots it
+// publishes. The increments above are per step, and match what they were per frame at 60 frames per second.
+const double SIMULATION_STEP = 1.0 / 60.0;
+FixedStepThread simulationThread;
+TripleBuffer<SceneSnapshot> snapshots; // Published by the simulation, read by the renderer
+std::mutex simulationInputMutex;
+SimulationInput simulationInput; // Input waiting for the next step, guarded by simulationInputMutex
+SimulationInput stepInput; // Input of the current step, on the simulation thread
 
 unsigned int selectedModel = 0; // Selected model to transform using keyboard
+int highlightedModel = -1; // Model currently drawn highlighted, on the render thread
+ScenePicker picker; // Finds the letter under a mouse click
+CollisionWorld collisions; // Keeps letters from being moved into each other
+Animator animator; // Plays the letter animation toggled with N
+std::vector<TRS> letterRestTransforms; // Where the letters stood before the animation started
+
+// How the letters and axes are drawn, switched with T, L, P and O. The values are the renderMode uniform of wire.fs.
+enum RenderMode { RENDER_MODE_SOLID, RENDER_MODE_WIRE, RENDER_MODE_POINTS, RENDER_MODE_SOLID_WIRE };
+int renderMode = RENDER_MODE_SOLID;
+const float WIRE_LINE_WIDTH = 1.5f; // Width of the edges, in window pixels
+const float WIRE_POINT_SIZE = 5.0f; // Diameter of the corners, in window pixels
+
+bool printMeshStats = false; // --mesh-stats prints what optimizing each kind of mesh changed
+const char* meshExportDirectory = NULL; // --export-meshes DIR saves each kind of mesh there, encoded with MeshCodec
+std::vector<std::string> preparedMeshNames; // The kinds of mesh prepared so far
+
+// Ground loaded with --terrain, in place of the grid. A 8k map at this spacing is about 2 km across; its highest
+// samples reach the grid's level.
+const float TERRAIN_SAMPLE_SPACING = 0.25f; // World units between two samples of the heightmap
+const float TERRAIN_HEIGHT = 12.0f; // Height of the highest sample above the lowest, in world units
+
+// Meshes loaded with --load-mesh, read on background threads and put on the GPU a slice per frame
+AssetStreamer streamer;
+MeshHandle streamPlaceholder; // Drawn in place of the meshes not resident yet
+const unsigned int STREAMING_THREADS = 2;
+const int DEFAULT_UPLOAD_BUDGET = 1024; // KB uploaded per frame, unless --upload-budget says otherwise
+const float STREAMED_MESH_SIZE = 1.0f; // Largest side of each streamed mesh, in world units
+const float STREAMED_MESH_SPACING = 1.5f; // Distance between the centers of two streamed meshes
+const glm::vec3 STREAMED_MESH_ROW(0.0f, 0.5f, -3.0f); // Center of the row of streamed meshes
+const glm::vec3 STREAMED_PLACEHOLDER_COLOR(0.5f, 0.5f, 0.5f);
+
+// View layouts cycled through with V: the main camera alone, a 2x2 wall of cameras, the main camera with an overview inset
+enum ViewLayout { VIEW_LAYOUT_SINGLE, VIEW_LAYOUT_WALL, VIEW_LAYOUT_INSET, VIEW_LAYOUT_COUNT };
+int viewLayout = VIEW_LAYOUT_SINGLE;
+std::vector<SceneView> views; // The views of the current layout, the main camera first
+
+// Field of view of the main camera. glm::perspective reads it in radians; kept as is so the main view looks as it always did.
+const float MAIN_FIELD_OF_VIEW = 45.0f;
+// Field of view of the fixed cameras
+const float OVERVIEW_FIELD_OF_VIEW = glm::radians(45.0f);
+
+// Colors of the letters T, E, L1, L2, U and M, applied once at creation. Letters past the sixth reuse them in order.
+const glm::vec3 letterColors[] = {
+    glm::vec3(48.0f, 26.0f, 75.0f) / 255.0f,
+    glm::vec3(109.0f, 177.0f, 191.0f) / 255.0f,
+    glm::vec3(255.0f, 224.0f, 236.0f) / 255.0f,
+    glm::vec3(243.0f, 154.0f, 157.0f) / 255.0f,
+    glm::vec3(63.0f, 108.0f, 81.0f) / 255.0f,
+    glm::vec3(223.0f, 87.0f, 188.0f) / 255.0f
+};
+const size_t LETTER_COLOR_COUNT = sizeof(letterColors) / sizeof(letterColors[0]);
+
+// Bands of latitude of the spheres the letters are made of, segments around them, and segments around the cylinders
+const int SPHERE_SEGMENTS = 40;
+
+// Below this many letters per worker, recording stays on fewer threads since waking workers costs more than it saves.
+const size_t MIN_LETTERS_PER_WORKER = 64;
 
 // Window initialization and handling modified from Ben Cook's Udemy course
 // https://www.udemy.com/course/graphics-with-modern-opengl/
 int main(int argc, char* argv[])
 {
 	// Initializing Global Variables
-	meshList = std::vector<Mesh*>();
-	objectList = std::vector<ComplexObject*>();
+	meshList = std::vector<Handle<Mesh>>();
+	objectList = std::vector<ObjectHandle>();
 
 	window = Window(WIDTH, HEIGHT);
 	window.initialise();
 
 	glEnable(GL_DEPTH_TEST);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	GLState::PolygonMode(GL_FILL);
     glEnable(GL_PRIMITIVE_RESTART);
-    glPrimitiveRestartIndex(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glPrimitiveRestartIndex(MeshOptimizer::RESTART_INDEX);
 
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
+	printMeshStats = HasArgument(argc, argv, "--mesh-stats");
+	GPUMemory::SetBudget((size_t)std::max(GetArgumentValue(argc, argv, "--vram-budget", 0), 0) * 1024 * 1024);
+	meshExportDirectory = GetArgumentString(argc, argv, "--export-meshes", NULL);
+
 	// Creating grid
 	createGrid(128);
 	Shader gridShader = Shader("src/shader.vs", "src/shader.fs");
-
-	glm::mat4 projection(1.0f);
-	projection = glm::perspective(45.0f, (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+	// The letters and axes are drawn through a geometry shader that also draws their edges or corners, depending on the render mode
+	Shader sceneShader = Shader("src/shader.vs", "src/wire.gs", "src/wire.fs");
+
+	// --terrain FILE draws a heightmap streamed from the file instead of the grid
+	Shader terrainShader = Shader("src/terrain.vs", "src/terrain.fs");
+	Terrain terrain;
+	const char* terrainPath = GetArgumentString(argc, argv, "--terrain", NULL);
+	if (terrainPath != NULL)
+	{
+		terrain.Open(terrainPath, glm::vec3(0.0f, -TERRAIN_HEIGHT, 0.0f), TERRAIN_SAMPLE_SPACING, TERRAIN_HEIGHT);
+	}
 
 	// Creating the letters
-	CreateLetters(&gridShader);
+	CreateLetters(&sceneShader);
 
 	// Create the axes
-    CreateAxes(&gridShader);
+    CreateAxes(&sceneShader);
+    objectList[1]->SetName("axes");
+
+	// Start reading the meshes to stream; every --load-mesh FILE is one of them
+	streamPlaceholder = CreateCube();
+	streamPlaceholder->SetColor(STREAMED_PLACEHOLDER_COLOR);
+	streamer.Start(STREAMING_THREADS, (size_t)std::max(GetArgumentValue(argc, argv, "--upload-budget", DEFAULT_UPLOAD_BUDGET), 0) * 1024);
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], "--load-mesh") == 0)
+		{
+			streamer.Load(argv[i + 1]);
+		}
+	}
 
-	while (!window.getShouldClose())
+	// Picking and collision structures over the parts of the letters
+	picker.Build(objectList[0].Get());
+	collisions.Build(objectList[0].Get());
+
+	// Workers recording the letter draws, and the lists they record into
+	WorkerPool workerPool;
+	std::vector<CommandList> letterDrawLists;
+	GLuint uniformModel = sceneShader.getLocation("model");
+
+	// --gl-stats prints the GL call counters of one frame every second
+	bool printGLStats = HasArgument(argc, argv, "--gl-stats");
+	double lastGLStatsTime = glfwGetTime();
+
+	// Render statistics of the frames, printed and shown in the title bar once per second with --render-stats
+	bool printRenderStats = HasArgument(argc, argv, "--render-stats");
+	double lastRenderStatsTime = glfwGetTime();
+	unsigned int frameNumber = 0;
+#ifndef RENDER_STATS
+	if (printRenderStats)
+	{
+		printf("--render-stats needs a build with RENDER_STATS defined\n");
+		printRenderStats = false;
+	}
+#endif
+
+	// Frame pacing: --swap-interval sets the vsync interval, --frames-in-flight bounds the frames queued in the driver,
+	// --low-latency bounds them to one, and --latency-stats prints the input to frame latency every second
+	FramePacer pacer;
+	pacer.SetSwapInterval(GetArgumentValue(argc, argv, "--swap-interval", 1));
+	pacer.SetMaxFramesInFlight(GetArgumentValue(argc, argv, "--frames-in-flight", HasArgument(argc, argv, "--low-latency") ? 1 : 0));
+	bool printLatencyStats = HasArgument(argc, argv, "--latency-stats");
+	double lastLatencyStatsTime = glfwGetTime();
+
+	// --gpu-budget N draws the scene offscreen, at the resolution that keeps the GPU time of a frame under N milliseconds,
+	// then scales it up to the window
+	int gpuBudget = GetArgumentValue(argc, argv, "--gpu-budget", 0);
+	RenderTarget sceneTarget;
+	DynamicResolution resolution;
+	resolution.SetBudget(gpuBudget / 1000.0);
+
+	// --capture records every frame drawn into a Y4M video, read back without stalling the GPU
+	FrameCapture capture;
+	const char* capturePath = GetArgumentString(argc, argv, "--capture", NULL);
+	if (capturePath != NULL)
 	{
+		capture.Start(capturePath, window.getBufferWidth(), window.getBufferHeight(), CAPTURE_FRAME_RATE);
+	}
 
-		// rendering commands
-        // Set background Teal 
-		glClearColor(0.0f, 0.502f, 0.502f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// --gl-capture FILE records the GL calls of the next frames, for GLReplay to play them back on their own
+	const char* glCapturePath = GetArgumentString(argc, argv, "--gl-capture", NULL);
+	if (glCapturePath != NULL)
+	{
+		GLCapture::Start(glCapturePath, (unsigned int)std::max(GetArgumentValue(argc, argv, "--gl-capture-frames", DEFAULT_GL_CAPTURE_FRAMES), 1),
+			window.getBufferWidth(), window.getBufferHeight());
+	}
 
-		// Camera movement
-		camera.pan(window.getKeys(), window.getDeltaX());
-		camera.tilt(window.getKeys(), window.getDeltaY());
-		camera.magnify(window.getKeys(), window.getDeltaY());
-		camera.movementFromKeyboard(window.getKeys());
+	// Unless --continuous is passed, frames are only drawn when something changed: a static scene costs no CPU or GPU time.
+	// A recording needs a frame every refresh to keep its timing.
+	bool idleRendering = !HasArgument(argc, argv, "--continuous") && !capture.IsCapturing();
 
-		gridShader.use();
+	// The simulation starts from the scene as created, then runs on its own thread. Frames are drawn one step behind
+	// it, between the two latest snapshots, so motion stays smooth whatever the frame rate.
+	PublishSnapshot();
+	snapshots.Update();
+	SceneSnapshot previousSnapshot = snapshots.GetReadBuffer();
+	SceneSnapshot frameSnapshot;
+	Camera viewCamera = camera;
+	simulationThread.Start(SIMULATION_STEP, SimulateStep);
 
-		// Handling rotations
-		// Rotating the entire world dependent on key presses.
-			// We rotate around the X-Axis
-		if (window.getKeys()[GLFW_KEY_LEFT])
-		{
-			// Anticlockwise rotation
-			currentWorldXAngle += worldRotationIncrement;
-		}
-		if (window.getKeys()[GLFW_KEY_RIGHT])
-		{
-			// Clockwise rotation
-			currentWorldXAngle -= worldRotationIncrement;
-		}
-		if (window.getKeys()[GLFW_KEY_UP])
+	while (!window.getShouldClose())
+	{
+		// Wait for the GPU if too many frames are queued, then sample input as late as possible before using it
+		pacer.BeginFrame();
+
+		// Held keys and buttons move something every step, and a new snapshot or one not fully blended in yet changes
+		// the picture. Otherwise, when nothing asked for a redraw, sleep until an event arrives (the simulation posts one
+		// with each snapshot) rather than drawing the same image again.
+		bool blending = glfwGetTime() - SIMULATION_STEP < snapshots.GetReadBuffer().time;
+		bool idle = idleRendering && !GLCapture::IsCapturing() && !blending && !RedrawSignal::IsRequested() && !window.isInputHeld() && !snapshots.HasNew();
+		if (idle)
 		{
-			// Anticlockwise rotation
-			currentWorldYAngle += worldRotationIncrement;
+			glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
 		}
-		if (window.getKeys()[GLFW_KEY_DOWN])
+		else
 		{
-			// Clockwise rotation
-			currentWorldYAngle -= worldRotationIncrement;
+			glfwPollEvents();
 		}
-		if (window.getKeys()[GLFW_KEY_HOME])
+
+		// The simulation gets the input even when this frame isn't drawn. Events that change nothing (e.g. mouse moves)
+		// go back to sleep.
+		SubmitInput();
+		if (idle && !RedrawSignal::IsRequested() && !window.isInputHeld() && !snapshots.HasNew())
 		{
-			// Reset to default rotation.
-			currentWorldXAngle = BASE_WORLD_XANGLE;
-			currentWorldYAngle = BASE_WORLD_YANGLE;
+			continue;
 		}
 
-		// Handling vertical camera movement
-		if (window.getKeys()[GLFW_KEY_EQUAL])
+		double inputTime = -1.0;
+		window.consumeInputTime(inputTime);
+
+		GLState::ResetFrameCounters();
+#ifdef RENDER_STATS
+		RenderStats::BeginFrame();
+#endif
+
+		// Put the terrain chunks read since the last frame on the GPU
+		terrain.Update();
+
+		// Put up as much of the streamed meshes as this frame's budget allows
+		streamer.Update();
+
+		// Take the latest snapshot, keeping the one before it to blend from
+		if (snapshots.HasNew())
 		{
-			currentYPos -= worldPosIncrement;
+			previousSnapshot = snapshots.GetReadBuffer();
+			snapshots.Update();
 		}
-		if (window.getKeys()[GLFW_KEY_MINUS])
+		const SceneSnapshot& latestSnapshot = snapshots.GetReadBuffer();
+		double snapshotSpan = latestSnapshot.time - previousSnapshot.time;
+		double blend = snapshotSpan > 0.0 ? (glfwGetTime() - SIMULATION_STEP - previousSnapshot.time) / snapshotSpan : 1.0;
+		SceneSnapshot::Interpolate(previousSnapshot, latestSnapshot, (float)std::min(std::max(blend, 0.0), 1.0), frameSnapshot);
+
+		// With a GPU budget, draw into the lower left part of the offscreen target the budget allows. The target keeps
+		// the window's size, so only the viewport changes with the scale.
+		GLint renderWidth = window.getBufferWidth();
+		GLint renderHeight = window.getBufferHeight();
+		if (gpuBudget > 0)
 		{
-			currentYPos += worldPosIncrement;
+			sceneTarget.Resize(renderWidth, renderHeight);
+			renderWidth = std::max((GLint)(renderWidth * resolution.GetScale()), 1);
+			renderHeight = std::max((GLint)(renderHeight * resolution.GetScale()), 1);
+			sceneTarget.Bind();
+			resolution.BeginFrame();
+
+			// Only clear the part drawn into
+			GLState::Enable(GL_SCISSOR_TEST);
+			GLState::Scissor(0, 0, renderWidth, renderHeight);
 		}
-		
+
+		// rendering commands
+        // Set background Teal 
+		GLState::ClearColor(0.0f, 0.502f, 0.502f, 1.0f);
+		GLState::Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
 		if (window.getKeys()[GLFW_KEY_T])
 		{
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			renderMode = RENDER_MODE_SOLID;
 		}
 		if (window.getKeys()[GLFW_KEY_L] && !window.getKeys()[GLFW_KEY_LEFT_SHIFT])
 		{
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			renderMode = RENDER_MODE_WIRE;
 		}
 		if (window.getKeys()[GLFW_KEY_P])
 		{
-			glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+			renderMode = RENDER_MODE_POINTS;
+		}
+		if (window.getKeys()[GLFW_KEY_O])
+		{
+			renderMode = RENDER_MODE_SOLID_WIRE;
 		}
 
-		// Seclect model to transform with keyboard
-        SelectModel();
+		// Edges and corners keep their width on screen when the scene is drawn at a lower resolution
+		float pixelScale = (float)renderWidth / window.getBufferWidth();
+		sceneShader.use();
+		sceneShader.setInt("renderMode", renderMode);
+		sceneShader.setFloat("lineWidth", WIRE_LINE_WIDTH * pixelScale);
+		sceneShader.setFloat("pointSize", WIRE_POINT_SIZE * pixelScale);
 
 		// Model matrix for the world grid
 		glm::mat4 model(1.0f);
@@ -178,122 +510,212 @@ int main(int argc, char* argv[])
 		model = glm::rotate(model, toRadians(0), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(20.0f, 1.0f, 20.0f));
 
-		// View matrix
+		// View matrix, from where the snapshots put the camera and the world
+		viewCamera.setPose(frameSnapshot.cameraPosition, frameSnapshot.cameraYaw, frameSnapshot.cameraPitch);
 		glm::mat4 view(1.0f);
-		view = glm::translate(view, glm::vec3(0.0f, currentYPos, 9.0f));
-		view = glm::rotate(view, toRadians(currentWorldXAngle), glm::vec3(1.0f, 0.0f, 0.0f)); // Rotating around X Axis
-		view = glm::rotate(view, toRadians(currentWorldYAngle), glm::vec3(0.0f, 1.0f, 0.0f)); // Rotating around Y Axis
-		view = camera.calculateViewMatrix() * view;
-
-		// Connect matrices with shaders
-		gridShader.setMatrix4Float("model", &model);
-		gridShader.setMatrix4Float("projection", &projection);
-		gridShader.setMatrix4Float("view", &view);
-
-		// Drawing the grid
-		// Setting the color (yellow)
-		gridShader.setFloat("r", 0.8f);
-		gridShader.setFloat("rg", 0.85f);
-		gridShader.setFloat("rgb", 0.0f);
-		meshList[0]->RenderMesh(GL_LINES);
-
-		// Drawing the letters
-
-        // If 1 is pressed, transform T with keyboard
-        if(selectedModel == 0){
-            objectList[0]->objectList[0]->Transform(window.getKeys());
-        }
-        // Setting color
-        gridShader.setFloat("r", 48.0f/255.0f);
-        gridShader.setFloat("rg", 26.0f/255.0f);
-        gridShader.setFloat("rgb", 75.0f/255.0f);
-        // Render T
-        objectList[0]->objectList[0]->RenderObject(objectList[0]->GetModelMatrix(), 0);
-
-        // If 2 is pressed, transform E with keyboard
-        if(selectedModel == 1){
-            objectList[0]->objectList[1]->Transform(window.getKeys());
-        }
-        // Setting color
-        gridShader.setFloat("r", 109.0f/255.0f);
-        gridShader.setFloat("rg", 177.0f/255.0f);
-        gridShader.setFloat("rgb", 191.0f/255.0f);
-        // Render E
-        objectList[0]->objectList[1]->RenderObject(objectList[0]->GetModelMatrix(), 0);
-
-        // If 3 is pressed, transform L1 with keyboard
-        if(selectedModel == 2){
-            objectList[0]->objectList[2]->Transform(window.getKeys());
-        }
-        // Setting color
-        gridShader.setFloat("r", 255.0f/255.0f);
-        gridShader.setFloat("rg", 224.0f/255.0f);
-        gridShader.setFloat("rgb", 236.0f/255.0f);
-        // Render L1
-        objectList[0]->objectList[2]->RenderObject(objectList[0]->GetModelMatrix(), 0);
-
-        // If 4 is pressed, transform L2 with keyboard
-        if(selectedModel == 3){
-            objectList[0]->objectList[3]->Transform(window.getKeys());
-        }
-        // Setting color
-        gridShader.setFloat("r", 243.0f/255.0f);
-        gridShader.setFloat("rg", 154.0f/255.0f);
-        gridShader.setFloat("rgb", 157.0f/255.0f);
-        // Render L2
-        objectList[0]->objectList[3]->RenderObject(objectList[0]->GetModelMatrix(), 0);
-
-        // If 5 is pressed, transform U with keyboard
-        if(selectedModel == 4){
-            objectList[0]->objectList[4]->Transform(window.getKeys());
-        }
-        // Setting color
-        gridShader.setFloat("r", 63.0f/255.0f);
-        gridShader.setFloat("rg", 108.0f/255.0f);
-        gridShader.setFloat("rgb", 81.0f/255.0f);
-        // Render U
-        objectList[0]->objectList[4]->RenderObject(objectList[0]->GetModelMatrix(), 0);
-
-        // If 6 is pressed, transform M with keyboard
-        if(selectedModel == 5){
-            objectList[0]->objectList[5]->Transform(window.getKeys());
+		view = glm::translate(view, glm::vec3(0.0f, frameSnapshot.worldYPos, 9.0f));
+		view = glm::rotate(view, toRadians(frameSnapshot.worldXAngle), glm::vec3(1.0f, 0.0f, 0.0f)); // Rotating around X Axis
+		view = glm::rotate(view, toRadians(frameSnapshot.worldYAngle), glm::vec3(0.0f, 1.0f, 0.0f)); // Rotating around Y Axis
+		view = viewCamera.calculateViewMatrix() * view;
+
+		// V cycles through the view layouts
+		if (window.consumeKeyPress(GLFW_KEY_V))
+		{
+			viewLayout = (viewLayout + 1) % VIEW_LAYOUT_COUNT;
+		}
+
+        // The views follow the letters, so place them where the snapshots put the letters
+        UpdateViews(view, frameSnapshot.letterBounds);
+
+		// Highlight whichever letter is selected
+		HighlightSelectedModel(frameSnapshot.selectedModel);
+
+        // Bake the letters that stand still, then record them once into per-letter command lists, replayed below by
+        // every view that sees them. Baked together, they are one list, seen by the views as a whole.
+        bool lettersBaked = BakeLetters(objectList[0].Get(), frameSnapshot);
+        RecordLetters(workerPool, letterDrawLists, objectList[0].Get(), frameSnapshot, uniformModel);
+        // Letters evicted while out of sight were recorded anyway; put them back before the lists are replayed
+        GPUMemory::RestoreRequested();
+        AABB allLetterBounds;
+        for (size_t i = 0; i < frameSnapshot.letterBounds.size(); i++)
+        {
+            allLetterBounds.Extend(frameSnapshot.letterBounds[i]);
         }
-        // Setting color
-        gridShader.setFloat("r", 223.0f/255.0f);
-        gridShader.setFloat("rg", 87.0f/255.0f);
-        gridShader.setFloat("rgb", 188.0f/255.0f);
-        // Render M
-        objectList[0]->objectList[5]->RenderObject(objectList[0]->GetModelMatrix(), 0);
 
         // Render object containing all letters
 		//objectList[0]->RenderObject();
 
+		// Everything changed so far is in this frame; anything changing from here on asks for the next one
+		RedrawSignal::Clear();
+
+		// Draw the scene in each view. The window was cleared as a whole; later views may cover earlier ones, so they clear their own rectangle.
+		GLState::Enable(GL_SCISSOR_TEST);
+		for (size_t v = 0; v < views.size(); v++)
+		{
+			glm::vec4 viewport = views[v].Apply(renderWidth, renderHeight);
+			if (v > 0)
+			{
+				GLState::Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			}
+
+			// Connect matrices with shaders
+			glm::mat4 viewMatrix = views[v].view;
+			glm::mat4 projection = views[v].projection;
+			if (terrain.IsOpen())
+			{
+				RENDER_STATS_SCOPE("terrain");
+				terrainShader.use();
+				terrainShader.setMatrix4Float("projection", &projection);
+				terrainShader.setMatrix4Float("view", &viewMatrix);
+				terrain.Draw(terrainShader, viewMatrix, projection, views[v].frustum);
+			}
+			else
+			{
+				RENDER_STATS_SCOPE("grid");
+				gridShader.use();
+				gridShader.setMatrix4Float("model", &model);
+				gridShader.setMatrix4Float("projection", &projection);
+				gridShader.setMatrix4Float("view", &viewMatrix);
+
+				// Drawing the grid (its color is set once, in createGrid)
+				meshList[0]->RenderMesh(GL_LINES);
+			}
+
+			sceneShader.use();
+			sceneShader.setMatrix4Float("projection", &projection);
+			sceneShader.setMatrix4Float("view", &viewMatrix);
+			sceneShader.setVec4("viewport", viewport);
+
+			// Drawing the letters this view can see
+			for (size_t i = 0; i < letterDrawLists.size(); i++)
+			{
+				if (views[v].frustum.Intersects(lettersBaked ? allLetterBounds : frameSnapshot.letterBounds[i]))
+				{
+					RENDER_STATS_SCOPE(lettersBaked ? objectList[0]->GetName() : objectList[0]->objectList[i]->GetName());
+					letterDrawLists[i].Execute();
+				}
+			}
+
+			{
+				RENDER_STATS_SCOPE(objectList[1]->GetName());
+
+				// Identity model matrix for the axes
+				glm::mat4 identity(1.0f);
+				sceneShader.setMatrix4Float("model", &identity);
+
+				// Render the set of axis (red X, green Y, blue Z, set in CreateAxes)
+				objectList[1]->meshList[0]->RenderMesh(GL_TRIANGLE_STRIP);
+				objectList[1]->meshList[1]->RenderMesh(GL_TRIANGLE_STRIP);
+				objectList[1]->meshList[2]->RenderMesh(GL_TRIANGLE_STRIP);
+			}
+
+			DrawStreamedMeshes(views[v], uniformModel, gridShader);
+		}
+		GLState::Disable(GL_SCISSOR_TEST);
 
-        // Resetting the matrix
-		model = glm::mat4(1.0f);
-		gridShader.setMatrix4Float("model", &model);
+		// Ask for the terrain chunks the views are missing, and free the ones unused for longest
+		terrain.EndFrame();
 
-		// Render the set of axis
-		// Setting the colors gridShader.setFloat("r", 1.0);
-		gridShader.setFloat("rg", 0.0f);
-		gridShader.setFloat("rgb", 0.0f);
-		objectList[1]->meshList[0]->RenderMesh(GL_TRIANGLE_STRIP);
+		// Make room for the next frames, if this one went over the GPU memory budget, at the expense of meshes not drawn lately
+		GPUMemory::EndFrame();
 
-		gridShader.setFloat("r", 0.0f);
-		gridShader.setFloat("rg", 1.0f);
-		gridShader.setFloat("rgb", 0.0f);
-		objectList[1]->meshList[1]->RenderMesh(GL_TRIANGLE_STRIP);
+		// Scale the offscreen frame up to the window
+		if (gpuBudget > 0)
+		{
+			resolution.EndFrame();
+			sceneTarget.BlitToWindow(renderWidth, renderHeight, window.getBufferWidth(), window.getBufferHeight());
+		}
+		GLState::Viewport(0, 0, window.getBufferWidth(), window.getBufferHeight());
 
-		gridShader.setFloat("r", 0.0f);
-		gridShader.setFloat("rg", 0.0f);
-		gridShader.setFloat("rgb", 1.0f);
-		objectList[1]->meshList[2]->RenderMesh(GL_TRIANGLE_STRIP);
+		sceneShader.free();
 
-		gridShader.free();
+		if (printGLStats && glfwGetTime() - lastGLStatsTime >= 1.0)
+		{
+			PrintGLStateCounters(GLState::GetFrameCounters());
+			if (gpuBudget > 0)
+			{
+				printf("Render scale %.2f (%dx%d), GPU time %.2f ms of %d ms\n", resolution.GetScale(), renderWidth, renderHeight,
+					resolution.GetGPUTime() * 1000.0, gpuBudget);
+			}
+			if (terrain.IsOpen())
+			{
+				Terrain::Stats terrainStats = terrain.GetStats();
+				printf("Terrain: %u chunks and %u triangles drawn, %u chunks resident (%.1f MB), %u loading\n", terrainStats.drawnChunks,
+					terrainStats.drawnTriangles, terrainStats.residentChunks, terrainStats.residentBytes / (1024.0 * 1024.0), terrainStats.loadingChunks);
+			}
+			GPUMemoryStats memoryStats = GPUMemory::GetStats();
+			printf("GPU memory: %.1f MB (vertices %.1f, indices %.1f, readback %.1f, render targets %.1f)", memoryStats.Total() / (1024.0 * 1024.0),
+				memoryStats.bytes[(int)GPUMemoryCategory::VertexBuffer] / (1024.0 * 1024.0), memoryStats.bytes[(int)GPUMemoryCategory::IndexBuffer] / (1024.0 * 1024.0),
+				memoryStats.bytes[(int)GPUMemoryCategory::PixelBuffer] / (1024.0 * 1024.0), memoryStats.bytes[(int)GPUMemoryCategory::Renderbuffer] / (1024.0 * 1024.0));
+			if (GPUMemory::GetBudget() > 0)
+			{
+				printf(" of %.1f MB, %u meshes evicted and %u restored so far", GPUMemory::GetBudget() / (1024.0 * 1024.0), memoryStats.evictedMeshes, memoryStats.restoredMeshes);
+			}
+			printf("\n");
+			if (streamer.GetAssetCount() > 0)
+			{
+				AssetStreamer::Stats streamStats = streamer.GetStats();
+				printf("Streamed meshes: %u resident, %u uploading, %u loading, %u failed, %.1f KB uploaded last frame\n", streamStats.resident,
+					streamStats.uploading, streamStats.loading, streamStats.failed, streamStats.uploadedBytes / 1024.0);
+			}
+			lastGLStatsTime = glfwGetTime();
+		}
 
-		//check and call events and swap buffers
+		// Read the frame back for the recording, then swap buffers; events are handled at the start of the next frame
+		capture.CaptureFrame(window.getBufferWidth(), window.getBufferHeight());
+		GLCapture::EndFrame();
 		window.swapBuffers();
-		glfwPollEvents();
+		pacer.EndFrame(inputTime);
+
+		if (printRenderStats && glfwGetTime() - lastRenderStatsTime >= 1.0)
+		{
+			ShowRenderStats(frameNumber);
+			lastRenderStatsTime = glfwGetTime();
+		}
+		frameNumber++;
+
+		if (printLatencyStats && glfwGetTime() - lastLatencyStatsTime >= 1.0)
+		{
+			FramePacer::LatencyStats latency = pacer.ConsumeLatencyStats();
+			if (latency.count > 0)
+			{
+				printf("Input to frame done: %.1f ms average, %.1f to %.1f ms over %u inputs (swap interval %d, frames in flight %u)\n",
+					latency.average * 1000.0, latency.minimum * 1000.0, latency.maximum * 1000.0, latency.count,
+					pacer.GetSwapInterval(), pacer.GetMaxFramesInFlight());
+			}
+			lastLatencyStatsTime = glfwGetTime();
+		}
+	}
+
+	// The simulation uses the scene, so it stops before the scene is destroyed
+	simulationThread.Stop();
+
+	if (capture.IsCapturing())
+	{
+		capture.Stop();
+		FrameCapture::Stats stats = capture.GetStats();
+		printf("Captured %u frames to %s (%u written, %u dropped), %.3f ms average and %.3f ms maximum added to each frame\n",
+			stats.captured, capturePath, stats.written, stats.dropped, stats.averageCaptureTime * 1000.0, stats.maximumCaptureTime * 1000.0);
+	}
+
+	// A GL capture cut short by closing the window keeps the frames recorded so far
+	GLCapture::Stop();
+
+	pacer.Clear();
+	resolution.Clear();
+	sceneTarget.Clear();
+	terrain.Close();
+	streamer.Stop();
+	IndependentMesh::Destroy(streamPlaceholder);
+
+	// Destroy the scene while the GL context still exists, since destroying meshes frees their buffers
+	for (size_t i = 0; i < objectList.size(); i++)
+	{
+		ComplexObject::Destroy(objectList[i]);
+	}
+	for (size_t i = 0; i < meshList.size(); i++)
+	{
+		Mesh::Destroy(meshList[i]);
 	}
 
 	glfwTerminate();
@@ -302,7 +724,7 @@ int main(int argc, char* argv[])
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	GLState::Viewport(0, 0, width, height);
 }
 
 void processInput(GLFWwindow* window)
@@ -316,50 +738,106 @@ float toRadians(float deg)
 	return deg * (3.14159265f / 180.0f);
 }
 
+bool HasArgument(int argc, char* argv[], const char* flag)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], flag) == 0)
+			return true;
+	}
+	return false;
+}
+
+int GetArgumentValue(int argc, char* argv[], const char* flag, int defaultValue)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], flag) == 0)
+			return atoi(argv[i + 1]);
+	}
+	return defaultValue;
+}
+
+const char* GetArgumentString(int argc, char* argv[], const char* flag, const char* defaultValue)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], flag) == 0)
+			return argv[i + 1];
+	}
+	return defaultValue;
+}
+
+void ShowRenderStats(unsigned int frameNumber)
+{
+#ifdef RENDER_STATS
+	const RenderCounters& frame = RenderStats::GetFrame();
+	printf("%s\n", RenderStats::ToJson(frameNumber).c_str());
+
+	char title[256];
+	snprintf(title, sizeof(title), "Assignment 1 | %u draws, %zu indices, %u VAO and %u program binds, %u uniforms (%.1f KB), %.1f KB to buffers",
+		frame.draws, frame.indices, frame.vertexArrayBinds, frame.programBinds, frame.uniformUploads, frame.uniformBytes / 1024.0,
+		frame.bufferBytes / 1024.0);
+	window.setTitle(title);
+#else
+	(void)frameNumber;
+#endif
+}
+
+void PrintGLStateCounters(const GLStateCounters& counters)
+{
+	const char* names[] = { "program", "vao", "buffer", "polygonMode", "uniform", "attribute", "draw" };
+
+	printf("GL calls per frame: %u issued, %u elided (issued/elided: ", counters.TotalIssued(), counters.TotalElided());
+	for (int i = 0; i < (int)GLCallType::Count; i++)
+	{
+		printf("%s%s %u/%u", i > 0 ? ", " : "", names[i], counters.issued[i], counters.elided[i]);
+	}
+	printf(")\n");
+}
+
 // Create grid to draw
 void createGrid(int squareCount)
 {
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
-
-	// Loops through each row, then for each column it creates a point clamped between 0 to 1
-	for (int i = 0; i <= squareCount; i++) {
-		for (int j = 0; j <= squareCount; j++) {
-			float x = (float)j / (float)squareCount;
-			float y = 0;
-			float z = (float)i / (float)squareCount;
-
-			vertices.push_back(x);
-			vertices.push_back(y);
-			vertices.push_back(z);
-		}
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	Shapes::Grid(squareCount, vertices, indices);
+
+	PrepareMesh(vertices, indices, GL_LINES, "grid");
+	Handle<Mesh> gridObj = Mesh::Create();
+	gridObj->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+	// Setting the color (yellow)
+	gridObj->SetColor(glm::vec3(0.8f, 0.85f, 0.0f));
+	meshList.push_back(gridObj);
+}
+
+void PrepareMesh(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, GLenum drawType, const char* name)
+{
+	bool first = std::find(preparedMeshNames.begin(), preparedMeshNames.end(), name) == preparedMeshNames.end();
+	MeshOptimizer::Report report;
+	MeshOptimizer::Optimize(vertices, NULL, indices, drawType, first && printMeshStats ? &report : NULL);
+	if (!first)
+	{
+		return;
 	}
+	preparedMeshNames.push_back(name);
 
-	// A double loop to connect all the vertices with the appropriate indices.
-	// First it top left to top right vertex, then top right with bottom right, then bottom right with bottom left and finally bottom left with top right. 
-	for (int i = 0; i < squareCount; i++) {
-		for (int j = 0; j < squareCount; j++) {
-			int top = i * (1 + squareCount);
-			int bottom = (i + 1) * (1 + squareCount);
-
-			// Top line
-			indices.push_back(top + j);
-			indices.push_back(top + j + 1);
-			// Right line
-			indices.push_back(top + j + 1);
-			indices.push_back(bottom + j + 1);
-			// Bottom line
-			indices.push_back(bottom + j + 1);
-			indices.push_back(bottom + j);
-			// Left line
-			indices.push_back(bottom + j);
-			indices.push_back(top + j);
+	if (printMeshStats)
+	{
+		const MeshOptimizer::Statistics* statistics[] = { &report.before, &report.after };
+		const char* labels[] = { "before", "after" };
+		for (int i = 0; i < 2; i++)
+		{
+			printf("Mesh %s %s: %u primitives, %u indices, ACMR %.3f, ATVR %.3f, overdraw %.3f\n", name, labels[i],
+				statistics[i]->primitiveCount, statistics[i]->indexCount, statistics[i]->acmr, statistics[i]->atvr, statistics[i]->overdraw);
 		}
 	}
 
-	Mesh* gridObj = new Mesh();
-	gridObj->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
-	meshList.push_back(gridObj);
+	if (meshExportDirectory != NULL)
+	{
+		std::string path = std::string(meshExportDirectory) + "/" + name + ".mesh";
+		MeshCodec::Save(path.c_str(), vertices, NULL, indices, drawType);
+	}
 }
 
 // Create letters individually and then add them to a single complex object to draw
@@ -371,38 +849,47 @@ void CreateLetters(Shader* shader) {
 	//////////////////////////////////////////
 
 	// Create letter T
-	ComplexObject* letterT = CreateLetterT(modelLocation);
+	ObjectHandle letterT = CreateLetterT(modelLocation);
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
     letterT->SetModelMatrix(model, modelLocation);
 
     // Create letter E
-    ComplexObject* letterE = CreateLetterE(modelLocation);
+    ObjectHandle letterE = CreateLetterE(modelLocation);
     model = glm::translate(model, glm::vec3(0.0f, 4.7f, 0.0f));
     letterE->SetModelMatrix(model, modelLocation);
 
     // Create letter L
-    ComplexObject* letterL1 = CreateLetterL(modelLocation);
+    ObjectHandle letterL1 = CreateLetterL(modelLocation);
     model = glm::translate(model, glm::vec3(0.0f, 4.7f, 0.0f));
     letterL1->SetModelMatrix(model, modelLocation);
 
     // Create another letter L
-    ComplexObject* letterL2 = CreateLetterL(modelLocation);
+    ObjectHandle letterL2 = CreateLetterL(modelLocation);
     model = glm::translate(model, glm::vec3(0.0f, 4.7f, 0.0f));
     letterL2->SetModelMatrix(model, modelLocation);
 
     // Create letter U
-    ComplexObject* letterU = CreateLetterU(modelLocation);
+    ObjectHandle letterU = CreateLetterU(modelLocation);
     model = glm::translate(model, glm::vec3(0.0f, 4.7f, 0.0f));
     letterU->SetModelMatrix(model, modelLocation);
 
     // Create letter M
-    ComplexObject* letterM = CreateLetterM(modelLocation);
+    ObjectHandle letterM = CreateLetterM(modelLocation);
     model = glm::translate(model, glm::vec3(0.0f, 4.3f, 0.0f));
     letterM->SetModelMatrix(model, modelLocation);
 
+    // Names under which --render-stats counts the letters
+    letterT->SetName("letter T");
+    letterE->SetName("letter E");
+    letterL1->SetName("letter L1");
+    letterL2->SetName("letter L2");
+    letterU->SetName("letter U");
+    letterM->SetName("letter M");
+
     // Complex object for all letters
-	ComplexObject* IanNameAndID = new ComplexObject();
+	ObjectHandle IanNameAndID = ComplexObject::Create();
+    IanNameAndID->SetName("letters");
 
     IanNameAndID->objectList.push_back(letterT);
     IanNameAndID->objectList.push_back(letterE);
@@ -411,6 +898,12 @@ void CreateLetters(Shader* shader) {
     IanNameAndID->objectList.push_back(letterU);
     IanNameAndID->objectList.push_back(letterM);
 
+    // Setting the letter colors
+    for (size_t i = 0; i < IanNameAndID->objectList.size(); i++)
+    {
+        IanNameAndID->objectList[i]->SetColor(letterColors[i % LETTER_COLOR_COUNT]);
+    }
+
     // Scale letters to a reasonable size and push to back of grid in z
     model = glm::mat4(1.0f);
     model = glm::scale(model, glm::vec3(0.25f,0.25f,0.25f));
@@ -447,32 +940,34 @@ void CreateAxes(Shader* shader)
 		0, 3
 	};
 
-	ComplexObject* axes = new ComplexObject();
+	ObjectHandle axes = ComplexObject::Create();
 
 	// Moving the set of axis
 	glm::mat4 model = glm::mat4(1.0f);
 
-	IndependentMesh* objX = CreateCylinder(0.125);
+	MeshHandle objX = CreateCylinder(0.125);
 	model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     objX->SetModelMatrix(model, modelLocation);
+	objX->SetColor(glm::vec3(1.0f, 0.0f, 0.0f));
 	axes->meshList.push_back(objX);
 
-	IndependentMesh* objY = CreateCylinder(0.125);
+	MeshHandle objY = CreateCylinder(0.125);
     model = glm::mat4(1.0f);
+	objY->SetColor(glm::vec3(0.0f, 1.0f, 0.0f));
 	axes->meshList.push_back(objY);
 
-	IndependentMesh* objZ = CreateCylinder(0.125);
+	MeshHandle objZ = CreateCylinder(0.125);
 	model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     objZ->SetModelMatrix(model, modelLocation);
+	objZ->SetColor(glm::vec3(0.0f, 0.0f, 1.0f));
 	axes->meshList.push_back(objZ);
 
 	objectList.push_back(axes);
 }
 
 // Select model to transform with keyboard
-void SelectModel()
+void SelectModel(bool* keys)
 {
-    bool *keys = window.getKeys();
     // Set global variable to index of model in ComplexObject vector
     if(keys[GLFW_KEY_1]) selectedModel = 0;
     if(keys[GLFW_KEY_2]) selectedModel = 1;
@@ -480,188 +975,468 @@ void SelectModel()
     if(keys[GLFW_KEY_4]) selectedModel = 3;
     if(keys[GLFW_KEY_5]) selectedModel = 4;
     if(keys[GLFW_KEY_6]) selectedModel = 5;
+}
 
+// Find the ray under the mouse cursor when clicking
+bool GetClickRay(glm::vec3& origin, glm::vec3& direction)
+{
+    GLfloat clickX, clickY;
+    if (!window.consumeClick(clickX, clickY))
+    {
+        return false;
+    }
+
+    // Later views are drawn over earlier ones, so the last view containing the click is the one that was clicked.
+    bool inView = false;
+    for (size_t v = views.size(); v > 0 && !inView; v--)
+    {
+        inView = views[v - 1].ScreenPointToRay(clickX, clickY, window.getWidth(), window.getHeight(), origin, direction);
+    }
+    return inView;
 }
 
-// Creates a unit sphere - taken from https://gist.github.com/zwzmzd/0195733fa1210346b00d
-IndependentMesh* CreateSphere(){
-    int lats = 40;
-    int longs = 40;
+// Select the letter hit by the click's ray
+void PickModel(const glm::vec3& origin, const glm::vec3& direction)
+{
+    int picked = picker.Pick(origin, direction);
+    if (picked >= 0)
+    {
+        selectedModel = (unsigned int)picked;
+    }
+}
+
+// Highlight the selected letter only
+void HighlightSelectedModel(unsigned int selected)
+{
+    if (highlightedModel == (int)selected)
+    {
+        return;
+    }
+
+    std::vector<ObjectHandle>& letters = objectList[0]->objectList;
+    if (highlightedModel >= 0)
+    {
+        letters[highlightedModel]->SetHighlight(false);
+    }
+    letters[selected]->SetHighlight(true);
+    highlightedModel = (int)selected;
+}
 
-    int i, j;
+// Hand the input to the simulation thread
+void SubmitInput()
+{
+    SimulationInput input;
+    bool* keys = window.getKeys();
+    for (int i = 0; i < 1024; i++)
+    {
+        input.keys[i] = keys[i];
+    }
+    input.held = window.isInputHeld();
+    window.consumeMouseDelta(input.mouseDeltaX, input.mouseDeltaY);
+    input.toggleAnimation = window.consumeKeyPress(GLFW_KEY_N);
+    input.pickPending = GetClickRay(input.pickOrigin, input.pickDirection);
+
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(simulationInputMutex);
+        simulationInput.Merge(input);
+        active = simulationInput.IsActive();
+    }
+    if (active)
+    {
+        simulationThread.Wake();
+    }
+}
+
+bool SimulateStep()
+{
+    // Take the input gathered since the last step
+    {
+        std::lock_guard<std::mutex> lock(simulationInputMutex);
+        stepInput = simulationInput;
+        simulationInput.ClearEvents();
+    }
+    bool* keys = stepInput.keys;
+
+    // Camera movement
+    camera.pan(keys, stepInput.mouseDeltaX);
+    camera.tilt(keys, stepInput.mouseDeltaY);
+    camera.magnify(keys, stepInput.mouseDeltaY);
+    camera.movementFromKeyboard(keys);
+
+    // Handling rotations
+    // Rotating the entire world dependent on key presses.
+        // We rotate around the X-Axis
+    if (keys[GLFW_KEY_LEFT])
+    {
+        // Anticlockwise rotation
+        currentWorldXAngle += worldRotationIncrement;
+    }
+    if (keys[GLFW_KEY_RIGHT])
+    {
+        // Clockwise rotation
+        currentWorldXAngle -= worldRotationIncrement;
+    }
+    if (keys[GLFW_KEY_UP])
+    {
+        // Anticlockwise rotation
+        currentWorldYAngle += worldRotationIncrement;
+    }
+    if (keys[GLFW_KEY_DOWN])
+    {
+        // Clockwise rotation
+        currentWorldYAngle -= worldRotationIncrement;
+    }
+    if (keys[GLFW_KEY_HOME])
+    {
+        // Reset to default rotation.
+        currentWorldXAngle = BASE_WORLD_XANGLE;
+        currentWorldYAngle = BASE_WORLD_YANGLE;
+    }
+
+    // Handling vertical camera movement
+    if (keys[GLFW_KEY_EQUAL])
+    {
+        currentYPos -= worldPosIncrement;
+    }
+    if (keys[GLFW_KEY_MINUS])
+    {
+        currentYPos += worldPosIncrement;
+    }
+
+    // Seclect model to transform with keyboard
+    SelectModel(keys);
+
+    // N starts and stops the letter animation
+    if (stepInput.toggleAnimation)
+    {
+        if (animator.GetPlayingCount() > 0)
+        {
+            StopLetterAnimation();
+        }
+        else
+        {
+            StartLetterAnimation();
+        }
+    }
+
+    if (animator.GetPlayingCount() > 0)
+    {
+        // The animation moves the letters: keep picking and collisions in step with them.
+        animator.Update((float)SIMULATION_STEP);
+        TransformStore::Global().ComposeDirty();
+        collisions.RefitAll();
+        for (size_t i = 0; i < objectList[0]->objectList.size(); i++)
+        {
+            picker.Refit((unsigned int)i);
+        }
+    }
+
+    // Transform the selected letter with keyboard (1 to 6 select T, E, L1, L2, U, M), unless it is animated
+    ObjectHandle letter = objectList[0]->objectList[selectedModel];
+    TRS previousTransform = letter->GetTransform();
+    if (animator.GetPlayingCount() == 0 && letter->Transform(keys))
+    {
+        collisions.Refit(selectedModel);
+        if (collisions.IsColliding(selectedModel))
+        {
+            // The move would push the letter into another one: undo it
+            letter->SetTransform(previousTransform);
+            collisions.Refit(selectedModel);
+        }
+        else
+        {
+            // Keep the picking structure in sync with the letter's new place
+            picker.Refit(selectedModel);
+        }
+    }
+
+    // Click to select a letter
+    if (stepInput.pickPending)
+    {
+        PickModel(stepInput.pickOrigin, stepInput.pickDirection);
+    }
+
+    // Publish the step and wake the main thread to draw it
+    PublishSnapshot();
+    glfwPostEmptyEvent();
+
+    return stepInput.held || animator.GetPlayingCount() > 0;
+}
+
+void PublishSnapshot()
+{
+    // Compose the matrices edited this step in one pass.
+    TransformStore::Global().ComposeDirty();
+
+    SceneSnapshot& snapshot = snapshots.GetWriteBuffer();
+    snapshot.time = glfwGetTime();
+    snapshot.cameraPosition = camera.getPosition();
+    snapshot.cameraYaw = camera.getYaw();
+    snapshot.cameraPitch = camera.getPitch();
+    snapshot.worldXAngle = currentWorldXAngle;
+    snapshot.worldYAngle = currentWorldYAngle;
+    snapshot.worldYPos = currentYPos;
+
+    std::vector<ObjectHandle>& letters = objectList[0]->objectList;
+    snapshot.lettersMatrix = objectList[0]->GetModelMatrix();
+    snapshot.letterTransforms.resize(letters.size());
+    snapshot.letterBounds.resize(letters.size());
+    for (size_t i = 0; i < letters.size(); i++)
+    {
+        snapshot.letterTransforms[i] = letters[i]->GetTransform();
+        snapshot.letterBounds[i] = collisions.GetObjectBounds((unsigned int)i);
+    }
+    snapshot.selectedModel = selectedModel;
+
+    snapshots.Publish();
+}
+
+// Record the letter draws on the worker threads
+bool BakeLetters(ComplexObject* letters, const SceneSnapshot& snapshot)
+{
+    // The letters' transformations belong to the simulation, so they are baked where the snapshot puts them
+    static std::vector<glm::mat4> letterMatrices;
+    letterMatrices.resize(snapshot.letterTransforms.size());
+    for (size_t i = 0; i < letterMatrices.size(); i++)
+    {
+        letterMatrices[i] = snapshot.letterTransforms[i].ToMatrix();
+    }
+    return letters->UpdateBake(glfwGetTime(), letterMatrices.empty() ? NULL : &letterMatrices[0]);
+}
+
+void RecordLetters(WorkerPool& pool, std::vector<CommandList>& lists, ComplexObject* letters, const SceneSnapshot& snapshot, GLuint uniformModel)
+{
+    if (letters->IsBaked())
+    {
+        lists.resize(1);
+        lists[0].Clear();
+        letters->RecordObjectAt(lists[0], snapshot.lettersMatrix, uniformModel);
+        return;
+    }
+
+    lists.resize(letters->objectList.size());
+
+    pool.ParallelFor(letters->objectList.size(), [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            // Each letter has its own list, so workers never share one. Colors travel with the meshes,
+            // so there is no uniform to set between letters. The letters are drawn where the snapshot puts
+            // them, while the simulation may be moving them on.
+            lists[i].Clear();
+            glm::mat4 letterMatrix = snapshot.lettersMatrix * snapshot.letterTransforms[i].ToMatrix();
+            letters->objectList[i]->RecordObjectAt(lists[i], letterMatrix, uniformModel);
+        }
+    }, MIN_LETTERS_PER_WORKER);
+}
+
+void UpdateViews(const glm::mat4& mainView, const std::vector<AABB>& letterBounds)
+{
+    views.clear();
+    if (viewLayout == VIEW_LAYOUT_WALL)
+    {
+        // Main camera top left, then top, front and side cameras.
+        views.push_back(SceneView(0.0f, 0.5f, 0.5f, 0.5f));
+        views.push_back(SceneView(0.5f, 0.5f, 0.5f, 0.5f));
+        views.push_back(SceneView(0.0f, 0.0f, 0.5f, 0.5f));
+        views.push_back(SceneView(0.5f, 0.0f, 0.5f, 0.5f));
+    }
+    else if (viewLayout == VIEW_LAYOUT_INSET)
+    {
+        // Main camera over the whole window, top camera in the top right corner.
+        views.push_back(SceneView());
+        views.push_back(SceneView(0.7f, 0.7f, 0.28f, 0.28f));
+    }
+    else
+    {
+        views.push_back(SceneView());
+    }
+
+    GLint width = window.getBufferWidth();
+    GLint height = window.getBufferHeight();
+    views[0].SetCamera(mainView, MAIN_FIELD_OF_VIEW, width, height);
+    if (views.size() == 1)
+    {
+        return;
+    }
+
+    // The fixed cameras frame the letters' bounding sphere, wherever the letters are.
+    AABB bounds;
+    for (size_t i = 0; i < letterBounds.size(); i++)
+    {
+        bounds.Extend(letterBounds[i]);
+    }
+    glm::vec3 center = bounds.GetCenter();
+    float distance = glm::length(bounds.GetExtents()) / sin(OVERVIEW_FIELD_OF_VIEW * 0.5f);
+
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+    glm::mat4 overviews[3] = {
+        glm::lookAt(center + glm::vec3(0.0f, distance, 0.0f), center, glm::vec3(0.0f, 0.0f, -1.0f)),
+        glm::lookAt(center + glm::vec3(0.0f, 0.0f, distance), center, up),
+        glm::lookAt(center + glm::vec3(distance, 0.0f, 0.0f), center, up)
+    };
+    for (size_t v = 1; v < views.size(); v++)
+    {
+        views[v].SetCamera(overviews[v - 1], OVERVIEW_FIELD_OF_VIEW, width, height);
+    }
+}
+
+void DrawStreamedMeshes(const SceneView& view, GLuint uniformModel, Shader& lineShader)
+{
+    RENDER_STATS_SCOPE("streamed meshes");
+    unsigned int count = streamer.GetAssetCount();
+    std::vector<std::pair<unsigned int, glm::mat4>> lineMeshes;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (streamer.GetState(i) == AssetStreamer::State::Failed)
+        {
+            continue;
+        }
+
+        glm::vec3 slot = STREAMED_MESH_ROW + glm::vec3((i - (count - 1) * 0.5f) * STREAMED_MESH_SPACING, 0.0f, 0.0f);
+        glm::vec3 halfSize(STREAMED_MESH_SIZE * 0.5f);
+        if (!view.frustum.Intersects(AABB(slot - halfSize, slot + halfSize)))
+        {
+            continue;
+        }
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), slot);
+        if (!streamer.Use(i))
+        {
+            model = glm::scale(model, glm::vec3(STREAMED_MESH_SIZE * 0.5f));
+            streamPlaceholder->RenderMesh(model, uniformModel);
+            continue;
+        }
+
+        // Fit the mesh's box into the slot, whatever the units it was saved in
+        Handle<Mesh> mesh = streamer.GetMesh(i);
+        const AABB& bounds = mesh->GetBounds();
+        glm::vec3 extents = bounds.GetExtents();
+        float largest = std::max(extents.x, std::max(extents.y, extents.z));
+        if (largest > 0.0f)
+        {
+            model = glm::scale(model, glm::vec3(STREAMED_MESH_SIZE * 0.5f / largest));
+        }
+        model = glm::translate(model, -bounds.GetCenter());
+
+        GLenum drawType = streamer.GetDrawType(i);
+        if (drawType != GL_TRIANGLES && drawType != GL_TRIANGLE_STRIP && drawType != GL_TRIANGLE_FAN)
+        {
+            lineMeshes.push_back(std::make_pair(i, model));
+            continue;
+        }
+        GLState::UniformMatrix4fv(uniformModel, &model[0][0]);
+        mesh->RenderMesh(drawType);
+    }
+
+    // Lines and points after the triangles, so the shaders are switched once
+    if (lineMeshes.empty())
+    {
+        return;
+    }
+    glm::mat4 projection = view.projection;
+    glm::mat4 viewMatrix = view.view;
+    lineShader.use();
+    lineShader.setMatrix4Float("projection", &projection);
+    lineShader.setMatrix4Float("view", &viewMatrix);
+    for (size_t i = 0; i < lineMeshes.size(); i++)
+    {
+        lineShader.setMatrix4Float("model", &lineMeshes[i].second);
+        streamer.GetMesh(lineMeshes[i].first)->RenderMesh(streamer.GetDrawType(lineMeshes[i].first));
+    }
+}
+
+void StartLetterAnimation()
+{
+    const float HOP_HEIGHT = 2.0f;
+    const float HOP_DURATION = 0.5f;
+    const float LETTER_DELAY = 0.15f;
+
+    std::vector<ObjectHandle>& letters = objectList[0]->objectList;
+    letterRestTransforms.clear();
+
+    for (size_t i = 0; i < letters.size(); i++)
+    {
+        TRS rest = letters[i]->GetTransform();
+        letterRestTransforms.push_back(rest);
+
+        // Two hops per turn, a quarter turn about the letter's own vertical axis per key.
+        AnimationClip clip;
+        for (int key = 0; key <= 4; key++)
+        {
+            TRS pose = rest;
+            glm::quat spin = glm::angleAxis(glm::radians(90.0f * key), glm::vec3(0.0f, 1.0f, 0.0f));
+            pose.rotation = rest.rotation * spin;
+            if (key % 2 == 1)
+            {
+                pose.translation += glm::vec3(0.0f, HOP_HEIGHT, 0.0f);
+            }
+            clip.AddKey(HOP_DURATION * key, pose);
+        }
+
+        // Each letter gets its own clip since they start from different places. Starting each one further back in
+        // its clip than the previous one makes them hop one after the other.
+        animator.Play(letters[i]->GetTransformIndex(), animator.AddClip(clip), -LETTER_DELAY * i);
+    }
+}
+
+void StopLetterAnimation()
+{
+    std::vector<ObjectHandle>& letters = objectList[0]->objectList;
+    animator.Clear();
+
+    for (size_t i = 0; i < letters.size() && i < letterRestTransforms.size(); i++)
+    {
+        letters[i]->SetTransform(letterRestTransforms[i]);
+    }
+    collisions.RefitAll();
+    for (size_t i = 0; i < letters.size(); i++)
+    {
+        picker.Refit((unsigned int)i);
+    }
+}
+
+// Creates a unit sphere
+MeshHandle CreateSphere(){
     std::vector<GLfloat> vertices;
     std::vector<GLuint> indices;
-    int indicator = 0;
-    for(i = 0; i <= lats; i++) {
-        double lat0 = glm::pi<double>() * (-0.5 + (double) (i - 1) / lats);
-        // Set radius to 0.25
-       double z0  = sin(lat0);
-       double zr0 =  cos(lat0);
-
-       double lat1 = glm::pi<double>() * (-0.5 + (double) i / lats);
-       double z1  = sin(lat1);
-       double zr1 =  cos(lat1);
-
-       for(j = 0; j <= longs; j++) {
-           double lng = 2 * glm::pi<double>() * (double) (j - 1) / longs;
-           double x = cos(lng);
-           double y = sin(lng);
-
-           vertices.push_back(x * zr0);
-           vertices.push_back(y * zr0);
-           vertices.push_back(z0);
-           indices.push_back(indicator);
-           indicator++;
-
-           vertices.push_back(x * zr1);
-           vertices.push_back(y * zr1);
-           vertices.push_back(z1);
-           indices.push_back(indicator);
-           indicator++;
-       }
-       indices.push_back(GL_PRIMITIVE_RESTART_FIXED_INDEX);
-   }
-    IndependentMesh* sphere = new IndependentMesh();
+    Shapes::Sphere(SPHERE_SEGMENTS, SPHERE_SEGMENTS, vertices, indices);
+    PrepareMesh(vertices, indices, GL_TRIANGLE_STRIP, "sphere");
+    MeshHandle sphere = IndependentMesh::Create();
     sphere->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+    sphere->SetCollisionShape(ConvexShape::Type::Sphere);
     return sphere;
 }
 
 // Creates a unit cube
-IndependentMesh* CreateCube(){
-    std::vector<GLuint> indices = {
-            // front
-            0, 1, 2,
-            2, 3, 0,
-            // right
-            1, 5, 6,
-            6, 2, 1,
-            // back
-            7, 6, 5,
-            5, 4, 7,
-            // left
-            4, 0, 3,
-            3, 7, 4,
-            // bottom
-            4, 5, 1,
-            1, 0, 4,
-            // top
-            3, 2, 6,
-            6, 7, 3
-    };
-
-    std::vector<GLfloat> vertices = {
-            // front
-            -0.5, -0.5,  0.5,
-            0.5, -0.5,  0.5,
-            0.5,  0.5,  0.5,
-            -0.5,  0.5,  0.5,
-            // back
-            -0.5, -0.5, -0.5,
-            0.5, -0.5, -0.5,
-            0.5,  0.5, -0.5,
-            -0.5,  0.5, -0.5
-    };
+MeshHandle CreateCube(){
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    Shapes::Cube(vertices, indices);
 
-    IndependentMesh* cube = new IndependentMesh();
+    PrepareMesh(vertices, indices, GL_TRIANGLE_STRIP, "cube");
+    MeshHandle cube = IndependentMesh::Create();
     cube->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+    cube->SetCollisionShape(ConvexShape::Type::Box);
     return cube;
 
 }
 
-// Creates a 0.25 x 2.5 cylinder. Modified from https://gist.github.com/zwzmzd/0195733fa1210346b00d
-IndependentMesh* CreateCylinder(double radius){
-    int lats = 40;
-
-    int i;
+// Creates a 0.25 x 2.5 cylinder
+MeshHandle CreateCylinder(double radius){
     std::vector<GLfloat> vertices;
     std::vector<GLuint> indices;
-    int indicator = 0;
-    for(i = 0; i <= lats; i++) {
-        //First build circle
-        double ang0 = 2 * glm::pi<double>() * ((double) (i - 1) / lats);
-        double z0  = radius * sin(ang0);
-        double x0 =  radius * cos(ang0);
-
-        double ang1 = 2 * glm::pi<double>() * ((double) i / lats);
-        double z1 = radius * sin(ang1);
-        double x1 = radius * cos(ang1);
-
-        // Sides
-        // Bottom vertices
-        vertices.push_back(x0);
-        vertices.push_back(0.0);
-        vertices.push_back(z0);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(x1);
-        vertices.push_back(0.0);
-        vertices.push_back(z1);
-        indices.push_back(indicator);
-        indicator++;
-
-
-        // Sides
-        // Top vertices
-        vertices.push_back(x0);
-        vertices.push_back(2.5);
-        vertices.push_back(z0);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(x1);
-        vertices.push_back(2.5);
-        vertices.push_back(z1);
-        indices.push_back(indicator);
-        indicator++;
-
-        // End faces
-        // Top face
-        vertices.push_back(x0);
-        vertices.push_back(2.5);
-        vertices.push_back(z0);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(x1);
-        vertices.push_back(2.5);
-        vertices.push_back(z1);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(0);
-        vertices.push_back(2.5);
-        vertices.push_back(0);
-        indices.push_back(indicator);
-        indicator++;
-
-        // Bottom face
-        vertices.push_back(x0);
-        vertices.push_back(0);
-        vertices.push_back(z0);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(x1);
-        vertices.push_back(0);
-        vertices.push_back(z1);
-        indices.push_back(indicator);
-        indicator++;
-
-        vertices.push_back(0);
-        vertices.push_back(0);
-        vertices.push_back(0);
-        indices.push_back(indicator);
-        indicator++;
-   }
-    IndependentMesh* cylinder = new IndependentMesh();
+    Shapes::Cylinder(radius, SPHERE_SEGMENTS, vertices, indices);
+    PrepareMesh(vertices, indices, GL_TRIANGLE_STRIP, "cylinder");
+    MeshHandle cylinder = IndependentMesh::Create();
     cylinder->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
     return cylinder;
 }
 
 // Transforms base unit sphere into a 0.25 x 1.00 ellipsoid to be used as vertical portion of letters
-IndependentMesh* CreateVertical(GLuint uniformModel){
-   IndependentMesh* vert = CreateSphere();
+MeshHandle CreateVertical(GLuint uniformModel){
+   MeshHandle vert = CreateSphere();
    glm::mat4 partModel(1.0f);
    partModel = glm::scale(partModel, glm::vec3(0.25f, 1.0f, 0.25f));
    vert->SetModelMatrix(partModel, uniformModel);
@@ -669,8 +1444,8 @@ IndependentMesh* CreateVertical(GLuint uniformModel){
 }
 
 // Transforms base unit cube into a 1.0 x 0.5 x 0.25 rectangle to be used as horizontal portion of letters
-IndependentMesh* CreateHorizontal(GLuint uniformModel){
-    IndependentMesh* horizontal = CreateCube();
+MeshHandle CreateHorizontal(GLuint uniformModel){
+    MeshHandle horizontal = CreateCube();
     glm::mat4 partModel(1.0f);
     partModel = glm::scale(partModel, glm::vec3(1.0f, 0.5f, 0.25f));
     horizontal->SetModelMatrix(partModel, uniformModel);
@@ -678,53 +1453,53 @@ IndependentMesh* CreateHorizontal(GLuint uniformModel){
 }
 
 // Creates a complex object for the letter M
-ComplexObject* CreateLetterM(GLuint uniformModel){
-    ComplexObject* letterM = new ComplexObject();
+ObjectHandle CreateLetterM(GLuint uniformModel){
+    ObjectHandle letterM = ComplexObject::Create();
 
     // Bottom left vertical
-    IndependentMesh* m1 = CreateVertical(uniformModel);
+    MeshHandle m1 = CreateVertical(uniformModel);
     glm::mat4 partModel = m1->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-4.0f, 0.0f, 0.0f));
     m1->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m1);
 
     // Top left vertical
-    IndependentMesh* m2 = CreateVertical(uniformModel);
+    MeshHandle m2 = CreateVertical(uniformModel);
     partModel = m2->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-4.0f, 2.0f, 0.0f));
     m2->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m2);
 
     // Middle vertical
-    IndependentMesh* m3 = CreateVertical(uniformModel);
+    MeshHandle m3 = CreateVertical(uniformModel);
     partModel = m3->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.0f, 2.0f, 0.0f));
     m3->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m3);
 
     // Bottom right vertical
-    IndependentMesh* m4 = CreateVertical(uniformModel);
+    MeshHandle m4 = CreateVertical(uniformModel);
     partModel = m4->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 0.0f, 0.0f));
     m4->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m4);
 
     // Top left vertical
-    IndependentMesh* m5 = CreateVertical(uniformModel);
+    MeshHandle m5 = CreateVertical(uniformModel);
     partModel = m5->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 2.0f, 0.0f));
     m5->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m5);
 
     // Bottom left horizontal
-    IndependentMesh* m6 = CreateHorizontal(uniformModel);
+    MeshHandle m6 = CreateHorizontal(uniformModel);
     partModel = m6->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, 6.0, 0.0));
     m6->SetModelMatrix(partModel, uniformModel);
     letterM->meshList.push_back(m6);
 
     // Bottom right horizontal
-    IndependentMesh* m7 = CreateHorizontal(uniformModel);
+    MeshHandle m7 = CreateHorizontal(uniformModel);
     partModel = m7->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, 6.0, 0.0));
     m7->SetModelMatrix(partModel, uniformModel);
@@ -734,46 +1509,46 @@ ComplexObject* CreateLetterM(GLuint uniformModel){
 }
 
 // Creates a complex object for the letter U
-ComplexObject* CreateLetterU(GLuint uniformModel){
-    ComplexObject* letterU = new ComplexObject();
+ObjectHandle CreateLetterU(GLuint uniformModel){
+    ObjectHandle letterU = ComplexObject::Create();
 
     // Bottom left vertical
-    IndependentMesh* u1 = CreateVertical(uniformModel);
+    MeshHandle u1 = CreateVertical(uniformModel);
     glm::mat4 partModel = u1->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-4.0f, 0.0f, 0.0f));
     u1->SetModelMatrix(partModel, uniformModel);
     letterU->meshList.push_back(u1);
 
     // Top left vertical
-    IndependentMesh* u2 = CreateVertical(uniformModel);
+    MeshHandle u2 = CreateVertical(uniformModel);
     partModel = u2->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-4.0f, 2.0f, 0.0f));
     u2->SetModelMatrix(partModel, uniformModel);
     letterU->meshList.push_back(u2);
 
     // Top right vertical
-    IndependentMesh* u3 = CreateVertical(uniformModel);
+    MeshHandle u3 = CreateVertical(uniformModel);
     partModel = u3->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 2.0f, 0.0f));
     u3->SetModelMatrix(partModel, uniformModel);
     letterU->meshList.push_back(u3);
 
     // Bottom right vertical
-    IndependentMesh* u4 = CreateVertical(uniformModel);
+    MeshHandle u4 = CreateVertical(uniformModel);
     partModel = u4->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 0.0f, 0.0f));
     u4->SetModelMatrix(partModel, uniformModel);
     letterU->meshList.push_back(u4);
 
     // Bottom left horizontal
-    IndependentMesh* u5 = CreateHorizontal(uniformModel);
+    MeshHandle u5 = CreateHorizontal(uniformModel);
     partModel = u5->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, -2.0, 0.0));
     u5->SetModelMatrix(partModel, uniformModel);
     letterU->meshList.push_back(u5);
 
     // Bottom right horizontal
-    IndependentMesh* u6 = CreateHorizontal(uniformModel);
+    MeshHandle u6 = CreateHorizontal(uniformModel);
     partModel = u6->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, -2.0, 0.0));
     u6->SetModelMatrix(partModel, uniformModel);
@@ -783,32 +1558,32 @@ ComplexObject* CreateLetterU(GLuint uniformModel){
 }
 
 // Creates a complex object for the letter L
-ComplexObject* CreateLetterL(GLuint uniformModel){
-    ComplexObject* letterL = new ComplexObject();
+ObjectHandle CreateLetterL(GLuint uniformModel){
+    ObjectHandle letterL = ComplexObject::Create();
 
     // Bottom left vertical
-    IndependentMesh* l1 = CreateVertical(uniformModel);
+    MeshHandle l1 = CreateVertical(uniformModel);
     glm::mat4 partModel = l1->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 0.0f, 0.0f));
     l1->SetModelMatrix(partModel, uniformModel);
     letterL->meshList.push_back(l1);
 
     // Top left vertical
-    IndependentMesh* l2 = CreateVertical(uniformModel);
+    MeshHandle l2 = CreateVertical(uniformModel);
     partModel = l2->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 2.0f, 0.0f));
     l2->SetModelMatrix(partModel, uniformModel);
     letterL->meshList.push_back(l2);
 
     // Bottom left horizontal
-    IndependentMesh* l3 = CreateHorizontal(uniformModel);
+    MeshHandle l3 = CreateHorizontal(uniformModel);
     partModel = l3->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, -2.0, 0.0));
     l3->SetModelMatrix(partModel, uniformModel);
     letterL->meshList.push_back(l3);
 
     // Bottom right horizontal
-    IndependentMesh* l4 = CreateHorizontal(uniformModel);
+    MeshHandle l4 = CreateHorizontal(uniformModel);
     partModel = l4->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, -2.0, 0.0));
     l4->SetModelMatrix(partModel, uniformModel);
@@ -818,60 +1593,60 @@ ComplexObject* CreateLetterL(GLuint uniformModel){
 }
 
 // Creates a complex object for the letter E
-ComplexObject* CreateLetterE(GLuint uniformModel){
-    ComplexObject* letterE = new ComplexObject();
+ObjectHandle CreateLetterE(GLuint uniformModel){
+    ObjectHandle letterE = ComplexObject::Create();
 
     // Bottom left vertical
-    IndependentMesh* e1 = CreateVertical(uniformModel);
+    MeshHandle e1 = CreateVertical(uniformModel);
     glm::mat4 partModel = e1->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 0.0f, 0.0f));
     e1->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e1);
 
     // Top left vertical
-    IndependentMesh* e2 = CreateVertical(uniformModel);
+    MeshHandle e2 = CreateVertical(uniformModel);
     partModel = e2->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(4.0f, 2.0f, 0.0f));
     e2->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e2);
 
     // Bottom left horizontal
-    IndependentMesh* e3 = CreateHorizontal(uniformModel);
+    MeshHandle e3 = CreateHorizontal(uniformModel);
     partModel = e3->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, -2.0, 0.0));
     e3->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e3);
 
     // Bottom right horizontal
-    IndependentMesh* e4 = CreateHorizontal(uniformModel);
+    MeshHandle e4 = CreateHorizontal(uniformModel);
     partModel = e4->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, -2.0, 0.0));
     e4->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e4);
 
     // Middle left horizontal
-    IndependentMesh* e5 = CreateHorizontal(uniformModel);
+    MeshHandle e5 = CreateHorizontal(uniformModel);
     partModel = e5->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, 2.0, 0.0));
     e5->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e5);
 
     // Middle right horizontal
-    IndependentMesh* e6 = CreateHorizontal(uniformModel);
+    MeshHandle e6 = CreateHorizontal(uniformModel);
     partModel = e6->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, 2.0, 0.0));
     e6->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e6);
 
     // Top left horizontal
-    IndependentMesh* e7 = CreateHorizontal(uniformModel);
+    MeshHandle e7 = CreateHorizontal(uniformModel);
     partModel = e7->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, 6.0, 0.0));
     e7->SetModelMatrix(partModel, uniformModel);
     letterE->meshList.push_back(e7);
 
     // Top left horizontal
-    IndependentMesh* e8 = CreateHorizontal(uniformModel);
+    MeshHandle e8 = CreateHorizontal(uniformModel);
     partModel = e8->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, 6.0, 0.0));
     e8->SetModelMatrix(partModel, uniformModel);
@@ -881,28 +1656,28 @@ ComplexObject* CreateLetterE(GLuint uniformModel){
 }
 
 // Create a complex object for the letter T
-ComplexObject* CreateLetterT(GLuint uniformModel) {
-    ComplexObject *letterT = new ComplexObject();
+ObjectHandle CreateLetterT(GLuint uniformModel) {
+    ObjectHandle letterT = ComplexObject::Create();
 
-    IndependentMesh *t1 = CreateVertical(uniformModel);
+    MeshHandle t1 = CreateVertical(uniformModel);
     glm::mat4 partModel = t1->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.0f, 0.0f, 0.0f));
     t1->SetModelMatrix(partModel, uniformModel);
     letterT->meshList.push_back(t1);
 
-    IndependentMesh *t2 = CreateVertical(uniformModel);
+    MeshHandle t2 = CreateVertical(uniformModel);
     partModel = t2->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.0f, 2.0f, 0.0f));
     t2->SetModelMatrix(partModel, uniformModel);
     letterT->meshList.push_back(t2);
 
-    IndependentMesh *t3 = CreateHorizontal(uniformModel);
+    MeshHandle t3 = CreateHorizontal(uniformModel);
     partModel = t3->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(-0.5, 6.0, 0.0));
     t3->SetModelMatrix(partModel, uniformModel);
     letterT->meshList.push_back(t3);
 
-    IndependentMesh *t4 = CreateHorizontal(uniformModel);
+    MeshHandle t4 = CreateHorizontal(uniformModel);
     partModel = t4->GetModelMatrix();
     partModel = glm::translate(partModel, glm::vec3(0.5, 6.0, 0.0));
     t4->SetModelMatrix(partModel, uniformModel);
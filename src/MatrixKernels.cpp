@@ -0,0 +1,418 @@
+#include "MatrixKernels.h"
+#include <cmath>
+
+// The SIMD versions are x86-64 only, where SSE2 is always available. AVX2 functions are compiled for AVX2 individually
+// and only called once the CPU is known to support it, so the rest of the program doesn't need AVX2 compiler flags.
+#if defined(__x86_64__) || defined(_M_X64)
+#define MATRIX_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+MatrixKernels::Level MatrixKernels::GetSupportedLevel()
+{
+#ifdef MATRIX_KERNELS_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	if (osSavesYmm && fma && avx2)
+	{
+		return Level::AVX2;
+	}
+#else
+	// Also checks that the operating system saves the AVX registers.
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return Level::AVX2;
+	}
+#endif
+	return Level::SSE;
+#else
+	return Level::Scalar;
+#endif
+}
+
+static MatrixKernels::Level& CurrentLevel()
+{
+	static MatrixKernels::Level level = MatrixKernels::GetSupportedLevel();
+	return level;
+}
+
+MatrixKernels::Level MatrixKernels::GetLevel()
+{
+	return CurrentLevel();
+}
+
+void MatrixKernels::SetLevel(Level level)
+{
+	Level supported = GetSupportedLevel();
+	CurrentLevel() = (int)level <= (int)supported ? level : supported;
+}
+
+const char* MatrixKernels::GetLevelName(Level level)
+{
+	switch (level)
+	{
+		case Level::SSE: return "SSE";
+		case Level::AVX2: return "AVX2";
+		default: return "Scalar";
+	}
+}
+
+// Scalar versions, also used for the remainder of the SIMD loops.
+// a is read with a stride of 1 for Multiply and 0 for MultiplyByParent, so both share the same loops.
+
+static void MultiplyScalar(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = a[i * aStride] * b[i];
+	}
+}
+
+static void ComposeTRSScalar(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::quat& q = rotations[i];
+		const glm::vec3& s = scales[i];
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		out[i][0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+		out[i][1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+		out[i][2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+		out[i][3] = glm::vec4(translations[i], 1.0f);
+	}
+}
+
+static void TransformAABBsScalar(const glm::mat4* matrices, const AABB* boxes, AABB* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = boxes[i].Transformed(matrices[i]);
+	}
+}
+
+#ifdef MATRIX_KERNELS_X86
+
+// SSE versions. A matrix column fits one register.
+
+static inline __m128 CombineColumnsSSE(__m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 weights)
+{
+	__m128 result = _mm_mul_ps(a0, _mm_shuffle_ps(weights, weights, 0x00));
+	result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(weights, weights, 0x55)));
+	result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(weights, weights, 0xAA)));
+	return _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(weights, weights, 0xFF)));
+}
+
+static void MultiplySSE(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* left = &a[i * aStride][0][0];
+		const float* right = &b[i][0][0];
+		float* result = &out[i][0][0];
+
+		// Column j of a * b is a's columns weighted by column j of b. Everything is loaded before storing, for aliasing.
+		__m128 a0 = _mm_loadu_ps(left), a1 = _mm_loadu_ps(left + 4), a2 = _mm_loadu_ps(left + 8), a3 = _mm_loadu_ps(left + 12);
+		__m128 b0 = _mm_loadu_ps(right), b1 = _mm_loadu_ps(right + 4), b2 = _mm_loadu_ps(right + 8), b3 = _mm_loadu_ps(right + 12);
+
+		_mm_storeu_ps(result, CombineColumnsSSE(a0, a1, a2, a3, b0));
+		_mm_storeu_ps(result + 4, CombineColumnsSSE(a0, a1, a2, a3, b1));
+		_mm_storeu_ps(result + 8, CombineColumnsSSE(a0, a1, a2, a3, b2));
+		_mm_storeu_ps(result + 12, CombineColumnsSSE(a0, a1, a2, a3, b3));
+	}
+}
+
+/// <summary>
+/// Takes one column of 4 matrices as x, y, z, w registers (one matrix per lane) and stores it in each matrix.
+/// </summary>
+static inline void StoreColumnSSE(glm::mat4* out, int column, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&out[0][column][0], x);
+	_mm_storeu_ps(&out[1][column][0], y);
+	_mm_storeu_ps(&out[2][column][0], z);
+	_mm_storeu_ps(&out[3][column][0], w);
+}
+
+static void ComposeTRSSSE(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// Four transformations at once, one per lane. Components are read by name since glm's quaternion layout varies between versions.
+		const glm::quat* q = rotations + i;
+		const glm::vec3* s = scales + i;
+		const glm::vec3* t = translations + i;
+		__m128 x = _mm_setr_ps(q[0].x, q[1].x, q[2].x, q[3].x);
+		__m128 y = _mm_setr_ps(q[0].y, q[1].y, q[2].y, q[3].y);
+		__m128 z = _mm_setr_ps(q[0].z, q[1].z, q[2].z, q[3].z);
+		__m128 w = _mm_setr_ps(q[0].w, q[1].w, q[2].w, q[3].w);
+		__m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+		__m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+		__m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+		__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		StoreColumnSSE(out + i, 0,
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+			zero);
+		StoreColumnSSE(out + i, 1,
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+			zero);
+		StoreColumnSSE(out + i, 2,
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+			zero);
+		StoreColumnSSE(out + i, 3,
+			_mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x),
+			_mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y),
+			_mm_setr_ps(t[0].z, t[1].z, t[2].z, t[3].z),
+			one);
+	}
+
+	ComposeTRSScalar(translations + i, rotations + i, scales + i, out + i, count - i);
+}
+
+static void TransformAABBsSSE(const glm::mat4* matrices, const AABB* boxes, AABB* out, size_t count)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* m = &matrices[i][0][0];
+		__m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+		glm::vec3 center = boxes[i].GetCenter();
+		glm::vec3 extents = boxes[i].GetExtents();
+
+		// Same as AABB::Transformed: the transformed center, plus the extents through the absolute linear part.
+		__m128 newCenter = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(center.x)));
+		newCenter = _mm_add_ps(newCenter, _mm_mul_ps(c1, _mm_set1_ps(center.y)));
+		newCenter = _mm_add_ps(newCenter, _mm_mul_ps(c2, _mm_set1_ps(center.z)));
+
+		__m128 newExtents = _mm_mul_ps(_mm_andnot_ps(signMask, c0), _mm_set1_ps(extents.x));
+		newExtents = _mm_add_ps(newExtents, _mm_mul_ps(_mm_andnot_ps(signMask, c1), _mm_set1_ps(extents.y)));
+		newExtents = _mm_add_ps(newExtents, _mm_mul_ps(_mm_andnot_ps(signMask, c2), _mm_set1_ps(extents.z)));
+
+		// An AABB is 6 floats, so go through a buffer instead of storing 4 lanes into it.
+		float low[4], high[4];
+		_mm_storeu_ps(low, _mm_sub_ps(newCenter, newExtents));
+		_mm_storeu_ps(high, _mm_add_ps(newCenter, newExtents));
+		out[i] = AABB(glm::vec3(low[0], low[1], low[2]), glm::vec3(high[0], high[1], high[2]));
+	}
+}
+
+// AVX2 versions. A register holds two matrix columns, or the same column of 8 matrices.
+
+AVX2_FUNCTION static void MultiplyAVX2(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* left = &a[i * aStride][0][0];
+		const float* right = &b[i][0][0];
+		float* result = &out[i][0][0];
+
+		// Each of a's columns in both halves, and two of b's columns per register: two result columns per step.
+		__m256 a0 = _mm256_broadcast_ps((const __m128*)left);
+		__m256 a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+		__m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8));
+		__m256 a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+		__m256 b01 = _mm256_loadu_ps(right);
+		__m256 b23 = _mm256_loadu_ps(right + 8);
+
+		__m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+		r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+		r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+		r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+		__m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+		r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+		r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+		r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+		_mm256_storeu_ps(result, r01);
+		_mm256_storeu_ps(result + 8, r23);
+	}
+}
+
+/// <summary>
+/// Takes one column of 8 matrices as x, y, z, w registers (one matrix per lane) and stores it in each matrix.
+/// The transposition works within each 128 bit half, so half 0 holds matrices 0 to 3 and half 1 matrices 4 to 7.
+/// </summary>
+AVX2_FUNCTION static inline void StoreColumnAVX2(glm::mat4* out, int column, __m256 x, __m256 y, __m256 z, __m256 w)
+{
+	__m256 xyLow = _mm256_unpacklo_ps(x, y);
+	__m256 zwLow = _mm256_unpacklo_ps(z, w);
+	__m256 xyHigh = _mm256_unpackhi_ps(x, y);
+	__m256 zwHigh = _mm256_unpackhi_ps(z, w);
+
+	__m256 columns[4];
+	columns[0] = _mm256_shuffle_ps(xyLow, zwLow, _MM_SHUFFLE(1, 0, 1, 0));
+	columns[1] = _mm256_shuffle_ps(xyLow, zwLow, _MM_SHUFFLE(3, 2, 3, 2));
+	columns[2] = _mm256_shuffle_ps(xyHigh, zwHigh, _MM_SHUFFLE(1, 0, 1, 0));
+	columns[3] = _mm256_shuffle_ps(xyHigh, zwHigh, _MM_SHUFFLE(3, 2, 3, 2));
+
+	for (int k = 0; k < 4; k++)
+	{
+		_mm_storeu_ps(&out[k][column][0], _mm256_castps256_ps128(columns[k]));
+		_mm_storeu_ps(&out[k + 4][column][0], _mm256_extractf128_ps(columns[k], 1));
+	}
+}
+
+#define GATHER8(array, component) _mm256_setr_ps(array[0].component, array[1].component, array[2].component, array[3].component, \
+	array[4].component, array[5].component, array[6].component, array[7].component)
+
+AVX2_FUNCTION static void ComposeTRSAVX2(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const glm::quat* q = rotations + i;
+		const glm::vec3* s = scales + i;
+		const glm::vec3* t = translations + i;
+		__m256 x = GATHER8(q, x), y = GATHER8(q, y), z = GATHER8(q, z), w = GATHER8(q, w);
+		__m256 sx = GATHER8(s, x), sy = GATHER8(s, y), sz = GATHER8(s, z);
+
+		__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+		StoreColumnAVX2(out + i, 0,
+			_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+			zero);
+		StoreColumnAVX2(out + i, 1,
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+			_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+			zero);
+		StoreColumnAVX2(out + i, 2,
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+			_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+			_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz),
+			zero);
+		StoreColumnAVX2(out + i, 3, GATHER8(t, x), GATHER8(t, y), GATHER8(t, z), one);
+	}
+
+	ComposeTRSSSE(translations + i, rotations + i, scales + i, out + i, count - i);
+}
+
+#undef GATHER8
+
+AVX2_FUNCTION static void TransformAABBsAVX2(const glm::mat4* matrices, const AABB* boxes, AABB* out, size_t count)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		// Two boxes at once, one per half.
+		const float* m0 = &matrices[i][0][0];
+		const float* m1 = &matrices[i + 1][0][0];
+		__m256 c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0)), _mm_loadu_ps(m1), 1);
+		__m256 c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0 + 4)), _mm_loadu_ps(m1 + 4), 1);
+		__m256 c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0 + 8)), _mm_loadu_ps(m1 + 8), 1);
+		__m256 c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m0 + 12)), _mm_loadu_ps(m1 + 12), 1);
+
+		glm::vec3 center0 = boxes[i].GetCenter(), center1 = boxes[i + 1].GetCenter();
+		glm::vec3 extents0 = boxes[i].GetExtents(), extents1 = boxes[i + 1].GetExtents();
+
+		__m256 newCenter = _mm256_fmadd_ps(c0, _mm256_setr_ps(center0.x, center0.x, center0.x, center0.x, center1.x, center1.x, center1.x, center1.x), c3);
+		newCenter = _mm256_fmadd_ps(c1, _mm256_setr_ps(center0.y, center0.y, center0.y, center0.y, center1.y, center1.y, center1.y, center1.y), newCenter);
+		newCenter = _mm256_fmadd_ps(c2, _mm256_setr_ps(center0.z, center0.z, center0.z, center0.z, center1.z, center1.z, center1.z, center1.z), newCenter);
+
+		__m256 newExtents = _mm256_mul_ps(_mm256_andnot_ps(signMask, c0), _mm256_setr_ps(extents0.x, extents0.x, extents0.x, extents0.x, extents1.x, extents1.x, extents1.x, extents1.x));
+		newExtents = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, c1), _mm256_setr_ps(extents0.y, extents0.y, extents0.y, extents0.y, extents1.y, extents1.y, extents1.y, extents1.y), newExtents);
+		newExtents = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, c2), _mm256_setr_ps(extents0.z, extents0.z, extents0.z, extents0.z, extents1.z, extents1.z, extents1.z, extents1.z), newExtents);
+
+		float low[8], high[8];
+		_mm256_storeu_ps(low, _mm256_sub_ps(newCenter, newExtents));
+		_mm256_storeu_ps(high, _mm256_add_ps(newCenter, newExtents));
+		out[i] = AABB(glm::vec3(low[0], low[1], low[2]), glm::vec3(high[0], high[1], high[2]));
+		out[i + 1] = AABB(glm::vec3(low[4], low[5], low[6]), glm::vec3(high[4], high[5], high[6]));
+	}
+
+	TransformAABBsSSE(matrices + i, boxes + i, out + i, count - i);
+}
+
+#endif
+
+void MatrixKernels::Multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count)
+{
+	switch (CurrentLevel())
+	{
+#ifdef MATRIX_KERNELS_X86
+		case Level::AVX2: MultiplyAVX2(a, 1, b, out, count); break;
+		case Level::SSE: MultiplySSE(a, 1, b, out, count); break;
+#endif
+		default: MultiplyScalar(a, 1, b, out, count); break;
+	}
+}
+
+void MatrixKernels::MultiplyByParent(const glm::mat4& parent, const glm::mat4* children, glm::mat4* out, size_t count)
+{
+	// Copied in case out aliases the parent.
+	glm::mat4 parentCopy = parent;
+
+	switch (CurrentLevel())
+	{
+#ifdef MATRIX_KERNELS_X86
+		case Level::AVX2: MultiplyAVX2(&parentCopy, 0, children, out, count); break;
+		case Level::SSE: MultiplySSE(&parentCopy, 0, children, out, count); break;
+#endif
+		default: MultiplyScalar(&parentCopy, 0, children, out, count); break;
+	}
+}
+
+void MatrixKernels::ComposeTRS(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+	switch (CurrentLevel())
+	{
+#ifdef MATRIX_KERNELS_X86
+		case Level::AVX2: ComposeTRSAVX2(translations, rotations, scales, out, count); break;
+		case Level::SSE: ComposeTRSSSE(translations, rotations, scales, out, count); break;
+#endif
+		default: ComposeTRSScalar(translations, rotations, scales, out, count); break;
+	}
+}
+
+void MatrixKernels::TransformAABBs(const glm::mat4* matrices, const AABB* boxes, AABB* out, size_t count)
+{
+	switch (CurrentLevel())
+	{
+#ifdef MATRIX_KERNELS_X86
+		case Level::AVX2: TransformAABBsAVX2(matrices, boxes, out, count); break;
+		case Level::SSE: TransformAABBsSSE(matrices, boxes, out, count); break;
+#endif
+		default: TransformAABBsScalar(matrices, boxes, out, count); break;
+	}
+}
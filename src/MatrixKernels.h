@@ -0,0 +1,57 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+#include "AABB.h"
+
+/// <summary>
+/// Matrix math over contiguous arrays, for the places that transform many nodes at once. Each function has a scalar,
+/// an SSE and an AVX2 version; the fastest one the CPU supports is picked the first time a kernel runs.
+/// Matrices are glm's column major mat4. Results match the equivalent glm expressions up to float rounding.
+/// </summary>
+class MatrixKernels
+{
+	public:
+		/// <summary>
+		/// The instruction sets the kernels come in, slowest first.
+		/// </summary>
+		enum class Level
+		{
+			Scalar,
+			SSE,
+			AVX2
+		};
+
+		/// <summary>
+		/// Returns the best level the CPU and operating system support.
+		/// </summary>
+		static Level GetSupportedLevel();
+		/// <summary>
+		/// Returns the level the kernels currently run at.
+		/// </summary>
+		static Level GetLevel();
+		/// <summary>
+		/// Forces the kernels to a level, for benchmarks and tests. Levels the CPU doesn't support are lowered to the supported one.
+		/// </summary>
+		static void SetLevel(Level level);
+		static const char* GetLevelName(Level level);
+
+		/// <summary>
+		/// out[i] = a[i] * b[i] for count matrices. out may alias a or b.
+		/// </summary>
+		static void Multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count);
+		/// <summary>
+		/// out[i] = parent * children[i], the step propagating a parent's transformation to its children. out may alias children.
+		/// </summary>
+		static void MultiplyByParent(const glm::mat4& parent, const glm::mat4* children, glm::mat4* out, size_t count);
+
+		/// <summary>
+		/// out[i] = translate(translations[i]) * mat4_cast(rotations[i]) * scale(scales[i]). Rotations must be unit quaternions.
+		/// </summary>
+		static void ComposeTRS(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count);
+
+		/// <summary>
+		/// out[i] = boxes[i].Transformed(matrices[i]) for count non empty boxes and affine matrices. out may alias boxes.
+		/// </summary>
+		static void TransformAABBs(const glm::mat4* matrices, const AABB* boxes, AABB* out, size_t count);
+};
@@ -1,29 +1,225 @@
 // Modified from Ben Cook's Udemy OpenGL course https://www.udemy.com/course/graphics-with-modern-opengl/
 #include "Mesh.h"
+#include "CommandList.h"
+#include "GLState.h"
+#include "RedrawSignal.h"
+#include "GPUMemory.h"
+#include "RenderStats.h"
+#include "GLCapture.h"
+#include <algorithm>
 
 Mesh::Mesh()
 {
 	VAO = 0;
 	VBO = 0;
 	IBO = 0;
+	CBO = 0;
 	indexCount = 0;
+	color = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	collisionShape = ConvexShape::Type::None;
+	uploadedBytes = 0;
+	lastDrawnFrame = 0;
+	evicted = false;
+	dataOnDisk = false;
+	GPUMemory::AddMesh(this);
 }
 
 Mesh::~Mesh()
 {
 	ClearMesh();
+	GPUMemory::RemoveMesh(this);
 }
 
 void Mesh::CreateMesh(GLfloat* vertices, unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices)
+{
+    CreateMesh(vertices, NULL, indices, numOfVertices, numOfIndices);
+}
+
+void Mesh::CreateMesh(GLfloat* vertices, GLfloat* colors, unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices)
 {
     // Updating our member variables
     indexCount = numOfIndices;
+    vertexData.assign(vertices, vertices + numOfVertices);
+    indexData.assign(indices, indices + numOfIndices);
+    if (colors != NULL)
+    {
+        colorData.assign(colors, colors + (numOfVertices / 3) * 4);
+    }
+    else
+    {
+        colorData.clear();
+    }
+
+    CreateBuffers(true);
+    uploadedBytes = GetDataSize();
+}
+
+void Mesh::BeginUpload(std::vector<GLfloat>& vertices, std::vector<GLfloat>& colors, std::vector<unsigned int>& indices)
+{
+    // Nothing is drawn until every index is uploaded.
+    indexCount = 0;
+    vertexData.swap(vertices);
+    colorData.swap(colors);
+    indexData.swap(indices);
+    vertices.clear();
+    colors.clear();
+    indices.clear();
+
+    CreateBuffers(false);
+    uploadedBytes = 0;
+}
+
+size_t Mesh::ContinueUpload(size_t maxBytes)
+{
+    // The data is uploaded in order: vertices, colors, then indices. The indices go through the VAO, which holds the IBO.
+    struct Part
+    {
+        GLenum target;
+        GLuint buffer;
+        const void* data;
+        size_t size;
+    };
+    Part parts[] = {
+        { GL_ARRAY_BUFFER, VBO, vertexData.data(), vertexData.size() * sizeof(GLfloat) },
+        { GL_ARRAY_BUFFER, CBO, colorData.data(), colorData.size() * sizeof(GLfloat) },
+        { GL_ELEMENT_ARRAY_BUFFER, IBO, indexData.data(), indexData.size() * sizeof(GLuint) }
+    };
+
+    size_t uploaded = 0;
+    size_t offset = uploadedBytes;
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]) && uploaded < maxBytes; i++)
+    {
+        if (offset >= parts[i].size)
+        {
+            offset -= parts[i].size;
+            continue;
+        }
+
+        size_t count = std::min(parts[i].size - offset, maxBytes - uploaded);
+        if (parts[i].target == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            GLState::BindVertexArray(VAO);
+        }
+        GLState::BindBuffer(parts[i].target, parts[i].buffer);
+        glBufferSubData(parts[i].target, offset, count, (const char*)parts[i].data + offset);
+        RENDER_STATS_COUNT(CountBufferUpload(count));
+        if (GLCapture::IsCapturing())
+        {
+            GLCapture::BufferSubData(parts[i].buffer, offset, count, (const char*)parts[i].data + offset);
+        }
+        uploaded += count;
+        offset = 0;
+    }
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    uploadedBytes += uploaded;
+    if (uploadedBytes == GetDataSize())
+    {
+        indexCount = (GLsizei)indexData.size();
+    }
+    return uploaded;
+}
+
+size_t Mesh::GetDataSize() const
+{
+    return (vertexData.size() + colorData.size()) * sizeof(GLfloat) + indexData.size() * sizeof(GLuint);
+}
+
+bool Mesh::CanEvict() const
+{
+    // Meshes still uploading aren't drawn yet, so they would come first; their owner is about to need them.
+    return VBO != 0 && IsUploaded();
+}
+
+void Mesh::Evict()
+{
+    if (!CanEvict())
+    {
+        return;
+    }
+
+    // Buffers stay alive while a vertex array holds them, unless it is bound when they are deleted. The vertex array
+    // itself is kept, so command lists recorded with its name stay valid once the mesh is restored.
+    GLState::BindVertexArray(VAO);
+    if (CBO != 0)
+    {
+        GLState::DeleteBuffer(CBO);
+        CBO = 0;
+    }
+    GLState::DeleteBuffer(IBO);
+    IBO = 0;
+    GLState::DeleteBuffer(VBO);
+    VBO = 0;
+    GLState::BindVertexArray(0);
+
+    evicted = true;
+    uploadedBytes = 0;
+    if (dataOnDisk)
+    {
+        std::vector<GLfloat>().swap(vertexData);
+        std::vector<GLfloat>().swap(colorData);
+        std::vector<unsigned int>().swap(indexData);
+    }
+}
+
+bool Mesh::Restore()
+{
+    if (!evicted)
+    {
+        return true;
+    }
+    if (vertexData.empty())
+    {
+        return false;
+    }
+
+    CreateBuffers(true);
+    uploadedBytes = GetDataSize();
+    GPUMemory::CountRestore();
+    return true;
+}
+
+bool Mesh::PrepareDraw()
+{
+    lastDrawnFrame = GPUMemory::GetFrame();
+    return Restore();
+}
+
+bool Mesh::PrepareRecord()
+{
+    lastDrawnFrame = GPUMemory::GetFrame();
+    if (!evicted)
+    {
+        return true;
+    }
+    if (vertexData.empty())
+    {
+        return false;
+    }
+
+    // The vertex array keeps its name, so the draw can be recorded now and the buffers uploaded before it is executed.
+    GPUMemory::RequestRestore(this);
+    return true;
+}
+
+void Mesh::CreateBuffers(bool upload)
+{
+    bounds = AABB();
+    for (size_t i = 0; i + 2 < vertexData.size(); i += 3)
+    {
+        bounds.Extend(glm::vec3(vertexData[i], vertexData[i + 1], vertexData[i + 2]));
+    }
 
     // Creating our VAO. 1- Amount of arrays and then 2- Where to store the ID of the array.
     // This now creates some stuff in the graphics card and its memory.
-    glGenVertexArrays(1, &VAO);
+    // An evicted mesh keeps its vertex array.
+    if (VAO == 0)
+    {
+        glGenVertexArrays(1, &VAO);
+    }
+    evicted = false;
     // Binding. Now all our operations that interact with Vertex Array will interact with this array.
-    glBindVertexArray(VAO);
+    GLState::BindVertexArray(VAO);
     // We now Indent, because this shows that everyting that is indented will work with the array object bound above.
 
     glGenBuffers(1, // How many buffers to create?
@@ -31,25 +227,25 @@ void Mesh::CreateMesh(GLfloat* vertices, unsigned int* indices, unsigned int num
     );
     // This is a buffer that stores elements, or indices. Same thing.
     // Look a bit down to see the definition of each param.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-        sizeof(GLuint) * numOfIndices,
-        indices,
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    GPUMemory::BufferData(GL_ELEMENT_ARRAY_BUFFER, IBO, GPUMemoryCategory::IndexBuffer,
+        sizeof(GLuint) * indexData.size(),
+        upload ? indexData.data() : NULL, // Without data, the buffer is only allocated, for ContinueUpload to fill.
         GL_STATIC_DRAW
     );
 
     // Same as above, but for buffers.
     glGenBuffers(1, &VBO);
     // Binding. First choose the target to bind to. VBO has multiple targets it can bind to.
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, VBO);
     // Connect the vertices we created to the VBO
-    glBufferData(GL_ARRAY_BUFFER, // Target
-        sizeof(GLfloat) * numOfVertices, // the size of the data we are passing in. could also have said sizeof(GLfloat * numOfVertices)
-        vertices, // Our actual array
+    GPUMemory::BufferData(GL_ARRAY_BUFFER, VBO, GPUMemoryCategory::VertexBuffer, // Target, buffer and what it holds
+        sizeof(GLfloat) * vertexData.size(), // the size of the data we are passing in.
+        upload ? vertexData.data() : NULL, // Our actual array
         GL_STATIC_DRAW // could also be GL_DYNAMIC_DRAW.  Static: Not going to change where the points are in the array.
     );
 
-    glVertexAttribPointer(0, // Location of position attribute. The position attribute and its location are determined inside the Shader code for vertex shader.
+    glVertexAttribPointer(POSITION_LOCATION, // Location of position attribute. The position attribute and its location are determined inside the Shader code for vertex shader.
         3, // Amount of values passed in to location. In our case, we have 3 values (X,Y,Z)
         GL_FLOAT, // Type of the values.
         GL_FALSE, // Normalize the values or not
@@ -59,14 +255,24 @@ void Mesh::CreateMesh(GLfloat* vertices, unsigned int* indices, unsigned int num
         0 // Offset. Where the data starts. We could say "ignore first line of array" through this.
     );
     // Enables the usage of our attribute located at position 0, so our position attribute for our vertices.
-    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(POSITION_LOCATION);
+
+    if (!colorData.empty())
+    {
+        // Per vertex colors go in their own buffer. Without it, the color attribute array stays disabled and
+        // the shader reads the constant value set by ApplyColor instead.
+        glGenBuffers(1, &CBO);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, CBO);
+        GPUMemory::BufferData(GL_ARRAY_BUFFER, CBO, GPUMemoryCategory::VertexBuffer, sizeof(GLfloat) * colorData.size(),
+            upload ? colorData.data() : NULL, GL_STATIC_DRAW);
+        glVertexAttribPointer(COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(COLOR_LOCATION);
+    }
 
     // Unbind buffer.
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    // Unbind array.
-    glBindVertexArray(0);
-    // Unbind IBO. Note, unbind IBO AFTER VAO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    // Unbind array. The IBO stays bound inside the VAO, which is what lets us draw without binding it again.
+    GLState::BindVertexArray(0);
 
 
     // And now we are not indented anymore! Because we have unbound our vertex array.
@@ -74,113 +280,114 @@ void Mesh::CreateMesh(GLfloat* vertices, unsigned int* indices, unsigned int num
 
 void Mesh::RenderMesh()
 {
-    // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
-
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-    // Drawing our triangles.
-    glDrawElements(GL_TRIANGLES, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
-
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    RenderMesh(GL_TRIANGLES);
 }
 
 void Mesh::RenderMesh(GLenum drawType)
 {
-    // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
+    if (!PrepareDraw())
+    {
+        return;
+    }
 
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    // We want to work with our created VAO. The IBO is part of its state, so there is nothing else to bind.
+    // The VAO is left bound: the next draw binding the same VAO costs nothing.
+    GLState::BindVertexArray(VAO);
+    ApplyColor();
 
     // Drawing our triangles.
-    glDrawElements(drawType, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
-
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::DrawElements(drawType, indexCount);
 }
 
-
-
 void Mesh::RenderMesh(glm::mat4& matrix, GLuint uniformModelLocation)
 {
+    if (!PrepareDraw())
+    {
+        return;
+    }
+
     // We want to work with our created VAO.
-    glBindVertexArray(VAO);
-    // We indent to show we are working with this VAO from here on.  
+    GLState::BindVertexArray(VAO);
 
-    // Binding IBO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    ApplyColor();
 
     // Applying the provided matrix
-    // Reassigning the uniform variable. So now we want to assign a matrix, 4x4, with float values.
-    glUniformMatrix4fv(uniformModelLocation, // Value to change
-        1, // How many matrices to pass
-        GL_FALSE, // Transpose?
-        glm::value_ptr(matrix)); // Our value. Can't pass our value directly. We need to use a pointer.
+    GLState::UniformMatrix4fv(uniformModelLocation, glm::value_ptr(matrix));
 
     // Drawing our triangles.
-    glDrawElements(GL_TRIANGLES, // What to draw
-        indexCount, // Count of indices
-        GL_UNSIGNED_INT, // Format of indices
-        0 // Point to the indices, but we dont need it because we have IBO already.
-    );
+    GLState::DrawElements(GL_TRIANGLES, indexCount);
+}
 
-    // Removing the model matrix from gpu
-    glUniform1f(uniformModelLocation, 0.0f);
+void Mesh::RecordMesh(CommandList& list, const glm::mat4& matrix, GLuint uniformModelLocation)
+{
+    if (!PrepareRecord())
+    {
+        return;
+    }
 
-    // We unbind the VAO.
-    glBindVertexArray(0);
-    // Unbinding the IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // Same commands as RenderMesh(matrix, uniformModelLocation), minus the binds the VAO already holds.
+    list.BindVertexArray(VAO);
+    if (CBO == 0)
+    {
+        list.SetVertexAttribute4(COLOR_LOCATION, color);
+    }
+    list.SetUniformMatrix4(uniformModelLocation, matrix);
+    list.DrawElements(GL_TRIANGLES, indexCount);
+}
+
+void Mesh::SetColor(const glm::vec3& color)
+{
+    this->color = glm::vec4(color, this->color.w);
+    RedrawSignal::Request();
+}
+
+void Mesh::SetHighlight(bool highlight)
+{
+    color.w = highlight ? 1.0f : 0.0f;
+    RedrawSignal::Request();
+}
+
+void Mesh::ApplyColor()
+{
+    if (CBO == 0)
+    {
+        GLState::VertexAttrib4f(COLOR_LOCATION, glm::value_ptr(color));
+    }
 }
 
 void Mesh::ClearMesh()
 {
+    if (CBO != 0)
+    {
+        GLState::DeleteBuffer(CBO);
+        CBO = 0;
+    }
+
     if (IBO != 0)
     {
         // Cleaning the buffers.
-        glDeleteBuffers(
-            1, // How many to delete?
-            &IBO  // Which to delete?
-        );
+        GLState::DeleteBuffer(IBO);
         IBO = 0;
     }
 
     if (VBO != 0)
     {
         // Cleaning the buffers.
-        glDeleteBuffers(
-            1, // How many to delete?
-            &VBO  // Which to delete?
-        );
+        GLState::DeleteBuffer(VBO);
         VBO = 0;
     }
 
     if (VAO != 0)
     {
         // Cleaning the array.
-        glDeleteVertexArrays(
-            1, // How many to delete?
-            &VAO  // Which to delete?
-        );
-        VBO = 0;
+        GLState::DeleteVertexArray(VAO);
+        VAO = 0;
     }
 
     indexCount = 0;
+    uploadedBytes = 0;
+    evicted = false;
+    vertexData.clear();
+    colorData.clear();
+    indexData.clear();
 }
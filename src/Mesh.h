@@ -4,12 +4,29 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "ConvexShape.h"
+#include "Pool.h"
+#include <vector>
+
+class CommandList;
 
 class Mesh
 {
 	public:
 		Mesh();
-		~Mesh();
+		virtual ~Mesh();
+		// Meshes are known to GPUMemory by address, so they are never copied.
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
+
+		/// <summary>
+		/// Creates an empty mesh in the shared mesh pool. Fill it with CreateMesh.
+		/// </summary>
+		static Handle<Mesh> Create() { return Pool<Mesh>::Global().Create(); }
+		/// <summary>
+		/// Destroys a mesh created with Create, freeing its GPU buffers.
+		/// </summary>
+		static void Destroy(Handle<Mesh> mesh) { Pool<Mesh>::Global().Destroy(mesh); }
 
 		/// <summary>
 		/// Creates a mesh using the supplied parameters
@@ -20,6 +37,62 @@ class Mesh
 		/// <param name="numOfIndices">Number of indices in the index drawing array</param>
 		void CreateMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices);
 		/// <summary>
+		/// Creates a mesh with one color per vertex, so parts of different colors can be merged into a single draw.
+		/// </summary>
+		/// <param name="vertices">Pointer to the vertices of the mesh.</param>
+		/// <param name="colors">Pointer to the vertex colors, 4 floats per vertex: red, green, blue and highlight.</param>
+		/// <param name="indices">Pointer to the indices for index drawing of the mesh.</param>
+		/// <param name="numOfVertices">Number of vertices (number of floats in the vertices array)</param>
+		/// <param name="numOfIndices">Number of indices in the index drawing array</param>
+		void CreateMesh(GLfloat *vertices, GLfloat *colors, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices);
+		/// <summary>
+		/// Starts creating the mesh without uploading its data: the buffers are allocated at full size, then filled a
+		/// slice at a time by ContinueUpload, so a large mesh doesn't hold up a frame. Nothing is drawn until the upload
+		/// is complete.
+		/// </summary>
+		/// <param name="vertices">The vertices, 3 floats each. Taken by the mesh, and left empty.</param>
+		/// <param name="colors">The vertex colors, 4 floats each, or empty for a single color. Taken by the mesh.</param>
+		/// <param name="indices">The indices. Taken by the mesh.</param>
+		void BeginUpload(std::vector<GLfloat>& vertices, std::vector<GLfloat>& colors, std::vector<unsigned int>& indices);
+		/// <summary>
+		/// Uploads the next slice of the data given to BeginUpload.
+		/// </summary>
+		/// <param name="maxBytes">Most bytes to upload.</param>
+		/// <returns>The bytes uploaded.</returns>
+		size_t ContinueUpload(size_t maxBytes);
+		/// <summary>
+		/// Returns true once all of the mesh's data is on the GPU, which CreateMesh does at once.
+		/// </summary>
+		bool IsUploaded() const { return uploadedBytes == GetDataSize(); }
+		/// <summary>
+		/// Returns the size of the mesh's vertices, colors and indices, in bytes.
+		/// </summary>
+		size_t GetDataSize() const;
+
+		/// <summary>
+		/// Frees the mesh's buffers to make room on the GPU, keeping what is needed to upload them again. Meshes whose
+		/// data is on disk also free their CPU copy, and stay evicted until their owner creates them again.
+		/// </summary>
+		void Evict();
+		/// <summary>
+		/// Uploads an evicted mesh again. Done by the next draw of the mesh.
+		/// </summary>
+		/// <returns>False if the mesh's data must be read from disk first.</returns>
+		bool Restore();
+		/// <summary>
+		/// Returns true if the mesh's buffers are on the GPU and can be freed by Evict.
+		/// </summary>
+		bool CanEvict() const;
+		bool IsEvicted() const { return evicted; }
+		/// <summary>
+		/// Returns the GPUMemory frame the mesh was last drawn or recorded in.
+		/// </summary>
+		unsigned int GetLastDrawnFrame() const { return lastDrawnFrame; }
+		/// <summary>
+		/// Tells whether the mesh's data can be read again from a file, in which case eviction also frees its CPU copy.
+		/// </summary>
+		void SetDataOnDisk(bool onDisk) { dataOnDisk = onDisk; }
+		/// <summary>
 		/// Draws the mesh on screen
 		/// </summary>
 		virtual void RenderMesh();
@@ -32,15 +105,133 @@ class Mesh
 		/// <param name="matrix">The model matrix, representing the transformation to apply.</param>
 		/// <param name="uniformModelLocation">The location of the provided model matrix.</param>
 		virtual void RenderMesh(glm::mat4& matrix, GLuint uniformModelLocation);
+
+		/// <summary>
+		/// Records the draw of RenderMesh(matrix, uniformModelLocation) into a command list instead of issuing it. Safe to call from worker threads.
+		/// </summary>
+		/// <param name="list">The list to record into.</param>
+		/// <param name="matrix">The model matrix, representing the transformation to apply.</param>
+		/// <param name="uniformModelLocation">The location of the provided model matrix.</param>
+		virtual void RecordMesh(CommandList& list, const glm::mat4& matrix, GLuint uniformModelLocation);
 		
 		/// <summary>
 		/// Clears the mesh from the GPU.
 		/// </summary>
 		void ClearMesh();
 
+		/// <summary>
+		/// Sets the color of the whole mesh. Ignored by meshes created with per vertex colors.
+		/// </summary>
+		/// <param name="color">Red, green and blue, from 0 to 1.</param>
+		void SetColor(const glm::vec3& color);
+		/// <summary>
+		/// Turns the selection highlight of the mesh on or off.
+		/// </summary>
+		void SetHighlight(bool highlight);
+		const glm::vec4& GetColor() const { return color; }
+
+		/// <summary>
+		/// Returns the box around the mesh's vertices, before any transformation.
+		/// </summary>
+		const AABB& GetBounds() const { return bounds; }
+
+		/// <summary>
+		/// Sets the shape the mesh collides as, fitted to its box. Meshes don't collide unless given a shape.
+		/// </summary>
+		void SetCollisionShape(ConvexShape::Type shape) { collisionShape = shape; }
+		ConvexShape::Type GetCollisionShape() const { return collisionShape; }
+
+		/// <summary>
+		/// Returns the primitives the mesh's indices describe, as drawn by RecordMesh.
+		/// </summary>
+		virtual GLenum GetDrawType() const { return GL_TRIANGLES; }
+
+		/// <summary>
+		/// The data the mesh was created from, kept so static batches can merge it with other meshes.
+		/// Colors are empty for meshes using a single color.
+		/// </summary>
+		const std::vector<GLfloat>& GetVertices() const { return vertexData; }
+		const std::vector<GLfloat>& GetVertexColors() const { return colorData; }
+		const std::vector<unsigned int>& GetIndices() const { return indexData; }
+
+		/// <summary>
+		/// Returns the transformation this mesh is drawn with under the given parent transformation.
+		/// </summary>
+		/// <param name="parentMatrix">The accumulated model matrix of the parents.</param>
+		virtual glm::mat4 GetWorldMatrix(const glm::mat4& parentMatrix) const { return parentMatrix; }
+
+		/// <summary>
+		/// Attribute locations shared with shader.vs.
+		/// </summary>
+		static const GLuint POSITION_LOCATION = 0;
+		static const GLuint COLOR_LOCATION = 1;
+
 
 	protected:
 		GLuint VAO, VBO, IBO;
+		/// <summary>
+		/// Buffer of per vertex colors, 0 if the mesh uses a single color.
+		/// </summary>
+		GLuint CBO;
 		GLsizei indexCount; // Just an integer, but recognized by openGL to represent a size.
+		/// <summary>
+		/// Color of the mesh (rgb) and highlight flag (a). Fed to the shader as the constant value of the color attribute.
+		/// </summary>
+		glm::vec4 color;
+		/// <summary>
+		/// Box around the vertices, computed when the mesh is created.
+		/// </summary>
+		AABB bounds;
+		/// <summary>
+		/// The shape the mesh collides as.
+		/// </summary>
+		ConvexShape::Type collisionShape;
+		/// <summary>
+		/// Copies of the vertices (3 floats each), vertex colors (4 floats each) and indices on the GPU.
+		/// </summary>
+		std::vector<GLfloat> vertexData;
+		std::vector<GLfloat> colorData;
+		std::vector<unsigned int> indexData;
+		/// <summary>
+		/// Bytes of the data on the GPU so far, vertices first, then colors and indices.
+		/// </summary>
+		size_t uploadedBytes;
+		/// <summary>
+		/// GPUMemory frame the mesh was last drawn or recorded in. Written by the recording threads, each mesh being
+		/// recorded by a single one.
+		/// </summary>
+		unsigned int lastDrawnFrame;
+		/// <summary>
+		/// True while the buffers are freed by Evict. The vertex array and index count are kept.
+		/// </summary>
+		bool evicted;
+		bool dataOnDisk;
+
+		/// <summary>
+		/// Sets the color attribute to this mesh's color, if it doesn't read colors from its own buffer.
+		/// </summary>
+		void ApplyColor();
+		/// <summary>
+		/// Marks the mesh drawn in this frame and restores it if it was evicted. Call before drawing.
+		/// </summary>
+		/// <returns>False if the mesh can't be drawn, its data being on disk.</returns>
+		bool PrepareDraw();
+		/// <summary>
+		/// Marks the mesh drawn in this frame and, if it was evicted, asks GPUMemory to restore it before the list
+		/// recording it is executed. Call before recording a draw; safe on the recording threads.
+		/// </summary>
+		/// <returns>False if the mesh can't be drawn, its data being on disk.</returns>
+		bool PrepareRecord();
+		/// <summary>
+		/// Creates the VAO and buffers for the data copied into the mesh, computing its bounds.
+		/// </summary>
+		/// <param name="upload">False to only allocate the buffers, for ContinueUpload to fill.</param>
+		void CreateBuffers(bool upload);
+
+		/// <summary>
+		/// Position of the mesh in GPUMemory's list of meshes.
+		/// </summary>
+		size_t memoryIndex;
+		friend class GPUMemory;
 };
 
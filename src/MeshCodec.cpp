@@ -0,0 +1,592 @@
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// SSE2 is always available on x86-64; other targets use the scalar loops.
+#if defined(__x86_64__) || defined(_M_X64)
+#define MESH_CODEC_SSE
+#include <emmintrin.h>
+#endif
+
+// The header: magic, version, draw type, vertex count, index count, bytes of encoded indices, flags, then the
+// position box's minimum and the size of a quantization step along each axis, all 4 bytes little endian.
+static const char MAGIC[4] = { 'M', 'S', 'H', 'Z' };
+static const unsigned int VERSION = 1;
+static const size_t HEADER_SIZE = 52;
+static const unsigned int FLAG_COLORS = 1;
+
+// Byte groups, stored as nothing, 8 bytes of nibbles or the 16 bytes themselves. Each group's mode takes 2 bits of
+// the headers written before the groups.
+static const size_t GROUP_SIZE = 16;
+static const unsigned char GROUP_ZERO = 0;
+static const unsigned char GROUP_NIBBLES = 1;
+static const unsigned char GROUP_BYTES = 2;
+static const size_t GROUP_DATA_SIZES[4] = { 0, 8, 16, 0 };
+
+// Index code of a restart index. Other indices are coded from 1.
+static const unsigned long long RESTART_CODE = 0;
+// Longest code of a 32 bit index, 7 bits per byte.
+static const int MAX_CODE_BYTES = 5;
+
+static size_t PadToGroups(size_t count)
+{
+	return (count + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE;
+}
+
+static void WriteUint(std::vector<unsigned char>& data, unsigned int value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		data.push_back((unsigned char)(value >> (i * 8)));
+	}
+}
+
+static void WriteFloat(std::vector<unsigned char>& data, float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, 4);
+	WriteUint(data, bits);
+}
+
+static unsigned int ReadUint(const unsigned char* data)
+{
+	return data[0] | data[1] << 8 | data[2] << 16 | (unsigned int)data[3] << 24;
+}
+
+static float ReadFloat(const unsigned char* data)
+{
+	unsigned int bits = ReadUint(data);
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+static void EncodeGroups(const unsigned char* bytes, size_t count, std::vector<unsigned char>& data)
+{
+	size_t groupCount = count / GROUP_SIZE;
+	size_t headers = data.size();
+	data.resize(headers + (groupCount + 3) / 4, 0);
+
+	for (size_t g = 0; g < groupCount; g++)
+	{
+		const unsigned char* group = bytes + g * GROUP_SIZE;
+		unsigned char largest = *std::max_element(group, group + GROUP_SIZE);
+		unsigned char mode = largest == 0 ? GROUP_ZERO : largest < 16 ? GROUP_NIBBLES : GROUP_BYTES;
+		data[headers + g / 4] |= mode << (g % 4 * 2);
+
+		if (mode == GROUP_NIBBLES)
+		{
+			for (size_t j = 0; j < GROUP_SIZE; j += 2)
+			{
+				data.push_back(group[j] | group[j + 1] << 4);
+			}
+		}
+		else if (mode == GROUP_BYTES)
+		{
+			data.insert(data.end(), group, group + GROUP_SIZE);
+		}
+	}
+}
+
+/// <summary>
+/// Decodes count bytes (a whole number of groups) and moves the data past them.
+/// </summary>
+static bool DecodeGroups(const unsigned char*& data, const unsigned char* end, unsigned char* bytes, size_t count)
+{
+	size_t groupCount = count / GROUP_SIZE;
+	size_t headerSize = (groupCount + 3) / 4;
+	if ((size_t)(end - data) < headerSize)
+	{
+		return false;
+	}
+	const unsigned char* headers = data;
+	const unsigned char* source = data + headerSize;
+
+	// Check the groups are all there before decoding any of them.
+	size_t dataSize = 0;
+	for (size_t g = 0; g < groupCount; g++)
+	{
+		unsigned char mode = headers[g / 4] >> (g % 4 * 2) & 3;
+		if (mode != GROUP_ZERO && mode != GROUP_NIBBLES && mode != GROUP_BYTES)
+		{
+			return false;
+		}
+		dataSize += GROUP_DATA_SIZES[mode];
+	}
+	if ((size_t)(end - source) < dataSize)
+	{
+		return false;
+	}
+
+#ifdef MESH_CODEC_SSE
+	const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+#endif
+	for (size_t g = 0; g < groupCount; g++)
+	{
+		unsigned char* group = bytes + g * GROUP_SIZE;
+		unsigned char mode = headers[g / 4] >> (g % 4 * 2) & 3;
+#ifdef MESH_CODEC_SSE
+		if (mode == GROUP_ZERO)
+		{
+			_mm_storeu_si128((__m128i*)group, _mm_setzero_si128());
+		}
+		else if (mode == GROUP_NIBBLES)
+		{
+			// Even bytes are in the low nibbles, odd ones in the high nibbles: interleave them.
+			__m128i packed = _mm_loadl_epi64((const __m128i*)source);
+			__m128i even = _mm_and_si128(packed, lowNibbles);
+			__m128i odd = _mm_and_si128(_mm_srli_epi16(packed, 4), lowNibbles);
+			_mm_storeu_si128((__m128i*)group, _mm_unpacklo_epi8(even, odd));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i*)group, _mm_loadu_si128((const __m128i*)source));
+		}
+#else
+		if (mode == GROUP_ZERO)
+		{
+			memset(group, 0, GROUP_SIZE);
+		}
+		else if (mode == GROUP_NIBBLES)
+		{
+			for (size_t j = 0; j < GROUP_SIZE / 2; j++)
+			{
+				group[j * 2] = source[j] & 0x0F;
+				group[j * 2 + 1] = source[j] >> 4;
+			}
+		}
+		else
+		{
+			memcpy(group, source, GROUP_SIZE);
+		}
+#endif
+		source += GROUP_DATA_SIZES[mode];
+	}
+
+	data = source;
+	return true;
+}
+
+/// <summary>
+/// Turns the quantized positions, stored as the low and high bytes of each component's zigzag coded differences,
+/// back into floats.
+/// </summary>
+static void DecodePositions(const unsigned char* planes, size_t planeSize, unsigned int vertexCount, const float* minimum, const float* step, GLfloat* vertices)
+{
+	unsigned short values[3] = { 0, 0, 0 };
+	size_t start = 0;
+
+#ifdef MESH_CODEC_SSE
+	// Eight vertices at a time: each component's differences are added up with a prefix sum, starting from the
+	// previous block's last value, then scaled. The rest, and other targets, take the scalar loop below.
+	size_t simdCount = vertexCount & ~(size_t)7;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i previous[3] = { zero, zero, zero };
+	__m128 scales[3], offsets[3];
+	for (int c = 0; c < 3; c++)
+	{
+		scales[c] = _mm_set1_ps(step[c]);
+		offsets[c] = _mm_set1_ps(minimum[c]);
+	}
+
+	float block[3][8];
+	for (size_t i = 0; i < simdCount; i += 8)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			__m128i low = _mm_loadl_epi64((const __m128i*)(planes + c * 2 * planeSize + i));
+			__m128i high = _mm_loadl_epi64((const __m128i*)(planes + (c * 2 + 1) * planeSize + i));
+			__m128i value = _mm_unpacklo_epi8(low, high);
+			value = _mm_xor_si128(_mm_srli_epi16(value, 1), _mm_sub_epi16(zero, _mm_and_si128(value, one)));
+			value = _mm_add_epi16(value, _mm_slli_si128(value, 2));
+			value = _mm_add_epi16(value, _mm_slli_si128(value, 4));
+			value = _mm_add_epi16(value, _mm_slli_si128(value, 8));
+			value = _mm_add_epi16(value, previous[c]);
+			__m128i last = _mm_shufflehi_epi16(value, 0xFF);
+			previous[c] = _mm_unpackhi_epi64(last, last);
+
+			__m128 first = _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero));
+			__m128 second = _mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero));
+			_mm_storeu_ps(block[c], _mm_add_ps(_mm_mul_ps(first, scales[c]), offsets[c]));
+			_mm_storeu_ps(block[c] + 4, _mm_add_ps(_mm_mul_ps(second, scales[c]), offsets[c]));
+		}
+
+		GLfloat* out = vertices + i * 3;
+		for (int k = 0; k < 8; k++)
+		{
+			out[k * 3] = block[0][k];
+			out[k * 3 + 1] = block[1][k];
+			out[k * 3 + 2] = block[2][k];
+		}
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		values[c] = (unsigned short)_mm_cvtsi128_si32(previous[c]);
+	}
+	start = simdCount;
+#endif
+
+	for (size_t i = start; i < vertexCount; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned short zigzag = (unsigned short)(planes[c * 2 * planeSize + i] | planes[(c * 2 + 1) * planeSize + i] << 8);
+			values[c] = (unsigned short)(values[c] + ((zigzag >> 1) ^ (0u - (zigzag & 1))));
+			vertices[i * 3 + c] = values[c] * step[c] + minimum[c];
+		}
+	}
+}
+
+/// <summary>
+/// Turns the colors, stored as the zigzag coded differences of each channel, back into floats.
+/// </summary>
+static void DecodeColors(const unsigned char* planes, size_t planeSize, unsigned int vertexCount, GLfloat* colors)
+{
+	const float scale = 1.0f / 255.0f;
+	unsigned char values[4] = { 0, 0, 0, 0 };
+	size_t start = 0;
+
+#ifdef MESH_CODEC_SSE
+	// Sixteen vertices at a time, as for the positions, with bytes.
+	size_t simdCount = vertexCount & ~(size_t)15;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i lowBits = _mm_set1_epi8(0x7F);
+	const __m128 scales = _mm_set1_ps(scale);
+	__m128i previous[4] = { zero, zero, zero, zero };
+
+	float block[4][16];
+	for (size_t i = 0; i < simdCount; i += 16)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			__m128i value = _mm_loadu_si128((const __m128i*)(planes + c * planeSize + i));
+			value = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(value, 1), lowBits), _mm_sub_epi8(zero, _mm_and_si128(value, one)));
+			value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+			value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+			value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+			value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+			value = _mm_add_epi8(value, previous[c]);
+			previous[c] = _mm_set1_epi8((char)(_mm_extract_epi16(value, 7) >> 8));
+
+			__m128i low = _mm_unpacklo_epi8(value, zero);
+			__m128i high = _mm_unpackhi_epi8(value, zero);
+			_mm_storeu_ps(block[c], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scales));
+			_mm_storeu_ps(block[c] + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scales));
+			_mm_storeu_ps(block[c] + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scales));
+			_mm_storeu_ps(block[c] + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scales));
+		}
+
+		GLfloat* out = colors + i * 4;
+		for (int k = 0; k < 16; k++)
+		{
+			out[k * 4] = block[0][k];
+			out[k * 4 + 1] = block[1][k];
+			out[k * 4 + 2] = block[2][k];
+			out[k * 4 + 3] = block[3][k];
+		}
+	}
+	for (int c = 0; c < 4; c++)
+	{
+		values[c] = (unsigned char)_mm_cvtsi128_si32(previous[c]);
+	}
+	start = simdCount;
+#endif
+
+	for (size_t i = start; i < vertexCount; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			unsigned char zigzag = planes[c * planeSize + i];
+			values[c] = (unsigned char)(values[c] + ((zigzag >> 1) ^ (0u - (zigzag & 1))));
+			colors[i * 4 + c] = values[c] * scale;
+		}
+	}
+}
+
+void MeshCodec::Encode(const std::vector<GLfloat>& vertices, const std::vector<GLfloat>* colors, const std::vector<unsigned int>& indices, GLenum drawType, std::vector<unsigned char>& data)
+{
+	unsigned int vertexCount = (unsigned int)(vertices.size() / 3);
+	bool hasColors = colors != NULL && colors->size() >= (size_t)vertexCount * 4 && vertexCount > 0;
+
+	float minimum[3] = { 0.0f, 0.0f, 0.0f };
+	float step[3] = { 0.0f, 0.0f, 0.0f };
+	for (int c = 0; c < 3 && vertexCount > 0; c++)
+	{
+		float maximum = vertices[c];
+		minimum[c] = vertices[c];
+		for (unsigned int i = 1; i < vertexCount; i++)
+		{
+			minimum[c] = std::min(minimum[c], vertices[i * 3 + c]);
+			maximum = std::max(maximum, vertices[i * 3 + c]);
+		}
+		step[c] = (maximum - minimum[c]) / 65535.0f;
+	}
+
+	// Indices: the difference to the next vertex not used yet, zigzag coded, plus one, as a variable length number.
+	std::vector<unsigned char> indexBytes;
+	unsigned int next = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int index = indices[i];
+		unsigned long long code = RESTART_CODE;
+		if (index != MeshOptimizer::RESTART_INDEX)
+		{
+			int difference = (int)(next - index);
+			code = (unsigned long long)(((unsigned int)difference << 1) ^ (unsigned int)(difference >> 31)) + 1;
+			next = std::max(next, index + 1);
+		}
+		while (code >= 0x80)
+		{
+			indexBytes.push_back((unsigned char)(code | 0x80));
+			code >>= 7;
+		}
+		indexBytes.push_back((unsigned char)code);
+	}
+
+	data.assign(MAGIC, MAGIC + 4);
+	WriteUint(data, VERSION);
+	WriteUint(data, drawType);
+	WriteUint(data, vertexCount);
+	WriteUint(data, (unsigned int)indices.size());
+	WriteUint(data, (unsigned int)indexBytes.size());
+	WriteUint(data, hasColors ? FLAG_COLORS : 0);
+	for (int c = 0; c < 3; c++)
+	{
+		WriteFloat(data, minimum[c]);
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		WriteFloat(data, step[c]);
+	}
+
+	// Positions: the low then high bytes of the zigzag coded differences of each component.
+	size_t planeSize = PadToGroups(vertexCount);
+	std::vector<unsigned char> planes(planeSize * 2);
+	for (int c = 0; c < 3; c++)
+	{
+		std::fill(planes.begin(), planes.end(), 0);
+		unsigned short previous = 0;
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			float quantized = step[c] > 0.0f ? (vertices[i * 3 + c] - minimum[c]) / step[c] : 0.0f;
+			unsigned short value = (unsigned short)std::min(std::max(std::floor(quantized + 0.5f), 0.0f), 65535.0f);
+			short difference = (short)(value - previous);
+			unsigned short zigzag = (unsigned short)(((unsigned int)difference << 1) ^ (unsigned int)(difference >> 15));
+			planes[i] = (unsigned char)zigzag;
+			planes[planeSize + i] = (unsigned char)(zigzag >> 8);
+			previous = value;
+		}
+		EncodeGroups(planes.data(), planeSize, data);
+		EncodeGroups(planes.data() + planeSize, planeSize, data);
+	}
+
+	// Colors: the zigzag coded differences of each channel, quantized to a byte.
+	if (hasColors)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			std::fill(planes.begin(), planes.end(), 0);
+			unsigned char previous = 0;
+			for (unsigned int i = 0; i < vertexCount; i++)
+			{
+				float channel = std::min(std::max((*colors)[i * 4 + c], 0.0f), 1.0f);
+				unsigned char value = (unsigned char)std::floor(channel * 255.0f + 0.5f);
+				signed char difference = (signed char)(value - previous);
+				planes[i] = (unsigned char)(((unsigned int)difference << 1) ^ (unsigned int)(difference >> 7));
+				previous = value;
+			}
+			EncodeGroups(planes.data(), planeSize, data);
+		}
+	}
+
+	indexBytes.resize(PadToGroups(indexBytes.size()), 0);
+	if (!indexBytes.empty())
+	{
+		EncodeGroups(&indexBytes[0], indexBytes.size(), data);
+	}
+}
+
+bool MeshCodec::ReadHeader(const unsigned char* data, size_t size, Header& header)
+{
+	if (size < HEADER_SIZE || memcmp(data, MAGIC, 4) != 0 || ReadUint(data + 4) != VERSION)
+	{
+		return false;
+	}
+
+	header.drawType = ReadUint(data + 8);
+	header.vertexCount = ReadUint(data + 12);
+	header.indexCount = ReadUint(data + 16);
+	header.hasColors = (ReadUint(data + 24) & FLAG_COLORS) != 0;
+
+	// Every index takes a byte at least, and every group of a plane 2 bits of its headers: counts the data can't hold
+	// are refused before anything is sized from them.
+	unsigned int indexByteCount = ReadUint(data + 20);
+	size_t planeCount = header.hasColors ? 10 : 6;
+	size_t groupHeaderSize = planeCount * ((PadToGroups(header.vertexCount) / GROUP_SIZE + 3) / 4) + (PadToGroups(indexByteCount) / GROUP_SIZE + 3) / 4;
+	return header.indexCount <= indexByteCount && groupHeaderSize <= size - HEADER_SIZE;
+}
+
+bool MeshCodec::Decode(const unsigned char* data, size_t size, GLfloat* vertices, GLfloat* colors, unsigned int* indices)
+{
+	Header header;
+	if (!ReadHeader(data, size, header) || (header.hasColors && colors == NULL))
+	{
+		return false;
+	}
+	unsigned int vertexCount = header.vertexCount;
+	size_t indexByteCount = ReadUint(data + 20);
+	float minimum[3], step[3];
+	for (int c = 0; c < 3; c++)
+	{
+		minimum[c] = ReadFloat(data + 28 + c * 4);
+		step[c] = ReadFloat(data + 40 + c * 4);
+	}
+
+	const unsigned char* end = data + size;
+	data += HEADER_SIZE;
+
+	size_t planeSize = PadToGroups(vertexCount);
+	std::vector<unsigned char> planes(planeSize * 6);
+	// The colors' planes reuse the positions' once these are decoded.
+	for (int p = 0; p < 6; p++)
+	{
+		if (!DecodeGroups(data, end, planes.data() + p * planeSize, planeSize))
+		{
+			return false;
+		}
+	}
+	DecodePositions(planes.data(), planeSize, vertexCount, minimum, step, vertices);
+
+	if (header.hasColors)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			if (!DecodeGroups(data, end, planes.data() + c * planeSize, planeSize))
+			{
+				return false;
+			}
+		}
+		DecodeColors(planes.data(), planeSize, vertexCount, colors);
+	}
+
+	// Every byte read is checked against the count in the header, so a corrupt file can't run off the end.
+	std::vector<unsigned char> indexBytes(PadToGroups(indexByteCount));
+	if (indexByteCount > 0 && !DecodeGroups(data, end, &indexBytes[0], PadToGroups(indexByteCount)))
+	{
+		return false;
+	}
+	const unsigned char* codes = indexBytes.data();
+	size_t position = 0;
+	unsigned int next = 0;
+	for (unsigned int i = 0; i < header.indexCount; i++)
+	{
+		// Most codes take a single byte.
+		if (position >= indexByteCount)
+		{
+			return false;
+		}
+		unsigned long long code = codes[position++];
+		if (code >= 0x80)
+		{
+			code &= 0x7F;
+			for (int shift = 7; ; shift += 7)
+			{
+				if (position >= indexByteCount)
+				{
+					return false;
+				}
+				unsigned char byte = codes[position++];
+				code |= (unsigned long long)(byte & 0x7F) << shift;
+				if (byte < 0x80)
+				{
+					break;
+				}
+				if (shift == 7 * (MAX_CODE_BYTES - 1))
+				{
+					return false;
+				}
+			}
+		}
+
+		if (code == RESTART_CODE)
+		{
+			indices[i] = MeshOptimizer::RESTART_INDEX;
+			continue;
+		}
+		unsigned int zigzag = (unsigned int)(code - 1);
+		unsigned int index = next - ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+		if (index >= vertexCount)
+		{
+			return false;
+		}
+		indices[i] = index;
+		next = std::max(next, index + 1);
+	}
+	return position <= indexByteCount;
+}
+
+bool MeshCodec::Decode(const unsigned char* data, size_t size, MeshData& mesh)
+{
+	Header header;
+	if (!ReadHeader(data, size, header))
+	{
+		return false;
+	}
+
+	mesh.drawType = header.drawType;
+	mesh.vertices.resize((size_t)header.vertexCount * 3);
+	mesh.colors.resize(header.hasColors ? (size_t)header.vertexCount * 4 : 0);
+	mesh.indices.resize(header.indexCount);
+	return Decode(data, size, mesh.vertices.data(), mesh.colors.data(), mesh.indices.data());
+}
+
+bool MeshCodec::Save(const char* path, const std::vector<GLfloat>& vertices, const std::vector<GLfloat>* colors, const std::vector<unsigned int>& indices, GLenum drawType)
+{
+	std::vector<unsigned char> data;
+	Encode(vertices, colors, indices, drawType, data);
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		printf("Could not create mesh file %s\n", path);
+		return false;
+	}
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	written = fclose(file) == 0 && written;
+	if (!written)
+	{
+		printf("Could not write mesh file %s\n", path);
+	}
+	return written;
+}
+
+bool MeshCodec::Load(const char* path, MeshData& mesh)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		printf("Could not open mesh file %s\n", path);
+		return false;
+	}
+
+	std::vector<unsigned char> data;
+	unsigned char buffer[65536];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(file);
+
+	if (!Decode(data.data(), data.size(), mesh))
+	{
+		printf("Mesh file %s is not a valid encoded mesh\n", path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Compact file encoding of meshes, several times smaller than their raw arrays and decoded faster than they are read.
+/// Positions are quantized to 16 bits within the mesh's box, colors to 8 bits, and each component is stored as the
+/// difference to the previous vertex's, so meshes ordered by MeshOptimizer mostly store small numbers. Indices are
+/// stored against the next vertex not used yet, which in that order is most often the index itself. The bytes then go
+/// through a byte group coder: each group of 16 bytes is stored as nothing (all zero), nibbles, or as is. Decoding the
+/// positions is vectorized with SSE2 on x86-64.
+/// </summary>
+class MeshCodec
+{
+	public:
+		/// <summary>
+		/// What a mesh's data holds, read before decoding it to size the arrays it is decoded into.
+		/// </summary>
+		struct Header
+		{
+			GLenum drawType;
+			/// <summary>
+			/// Number of vertices. The vertex array holds 3 floats per vertex, the color array 4.
+			/// </summary>
+			unsigned int vertexCount;
+			unsigned int indexCount;
+			bool hasColors;
+		};
+
+		/// <summary>
+		/// A decoded mesh, in the arrays Mesh::CreateMesh takes.
+		/// </summary>
+		struct MeshData
+		{
+			GLenum drawType;
+			std::vector<GLfloat> vertices;
+			/// <summary>
+			/// Empty for meshes using a single color.
+			/// </summary>
+			std::vector<GLfloat> colors;
+			std::vector<unsigned int> indices;
+		};
+
+		/// <summary>
+		/// Encodes a mesh. Positions come back off by at most half a 65535th of the mesh's size along each axis, colors by
+		/// half a 255th.
+		/// </summary>
+		/// <param name="vertices">The vertices, 3 floats each.</param>
+		/// <param name="colors">The vertex colors, 4 floats each from 0 to 1, or NULL.</param>
+		/// <param name="indices">The indices. Restart indices of strips are kept.</param>
+		/// <param name="drawType">The primitives the indices describe, returned by Decode.</param>
+		/// <param name="data">Receives the encoded mesh.</param>
+		static void Encode(const std::vector<GLfloat>& vertices, const std::vector<GLfloat>* colors, const std::vector<unsigned int>& indices, GLenum drawType, std::vector<unsigned char>& data);
+
+		/// <summary>
+		/// Reads the header of an encoded mesh.
+		/// </summary>
+		/// <returns>False if the data isn't an encoded mesh.</returns>
+		static bool ReadHeader(const unsigned char* data, size_t size, Header& header);
+		/// <summary>
+		/// Decodes a mesh into arrays sized from its header, such as mapped buffers.
+		/// </summary>
+		/// <param name="vertices">Receives the vertices, 3 floats each.</param>
+		/// <param name="colors">Receives the vertex colors, 4 floats each, if the mesh has some. May be NULL otherwise.</param>
+		/// <param name="indices">Receives the indices.</param>
+		/// <returns>False if the data isn't a whole encoded mesh.</returns>
+		static bool Decode(const unsigned char* data, size_t size, GLfloat* vertices, GLfloat* colors, unsigned int* indices);
+		/// <summary>
+		/// Decodes a mesh into vectors, resized to fit.
+		/// </summary>
+		static bool Decode(const unsigned char* data, size_t size, MeshData& mesh);
+
+		/// <summary>
+		/// Encodes a mesh into a file.
+		/// </summary>
+		/// <returns>False if the file couldn't be written.</returns>
+		static bool Save(const char* path, const std::vector<GLfloat>& vertices, const std::vector<GLfloat>* colors, const std::vector<unsigned int>& indices, GLenum drawType);
+		/// <summary>
+		/// Reads and decodes a mesh file.
+		/// </summary>
+		/// <returns>False if the file couldn't be read or isn't an encoded mesh.</returns>
+		static bool Load(const char* path, MeshData& mesh);
+};
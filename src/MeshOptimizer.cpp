@@ -0,0 +1,705 @@
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_set>
+#include <utility>
+
+const unsigned int MeshOptimizer::RESTART_INDEX;
+const unsigned int MeshOptimizer::CACHE_SIZE;
+
+// Tom Forsyth's scoring: vertices of the last primitive score a fixed amount, others decay with their position in the
+// cache, and vertices left in few primitives get a boost so that they are finished off rather than left behind.
+static const unsigned int FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_PRIMITIVE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// Overdraw reordering may cost this much more cache misses.
+static const float OVERDRAW_THRESHOLD = 1.05f;
+// Side of the image overdraw is measured on.
+static const int OVERDRAW_RESOLUTION = 256;
+
+/// <summary>
+/// FIFO post transform cache simulation. A vertex is cached if it was transformed within the last CACHE_SIZE misses.
+/// </summary>
+struct FifoCache
+{
+	std::vector<unsigned int> missTimes;
+	unsigned int time;
+
+	FifoCache(unsigned int vertexCount) : missTimes(vertexCount, 0), time(MeshOptimizer::CACHE_SIZE + 1) {}
+
+	/// <summary>
+	/// Returns true if the vertex had to be transformed.
+	/// </summary>
+	bool Access(unsigned int vertex)
+	{
+		if (time - missTimes[vertex] <= MeshOptimizer::CACHE_SIZE)
+		{
+			return false;
+		}
+		missTimes[vertex] = time++;
+		return true;
+	}
+
+	void Reset() { time += MeshOptimizer::CACHE_SIZE + 1; }
+};
+
+static float GetVertexScore(int cachePosition, unsigned int remaining, unsigned int primitiveSize)
+{
+	if (remaining == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < (int)primitiveSize)
+		{
+			score = FORSYTH_LAST_PRIMITIVE_SCORE;
+		}
+		else
+		{
+			float scale = 1.0f / (FORSYTH_CACHE_SIZE - primitiveSize);
+			score = std::pow(1.0f - (cachePosition - primitiveSize) * scale, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+	return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remaining, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+static unsigned int GetVertexCount(const std::vector<GLfloat>& vertices)
+{
+	return (unsigned int)(vertices.size() / 3);
+}
+
+static glm::vec3 GetVertex(const std::vector<GLfloat>& vertices, unsigned int index)
+{
+	return glm::vec3(vertices[index * 3], vertices[index * 3 + 1], vertices[index * 3 + 2]);
+}
+
+/// <summary>
+/// Returns how many vertices the GPU transforms drawing the indices, skipping restart indices if asked.
+/// </summary>
+static unsigned int CountCacheMisses(const std::vector<unsigned int>& indices, unsigned int vertexCount, bool restart = false)
+{
+	FifoCache cache(vertexCount);
+	unsigned int misses = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (restart && indices[i] == MeshOptimizer::RESTART_INDEX)
+		{
+			continue;
+		}
+		misses += cache.Access(indices[i]) ? 1 : 0;
+	}
+	return misses;
+}
+
+/// <summary>
+/// Returns pixels shaded per pixel covered when the triangles are drawn, in order and with a depth test, looking at the
+/// mesh along each axis from both sides.
+/// </summary>
+static float MeasureOverdraw(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& triangles)
+{
+	glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		glm::vec3 vertex = GetVertex(vertices, triangles[i]);
+		minimum = glm::min(minimum, vertex);
+		maximum = glm::max(maximum, vertex);
+	}
+
+	std::vector<float> depths(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+	unsigned long long shaded = 0;
+	unsigned long long covered = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+		float size = std::max(maximum[u] - minimum[u], maximum[v] - minimum[v]);
+		if (!(size > 0.0f))
+		{
+			continue;
+		}
+		float scale = OVERDRAW_RESOLUTION / size;
+
+		for (int side = 0; side < 2; side++)
+		{
+			std::fill(depths.begin(), depths.end(), FLT_MAX);
+			for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+			{
+				float x[3], y[3], z[3];
+				for (int k = 0; k < 3; k++)
+				{
+					glm::vec3 vertex = GetVertex(vertices, triangles[t + k]);
+					x[k] = (vertex[u] - minimum[u]) * scale;
+					y[k] = (vertex[v] - minimum[v]) * scale;
+					z[k] = side == 0 ? vertex[axis] - minimum[axis] : maximum[axis] - vertex[axis];
+				}
+
+				// Faces aren't culled in the scene, so both windings are drawn.
+				float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+				if (area == 0.0f)
+				{
+					continue;
+				}
+				int left = std::max(0, (int)std::floor(std::min(std::min(x[0], x[1]), x[2])));
+				int right = std::min(OVERDRAW_RESOLUTION - 1, (int)std::ceil(std::max(std::max(x[0], x[1]), x[2])));
+				int bottom = std::max(0, (int)std::floor(std::min(std::min(y[0], y[1]), y[2])));
+				int top = std::min(OVERDRAW_RESOLUTION - 1, (int)std::ceil(std::max(std::max(y[0], y[1]), y[2])));
+
+				for (int py = bottom; py <= top; py++)
+				{
+					for (int px = left; px <= right; px++)
+					{
+						float cx = px + 0.5f;
+						float cy = py + 0.5f;
+						float w0 = ((x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1])) / area;
+						float w1 = ((x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2])) / area;
+						float w2 = 1.0f - w0 - w1;
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						{
+							continue;
+						}
+
+						float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+						float& stored = depths[py * OVERDRAW_RESOLUTION + px];
+						if (depth < stored)
+						{
+							covered += stored == FLT_MAX ? 1 : 0;
+							stored = depth;
+							shaded++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return covered > 0 ? (float)shaded / covered : 0.0f;
+}
+
+void MeshOptimizer::Optimize(std::vector<GLfloat>& vertices, std::vector<GLfloat>* colors, std::vector<unsigned int>& indices, GLenum drawType, Report* report)
+{
+	if (report != NULL)
+	{
+		report->before = Analyze(vertices, indices, drawType);
+		report->after = report->before;
+	}
+
+	unsigned int vertexCount = GetVertexCount(vertices);
+	std::vector<unsigned int> primitives;
+	unsigned int primitiveSize;
+	switch (drawType)
+	{
+		case GL_TRIANGLE_STRIP:
+			ToTriangles(indices, 0, primitives);
+			primitiveSize = 3;
+			break;
+		case GL_TRIANGLES:
+			primitives.assign(indices.begin(), indices.end() - indices.size() % 3);
+			primitiveSize = 3;
+			break;
+		case GL_LINES:
+		{
+			// Grids and outlines built cell by cell add each inner edge twice.
+			std::unordered_set<unsigned long long> lines;
+			for (size_t i = 0; i + 1 < indices.size(); i += 2)
+			{
+				unsigned int a = std::min(indices[i], indices[i + 1]);
+				unsigned int b = std::max(indices[i], indices[i + 1]);
+				if (a != b && lines.insert((unsigned long long)a << 32 | b).second)
+				{
+					primitives.push_back(indices[i]);
+					primitives.push_back(indices[i + 1]);
+				}
+			}
+			primitiveSize = 2;
+			break;
+		}
+		default:
+			return;
+	}
+
+	OptimizeVertexCache(primitives, vertexCount, primitiveSize);
+	if (primitiveSize == 3)
+	{
+		OptimizeOverdraw(primitives, vertices, OVERDRAW_THRESHOLD);
+	}
+
+	bool restart = drawType == GL_TRIANGLE_STRIP;
+	std::vector<unsigned int> optimized;
+	if (restart)
+	{
+		ToStrips(primitives, optimized);
+	}
+	else
+	{
+		optimized.swap(primitives);
+	}
+
+	// Strips generated along a shape's rows are often as good as it gets already: keep them if the new order would
+	// transform more vertices, or as many from more indices.
+	unsigned int misses = CountCacheMisses(indices, vertexCount, restart);
+	unsigned int optimizedMisses = CountCacheMisses(optimized, vertexCount, restart);
+	if (optimizedMisses < misses || (optimizedMisses == misses && optimized.size() <= indices.size()))
+	{
+		indices.swap(optimized);
+	}
+	OptimizeVertexFetch(vertices, colors, indices, restart);
+
+	if (report != NULL)
+	{
+		report->after = Analyze(vertices, indices, drawType);
+	}
+}
+
+MeshOptimizer::Statistics MeshOptimizer::Analyze(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices, GLenum drawType)
+{
+	Statistics statistics = Statistics();
+	statistics.indexCount = (unsigned int)indices.size();
+	unsigned int vertexCount = GetVertexCount(vertices);
+
+	std::vector<unsigned int> triangles;
+	switch (drawType)
+	{
+		case GL_TRIANGLE_STRIP:
+			ToTriangles(indices, 0, triangles);
+			break;
+		case GL_TRIANGLES:
+			triangles.assign(indices.begin(), indices.end() - indices.size() % 3);
+			break;
+		case GL_LINES:
+			statistics.primitiveCount = (unsigned int)(indices.size() / 2);
+			break;
+		default:
+			return statistics;
+	}
+	if (!triangles.empty())
+	{
+		statistics.primitiveCount = (unsigned int)(triangles.size() / 3);
+	}
+
+	// The GPU transforms the strips' own indices, not the triangles they stand for.
+	unsigned int misses = CountCacheMisses(indices, vertexCount, drawType == GL_TRIANGLE_STRIP);
+	statistics.acmr = statistics.primitiveCount > 0 ? (float)misses / statistics.primitiveCount : 0.0f;
+	statistics.atvr = vertexCount > 0 ? (float)misses / vertexCount : 0.0f;
+	statistics.overdraw = triangles.empty() ? 0.0f : MeasureOverdraw(vertices, triangles);
+	return statistics;
+}
+
+void MeshOptimizer::ToTriangles(const std::vector<unsigned int>& strips, unsigned int first, std::vector<unsigned int>& triangles)
+{
+	size_t stripStart = 0;
+	for (size_t i = 0; i <= strips.size(); i++)
+	{
+		if (i < strips.size() && strips[i] != RESTART_INDEX)
+		{
+			continue;
+		}
+
+		// Every other triangle of a strip is flipped, to keep the strip's winding.
+		for (size_t j = stripStart; j + 2 < i; j++)
+		{
+			unsigned int a = strips[j];
+			unsigned int b = strips[j + 1];
+			unsigned int c = strips[j + 2];
+			if (a == b || b == c || a == c)
+			{
+				continue;
+			}
+			if ((j - stripStart) % 2 == 1)
+			{
+				std::swap(a, b);
+			}
+			triangles.push_back(first + a);
+			triangles.push_back(first + b);
+			triangles.push_back(first + c);
+		}
+		stripStart = i + 1;
+	}
+}
+
+void MeshOptimizer::ToStrips(const std::vector<unsigned int>& triangles, std::vector<unsigned int>& strips)
+{
+	size_t triangleCount = triangles.size() / 3;
+
+	// Every directed edge with the triangle it belongs to, sorted to find a triangle's neighbours. The neighbour across
+	// the edge from a to b of a triangle has the edge from b to a.
+	std::vector<std::pair<unsigned long long, unsigned int>> edges;
+	edges.reserve(triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned long long from = triangles[t * 3 + k];
+			unsigned long long to = triangles[t * 3 + (k + 1) % 3];
+			edges.push_back(std::make_pair(from << 32 | to, (unsigned int)t));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+
+	std::vector<bool> used(triangleCount, false);
+	// Returns an unused triangle having the edge from a to b, and its third vertex, or false if there is none.
+	auto findTriangle = [&](unsigned int a, unsigned int b, unsigned int& triangle, unsigned int& third)
+	{
+		unsigned long long key = (unsigned long long)a << 32 | b;
+		std::vector<std::pair<unsigned long long, unsigned int>>::const_iterator edge =
+			std::lower_bound(edges.begin(), edges.end(), std::make_pair(key, 0u));
+		for (; edge != edges.end() && edge->first == key; ++edge)
+		{
+			if (!used[edge->second])
+			{
+				triangle = edge->second;
+				const unsigned int* vertices = &triangles[triangle * 3];
+				third = vertices[0] != a && vertices[0] != b ? vertices[0] : vertices[1] != a && vertices[1] != b ? vertices[1] : vertices[2];
+				return true;
+			}
+		}
+		return false;
+	};
+
+	strips.clear();
+	unsigned int neighbour, third;
+	std::vector<unsigned int> strip, longest;
+	std::vector<unsigned int> taken, longestTaken;
+	for (size_t start = 0; start < triangleCount; start++)
+	{
+		if (used[start])
+		{
+			continue;
+		}
+		used[start] = true;
+
+		// Grow a strip from each rotation of the triangle, which decides the edge it continues across, and keep the longest.
+		const unsigned int* vertices = &triangles[start * 3];
+		for (int rotation = 0; rotation < 3; rotation++)
+		{
+			strip.clear();
+			taken.clear();
+			for (int k = 0; k < 3; k++)
+			{
+				strip.push_back(vertices[(rotation + k) % 3]);
+			}
+
+			// Triangle i of a strip is drawn from its last two indices and a new one, flipped when i is odd. The next
+			// triangle must then have the edge between the last two indices, in the order it is drawn in.
+			while (true)
+			{
+				size_t count = strip.size();
+				unsigned int a = strip[count - 2];
+				unsigned int b = strip[count - 1];
+				bool odd = count % 2 == 1;
+				if (!(odd ? findTriangle(b, a, neighbour, third) : findTriangle(a, b, neighbour, third)))
+				{
+					break;
+				}
+				used[neighbour] = true;
+				taken.push_back(neighbour);
+				strip.push_back(third);
+			}
+
+			for (size_t i = 0; i < taken.size(); i++)
+			{
+				used[taken[i]] = false;
+			}
+			if (rotation == 0 || strip.size() > longest.size())
+			{
+				longest.swap(strip);
+				longestTaken.swap(taken);
+			}
+		}
+
+		for (size_t i = 0; i < longestTaken.size(); i++)
+		{
+			used[longestTaken[i]] = true;
+		}
+		if (!strips.empty())
+		{
+			strips.push_back(RESTART_INDEX);
+		}
+		strips.insert(strips.end(), longest.begin(), longest.end());
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int primitiveSize)
+{
+	size_t primitiveCount = indices.size() / primitiveSize;
+	if (primitiveCount == 0)
+	{
+		return;
+	}
+
+	// The primitives using each vertex, packed: those of vertex v start at firstPrimitives[v], and the first
+	// remaining[v] of them aren't emitted yet.
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < primitiveCount * primitiveSize; i++)
+	{
+		remaining[indices[i]]++;
+	}
+	std::vector<unsigned int> firstPrimitives(vertexCount, 0);
+	for (unsigned int v = 1; v < vertexCount; v++)
+	{
+		firstPrimitives[v] = firstPrimitives[v - 1] + remaining[v - 1];
+	}
+	std::vector<unsigned int> vertexPrimitives(primitiveCount * primitiveSize);
+	std::vector<unsigned int> filled(vertexCount, 0);
+	for (size_t p = 0; p < primitiveCount; p++)
+	{
+		for (unsigned int k = 0; k < primitiveSize; k++)
+		{
+			unsigned int v = indices[p * primitiveSize + k];
+			vertexPrimitives[firstPrimitives[v] + filled[v]++] = (unsigned int)p;
+		}
+	}
+
+	std::vector<float> vertexScores(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = GetVertexScore(-1, remaining[v], primitiveSize);
+	}
+	std::vector<float> primitiveScores(primitiveCount, 0.0f);
+	std::vector<bool> emitted(primitiveCount, false);
+	int best = 0;
+	for (size_t p = 0; p < primitiveCount; p++)
+	{
+		for (unsigned int k = 0; k < primitiveSize; k++)
+		{
+			primitiveScores[p] += vertexScores[indices[p * primitiveSize + k]];
+		}
+		if (primitiveScores[p] > primitiveScores[best])
+		{
+			best = (int)p;
+		}
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(primitiveCount * primitiveSize);
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	size_t scan = 0;
+	while (best >= 0)
+	{
+		emitted[best] = true;
+		const unsigned int* primitive = &indices[best * primitiveSize];
+		output.insert(output.end(), primitive, primitive + primitiveSize);
+
+		// The primitive's vertices move to the front of the cache, the others move back after them.
+		newCache.clear();
+		for (unsigned int k = 0; k < primitiveSize; k++)
+		{
+			unsigned int v = primitive[k];
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+			{
+				newCache.push_back(v);
+			}
+
+			unsigned int* list = &vertexPrimitives[firstPrimitives[v]];
+			unsigned int* found = std::find(list, list + remaining[v], (unsigned int)best);
+			std::swap(*found, list[--remaining[v]]);
+		}
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			if (std::find(newCache.begin(), newCache.end(), cache[i]) == newCache.end())
+			{
+				newCache.push_back(cache[i]);
+			}
+		}
+
+		// Rescore the vertices whose cache position changed, including the ones pushed out, then their primitives.
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			unsigned int v = newCache[i];
+			vertexScores[v] = GetVertexScore(i < FORSYTH_CACHE_SIZE ? (int)i : -1, remaining[v], primitiveSize);
+		}
+		best = -1;
+		float bestScore = -FLT_MAX;
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			unsigned int v = newCache[i];
+			const unsigned int* list = &vertexPrimitives[firstPrimitives[v]];
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int p = list[j];
+				float score = 0.0f;
+				for (unsigned int k = 0; k < primitiveSize; k++)
+				{
+					score += vertexScores[indices[p * primitiveSize + k]];
+				}
+				primitiveScores[p] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = (int)p;
+				}
+			}
+		}
+
+		if (newCache.size() > FORSYTH_CACHE_SIZE)
+		{
+			newCache.resize(FORSYTH_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		// Nothing left around the cache: carry on from the next primitive not emitted yet, in the original order.
+		if (best < 0)
+		{
+			while (scan < primitiveCount && emitted[scan])
+			{
+				scan++;
+			}
+			best = scan < primitiveCount ? (int)scan : -1;
+		}
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& triangles, const std::vector<GLfloat>& vertices, float threshold)
+{
+	size_t triangleCount = triangles.size() / 3;
+	unsigned int vertexCount = GetVertexCount(vertices);
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	unsigned int cacheMisses = CountCacheMisses(triangles, vertexCount);
+
+	// Clusters start where the cache order already starts afresh (all three vertices miss), or where the triangles
+	// since the last start, transformed on their own, miss about as much as the whole mesh does. Moving whole
+	// clusters around then costs few extra misses.
+	float budget = (float)cacheMisses / triangleCount * threshold;
+	std::vector<size_t> clusterStarts;
+	FifoCache meshCache(vertexCount);
+	FifoCache clusterCache(vertexCount);
+	unsigned int clusterMisses = 0;
+	size_t clusterStart = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		unsigned int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			misses += meshCache.Access(triangles[t * 3 + k]) ? 1 : 0;
+		}
+		if (t == 0 || misses == 3)
+		{
+			clusterStarts.push_back(t);
+			clusterStart = t;
+			clusterMisses = 0;
+			clusterCache.Reset();
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			clusterMisses += clusterCache.Access(triangles[t * 3 + k]) ? 1 : 0;
+		}
+		if (t + 1 < triangleCount && clusterMisses <= budget * (t + 1 - clusterStart))
+		{
+			clusterStarts.push_back(t + 1);
+			clusterStart = t + 1;
+			clusterMisses = 0;
+			clusterCache.Reset();
+		}
+	}
+	clusterStarts.erase(std::unique(clusterStarts.begin(), clusterStarts.end()), clusterStarts.end());
+	if (clusterStarts.size() < 2)
+	{
+		return;
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Each cluster's area weighted center and normal. Clusters far out from the mesh's center along their normal face
+	// outwards and are drawn first.
+	size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<glm::vec3> centers(clusterCount);
+	std::vector<glm::vec3> normals(clusterCount);
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			glm::vec3 a = GetVertex(vertices, triangles[t * 3]);
+			glm::vec3 b = GetVertex(vertices, triangles[t * 3 + 1]);
+			glm::vec3 d = GetVertex(vertices, triangles[t * 3 + 2]);
+			glm::vec3 areaNormal = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(areaNormal);
+			center += (a + b + d) * (triangleArea / 3.0f);
+			normal += areaNormal;
+			area += triangleArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers[c] = area > 0.0f ? center / area : GetVertex(vertices, triangles[clusterStarts[c] * 3]);
+		normals[c] = normal;
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCenter = meshCenter / meshArea;
+	}
+
+	std::vector<float> scores(clusterCount);
+	std::vector<unsigned int> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float normalLength = glm::length(normals[c]);
+		scores[c] = normalLength > 0.0f ? glm::dot(centers[c] - meshCenter, normals[c] / normalLength) : 0.0f;
+		order[c] = (unsigned int)c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return scores[a] > scores[b]; });
+
+	std::vector<unsigned int> reordered;
+	reordered.reserve(triangleCount * 3);
+	for (size_t i = 0; i < clusterCount; i++)
+	{
+		unsigned int c = order[i];
+		reordered.insert(reordered.end(), triangles.begin() + clusterStarts[c] * 3, triangles.begin() + clusterStarts[c + 1] * 3);
+	}
+	if (CountCacheMisses(reordered, vertexCount) <= cacheMisses * threshold)
+	{
+		triangles.swap(reordered);
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLfloat>* colors, std::vector<unsigned int>& indices, bool restart)
+{
+	const unsigned int UNUSED = ~0u;
+	unsigned int vertexCount = GetVertexCount(vertices);
+	std::vector<unsigned int> remap(vertexCount, UNUSED);
+	std::vector<GLfloat> newVertices;
+	std::vector<GLfloat> newColors;
+	newVertices.reserve(vertices.size());
+	unsigned int next = 0;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int index = indices[i];
+		if (restart && index == RESTART_INDEX)
+		{
+			continue;
+		}
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = next++;
+			newVertices.insert(newVertices.end(), vertices.begin() + index * 3, vertices.begin() + index * 3 + 3);
+			if (colors != NULL && !colors->empty())
+			{
+				newColors.insert(newColors.end(), colors->begin() + index * 4, colors->begin() + index * 4 + 4);
+			}
+		}
+		indices[i] = remap[index];
+	}
+
+	vertices.swap(newVertices);
+	if (colors != NULL && !colors->empty())
+	{
+		colors->swap(newColors);
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Reorders the indices and vertices of a mesh so the GPU draws it faster, without changing what it draws: primitives in
+/// the order that reuses the most vertices from the post transform cache, then, for triangles, groups of them reordered
+/// so the ones likely to hide others come first, then vertices stored in the order they are first used, so fetching
+/// them reads memory in order. Main's shapes are optimized once before their meshes are created, and static batches as they
+/// are built; Mesh::CreateMesh doesn't optimize.
+/// </summary>
+class MeshOptimizer
+{
+	public:
+		/// <summary>
+		/// The index ending a strip, as Main sets it with glPrimitiveRestartIndex. Restart is on for every draw, triangles
+		/// included, so this is the largest index there is: no mesh, however many meshes are batched into it, can reach it.
+		/// </summary>
+		static const unsigned int RESTART_INDEX = 0xFFFFFFFFu;
+		/// <summary>
+		/// Entries of the FIFO post transform cache the statistics simulate, about the size of current GPUs' caches.
+		/// </summary>
+		static const unsigned int CACHE_SIZE = 16;
+
+		/// <summary>
+		/// How well a mesh's order suits the GPU.
+		/// </summary>
+		struct Statistics
+		{
+			unsigned int primitiveCount;
+			unsigned int indexCount;
+			/// <summary>
+			/// Average cache miss ratio: vertices transformed per primitive. 3 for triangles sharing no vertices, 0.5 at best.
+			/// </summary>
+			float acmr;
+			/// <summary>
+			/// Average transformed vertex ratio: vertices transformed per vertex of the mesh. 1 at best.
+			/// </summary>
+			float atvr;
+			/// <summary>
+			/// Pixels shaded per pixel covered, seen along each axis in both directions. 1 at best, 0 for lines.
+			/// </summary>
+			float overdraw;
+		};
+
+		struct Report
+		{
+			Statistics before;
+			Statistics after;
+		};
+
+		/// <summary>
+		/// Optimizes a mesh in place. Triangles and strips go through every step, and strips come back as strips
+		/// separated by restart indices. Lines are only reordered for the cache and fetch, repeated lines dropped.
+		/// Other primitives are left as they are.
+		/// </summary>
+		/// <param name="vertices">The vertices, 3 floats each. Unused vertices are dropped.</param>
+		/// <param name="colors">The vertex colors, 4 floats each, reordered with the vertices. May be NULL.</param>
+		/// <param name="indices">The indices.</param>
+		/// <param name="drawType">The primitives the indices describe: GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_LINES.</param>
+		/// <param name="report">If not NULL, receives the statistics before and after. Measuring overdraw rasterizes the
+		/// mesh six times, so only pass one when the numbers are printed.</param>
+		static void Optimize(std::vector<GLfloat>& vertices, std::vector<GLfloat>* colors, std::vector<unsigned int>& indices, GLenum drawType, Report* report = NULL);
+
+		/// <summary>
+		/// Measures a mesh as drawn with the given primitives.
+		/// </summary>
+		static Statistics Analyze(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices, GLenum drawType);
+
+		/// <summary>
+		/// Appends the triangles strips describe, keeping their winding. Each strip, up to a restart index, gives a
+		/// triangle per index past its second one; triangles repeating a vertex (strips joined by repeating one) are dropped.
+		/// </summary>
+		/// <param name="strips">The strip indices.</param>
+		/// <param name="first">Added to every index appended.</param>
+		/// <param name="triangles">The triangle list to append to.</param>
+		static void ToTriangles(const std::vector<unsigned int>& strips, unsigned int first, std::vector<unsigned int>& triangles);
+		/// <summary>
+		/// Joins triangles sharing edges into strips, separated by restart indices, keeping their winding and, as much as
+		/// possible, their order.
+		/// </summary>
+		static void ToStrips(const std::vector<unsigned int>& triangles, std::vector<unsigned int>& strips);
+
+		/// <summary>
+		/// Orders primitives so each reuses the vertices of the last ones, with Tom Forsyth's linear speed algorithm.
+		/// </summary>
+		/// <param name="indices">Lines or triangles, reordered in place.</param>
+		/// <param name="vertexCount">Number of vertices the indices refer to.</param>
+		/// <param name="primitiveSize">2 for lines, 3 for triangles.</param>
+		static void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int primitiveSize);
+		/// <summary>
+		/// Reorders groups of cache ordered triangles, the ones facing out from the mesh's center first, so the depth test
+		/// rejects more of the triangles behind them. Keeps the new order only if it transforms at most threshold times
+		/// as many vertices.
+		/// </summary>
+		static void OptimizeOverdraw(std::vector<unsigned int>& triangles, const std::vector<GLfloat>& vertices, float threshold);
+		/// <summary>
+		/// Stores the vertices (and colors) in the order the indices first use them, dropping unused ones, and renumbers the indices.
+		/// </summary>
+		/// <param name="restart">True to leave restart indices as they are.</param>
+		static void OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLfloat>* colors, std::vector<unsigned int>& indices, bool restart);
+};
@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+template <class T> class Pool;
+
+/// <summary>
+/// A reference to an object stored in a Pool. Holds the object's slot and the generation of the slot when the object was
+/// created: once the object is destroyed and its slot reused, old handles to it are detected as stale instead of
+/// silently reaching the new object.
+/// </summary>
+template <class T>
+class Handle
+{
+	public:
+		/// <summary>
+		/// Creates a null handle, which never refers to an object.
+		/// </summary>
+		Handle() : index(0), generation(0) {}
+		Handle(unsigned int index, unsigned int generation) : index(index), generation(generation) {}
+
+		/// <summary>
+		/// Returns the object, or NULL if the handle is null or the object was destroyed.
+		/// </summary>
+		T* Get() const { return Pool<T>::Global().Get(*this); }
+		/// <summary>
+		/// Returns true if the handle refers to a living object.
+		/// </summary>
+		bool IsValid() const { return Get() != NULL; }
+
+		/// <summary>
+		/// Accesses the object. The handle must be valid.
+		/// </summary>
+		T* operator->() const { return Get(); }
+		T& operator*() const { return *Get(); }
+
+		bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const Handle& other) const { return !(*this == other); }
+
+		unsigned int GetIndex() const { return index; }
+		unsigned int GetGeneration() const { return generation; }
+
+	private:
+		unsigned int index;
+		/// <summary>
+		/// Generation of the slot when the object was created. Always odd for a created object, 0 for a null handle.
+		/// </summary>
+		unsigned int generation;
+};
+
+/// <summary>
+/// Stores objects of one type in fixed size chunks, recycling the slots of destroyed objects. Creating and destroying
+/// an object is constant time with no heap allocation (besides a new chunk now and then), objects never move once created,
+/// and objects created together sit next to each other in memory.
+/// Creating and destroying objects isn't thread safe, but reading objects through handles from many threads is.
+/// </summary>
+template <class T>
+class Pool
+{
+	public:
+		/// <summary>
+		/// Number of objects per chunk.
+		/// </summary>
+		static const unsigned int CHUNK_SIZE = 1024;
+
+		Pool() : liveCount(0) {}
+		~Pool()
+		{
+			Clear();
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				::operator delete(chunks[i]);
+			}
+		}
+
+		Pool(const Pool&) = delete;
+		Pool& operator=(const Pool&) = delete;
+
+		/// <summary>
+		/// Returns the pool shared by every object of type T, the one handles resolve through.
+		/// </summary>
+		static Pool& Global()
+		{
+			static Pool pool;
+			return pool;
+		}
+
+		/// <summary>
+		/// Constructs an object in a free slot, with the given constructor arguments.
+		/// </summary>
+		/// <returns>The handle of the new object.</returns>
+		template <class... Arguments>
+		Handle<T> Create(Arguments&&... arguments)
+		{
+			unsigned int index;
+			if (!freeSlots.empty())
+			{
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else
+			{
+				index = (unsigned int)generations.size();
+				if (index % CHUNK_SIZE == 0)
+				{
+					chunks.push_back(static_cast<T*>(::operator new(sizeof(T) * CHUNK_SIZE)));
+				}
+				generations.push_back(0);
+			}
+
+			new (Slot(index)) T(std::forward<Arguments>(arguments)...);
+
+			// Odd generations mark living objects.
+			generations[index]++;
+			liveCount++;
+			return Handle<T>(index, generations[index]);
+		}
+
+		/// <summary>
+		/// Destroys the object and frees its slot. Does nothing if the handle is null or stale.
+		/// </summary>
+		void Destroy(Handle<T> handle)
+		{
+			if (Get(handle) == NULL)
+			{
+				return;
+			}
+
+			// Mark the slot free first, so the destructor destroying other objects of this pool sees a consistent state.
+			unsigned int index = handle.GetIndex();
+			generations[index]++;
+			liveCount--;
+			Slot(index)->~T();
+			freeSlots.push_back(index);
+		}
+
+		/// <summary>
+		/// Returns the object a handle refers to, or NULL if the handle is null or stale.
+		/// </summary>
+		T* Get(Handle<T> handle) const
+		{
+			unsigned int index = handle.GetIndex();
+			if (index >= generations.size() || generations[index] != handle.GetGeneration() || (handle.GetGeneration() & 1) == 0)
+			{
+				return NULL;
+			}
+			return Slot(index);
+		}
+
+		/// <summary>
+		/// Calls the function on every living object, in memory order.
+		/// </summary>
+		template <class Function>
+		void ForEach(Function function)
+		{
+			for (unsigned int i = 0; i < generations.size(); i++)
+			{
+				if (generations[i] & 1)
+				{
+					function(*Slot(i));
+				}
+			}
+		}
+
+		/// <summary>
+		/// Destroys every living object at once. Handles to them all become stale. Chunks are kept for reuse.
+		/// </summary>
+		void Clear()
+		{
+			for (unsigned int i = 0; i < generations.size(); i++)
+			{
+				if (generations[i] & 1)
+				{
+					generations[i]++;
+					Slot(i)->~T();
+				}
+			}
+
+			// Every slot is free again; hand out the lowest ones first so new objects are packed at the start.
+			freeSlots.clear();
+			for (unsigned int i = (unsigned int)generations.size(); i > 0; i--)
+			{
+				freeSlots.push_back(i - 1);
+			}
+			liveCount = 0;
+		}
+
+		/// <summary>
+		/// Returns the number of living objects.
+		/// </summary>
+		size_t GetCount() const { return liveCount; }
+
+	private:
+		T* Slot(unsigned int index) const { return chunks[index / CHUNK_SIZE] + index % CHUNK_SIZE; }
+
+		/// <summary>
+		/// Raw storage for CHUNK_SIZE objects each. Never reallocated, so objects keep their address.
+		/// </summary>
+		std::vector<T*> chunks;
+		/// <summary>
+		/// Generation of every slot: odd if it holds a living object, even if it is free.
+		/// </summary>
+		std::vector<unsigned int> generations;
+		std::vector<unsigned int> freeSlots;
+		size_t liveCount;
+};
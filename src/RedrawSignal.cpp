@@ -0,0 +1,3 @@
+#include "RedrawSignal.h"
+
+std::atomic<bool> RedrawSignal::requested(true);
@@ -0,0 +1,30 @@
+#pragma once
+#include <atomic>
+
+/// <summary>
+/// Scene-wide flag telling the main loop that what is on screen is out of date. Everything that changes what is drawn
+/// (camera moves, world rotation, transformation edits, color and highlight changes, window events) requests a redraw;
+/// when nothing did, the main loop sleeps until the next event instead of drawing the same image again.
+/// </summary>
+class RedrawSignal
+{
+	public:
+		/// <summary>
+		/// Flags the window for redrawing. Can be called from any thread; a thread other than the main thread must also
+		/// call glfwPostEmptyEvent to wake the main loop up.
+		/// </summary>
+		static void Request() { requested.store(true, std::memory_order_relaxed); }
+
+		static bool IsRequested() { return requested.load(std::memory_order_relaxed); }
+
+		/// <summary>
+		/// Clears the flag. Call once the frame about to be drawn accounts for every change made so far.
+		/// </summary>
+		static void Clear() { requested.store(false, std::memory_order_relaxed); }
+
+	private:
+		/// <summary>
+		/// Starts set, so the first frame is drawn.
+		/// </summary>
+		static std::atomic<bool> requested;
+};
@@ -0,0 +1,113 @@
+#include "RenderStats.h"
+#include <cstdio>
+
+void RenderCounters::Add(const RenderCounters& other)
+{
+	draws += other.draws;
+	indices += other.indices;
+	vertexArrayBinds += other.vertexArrayBinds;
+	programBinds += other.programBinds;
+	uniformUploads += other.uniformUploads;
+	uniformBytes += other.uniformBytes;
+	bufferBytes += other.bufferBytes;
+}
+
+void RenderCounters::Subtract(const RenderCounters& other)
+{
+	draws -= other.draws;
+	indices -= other.indices;
+	vertexArrayBinds -= other.vertexArrayBinds;
+	programBinds -= other.programBinds;
+	uniformUploads -= other.uniformUploads;
+	uniformBytes -= other.uniformBytes;
+	bufferBytes -= other.bufferBytes;
+}
+
+#ifdef RENDER_STATS
+
+RenderCounters RenderStats::frame = RenderCounters();
+std::vector<std::pair<std::string, RenderCounters>> RenderStats::subtrees;
+std::vector<RenderStats::OpenSubtree> RenderStats::openSubtrees;
+
+void RenderStats::BeginFrame()
+{
+	frame = RenderCounters();
+	subtrees.clear();
+	openSubtrees.clear();
+}
+
+void RenderStats::BeginSubtree(const std::string& name)
+{
+	OpenSubtree open;
+	open.subtree = -1;
+	open.start = frame;
+
+	if (!name.empty())
+	{
+		// Few parts are named, so a linear search is enough.
+		size_t i = 0;
+		while (i < subtrees.size() && subtrees[i].first != name)
+		{
+			i++;
+		}
+		if (i == subtrees.size())
+		{
+			subtrees.push_back(std::make_pair(name, RenderCounters()));
+		}
+		open.subtree = (int)i;
+
+		for (size_t j = 0; j < openSubtrees.size(); j++)
+		{
+			if (openSubtrees[j].subtree == open.subtree)
+			{
+				open.subtree = -1;
+				break;
+			}
+		}
+	}
+
+	openSubtrees.push_back(open);
+}
+
+void RenderStats::EndSubtree()
+{
+	OpenSubtree open = openSubtrees.back();
+	openSubtrees.pop_back();
+	if (open.subtree < 0)
+	{
+		return;
+	}
+
+	RenderCounters counted = frame;
+	counted.Subtract(open.start);
+	subtrees[open.subtree].second.Add(counted);
+}
+
+// Writes the counters as the members of a JSON object, without its braces.
+static void AppendCounters(std::string& json, const RenderCounters& counters)
+{
+	char members[256];
+	snprintf(members, sizeof(members),
+		"\"draws\":%u,\"indices\":%zu,\"vaoBinds\":%u,\"programBinds\":%u,\"uniformUploads\":%u,\"uniformBytes\":%zu,\"bufferBytes\":%zu",
+		counters.draws, counters.indices, counters.vertexArrayBinds, counters.programBinds, counters.uniformUploads,
+		counters.uniformBytes, counters.bufferBytes);
+	json += members;
+}
+
+std::string RenderStats::ToJson(unsigned int frameNumber)
+{
+	std::string json = "{\"frame\":" + std::to_string(frameNumber) + ",";
+	AppendCounters(json, frame);
+	json += ",\"subtrees\":{";
+	for (size_t i = 0; i < subtrees.size(); i++)
+	{
+		// Names are set by the code, never with quotes or backslashes, so they need no escaping.
+		json += (i > 0 ? ",\"" : "\"") + subtrees[i].first + "\":{";
+		AppendCounters(json, subtrees[i].second);
+		json += "}";
+	}
+	json += "}}";
+	return json;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// What a frame, or a part of it, submitted to the GPU.
+/// </summary>
+struct RenderCounters
+{
+	unsigned int draws;
+	/// <summary>
+	/// Indices submitted by the draws, restart indices included.
+	/// </summary>
+	size_t indices;
+	unsigned int vertexArrayBinds;
+	unsigned int programBinds;
+	unsigned int uniformUploads;
+	size_t uniformBytes;
+	/// <summary>
+	/// Bytes written into buffers, by allocations given data and by partial updates.
+	/// </summary>
+	size_t bufferBytes;
+
+	void Add(const RenderCounters& other);
+	void Subtract(const RenderCounters& other);
+};
+
+#ifdef RENDER_STATS
+
+/// <summary>
+/// Counts the draws, binds and uploads of each frame, as a whole and per named part of the scene. GLState counts every
+/// call it issues to the driver, so the meshes, objects, command lists and shader setters all count through it.
+/// Built only with RENDER_STATS defined; without it, the counting macros below compile to nothing.
+/// Must only be used from the thread owning the GL context.
+/// </summary>
+class RenderStats
+{
+	public:
+		static void CountDraw(GLsizei indices) { frame.draws++; frame.indices += indices; }
+		static void CountVertexArrayBind() { frame.vertexArrayBinds++; }
+		static void CountProgramBind() { frame.programBinds++; }
+		static void CountUniformUpload(size_t bytes) { frame.uniformUploads++; frame.uniformBytes += bytes; }
+		static void CountBufferUpload(size_t bytes) { frame.bufferBytes += bytes; }
+
+		/// <summary>
+		/// Clears the counters of the frame and of its parts. Call once per frame, before drawing.
+		/// </summary>
+		static void BeginFrame();
+		static const RenderCounters& GetFrame() { return frame; }
+
+		/// <summary>
+		/// Starts counting what is drawn into the part of the scene of the given name, until the matching EndSubtree.
+		/// Parts nest: what a part draws also counts for the parts around it, but only once for a part nested in
+		/// itself. Parts drawn several times in a frame, once per view for instance, add up.
+		/// </summary>
+		/// <param name="name">The part, or an empty name for nothing.</param>
+		static void BeginSubtree(const std::string& name);
+		static void EndSubtree();
+
+		/// <summary>
+		/// Returns the counters of each part drawn in the frame so far, in the order they were first drawn.
+		/// </summary>
+		static const std::vector<std::pair<std::string, RenderCounters>>& GetSubtrees() { return subtrees; }
+
+		/// <summary>
+		/// Returns the frame's counters and those of its parts as one line of JSON.
+		/// </summary>
+		/// <param name="frameNumber">The number of the frame, written first.</param>
+		static std::string ToJson(unsigned int frameNumber);
+
+		/// <summary>
+		/// Counts a subtree for as long as it lives.
+		/// </summary>
+		class Scope
+		{
+			public:
+				Scope(const std::string& name) { BeginSubtree(name); }
+				~Scope() { EndSubtree(); }
+		};
+
+	private:
+		struct OpenSubtree
+		{
+			/// <summary>
+			/// Position in subtrees, or -1 for an empty name or a part nested in itself, which count nothing.
+			/// </summary>
+			int subtree;
+			/// <summary>
+			/// The frame's counters when the part started.
+			/// </summary>
+			RenderCounters start;
+		};
+
+		static RenderCounters frame;
+		static std::vector<std::pair<std::string, RenderCounters>> subtrees;
+		static std::vector<OpenSubtree> openSubtrees;
+};
+
+#define RENDER_STATS_COUNT(call) RenderStats::call
+#define RENDER_STATS_SCOPE(name) RenderStats::Scope renderStatsScope(name)
+
+#else
+
+#define RENDER_STATS_COUNT(call)
+#define RENDER_STATS_SCOPE(name)
+
+#endif
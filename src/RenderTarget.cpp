@@ -0,0 +1,80 @@
+#include "RenderTarget.h"
+#include "GPUMemory.h"
+#include <cstdio>
+
+RenderTarget::RenderTarget()
+{
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	width = 0;
+	height = 0;
+}
+
+void RenderTarget::Resize(int width, int height)
+{
+	if (framebuffer != 0 && width == this->width && height == this->height)
+	{
+		return;
+	}
+
+	if (framebuffer == 0)
+	{
+		glGenFramebuffers(1, &framebuffer);
+		glGenRenderbuffers(1, &colorBuffer);
+		glGenRenderbuffers(1, &depthBuffer);
+	}
+
+	// Renderbuffers rather than textures: the target is only ever blitted, never sampled.
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	GPUMemory::RenderbufferStorage(colorBuffer, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	GPUMemory::RenderbufferStorage(depthBuffer, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("Offscreen framebuffer of %dx%d is incomplete\n", width, height);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	this->width = width;
+	this->height = height;
+}
+
+void RenderTarget::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void RenderTarget::BlitToWindow(int width, int height, int windowWidth, int windowHeight)
+{
+	// Linear filtering is allowed since only the color is blitted.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT,
+		width == windowWidth && height == windowHeight ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Clear()
+{
+	if (framebuffer == 0)
+	{
+		return;
+	}
+
+	glDeleteFramebuffers(1, &framebuffer);
+	GPUMemory::ReleaseRenderbuffer(colorBuffer);
+	GPUMemory::ReleaseRenderbuffer(depthBuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	width = 0;
+	height = 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <GL/glew.h>
+
+/// <summary>
+/// An offscreen framebuffer with a color and a depth attachment. It is allocated at the window's size, and frames are
+/// drawn into its lower left corner at whatever resolution they use, so changing the resolution only changes the
+/// viewport: the attachments are only reallocated when the window itself changes size.
+/// Must be used on the thread owning the GL context, and cleared before the context is destroyed.
+/// </summary>
+class RenderTarget
+{
+	public:
+		RenderTarget();
+
+		/// <summary>
+		/// Sizes the attachments, creating them the first time. Does nothing if they already have this size.
+		/// </summary>
+		void Resize(int width, int height);
+
+		/// <summary>
+		/// Makes the target the framebuffer drawn into and read from.
+		/// </summary>
+		void Bind();
+
+		/// <summary>
+		/// Scales the lower left width x height pixels of the target to the whole window with a filtered blit, and makes
+		/// the window's framebuffer current again. The scissor test must be off.
+		/// </summary>
+		/// <param name="width">Width of the part of the target drawn into.</param>
+		/// <param name="height">Height of the part of the target drawn into.</param>
+		/// <param name="windowWidth">Width of the window's framebuffer.</param>
+		/// <param name="windowHeight">Height of the window's framebuffer.</param>
+		void BlitToWindow(int width, int height, int windowWidth, int windowHeight);
+
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+
+		/// <summary>
+		/// Deletes the framebuffer and its attachments. Call before destroying the context.
+		/// </summary>
+		void Clear();
+
+	private:
+		GLuint framebuffer;
+		GLuint colorBuffer;
+		GLuint depthBuffer;
+		int width;
+		int height;
+};
@@ -0,0 +1,94 @@
+#include "ScenePicker.h"
+#include <cfloat>
+
+ScenePicker::ScenePicker()
+{
+	root = NULL;
+}
+
+ScenePicker::~ScenePicker()
+{
+}
+
+void ScenePicker::Build(ComplexObject* root)
+{
+	this->root = root;
+	parts.clear();
+	objectFirstPart.clear();
+
+	std::vector<AABB> bounds;
+	glm::mat4 rootMatrix = root->GetWorldMatrix(glm::mat4(1.0f));
+	unsigned int next = 0;
+
+	for (unsigned int i = 0; i < root->objectList.size(); i++)
+	{
+		objectFirstPart.push_back(next);
+		VisitParts(root->objectList[i].Get(), rootMatrix, i, false, next, bounds);
+	}
+
+	bvh.Build(bounds);
+}
+
+void ScenePicker::Refit(unsigned int object)
+{
+	if (root == NULL || object >= objectFirstPart.size())
+	{
+		return;
+	}
+
+	std::vector<AABB> unused;
+	glm::mat4 rootMatrix = root->GetWorldMatrix(glm::mat4(1.0f));
+	unsigned int next = objectFirstPart[object];
+
+	VisitParts(root->objectList[object].Get(), rootMatrix, object, true, next, unused);
+}
+
+int ScenePicker::Pick(const glm::vec3& origin, const glm::vec3& direction) const
+{
+	// The world boxes are loose around rotated meshes, so confirm each hit against the mesh's own box in its local space.
+	// The transformation is affine, so the ray's parameter (the distance) is the same in both spaces.
+	BVH::ItemTest exactTest = [&](unsigned int item, float& distance)
+	{
+		const Part& part = parts[item];
+		glm::vec3 localOrigin = glm::vec3(part.inverseWorld * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection = glm::vec3(part.inverseWorld * glm::vec4(direction, 0.0f));
+		glm::vec3 inverseDirection(1.0f / localDirection.x, 1.0f / localDirection.y, 1.0f / localDirection.z);
+
+		return part.mesh->GetBounds().IntersectRay(localOrigin, inverseDirection, FLT_MAX, distance);
+	};
+
+	float distance;
+	int item = bvh.Raycast(origin, direction, FLT_MAX, exactTest, distance);
+
+	return item >= 0 ? (int)parts[item].object : -1;
+}
+
+void ScenePicker::VisitParts(const ComplexObject* object, const glm::mat4& parentMatrix, unsigned int owner, bool refit, unsigned int& next, std::vector<AABB>& bounds)
+{
+	glm::mat4 objectMatrix = object->GetWorldMatrix(parentMatrix);
+
+	for (size_t i = 0; i < object->meshList.size(); i++)
+	{
+		const Mesh* mesh = object->meshList[i].Get();
+		glm::mat4 world = mesh->GetWorldMatrix(objectMatrix);
+		AABB box = mesh->GetBounds().Transformed(world);
+
+		if (refit)
+		{
+			parts[next].inverseWorld = glm::inverse(world);
+			bvh.Refit(next, box);
+		}
+		else
+		{
+			Part part = { mesh, owner, glm::inverse(world) };
+			parts.push_back(part);
+			bounds.push_back(box);
+		}
+		next++;
+	}
+
+	for (size_t i = 0; i < object->objectList.size(); i++)
+	{
+		VisitParts(object->objectList[i].Get(), objectMatrix, owner, refit, next, bounds);
+	}
+}
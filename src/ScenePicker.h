@@ -0,0 +1,60 @@
+#pragma once
+#include "BVH.h"
+#include "ComplexObject.h"
+#include <vector>
+
+/// <summary>
+/// Finds which object of a scene is under a ray, for click to select. The world space boxes of every mesh below the
+/// root's children are kept in a BVH, so a pick only tests the few meshes near the ray.
+/// </summary>
+class ScenePicker
+{
+	public:
+		ScenePicker();
+		~ScenePicker();
+
+		/// <summary>
+		/// Builds the picking structure. Each child object of the root is one pickable object, made of all the meshes below it.
+		/// </summary>
+		/// <param name="root">The object holding the pickable objects. Must outlive the picker, and be rebuilt if the root itself moves.</param>
+		void Build(ComplexObject* root);
+
+		/// <summary>
+		/// Updates the boxes of one pickable object's meshes after it moved, refitting the BVH instead of rebuilding it.
+		/// </summary>
+		/// <param name="object">Index of the object in the root's object list.</param>
+		void Refit(unsigned int object);
+
+		/// <summary>
+		/// Finds the closest pickable object hit by a ray. Meshes are hit tested by their own box, transformed with them.
+		/// </summary>
+		/// <param name="origin">Origin of the ray, in world space.</param>
+		/// <param name="direction">Direction of the ray, in world space.</param>
+		/// <returns>The index of the object in the root's object list, or -1 if the ray hits nothing.</returns>
+		int Pick(const glm::vec3& origin, const glm::vec3& direction) const;
+
+	private:
+		/// <summary>
+		/// One mesh of a pickable object, with the transformation it is drawn with.
+		/// </summary>
+		struct Part
+		{
+			const Mesh* mesh;
+			unsigned int object;
+			glm::mat4 inverseWorld;
+		};
+
+		/// <summary>
+		/// Walks an object's meshes and children in drawing order, computing each mesh's world box. When building, parts
+		/// are appended to parts and their boxes to bounds. When refitting, the parts starting at next are updated and refitted in the BVH.
+		/// </summary>
+		void VisitParts(const ComplexObject* object, const glm::mat4& parentMatrix, unsigned int owner, bool refit, unsigned int& next, std::vector<AABB>& bounds);
+
+		ComplexObject* root;
+		std::vector<Part> parts;
+		/// <summary>
+		/// Index of the first part of each pickable object. Its parts are contiguous.
+		/// </summary>
+		std::vector<unsigned int> objectFirstPart;
+		BVH bvh;
+};
@@ -0,0 +1,107 @@
+#include "SceneSnapshot.h"
+
+SimulationInput::SimulationInput()
+{
+	for (int i = 0; i < 1024; i++)
+	{
+		keys[i] = false;
+	}
+	held = false;
+	pickOrigin = glm::vec3(0.0f);
+	pickDirection = glm::vec3(0.0f);
+	ClearEvents();
+}
+
+void SimulationInput::Merge(const SimulationInput& newer)
+{
+	for (int i = 0; i < 1024; i++)
+	{
+		keys[i] = newer.keys[i];
+	}
+	held = newer.held;
+
+	mouseDeltaX += newer.mouseDeltaX;
+	mouseDeltaY += newer.mouseDeltaY;
+	// Two presses cancel out, as they would have one step apart.
+	toggleAnimation = toggleAnimation != newer.toggleAnimation;
+	if (newer.pickPending)
+	{
+		pickPending = true;
+		pickOrigin = newer.pickOrigin;
+		pickDirection = newer.pickDirection;
+	}
+}
+
+void SimulationInput::ClearEvents()
+{
+	mouseDeltaX = 0.0f;
+	mouseDeltaY = 0.0f;
+	toggleAnimation = false;
+	pickPending = false;
+}
+
+bool SimulationInput::IsActive() const
+{
+	return held || toggleAnimation || pickPending || mouseDeltaX != 0.0f || mouseDeltaY != 0.0f;
+}
+
+SceneSnapshot::SceneSnapshot()
+{
+	time = 0.0;
+	cameraPosition = glm::vec3(0.0f);
+	cameraYaw = 0.0f;
+	cameraPitch = 0.0f;
+	worldXAngle = 0.0f;
+	worldYAngle = 0.0f;
+	worldYPos = 0.0f;
+	lettersMatrix = glm::mat4(1.0f);
+	selectedModel = 0;
+}
+
+// Interpolates angles in degrees the short way round, since the camera yaw wraps from 360 back to 0.
+static float MixDegrees(float from, float to, float t)
+{
+	float difference = to - from;
+	if (difference > 180.0f)
+	{
+		difference -= 360.0f;
+	}
+	else if (difference < -180.0f)
+	{
+		difference += 360.0f;
+	}
+	return from + difference * t;
+}
+
+void SceneSnapshot::Interpolate(const SceneSnapshot& from, const SceneSnapshot& to, float t, SceneSnapshot& out)
+{
+	out.time = from.time + (to.time - from.time) * t;
+	out.cameraPosition = glm::mix(from.cameraPosition, to.cameraPosition, t);
+	out.cameraYaw = MixDegrees(from.cameraYaw, to.cameraYaw, t);
+	out.cameraPitch = glm::mix(from.cameraPitch, to.cameraPitch, t);
+	out.worldXAngle = glm::mix(from.worldXAngle, to.worldXAngle, t);
+	out.worldYAngle = glm::mix(from.worldYAngle, to.worldYAngle, t);
+	out.worldYPos = glm::mix(from.worldYPos, to.worldYPos, t);
+	out.lettersMatrix = to.lettersMatrix;
+	out.selectedModel = to.selectedModel;
+
+	out.letterTransforms.resize(to.letterTransforms.size());
+	out.letterBounds.resize(to.letterBounds.size());
+	for (size_t i = 0; i < to.letterTransforms.size(); i++)
+	{
+		if (i >= from.letterTransforms.size())
+		{
+			out.letterTransforms[i] = to.letterTransforms[i];
+			out.letterBounds[i] = to.letterBounds[i];
+			continue;
+		}
+
+		const TRS& a = from.letterTransforms[i];
+		const TRS& b = to.letterTransforms[i];
+		out.letterTransforms[i] = TRS(glm::mix(a.translation, b.translation, t), glm::slerp(a.rotation, b.rotation, t),
+			glm::mix(a.scale, b.scale, t));
+
+		out.letterBounds[i] = from.letterBounds[i];
+		out.letterBounds[i].Extend(to.letterBounds[i]);
+	}
+}
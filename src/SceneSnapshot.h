@@ -0,0 +1,96 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "TransformStore.h"
+#include "AABB.h"
+
+/// <summary>
+/// Input the main thread hands to the simulation thread: the state of the keys, and the events since the
+/// simulation last took its input.
+/// </summary>
+struct SimulationInput
+{
+	/// <summary>
+	/// Keyboard keys and mouse buttons held down, indexed like Window::getKeys.
+	/// </summary>
+	bool keys[1024];
+	/// <summary>
+	/// True if any key or button is held.
+	/// </summary>
+	bool held;
+	/// <summary>
+	/// Mouse motion while a button was held, in pixels, summed over the events.
+	/// </summary>
+	float mouseDeltaX;
+	float mouseDeltaY;
+	/// <summary>
+	/// True if N was pressed, to start or stop the letter animation.
+	/// </summary>
+	bool toggleAnimation;
+	/// <summary>
+	/// True if the mouse was clicked, with the ray under the click in world space.
+	/// </summary>
+	bool pickPending;
+	glm::vec3 pickOrigin;
+	glm::vec3 pickDirection;
+
+	SimulationInput();
+
+	/// <summary>
+	/// Adds newer input: its keys replace these, its motion adds up with this one, and its events are added to these.
+	/// </summary>
+	void Merge(const SimulationInput& newer);
+	/// <summary>
+	/// Forgets the events, once the simulation has taken them. Held keys stay.
+	/// </summary>
+	void ClearEvents();
+	/// <summary>
+	/// Returns true if there is anything for the simulation to process: an event or a held key.
+	/// </summary>
+	bool IsActive() const;
+};
+
+/// <summary>
+/// Everything the renderer needs from one simulation step. The simulation thread fills one per step, and the
+/// renderer draws the two latest ones interpolated, without touching the simulation's own state.
+/// </summary>
+struct SceneSnapshot
+{
+	/// <summary>
+	/// glfwGetTime() when the step ran.
+	/// </summary>
+	double time;
+
+	glm::vec3 cameraPosition;
+	float cameraYaw;
+	float cameraPitch;
+	float worldXAngle;
+	float worldYAngle;
+	float worldYPos;
+
+	/// <summary>
+	/// Model matrix of the object holding the letters.
+	/// </summary>
+	glm::mat4 lettersMatrix;
+	/// <summary>
+	/// Transformation of each letter, relative to lettersMatrix.
+	/// </summary>
+	std::vector<TRS> letterTransforms;
+	/// <summary>
+	/// World space bounds of each letter.
+	/// </summary>
+	std::vector<AABB> letterBounds;
+	unsigned int selectedModel;
+
+	SceneSnapshot();
+
+	/// <summary>
+	/// Blends two snapshots of the same scene. Positions and angles are interpolated, rotations along the shortest arc,
+	/// and the bounds cover both snapshots' so nothing between them is culled. The rest is taken from the later one.
+	/// </summary>
+	/// <param name="from">The earlier snapshot.</param>
+	/// <param name="to">The later snapshot.</param>
+	/// <param name="t">0 for from, 1 for to.</param>
+	/// <param name="out">Set to the blend. Must not be from or to.</param>
+	static void Interpolate(const SceneSnapshot& from, const SceneSnapshot& to, float t, SceneSnapshot& out);
+};
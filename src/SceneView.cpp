@@ -0,0 +1,65 @@
+#include "SceneView.h"
+#include "Camera.h"
+#include "GLState.h"
+
+// Near and far planes of the views, the same as the original single view.
+static const float NEAR_PLANE = 0.1f;
+static const float FAR_PLANE = 100.0f;
+
+SceneView::SceneView()
+{
+	left = 0.0f;
+	bottom = 0.0f;
+	width = 1.0f;
+	height = 1.0f;
+	view = glm::mat4(1.0f);
+	projection = glm::mat4(1.0f);
+}
+
+SceneView::SceneView(float left, float bottom, float width, float height)
+{
+	this->left = left;
+	this->bottom = bottom;
+	this->width = width;
+	this->height = height;
+	view = glm::mat4(1.0f);
+	projection = glm::mat4(1.0f);
+}
+
+void SceneView::SetCamera(const glm::mat4& view, float fieldOfView, int windowWidth, int windowHeight)
+{
+	float aspect = (width * windowWidth) / (height * windowHeight);
+	this->view = view;
+	projection = glm::perspective(fieldOfView, aspect, NEAR_PLANE, FAR_PLANE);
+	frustum = Frustum::FromMatrix(projection * view);
+}
+
+glm::vec4 SceneView::Apply(GLint bufferWidth, GLint bufferHeight) const
+{
+	GLint x = (GLint)(left * bufferWidth);
+	GLint y = (GLint)(bottom * bufferHeight);
+	GLsizei pixelWidth = (GLsizei)(width * bufferWidth);
+	GLsizei pixelHeight = (GLsizei)(height * bufferHeight);
+
+	GLState::Viewport(x, y, pixelWidth, pixelHeight);
+	GLState::Scissor(x, y, pixelWidth, pixelHeight);
+
+	return glm::vec4((float)x, (float)y, (float)pixelWidth, (float)pixelHeight);
+}
+
+bool SceneView::ScreenPointToRay(float cursorX, float cursorY, int windowWidth, int windowHeight, glm::vec3& origin, glm::vec3& direction) const
+{
+	// Window coordinates have y pointing down, the rectangle y pointing up.
+	float x = cursorX / windowWidth - left;
+	float y = (1.0f - cursorY / windowHeight) - bottom;
+	if (x < 0.0f || x > width || y < 0.0f || y > height)
+	{
+		return false;
+	}
+
+	// Back to window coordinates, relative to the rectangle.
+	float localX = x * windowWidth;
+	float localY = (height - y) * windowHeight;
+	Camera::screenPointToRay(localX, localY, (GLint)(width * windowWidth), (GLint)(height * windowHeight), projection, view, origin, direction);
+	return true;
+}
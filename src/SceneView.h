@@ -0,0 +1,61 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+/// <summary>
+/// One camera looking at the scene, drawn into a rectangle of the window. Several views share the work of preparing
+/// the scene each frame; only culling against the view's frustum and drawing are done per view.
+/// </summary>
+struct SceneView
+{
+	/// <summary>
+	/// The rectangle the view is drawn in, as fractions of the window size, from the bottom left corner as in glViewport.
+	/// </summary>
+	float left;
+	float bottom;
+	float width;
+	float height;
+
+	glm::mat4 view;
+	glm::mat4 projection;
+	/// <summary>
+	/// The frustum of projection * view, in world space. Updated by SetCamera.
+	/// </summary>
+	Frustum frustum;
+
+	/// <summary>
+	/// Creates a view covering the whole window.
+	/// </summary>
+	SceneView();
+	SceneView(float left, float bottom, float width, float height);
+
+	/// <summary>
+	/// Sets the camera of the view, with a perspective projection matching the shape of its rectangle.
+	/// </summary>
+	/// <param name="view">The view matrix.</param>
+	/// <param name="fieldOfView">Vertical field of view, in radians.</param>
+	/// <param name="windowWidth">Width of the window, in any unit.</param>
+	/// <param name="windowHeight">Height of the window, in the same unit.</param>
+	void SetCamera(const glm::mat4& view, float fieldOfView, int windowWidth, int windowHeight);
+
+	/// <summary>
+	/// Restricts drawing, and clearing, to the view's rectangle.
+	/// </summary>
+	/// <param name="bufferWidth">Width of the framebuffer, in pixels.</param>
+	/// <param name="bufferHeight">Height of the framebuffer, in pixels.</param>
+	/// <returns>The rectangle in pixels: x, y, width and height.</returns>
+	glm::vec4 Apply(GLint bufferWidth, GLint bufferHeight) const;
+
+	/// <summary>
+	/// Unprojects a point of the window into the ray going from the view's camera through it.
+	/// </summary>
+	/// <param name="cursorX">The x position of the point, in window coordinates (0 on the left).</param>
+	/// <param name="cursorY">The y position of the point, in window coordinates (0 at the top).</param>
+	/// <param name="windowWidth">The window width.</param>
+	/// <param name="windowHeight">The window height.</param>
+	/// <param name="origin">Set to the start of the ray, on the near plane.</param>
+	/// <param name="direction">Set to the normalized direction of the ray.</param>
+	/// <returns>False if the point is outside of the view's rectangle.</returns>
+	bool ScreenPointToRay(float cursorX, float cursorY, int windowWidth, int windowHeight, glm::vec3& origin, glm::vec3& direction) const;
+};
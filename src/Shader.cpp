@@ -1,83 +1,94 @@
 // Modified from https://learnopengl.com/code_viewer_gh.php?code=includes/learnopengl/shader_s.h
 #include "Shader.h"
+#include "GLState.h"
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
-	// 1. Get shader source code from local files
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
+	build(vertexPath, NULL, fragmentPath);
+}
+
+Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath)
+{
+	build(vertexPath, geometryPath, fragmentPath);
+}
+
+void Shader::build(const char* vertexPath, const char* geometryPath, const char* fragmentPath)
+{
+	int success;
+	char infoLog[512];
+
+	// 1. compile shaders
+	unsigned int vertex = compile(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+	unsigned int geometry = geometryPath != NULL ? compile(GL_GEOMETRY_SHADER, geometryPath, "GEOMETRY") : 0;
+	unsigned int fragment = compile(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
+
+	// 2. link them into a program
+	ID = glCreateProgram();
+	glAttachShader(ID, vertex);
+	if (geometry != 0)
+	{
+		glAttachShader(ID, geometry);
+	}
+	glAttachShader(ID, fragment);
+	glLinkProgram(ID);
+	// Check for linking errors
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(ID, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	}
+
+	// Delete shaders, they are now linked to our program and no longer neccessary 
+	glDeleteShader(vertex);
+	if (geometry != 0)
+	{
+		glDeleteShader(geometry);
+	}
+	glDeleteShader(fragment);
+}
+
+unsigned int Shader::compile(GLenum type, const char* path, const char* stage)
+{
+	// Get shader source code from local file
+	std::string code;
+	std::ifstream shaderFile;
 
 	// ensure ifstrem objects can throw exceptions
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
 	try
 	{
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
+		shaderFile.open(path);
+		std::stringstream shaderStream;
 
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
+		shaderStream << shaderFile.rdbuf();
 
-		vShaderFile.close();
-		fShaderFile.close();
+		shaderFile.close();
 
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
+		code = shaderStream.str();
 	}
 	catch (std::ifstream::failure e)
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
 
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-
-	// 2. compile shaders
-	unsigned int vertex, fragment;
+	const char* shaderCode = code.c_str();
 	int success;
 	char infoLog[512];
 
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
+	unsigned int shader = glCreateShader(type);
+	glShaderSource(shader, 1, &shaderCode, NULL);
+	glCompileShader(shader);
 
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 	if (!success)
 	{
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+		glGetShaderInfoLog(shader, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" << infoLog << std::endl;
 	}
 
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	ID = glCreateProgram();
-	glAttachShader(ID, vertex);
-	glAttachShader(ID, fragment);
-	glLinkProgram(ID);
-	// Check for linking errors
-	glGetProgramiv(ID, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-
-	// Delete shaders, they are now linked to our program and no longer neccessary 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	return shader;
 }
 
 unsigned int Shader::getId()
@@ -87,36 +98,47 @@ unsigned int Shader::getId()
 
 void Shader::use()
 {
-	glUseProgram(ID);
+	GLState::UseProgram(ID);
 }
 
 void Shader::free()
 {
-	glUseProgram(0);
+	GLState::UseProgram(0);
 }
 
-// Setter methods to set uniform values inside shaders. 
+// Setter methods to set uniform values inside shaders. They go through GLState, which skips values the program already holds.
 void Shader::setBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	GLState::Uniform1i(getLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	GLState::Uniform1i(getLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	GLState::Uniform1f(getLocation(name), value);
+}
+
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const
+{
+	GLState::Uniform4fv(getLocation(name), glm::value_ptr(value));
 }
 
 void Shader::setMatrix4Float(const std::string& name, glm::mat4* transformMatrix) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(*transformMatrix));
+	GLState::UniformMatrix4fv(getLocation(name), glm::value_ptr(*transformMatrix));
 }
 
 GLuint Shader::getLocation(const std::string& name) const
 {
-	return glGetUniformLocation(ID, name.c_str());
+	// Looking up a location is a round trip to the driver, so we only do it once per name.
+	std::unordered_map<std::string, GLint>::iterator found = locations.find(name);
+	if (found == locations.end())
+	{
+		found = locations.insert(std::make_pair(name, glGetUniformLocation(ID, name.c_str()))).first;
+	}
+	return found->second;
 }
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 /* Entire process of creating a vertex and fragment shader from source code on disk, compiling them and then creating and linking a program*/
 class Shader
@@ -21,6 +22,13 @@ public:
 	/// <param name="vertexPath"></param>
 	/// <param name="fragmentPath"></param>
 	Shader(const char* vertexPath, const char* fragmentPath);
+	/// <summary>
+	/// Constructor, constructs shaders from file, with a geometry shader between the vertex and fragment shaders
+	/// </summary>
+	/// <param name="vertexPath"></param>
+	/// <param name="geometryPath"></param>
+	/// <param name="fragmentPath"></param>
+	Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath);
 	void use();
 	void free(); // free program
 	unsigned int getId();
@@ -44,6 +52,12 @@ public:
 	/// <param name="value"></param>
 	void setFloat(const std::string& name, float value) const;
 	/// <summary>
+	/// Used to set a vec4 uniform inside a shader
+	/// </summary>
+	/// <param name="name">Name of the uniform to be set</param>
+	/// <param name="value">Vector to be set</param>
+	void setVec4(const std::string& name, const glm::vec4& value) const;
+	/// <summary>
 	/// Used to set a 4x4 matrix uniform inside a shader
 	/// </summary>
 	/// <param name="name">Name of the uniform to be set</param>
@@ -55,4 +69,22 @@ public:
 	/// <param name="name">Name of the uniform</param>
 	/// <returns>Returns the unsigned integer that points to that uniform</returns>
 	GLuint getLocation(const std::string& name) const;
+
+private:
+	/// <summary>
+	/// Compiles and links the program from the shader files. geometryPath may be NULL.
+	/// </summary>
+	void build(const char* vertexPath, const char* geometryPath, const char* fragmentPath);
+	/// <summary>
+	/// Reads and compiles one shader, printing the errors if it fails
+	/// </summary>
+	/// <param name="type">GL_VERTEX_SHADER, GL_GEOMETRY_SHADER or GL_FRAGMENT_SHADER</param>
+	/// <param name="path">The source file</param>
+	/// <param name="stage">Name of the stage in error messages</param>
+	/// <returns>The shader object</returns>
+	static unsigned int compile(GLenum type, const char* path, const char* stage);
+	/// <summary>
+	/// Uniform locations already looked up, by name. Locations never change once the program is linked.
+	/// </summary>
+	mutable std::unordered_map<std::string, GLint> locations;
 };
@@ -0,0 +1,168 @@
+#include "Shapes.h"
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+
+void Shapes::Grid(int squareCount, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	vertices.clear();
+	indices.clear();
+	vertices.reserve((size_t)(squareCount + 1) * (squareCount + 1) * 3);
+	indices.reserve((size_t)squareCount * squareCount * 8);
+
+	// Loops through each row, then for each column it creates a point clamped between 0 to 1
+	for (int i = 0; i <= squareCount; i++)
+	{
+		for (int j = 0; j <= squareCount; j++)
+		{
+			vertices.push_back((float)j / (float)squareCount);
+			vertices.push_back(0.0f);
+			vertices.push_back((float)i / (float)squareCount);
+		}
+	}
+
+	// A double loop to connect all the vertices with the appropriate indices.
+	// First it top left to top right vertex, then top right with bottom right, then bottom right with bottom left and finally bottom left with top right.
+	for (int i = 0; i < squareCount; i++)
+	{
+		for (int j = 0; j < squareCount; j++)
+		{
+			GLuint top = i * (1 + squareCount);
+			GLuint bottom = (i + 1) * (1 + squareCount);
+
+			// Top line
+			indices.push_back(top + j);
+			indices.push_back(top + j + 1);
+			// Right line
+			indices.push_back(top + j + 1);
+			indices.push_back(bottom + j + 1);
+			// Bottom line
+			indices.push_back(bottom + j + 1);
+			indices.push_back(bottom + j);
+			// Left line
+			indices.push_back(bottom + j);
+			indices.push_back(top + j);
+		}
+	}
+}
+
+// Taken from https://gist.github.com/zwzmzd/0195733fa1210346b00d
+void Shapes::Sphere(int latitudes, int longitudes, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	vertices.clear();
+	indices.clear();
+	vertices.reserve((size_t)(latitudes + 1) * (longitudes + 1) * 6);
+	indices.reserve((size_t)(latitudes + 1) * (longitudes + 2) * 2);
+
+	GLuint indicator = 0;
+	for (int i = 0; i <= latitudes; i++)
+	{
+		double lat0 = glm::pi<double>() * (-0.5 + (double)(i - 1) / latitudes);
+		double z0 = sin(lat0);
+		double zr0 = cos(lat0);
+
+		double lat1 = glm::pi<double>() * (-0.5 + (double)i / latitudes);
+		double z1 = sin(lat1);
+		double zr1 = cos(lat1);
+
+		for (int j = 0; j <= longitudes; j++)
+		{
+			double lng = 2 * glm::pi<double>() * (double)(j - 1) / longitudes;
+			double x = cos(lng);
+			double y = sin(lng);
+
+			vertices.push_back((GLfloat)(x * zr0));
+			vertices.push_back((GLfloat)(y * zr0));
+			vertices.push_back((GLfloat)z0);
+			indices.push_back(indicator++);
+
+			vertices.push_back((GLfloat)(x * zr1));
+			vertices.push_back((GLfloat)(y * zr1));
+			vertices.push_back((GLfloat)z1);
+			indices.push_back(indicator++);
+		}
+		indices.push_back(MeshOptimizer::RESTART_INDEX);
+	}
+}
+
+void Shapes::Cube(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	indices = {
+		// front
+		0, 1, 2,
+		2, 3, 0,
+		// right
+		1, 5, 6,
+		6, 2, 1,
+		// back
+		7, 6, 5,
+		5, 4, 7,
+		// left
+		4, 0, 3,
+		3, 7, 4,
+		// bottom
+		4, 5, 1,
+		1, 0, 4,
+		// top
+		3, 2, 6,
+		6, 7, 3
+	};
+
+	vertices = {
+		// front
+		-0.5, -0.5,  0.5,
+		0.5, -0.5,  0.5,
+		0.5,  0.5,  0.5,
+		-0.5,  0.5,  0.5,
+		// back
+		-0.5, -0.5, -0.5,
+		0.5, -0.5, -0.5,
+		0.5,  0.5, -0.5,
+		-0.5,  0.5, -0.5
+	};
+}
+
+// Modified from https://gist.github.com/zwzmzd/0195733fa1210346b00d
+void Shapes::Cylinder(double radius, int segments, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	vertices.clear();
+	indices.clear();
+	vertices.reserve((size_t)(segments + 1) * 10 * 3);
+	indices.reserve((size_t)(segments + 1) * 10);
+
+	// Each segment is a quad of the side, then a triangle of each end face, all in one strip.
+	const GLfloat height = 2.5f;
+	GLuint indicator = 0;
+	for (int i = 0; i <= segments; i++)
+	{
+		double ang0 = 2 * glm::pi<double>() * ((double)(i - 1) / segments);
+		GLfloat z0 = (GLfloat)(radius * sin(ang0));
+		GLfloat x0 = (GLfloat)(radius * cos(ang0));
+
+		double ang1 = 2 * glm::pi<double>() * ((double)i / segments);
+		GLfloat z1 = (GLfloat)(radius * sin(ang1));
+		GLfloat x1 = (GLfloat)(radius * cos(ang1));
+
+		const GLfloat segment[] = {
+			// Side, bottom then top
+			x0, 0.0f, z0,
+			x1, 0.0f, z1,
+			x0, height, z0,
+			x1, height, z1,
+			// Top face
+			x0, height, z0,
+			x1, height, z1,
+			0.0f, height, 0.0f,
+			// Bottom face
+			x0, 0.0f, z0,
+			x1, 0.0f, z1,
+			0.0f, 0.0f, 0.0f
+		};
+		vertices.insert(vertices.end(), segment, segment + sizeof(segment) / sizeof(segment[0]));
+		for (size_t j = 0; j < sizeof(segment) / sizeof(segment[0]) / 3; j++)
+		{
+			indices.push_back(indicator++);
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+
+/// <summary>
+/// Builds the vertices and indices of the basic shapes the scene is made of, without touching GL, so building them can
+/// be measured and reused apart from creating their meshes. Vertices are 3 floats each; the arrays are filled from empty.
+/// </summary>
+class Shapes
+{
+	public:
+		/// <summary>
+		/// A flat square grid from (0, 0, 0) to (1, 0, 1), drawn with GL_LINES: each square is four lines.
+		/// </summary>
+		/// <param name="squareCount">Number of squares along each side.</param>
+		static void Grid(int squareCount, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+		/// <summary>
+		/// A unit sphere drawn with GL_TRIANGLE_STRIP, one strip per band of latitude, ended by a restart index.
+		/// </summary>
+		/// <param name="latitudes">Number of bands from pole to pole.</param>
+		/// <param name="longitudes">Number of segments around each band.</param>
+		static void Sphere(int latitudes, int longitudes, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+		/// <summary>
+		/// A unit cube centered on the origin, as 12 triangles.
+		/// </summary>
+		static void Cube(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+		/// <summary>
+		/// A closed cylinder 2.5 high standing on the origin, drawn with GL_TRIANGLE_STRIP.
+		/// </summary>
+		/// <param name="radius">Radius of the cylinder.</param>
+		/// <param name="segments">Number of segments around it.</param>
+		static void Cylinder(double radius, int segments, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+};
@@ -0,0 +1,64 @@
+#include "StaticBatch.h"
+#include "MeshOptimizer.h"
+
+StaticBatch::StaticBatch()
+{
+}
+
+void StaticBatch::Add(const Mesh& mesh, const glm::mat4& matrix)
+{
+	const std::vector<GLfloat>& meshVertices = mesh.GetVertices();
+	const std::vector<GLfloat>& meshColors = mesh.GetVertexColors();
+	const std::vector<unsigned int>& meshIndices = mesh.GetIndices();
+	unsigned int first = (unsigned int)(vertices.size() / 3);
+	size_t vertexCount = meshVertices.size() / 3;
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec4 position = matrix * glm::vec4(meshVertices[i * 3], meshVertices[i * 3 + 1], meshVertices[i * 3 + 2], 1.0f);
+		vertices.push_back(position.x);
+		vertices.push_back(position.y);
+		vertices.push_back(position.z);
+
+		if (!meshColors.empty())
+		{
+			colors.insert(colors.end(), meshColors.begin() + i * 4, meshColors.begin() + i * 4 + 4);
+		}
+		else
+		{
+			const glm::vec4& color = mesh.GetColor();
+			colors.push_back(color.x);
+			colors.push_back(color.y);
+			colors.push_back(color.z);
+			colors.push_back(color.w);
+		}
+	}
+
+	if (mesh.GetDrawType() == GL_TRIANGLE_STRIP)
+	{
+		MeshOptimizer::ToTriangles(meshIndices, first, indices);
+		return;
+	}
+	for (size_t i = 0; i < meshIndices.size(); i++)
+	{
+		indices.push_back(first + meshIndices[i]);
+	}
+}
+
+Handle<Mesh> StaticBatch::Build()
+{
+	// Ordered as a whole, so that the parts hiding others can be drawn first.
+	MeshOptimizer::Optimize(vertices, &colors, indices, GL_TRIANGLES);
+
+	Handle<Mesh> mesh = Mesh::Create();
+	mesh->CreateMesh(&vertices[0], &colors[0], &indices[0], (unsigned int)vertices.size(), (unsigned int)indices.size());
+	Clear();
+	return mesh;
+}
+
+void StaticBatch::Clear()
+{
+	vertices.clear();
+	colors.clear();
+	indices.clear();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Mesh.h"
+#include <vector>
+
+/// <summary>
+/// Merges meshes that don't move relative to each other into a single mesh, drawn in one call. Each mesh's vertices are
+/// moved by its matrix as they are added, and its color (or vertex colors) copied into every vertex, so meshes of
+/// different colors and transformations share one vertex buffer, one index buffer and one draw.
+/// </summary>
+class StaticBatch
+{
+	public:
+		StaticBatch();
+
+		/// <summary>
+		/// Adds a mesh, its vertices transformed by the matrix. Triangle strips are turned into triangles, so meshes
+		/// drawn either way can be merged.
+		/// </summary>
+		/// <param name="mesh">The mesh to add. Its current color and highlight are baked in.</param>
+		/// <param name="matrix">The transformation of the mesh in the batch's space.</param>
+		void Add(const Mesh& mesh, const glm::mat4& matrix);
+
+		bool IsEmpty() const { return indices.empty(); }
+
+		/// <summary>
+		/// Creates the merged mesh in the shared mesh pool, drawn as triangles with per vertex colors, and empties the batch.
+		/// The triangles and vertices are reordered for the GPU with MeshOptimizer.
+		/// </summary>
+		/// <returns>The mesh, to destroy with Mesh::Destroy.</returns>
+		Handle<Mesh> Build();
+
+		void Clear();
+
+	private:
+		std::vector<GLfloat> vertices;
+		std::vector<GLfloat> colors;
+		std::vector<unsigned int> indices;
+};
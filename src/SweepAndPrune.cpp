@@ -0,0 +1,306 @@
+#include "SweepAndPrune.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune()
+{
+	pairCount = 0;
+}
+
+SweepAndPrune::~SweepAndPrune()
+{
+}
+
+bool SweepAndPrune::Precedes(const Endpoint& a, const Endpoint& b)
+{
+	return a.value < b.value || (a.value == b.value && !a.IsMax() && b.IsMax());
+}
+
+void SweepAndPrune::Build(const std::vector<AABB>& bounds)
+{
+	objectBounds = bounds;
+	unsigned int count = (unsigned int)bounds.size();
+
+	overlaps.assign(count, std::vector<unsigned int>());
+	pairCount = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<Endpoint>& list = endpoints[axis];
+		list.resize(2 * count);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			Endpoint min = { bounds[i].min[axis], 2 * i };
+			Endpoint max = { bounds[i].max[axis], 2 * i + 1 };
+			list[2 * i] = min;
+			list[2 * i + 1] = max;
+		}
+
+		std::sort(list.begin(), list.end(), Precedes);
+
+		positions[axis].resize(2 * count);
+		for (unsigned int i = 0; i < 2 * count; i++)
+		{
+			positions[axis][list[i].id] = i;
+		}
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Sweep along the axis the boxes are most spread on, so the fewest boxes are open at once.
+	AABB centers;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		centers.Extend(bounds[i].GetCenter());
+	}
+	glm::vec3 spread = centers.max - centers.min;
+	int sweepAxis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+	// Boxes whose min was passed but not their max yet, with each one's place in that list for constant time removal.
+	std::vector<unsigned int> open;
+	std::vector<unsigned int> openPosition(count);
+
+	const std::vector<Endpoint>& list = endpoints[sweepAxis];
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		unsigned int object = list[i].GetObject();
+
+		if (list[i].IsMax())
+		{
+			unsigned int last = open.back();
+			open[openPosition[object]] = last;
+			openPosition[last] = openPosition[object];
+			open.pop_back();
+			continue;
+		}
+
+		for (size_t j = 0; j < open.size(); j++)
+		{
+			if (bounds[object].Overlaps(bounds[open[j]]))
+			{
+				overlaps[object].push_back(open[j]);
+				overlaps[open[j]].push_back(object);
+				pairCount++;
+			}
+		}
+
+		openPosition[object] = (unsigned int)open.size();
+		open.push_back(object);
+	}
+}
+
+void SweepAndPrune::Update(unsigned int object, const AABB& bounds)
+{
+	// The pair tests below read the new box on every axis, so set it before sorting any axis.
+	objectBounds[object] = bounds;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<Endpoint>& list = endpoints[axis];
+		unsigned int minPosition = positions[axis][2 * object];
+		unsigned int maxPosition = positions[axis][2 * object + 1];
+
+		bool movingDown = bounds.min[axis] < list[minPosition].value;
+		list[minPosition].value = bounds.min[axis];
+		list[maxPosition].value = bounds.max[axis];
+
+		// Move the end leading the motion first, so the min and max of the object never need to pass each other.
+		if (movingDown)
+		{
+			SortEndpoint(axis, minPosition);
+			SortEndpoint(axis, positions[axis][2 * object + 1]);
+		}
+		else
+		{
+			SortEndpoint(axis, maxPosition);
+			SortEndpoint(axis, positions[axis][2 * object]);
+		}
+	}
+}
+
+void SweepAndPrune::UpdateAll(const std::vector<AABB>& bounds, WorkerPool* pool)
+{
+	previousBounds.swap(objectBounds);
+	objectBounds = bounds;
+
+	// The axes are sorted independently, each collecting the pair changes it sees; they are applied afterwards.
+	// An axis only reports pairs that really start (new boxes overlap) or end (old boxes overlapped), which are few.
+	if (pool != NULL)
+	{
+		pool->ParallelFor(3, [this](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t axis = begin; axis < end; axis++)
+			{
+				SortAxis((int)axis);
+			}
+		});
+	}
+	else
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			SortAxis(axis);
+		}
+	}
+
+	// Each pair of boxes swaps ends at most once per axis and the same pair can't both start and end overlapping,
+	// so the order the changes are applied in doesn't matter.
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<PairChange>& changes = pairChanges[axis];
+		for (size_t i = 0; i < changes.size(); i++)
+		{
+			if (changes[i].starts)
+			{
+				AddPair(changes[i].a, changes[i].b);
+			}
+			else
+			{
+				RemovePair(changes[i].a, changes[i].b);
+			}
+		}
+		changes.clear();
+	}
+}
+
+void SweepAndPrune::SortAxis(int axis)
+{
+	std::vector<Endpoint>& list = endpoints[axis];
+	std::vector<PairChange>& changes = pairChanges[axis];
+
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		const AABB& box = objectBounds[list[i].GetObject()];
+		list[i].value = list[i].IsMax() ? box.max[axis] : box.min[axis];
+	}
+
+	// Every pair of endpoints out of order is swapped exactly once, so each overlap change is seen once.
+	for (size_t i = 1; i < list.size(); i++)
+	{
+		Endpoint moving = list[i];
+		size_t position = i;
+
+		while (position > 0 && Precedes(moving, list[position - 1]))
+		{
+			const Endpoint& passed = list[position - 1];
+			unsigned int a = moving.GetObject();
+			unsigned int b = passed.GetObject();
+
+			if (a != b && moving.IsMax() != passed.IsMax())
+			{
+				// A min now before a max: the boxes start overlapping on this axis. A max now before a min: they stop.
+				bool starts = passed.IsMax();
+				const std::vector<AABB>& boxes = starts ? objectBounds : previousBounds;
+
+				if (boxes[a].Overlaps(boxes[b]))
+				{
+					PairChange change = { a, b, starts };
+					changes.push_back(change);
+				}
+			}
+
+			list[position] = passed;
+			position--;
+		}
+
+		list[position] = moving;
+	}
+
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		positions[axis][list[i].id] = (unsigned int)i;
+	}
+}
+
+void SweepAndPrune::SortEndpoint(int axis, unsigned int position)
+{
+	std::vector<Endpoint>& list = endpoints[axis];
+	std::vector<unsigned int>& places = positions[axis];
+	Endpoint moving = list[position];
+
+	while (position > 0 && Precedes(moving, list[position - 1]))
+	{
+		const Endpoint& passed = list[position - 1];
+		Swapped(moving, passed);
+
+		list[position] = passed;
+		places[passed.id] = position;
+		position--;
+	}
+
+	while (position + 1 < list.size() && Precedes(list[position + 1], moving))
+	{
+		const Endpoint& passed = list[position + 1];
+		Swapped(passed, moving);
+
+		list[position] = passed;
+		places[passed.id] = position;
+		position++;
+	}
+
+	list[position] = moving;
+	places[moving.id] = position;
+}
+
+void SweepAndPrune::Swapped(const Endpoint& lower, const Endpoint& upper)
+{
+	unsigned int a = lower.GetObject();
+	unsigned int b = upper.GetObject();
+
+	if (a == b || lower.IsMax() == upper.IsMax())
+	{
+		return;
+	}
+
+	// A min now before a max: the boxes start overlapping on this axis. A max now before a min: they stop.
+	if (upper.IsMax())
+	{
+		AddPair(a, b);
+	}
+	else
+	{
+		RemovePair(a, b);
+	}
+}
+
+void SweepAndPrune::AddPair(unsigned int a, unsigned int b)
+{
+	// Overlapping on this axis isn't enough: the boxes must overlap on the other two as well.
+	if (!objectBounds[a].Overlaps(objectBounds[b]))
+	{
+		return;
+	}
+
+	std::vector<unsigned int>& list = overlaps[a];
+	if (std::find(list.begin(), list.end(), b) != list.end())
+	{
+		return;
+	}
+
+	list.push_back(b);
+	overlaps[b].push_back(a);
+	pairCount++;
+}
+
+void SweepAndPrune::RemovePair(unsigned int a, unsigned int b)
+{
+	std::vector<unsigned int>& listA = overlaps[a];
+	std::vector<unsigned int>::iterator found = std::find(listA.begin(), listA.end(), b);
+	if (found == listA.end())
+	{
+		return;
+	}
+	*found = listA.back();
+	listA.pop_back();
+
+	std::vector<unsigned int>& listB = overlaps[b];
+	found = std::find(listB.begin(), listB.end(), a);
+	*found = listB.back();
+	listB.pop_back();
+
+	pairCount--;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "AABB.h"
+#include <vector>
+
+class WorkerPool;
+
+/// <summary>
+/// Broad phase collision detection: keeps the set of objects whose boxes overlap, using sort and sweep.
+/// The start and end of every box along each axis are kept sorted. When an object moves, its ends are moved by
+/// insertion sort, and every end they pass starts or stops an overlap on that axis. Objects moving a little
+/// between frames only pass a few ends, so updates cost close to nothing.
+/// </summary>
+class SweepAndPrune
+{
+	public:
+		SweepAndPrune();
+		~SweepAndPrune();
+
+		/// <summary>
+		/// Sets the objects from scratch, sorting their ends and sweeping once to find the overlapping pairs.
+		/// </summary>
+		/// <param name="bounds">Box of each object. Object i is referred to by index i afterwards.</param>
+		void Build(const std::vector<AABB>& bounds);
+
+		/// <summary>
+		/// Moves one object to its new box, updating the pairs it is part of.
+		/// </summary>
+		/// <param name="object">The object that moved.</param>
+		/// <param name="bounds">Its new box.</param>
+		void Update(unsigned int object, const AABB& bounds);
+
+		/// <summary>
+		/// Moves every object at once. Cheaper than updating them one by one when most of them moved: each axis is
+		/// insertion sorted in a single pass over its endpoints, in memory order.
+		/// </summary>
+		/// <param name="bounds">New box of each object, as many as there are objects.</param>
+		/// <param name="pool">Optional workers to sort the three axes on at the same time.</param>
+		void UpdateAll(const std::vector<AABB>& bounds, WorkerPool* pool = NULL);
+
+		/// <summary>
+		/// Returns the objects whose box overlaps or touches the object's box, in no particular order.
+		/// </summary>
+		const std::vector<unsigned int>& GetOverlaps(unsigned int object) const { return overlaps[object]; }
+
+		size_t GetObjectCount() const { return objectBounds.size(); }
+		const AABB& GetBounds(unsigned int object) const { return objectBounds[object]; }
+		/// <summary>
+		/// Returns the number of overlapping pairs.
+		/// </summary>
+		size_t GetPairCount() const { return pairCount; }
+
+	private:
+		/// <summary>
+		/// The start (min) or end (max) of an object's box along one axis.
+		/// </summary>
+		struct Endpoint
+		{
+			float value;
+			/// <summary>
+			/// The object index times 2, plus 1 for a max.
+			/// </summary>
+			unsigned int id;
+
+			unsigned int GetObject() const { return id >> 1; }
+			bool IsMax() const { return (id & 1) != 0; }
+		};
+
+		/// <summary>
+		/// Endpoint order. A min sorts before a max of the same value, so touching boxes count as overlapping, as in AABB::Overlaps.
+		/// </summary>
+		static bool Precedes(const Endpoint& a, const Endpoint& b);
+
+		/// <summary>
+		/// Moves the endpoint at the given position of an axis to its sorted place, adding and removing the pairs it passes.
+		/// </summary>
+		void SortEndpoint(int axis, unsigned int position);
+
+		/// <summary>
+		/// A pair starting or stopping to overlap, found while sorting an axis in UpdateAll.
+		/// </summary>
+		struct PairChange
+		{
+			unsigned int a, b;
+			bool starts;
+		};
+
+		/// <summary>
+		/// Sorts one axis after its endpoints' objects all moved, collecting the pairs that changed into pairChanges.
+		/// Only writes to that axis' data, so the three axes can be sorted on different threads.
+		/// </summary>
+		void SortAxis(int axis);
+
+		/// <summary>
+		/// Records that two endpoints of different objects swapped places along an axis.
+		/// </summary>
+		/// <param name="lower">The endpoint now first.</param>
+		/// <param name="upper">The endpoint now second.</param>
+		void Swapped(const Endpoint& lower, const Endpoint& upper);
+
+		/// <summary>
+		/// Adds the pair if the two objects' boxes overlap and the pair doesn't exist yet.
+		/// </summary>
+		void AddPair(unsigned int a, unsigned int b);
+		void RemovePair(unsigned int a, unsigned int b);
+
+		std::vector<AABB> objectBounds;
+		/// <summary>
+		/// The boxes before the last UpdateAll, to tell which pairs existed without searching the overlap lists.
+		/// </summary>
+		std::vector<AABB> previousBounds;
+		/// <summary>
+		/// Pair changes found on each axis by UpdateAll.
+		/// </summary>
+		std::vector<PairChange> pairChanges[3];
+		/// <summary>
+		/// Sorted endpoints of each axis.
+		/// </summary>
+		std::vector<Endpoint> endpoints[3];
+		/// <summary>
+		/// Position of each endpoint in its axis' array, indexed by Endpoint::id.
+		/// </summary>
+		std::vector<unsigned int> positions[3];
+		/// <summary>
+		/// The objects overlapping each object. Both objects of a pair list each other.
+		/// </summary>
+		std::vector<std::vector<unsigned int>> overlaps;
+		size_t pairCount;
+};
@@ -0,0 +1,559 @@
+#include "Terrain.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+#include "RenderStats.h"
+#include "GLCapture.h"
+#include "RedrawSignal.h"
+#include "Shader.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Attribute locations shared with terrain.vs.
+static const GLuint GRID_LOCATION = 0;
+static const GLuint HEIGHT_LOCATION = 1;
+
+// Fraction of a level's range at which its vertices start morphing to the next level. The first range is sized from it
+// so that a chunk's neighbours are at most one level apart, and have finished morphing where they meet a coarser one.
+static const float MORPH_START = 0.75f;
+// Chunks kept on the GPU once they are no longer drawn. Chunks still drawn are never freed, so the views can go past it.
+static const size_t MAX_RESIDENT_CHUNKS = 1024;
+// Freed chunks whose buffers are kept, per level, to take the next chunk loaded without allocating.
+static const size_t MAX_SPARE_CHUNKS = 32;
+// Chunks uploaded at most per frame, so a burst of loads doesn't stall one frame.
+static const size_t MAX_UPLOADS_PER_FRAME = 16;
+
+// 64 bit seeks: a 16k map is already 512 MB.
+static int SeekFile(FILE* file, long long offset, int origin)
+{
+#ifdef _WIN32
+	return _fseeki64(file, offset, origin);
+#else
+	return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+static long long TellFile(FILE* file)
+{
+#ifdef _WIN32
+	return _ftelli64(file);
+#else
+	return (long long)ftello(file);
+#endif
+}
+
+Terrain::Terrain()
+{
+	file = NULL;
+	mapSize = 0;
+	chunkCount = 0;
+	origin = glm::vec3(0.0f);
+	sampleSpacing = 1.0f;
+	heightScale = 1.0f;
+	for (int level = 0; level < LEVEL_COUNT; level++)
+	{
+		levelRanges[level] = 0.0f;
+		gridBuffers[level] = 0;
+		indexBuffers[level] = 0;
+		indexCounts[level] = 0;
+	}
+	frame = 0;
+	stopping = false;
+	frameStats = Stats();
+	stats = Stats();
+}
+
+bool Terrain::Open(const char* path, const glm::vec3& center, float sampleSpacing, float heightScale)
+{
+	Close();
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		printf("Could not open terrain file %s\n", path);
+		return false;
+	}
+
+	SeekFile(file, 0, SEEK_END);
+	long long samples = TellFile(file) / 2;
+	mapSize = (int)std::sqrt((double)samples);
+	while ((long long)mapSize * mapSize < samples)
+	{
+		mapSize++;
+	}
+	chunkCount = (mapSize - 1) / CHUNK_QUADS;
+	if ((long long)mapSize * mapSize != samples || chunkCount == 0)
+	{
+		printf("Terrain file %s is not a square map of 16 bit samples, at least %d on a side\n", path, CHUNK_QUADS + 1);
+		fclose(file);
+		file = NULL;
+		return false;
+	}
+
+	this->sampleSpacing = sampleSpacing;
+	this->heightScale = heightScale;
+	float mapWidth = (mapSize - 1) * sampleSpacing;
+	origin = glm::vec3(center.x - mapWidth * 0.5f, center.y, center.z - mapWidth * 0.5f);
+
+	// Neighbours are at most a chunk's diagonal further from the camera than each other. With the first range that
+	// many times larger, a chunk's coarser neighbour starts morphing further than where their shared edge can be.
+	float chunkWidth = CHUNK_QUADS * sampleSpacing;
+	float chunkDiagonal = glm::length(glm::vec3(chunkWidth, heightScale, chunkWidth));
+	levelRanges[0] = chunkDiagonal / (2.0f * MORPH_START - 1.0f);
+	for (int level = 1; level < LEVEL_COUNT; level++)
+	{
+		levelRanges[level] = levelRanges[level - 1] * 2.0f;
+	}
+
+	CreateLevels();
+
+	frame = 0;
+	stopping = false;
+	frameStats = Stats();
+	stats = Stats();
+	loader = std::thread(&Terrain::LoadChunks, this);
+	return true;
+}
+
+void Terrain::Close()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		queue.clear();
+	}
+	queueCondition.notify_all();
+	loader.join();
+	loaded.clear();
+
+	fclose(file);
+	file = NULL;
+
+	for (std::unordered_map<unsigned long long, Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+	{
+		GLState::DeleteVertexArray(it->second.vertexArray);
+		GLState::DeleteBuffer(it->second.heightBuffer);
+	}
+	chunks.clear();
+	for (int level = 0; level < LEVEL_COUNT; level++)
+	{
+		for (size_t i = 0; i < spareChunks[level].size(); i++)
+		{
+			GLState::DeleteVertexArray(spareChunks[level][i].vertexArray);
+			GLState::DeleteBuffer(spareChunks[level][i].heightBuffer);
+		}
+		spareChunks[level].clear();
+
+		GLState::DeleteBuffer(gridBuffers[level]);
+		GLState::DeleteBuffer(indexBuffers[level]);
+		gridBuffers[level] = 0;
+		indexBuffers[level] = 0;
+		indexCounts[level] = 0;
+	}
+
+	requested.clear();
+	wanted.clear();
+	wantedKeys.clear();
+}
+
+void Terrain::Update()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	// The loading thread reads the nearest chunks first, so the first ones waiting are the ones to show first
+	std::vector<Load> uploads;
+	bool more;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t count = std::min(loaded.size(), MAX_UPLOADS_PER_FRAME);
+		uploads.assign(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.begin() + count));
+		loaded.erase(loaded.begin(), loaded.begin() + count);
+		more = !loaded.empty();
+	}
+
+	for (size_t i = 0; i < uploads.size(); i++)
+	{
+		requested.erase(uploads[i].key);
+		if (chunks.find(uploads[i].key) == chunks.end())
+		{
+			Upload(uploads[i]);
+		}
+	}
+
+	// The new chunks change the picture, and the ones left need another frame to go up
+	if (!uploads.empty() || more)
+	{
+		RedrawSignal::Request();
+	}
+}
+
+void Terrain::Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum)
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	glm::vec3 camera = glm::vec3(glm::inverse(view)[3]);
+
+	// Only the chunks under the frustum are looked at, so the cost follows what the view sees rather than the map's size
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::vec2 low(FLT_MAX);
+	glm::vec2 high(-FLT_MAX);
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner = inverseViewProjection * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+		glm::vec2 position = glm::vec2(corner.x, corner.z) / corner.w;
+		low = glm::min(low, position);
+		high = glm::max(high, position);
+	}
+	float chunkWidth = CHUNK_QUADS * sampleSpacing;
+	int firstX = std::max((int)std::floor((low.x - origin.x) / chunkWidth), 0);
+	int lastX = std::min((int)std::floor((high.x - origin.x) / chunkWidth), chunkCount - 1);
+	int firstZ = std::max((int)std::floor((low.y - origin.z) / chunkWidth), 0);
+	int lastZ = std::min((int)std::floor((high.y - origin.z) / chunkWidth), chunkCount - 1);
+
+	shader.setVec4("terrainOrigin", glm::vec4(origin, sampleSpacing));
+	shader.setFloat("heightScale", heightScale);
+	shader.setVec4("cameraPosition", glm::vec4(camera, 1.0f));
+
+	for (int z = firstZ; z <= lastZ; z++)
+	{
+		for (int x = firstX; x <= lastX; x++)
+		{
+			AABB bounds = GetChunkBounds(x, z);
+			if (!frustum.Intersects(bounds))
+			{
+				continue;
+			}
+
+			float distance = glm::length(camera - glm::clamp(camera, bounds.min, bounds.max));
+			int level = SelectLevel(distance);
+			unsigned long long key = GetKey(x, z, level);
+			std::unordered_map<unsigned long long, Chunk>::iterator found = chunks.find(key);
+			if (found == chunks.end())
+			{
+				if (requested.find(key) == requested.end() && wantedKeys.insert(key).second)
+				{
+					Load load;
+					load.key = key;
+					load.x = x;
+					load.z = z;
+					load.level = level;
+					load.distance = distance;
+					wanted.push_back(load);
+				}
+
+				// Until it is loaded, draw the nearest level that is
+				for (int offset = 1; offset < LEVEL_COUNT && found == chunks.end(); offset++)
+				{
+					if (level + offset < LEVEL_COUNT)
+					{
+						found = chunks.find(GetKey(x, z, level + offset));
+					}
+					if (found == chunks.end() && level - offset >= 0)
+					{
+						found = chunks.find(GetKey(x, z, level - offset));
+					}
+				}
+				if (found == chunks.end())
+				{
+					continue;
+				}
+			}
+
+			Chunk& chunk = found->second;
+			chunk.lastDrawnFrame = frame;
+			if (!frustum.Intersects(chunk.bounds))
+			{
+				continue;
+			}
+
+			// The coarsest level has nothing to morph to, so its range starts further than anything can be
+			glm::vec4 morphRange(1e30f, 2e30f, 0.0f, 0.0f);
+			if (chunk.level < LEVEL_COUNT - 1)
+			{
+				morphRange.x = levelRanges[chunk.level] * MORPH_START;
+				morphRange.y = levelRanges[chunk.level];
+			}
+			shader.setVec4("chunkOffset", glm::vec4((float)(x * CHUNK_QUADS), (float)(z * CHUNK_QUADS), (float)(1 << chunk.level), 0.0f));
+			shader.setVec4("morphRange", morphRange);
+
+			GLState::BindVertexArray(chunk.vertexArray);
+			GLState::DrawElements(GL_TRIANGLES, indexCounts[chunk.level]);
+
+			frameStats.drawnChunks++;
+			frameStats.drawnTriangles += indexCounts[chunk.level] / 3;
+		}
+	}
+}
+
+void Terrain::EndFrame()
+{
+	if (file == NULL)
+	{
+		return;
+	}
+
+	// Requests no view made this frame are dropped: the camera moved on before they were read
+	std::sort(wanted.begin(), wanted.end(), [](const Load& a, const Load& b) { return a.distance < b.distance; });
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			requested.erase(queue[i].key);
+		}
+		queue.clear();
+		for (size_t i = 0; i < wanted.size(); i++)
+		{
+			requested.insert(wanted[i].key);
+			queue.push_back(wanted[i]);
+		}
+	}
+	queueCondition.notify_one();
+	wanted.clear();
+	wantedKeys.clear();
+
+	// Free the least recently drawn chunks beyond the budget, never one drawn this frame
+	if (chunks.size() > MAX_RESIDENT_CHUNKS)
+	{
+		std::vector<std::pair<unsigned int, unsigned long long>> candidates;
+		for (std::unordered_map<unsigned long long, Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+		{
+			if (it->second.lastDrawnFrame != frame)
+			{
+				candidates.push_back(std::make_pair(it->second.lastDrawnFrame, it->first));
+			}
+		}
+		size_t excess = std::min(chunks.size() - MAX_RESIDENT_CHUNKS, candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + excess, candidates.end());
+		for (size_t i = 0; i < excess; i++)
+		{
+			std::unordered_map<unsigned long long, Chunk>::iterator it = chunks.find(candidates[i].second);
+			Release(it->second);
+			chunks.erase(it);
+		}
+	}
+
+	size_t residentBytes = stats.residentBytes;
+	stats = frameStats;
+	stats.residentChunks = (unsigned int)chunks.size();
+	stats.residentBytes = residentBytes;
+	stats.loadingChunks = (unsigned int)requested.size();
+	frameStats = Stats();
+	frame++;
+}
+
+unsigned long long Terrain::GetKey(int x, int z, int level)
+{
+	return ((unsigned long long)level << 48) | ((unsigned long long)x << 24) | (unsigned long long)z;
+}
+
+void Terrain::CreateLevels()
+{
+	for (int level = 0; level < LEVEL_COUNT; level++)
+	{
+		int quads = CHUNK_QUADS >> level;
+		int side = quads + 1;
+
+		// Positions in steps of the level, turned into samples and world units by terrain.vs
+		std::vector<GLfloat> grid;
+		for (int z = 0; z < side; z++)
+		{
+			for (int x = 0; x < side; x++)
+			{
+				grid.push_back((GLfloat)x);
+				grid.push_back((GLfloat)z);
+			}
+		}
+
+		// Every quad is split along the same diagonal, which is what lets the odd vertices fold into the coarser grid
+		std::vector<GLuint> indices;
+		for (int z = 0; z < quads; z++)
+		{
+			for (int x = 0; x < quads; x++)
+			{
+				GLuint corner = z * side + x;
+				indices.push_back(corner);
+				indices.push_back(corner + side + 1);
+				indices.push_back(corner + 1);
+				indices.push_back(corner);
+				indices.push_back(corner + side);
+				indices.push_back(corner + side + 1);
+			}
+		}
+
+		glGenBuffers(1, &gridBuffers[level]);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, gridBuffers[level]);
+		GPUMemory::BufferData(GL_ARRAY_BUFFER, gridBuffers[level], GPUMemoryCategory::VertexBuffer, sizeof(GLfloat) * grid.size(), &grid[0], GL_STATIC_DRAW);
+
+		// Element buffers are bound to the vertex array, so this one is only filled here and bound to each chunk's
+		glGenBuffers(1, &indexBuffers[level]);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, indexBuffers[level]);
+		GPUMemory::BufferData(GL_ARRAY_BUFFER, indexBuffers[level], GPUMemoryCategory::IndexBuffer, sizeof(GLuint) * indices.size(), &indices[0], GL_STATIC_DRAW);
+		indexCounts[level] = (GLsizei)indices.size();
+	}
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+AABB Terrain::GetChunkBounds(int x, int z) const
+{
+	float chunkWidth = CHUNK_QUADS * sampleSpacing;
+	glm::vec3 min = origin + glm::vec3(x * chunkWidth, 0.0f, z * chunkWidth);
+	return AABB(min, min + glm::vec3(chunkWidth, heightScale, chunkWidth));
+}
+
+int Terrain::SelectLevel(float distance) const
+{
+	for (int level = 0; level < LEVEL_COUNT - 1; level++)
+	{
+		if (distance < levelRanges[level])
+		{
+			return level;
+		}
+	}
+	return LEVEL_COUNT - 1;
+}
+
+void Terrain::Upload(const Load& load)
+{
+	int side = (CHUNK_QUADS >> load.level) + 1;
+	GLsizeiptr size = sizeof(GLushort) * load.heights.size();
+
+	Chunk chunk;
+	if (!spareChunks[load.level].empty())
+	{
+		chunk = spareChunks[load.level].back();
+		spareChunks[load.level].pop_back();
+		GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.heightBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, &load.heights[0]);
+		RENDER_STATS_COUNT(CountBufferUpload((size_t)size));
+		if (GLCapture::IsCapturing())
+		{
+			GLCapture::BufferSubData(chunk.heightBuffer, 0, size, &load.heights[0]);
+		}
+	}
+	else
+	{
+		glGenVertexArrays(1, &chunk.vertexArray);
+		GLState::BindVertexArray(chunk.vertexArray);
+
+		GLState::BindBuffer(GL_ARRAY_BUFFER, gridBuffers[load.level]);
+		glVertexAttribPointer(GRID_LOCATION, 2, GL_FLOAT, GL_FALSE, 0, 0);
+		glEnableVertexAttribArray(GRID_LOCATION);
+
+		// Heights stay 16 bit on the GPU, read as 0 to 1 and scaled by terrain.vs
+		glGenBuffers(1, &chunk.heightBuffer);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.heightBuffer);
+		GPUMemory::BufferData(GL_ARRAY_BUFFER, chunk.heightBuffer, GPUMemoryCategory::VertexBuffer, size, &load.heights[0], GL_STATIC_DRAW);
+		glVertexAttribPointer(HEIGHT_LOCATION, 2, GL_UNSIGNED_SHORT, GL_TRUE, 0, 0);
+		glEnableVertexAttribArray(HEIGHT_LOCATION);
+
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers[load.level]);
+		GLState::BindVertexArray(0);
+	}
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	float chunkWidth = CHUNK_QUADS * sampleSpacing;
+	glm::vec3 min = origin + glm::vec3(load.x * chunkWidth, load.minimum / 65535.0f * heightScale, load.z * chunkWidth);
+	glm::vec3 max = origin + glm::vec3((load.x + 1) * chunkWidth, load.maximum / 65535.0f * heightScale, (load.z + 1) * chunkWidth);
+	chunk.level = load.level;
+	chunk.bounds = AABB(min, max);
+	chunk.lastDrawnFrame = frame;
+	chunks[load.key] = chunk;
+	stats.residentBytes += side * side * 2 * sizeof(GLushort);
+}
+
+void Terrain::Release(Chunk& chunk)
+{
+	int side = (CHUNK_QUADS >> chunk.level) + 1;
+	stats.residentBytes -= side * side * 2 * sizeof(GLushort);
+
+	if (spareChunks[chunk.level].size() < MAX_SPARE_CHUNKS)
+	{
+		spareChunks[chunk.level].push_back(chunk);
+		return;
+	}
+	GLState::DeleteVertexArray(chunk.vertexArray);
+	GLState::DeleteBuffer(chunk.heightBuffer);
+}
+
+void Terrain::LoadChunks()
+{
+	while (true)
+	{
+		Load load;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			load = queue.front();
+			queue.pop_front();
+		}
+
+		ReadChunk(load);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			loaded.push_back(std::move(load));
+		}
+
+		// Wake the render loop if it is idle, so the chunk is drawn
+		RedrawSignal::Request();
+		glfwPostEmptyEvent();
+	}
+}
+
+void Terrain::ReadChunk(Load& load)
+{
+	int step = 1 << load.level;
+	int side = (CHUNK_QUADS >> load.level) + 1;
+	int firstX = load.x * CHUNK_QUADS;
+	int firstZ = load.z * CHUNK_QUADS;
+
+	// Only every step-th row is read. Within a row, reading the whole span is cheaper than seeking to every sample.
+	std::vector<unsigned char> row((CHUNK_QUADS + 1) * 2);
+	std::vector<GLushort> samples(side * side);
+	for (int z = 0; z < side; z++)
+	{
+		long long offset = ((long long)(firstZ + z * step) * mapSize + firstX) * 2;
+		if (SeekFile(file, offset, SEEK_SET) != 0 || fread(&row[0], 1, row.size(), file) != row.size())
+		{
+			std::fill(row.begin(), row.end(), 0);
+		}
+		for (int x = 0; x < side; x++)
+		{
+			samples[z * side + x] = (GLushort)(row[x * step * 2] | (row[x * step * 2 + 1] << 8));
+		}
+	}
+
+	// Each vertex also keeps the height of the vertex it folds into at the next level: odd positions move down to the
+	// even one before them, as terrain.vs moves them
+	bool coarsest = load.level == LEVEL_COUNT - 1;
+	load.heights.resize(side * side * 2);
+	load.minimum = 65535;
+	load.maximum = 0;
+	for (int z = 0; z < side; z++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			GLushort height = samples[z * side + x];
+			load.heights[(z * side + x) * 2] = height;
+			load.heights[(z * side + x) * 2 + 1] = coarsest ? height : samples[(z & ~1) * side + (x & ~1)];
+			load.minimum = std::min(load.minimum, height);
+			load.maximum = std::max(load.maximum, height);
+		}
+	}
+}
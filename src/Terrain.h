@@ -0,0 +1,193 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdio>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "AABB.h"
+#include "Frustum.h"
+
+class Shader;
+
+/// <summary>
+/// Ground made from a heightmap too large to keep in memory: a square grid of 16 bit samples in a raw little endian file,
+/// as terrain tools export them. The map is split into chunks of CHUNK_QUADS by CHUNK_QUADS quads, each drawn at one of
+/// LEVEL_COUNT levels of detail chosen by its distance to the camera. The chunks of a level share its grid and index
+/// buffers; only their heights are their own, read from disk by a background thread when a view first needs them and
+/// freed once they haven't been drawn for a while. Vertices morph towards the next coarser level as they get further
+/// away, so that neighbouring chunks of different levels meet without cracks and chunks change level without popping.
+/// Must be used on the thread owning the GL context, and closed before the context is destroyed.
+/// </summary>
+class Terrain
+{
+	public:
+		/// <summary>
+		/// Quads along each side of a chunk at the finest level. Each coarser level has half as many.
+		/// </summary>
+		static const int CHUNK_QUADS = 32;
+		static const int LEVEL_COUNT = 4;
+
+		/// <summary>
+		/// Counters of the last finished frame, over every view.
+		/// </summary>
+		struct Stats
+		{
+			unsigned int drawnChunks;
+			unsigned int drawnTriangles;
+			unsigned int residentChunks;
+			size_t residentBytes;
+			unsigned int loadingChunks;
+		};
+
+		Terrain();
+
+		/// <summary>
+		/// Opens a heightmap and starts the thread loading its chunks. Nothing is read until a view draws the terrain.
+		/// The file holds size * size samples, row after row along x, so its size must be a square number of samples.
+		/// Samples past the last whole chunk are not drawn.
+		/// </summary>
+		/// <param name="path">The raw heightmap file.</param>
+		/// <param name="center">Where the middle of the map is, at the height of a 0 sample.</param>
+		/// <param name="sampleSpacing">Distance between neighbouring samples, in world units.</param>
+		/// <param name="heightScale">Height of a 65535 sample above a 0 sample, in world units.</param>
+		/// <returns>False if the file couldn't be read or isn't a square map.</returns>
+		bool Open(const char* path, const glm::vec3& center, float sampleSpacing, float heightScale);
+		/// <summary>
+		/// Stops the loading thread, closes the file and frees every chunk.
+		/// </summary>
+		void Close();
+
+		bool IsOpen() const { return file != NULL; }
+
+		/// <summary>
+		/// Uploads some of the chunks loaded since the last call. Call once per frame, before drawing.
+		/// </summary>
+		void Update();
+		/// <summary>
+		/// Draws the chunks a view sees, each at the level its distance calls for, and asks for the ones that aren't
+		/// loaded yet. Until they are, the chunk is drawn at another loaded level, or not at all.
+		/// The shader must be in use, with its projection and view set.
+		/// </summary>
+		/// <param name="shader">The terrain shader, terrain.vs and terrain.fs.</param>
+		/// <param name="view">The view matrix, from world space.</param>
+		/// <param name="projection">The projection matrix.</param>
+		/// <param name="frustum">The frustum of projection * view.</param>
+		void Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum);
+		/// <summary>
+		/// Hands the chunks the views asked for to the loading thread, nearest first, and frees the chunks least recently
+		/// drawn beyond the budget. Call once per frame, after every view is drawn.
+		/// </summary>
+		void EndFrame();
+
+		Stats GetStats() const { return stats; }
+
+	private:
+		/// <summary>
+		/// The heights of one chunk at one level, on the GPU.
+		/// </summary>
+		struct Chunk
+		{
+			GLuint vertexArray;
+			GLuint heightBuffer;
+			int level;
+			/// <summary>
+			/// Box around the chunk's samples, tighter than the one used before it is loaded.
+			/// </summary>
+			AABB bounds;
+			unsigned int lastDrawnFrame;
+		};
+
+		/// <summary>
+		/// A chunk to read, then read, passed between the render and the loading threads.
+		/// </summary>
+		struct Load
+		{
+			unsigned long long key;
+			int x;
+			int z;
+			int level;
+			float distance;
+			/// <summary>
+			/// Two values per vertex: its height, and the height it morphs to at the next coarser level.
+			/// </summary>
+			std::vector<GLushort> heights;
+			GLushort minimum;
+			GLushort maximum;
+		};
+
+		static unsigned long long GetKey(int x, int z, int level);
+
+		/// <summary>
+		/// Creates the grid and index buffers the chunks of each level share.
+		/// </summary>
+		void CreateLevels();
+		/// <summary>
+		/// Returns the box of a chunk from the full height range of the map, which holds whatever its samples are.
+		/// </summary>
+		AABB GetChunkBounds(int x, int z) const;
+		/// <summary>
+		/// Returns the level of a chunk at the given distance from the camera.
+		/// </summary>
+		int SelectLevel(float distance) const;
+		/// <summary>
+		/// Puts a loaded chunk on the GPU, reusing a freed chunk of its level if there is one.
+		/// </summary>
+		void Upload(const Load& load);
+		/// <summary>
+		/// Frees a chunk, keeping its buffers for a later chunk of the same level if there aren't many spares yet.
+		/// </summary>
+		void Release(Chunk& chunk);
+		/// <summary>
+		/// Reads the requested chunks until closed. Runs on the loading thread.
+		/// </summary>
+		void LoadChunks();
+		/// <summary>
+		/// Reads the samples of one chunk from the file.
+		/// </summary>
+		void ReadChunk(Load& load);
+
+		FILE* file;
+		int mapSize;
+		int chunkCount;
+		glm::vec3 origin;
+		float sampleSpacing;
+		float heightScale;
+		/// <summary>
+		/// Distance from the camera under which a chunk is drawn at each level. Each is twice the one before.
+		/// </summary>
+		float levelRanges[LEVEL_COUNT];
+
+		// Shared by the chunks of each level: their vertices' grid positions, and the triangles joining them.
+		GLuint gridBuffers[LEVEL_COUNT];
+		GLuint indexBuffers[LEVEL_COUNT];
+		GLsizei indexCounts[LEVEL_COUNT];
+
+		std::unordered_map<unsigned long long, Chunk> chunks;
+		std::vector<Chunk> spareChunks[LEVEL_COUNT];
+		/// <summary>
+		/// Chunks handed to the loading thread and not uploaded yet.
+		/// </summary>
+		std::unordered_set<unsigned long long> requested;
+		/// <summary>
+		/// Chunks the views asked for this frame.
+		/// </summary>
+		std::vector<Load> wanted;
+		std::unordered_set<unsigned long long> wantedKeys;
+		unsigned int frame;
+
+		std::thread loader;
+		// Guarded by mutex: the chunks waiting to be read, nearest first, and the ones read but not uploaded yet.
+		std::mutex mutex;
+		std::condition_variable queueCondition;
+		std::deque<Load> queue;
+		std::vector<Load> loaded;
+		bool stopping;
+
+		Stats frameStats;
+		Stats stats;
+};
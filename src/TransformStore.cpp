@@ -0,0 +1,177 @@
+#include "TransformStore.h"
+#include "MatrixKernels.h"
+#include "RedrawSignal.h"
+#include <cmath>
+#include <algorithm>
+
+TRS::TRS()
+{
+	translation = glm::vec3(0.0f);
+	rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	scale = glm::vec3(1.0f);
+}
+
+TRS::TRS(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	this->translation = translation;
+	this->rotation = rotation;
+	this->scale = scale;
+}
+
+glm::mat4 TRS::ToMatrix() const
+{
+	// The rotation's columns scaled by the scale, then the translation: no matrix product needed.
+	glm::mat3 axes = glm::mat3_cast(rotation);
+	glm::mat4 matrix(1.0f);
+	matrix[0] = glm::vec4(axes[0] * scale.x, 0.0f);
+	matrix[1] = glm::vec4(axes[1] * scale.y, 0.0f);
+	matrix[2] = glm::vec4(axes[2] * scale.z, 0.0f);
+	matrix[3] = glm::vec4(translation, 1.0f);
+	return matrix;
+}
+
+TRS TRS::FromMatrix(const glm::mat4& matrix)
+{
+	TRS result;
+	result.translation = glm::vec3(matrix[3]);
+
+	glm::mat3 axes;
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec3 column = glm::vec3(matrix[i]);
+		result.scale[i] = glm::length(column);
+		axes[i] = result.scale[i] > 0.0f ? column / result.scale[i] : glm::vec3(0.0f);
+	}
+
+	// A mirroring matrix has a negative determinant: move the mirror into the scale so what remains is a rotation.
+	if (glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0.0f)
+	{
+		result.scale.x = -result.scale.x;
+		axes[0] = -axes[0];
+	}
+
+	result.rotation = glm::normalize(glm::quat_cast(axes));
+	return result;
+}
+
+TransformStore::TransformStore()
+{
+}
+
+TransformStore::~TransformStore()
+{
+}
+
+TransformStore& TransformStore::Global()
+{
+	static TransformStore store;
+	return store;
+}
+
+unsigned int TransformStore::Create()
+{
+	unsigned int transform;
+	if (!freeTransforms.empty())
+	{
+		transform = freeTransforms.back();
+		freeTransforms.pop_back();
+	}
+	else
+	{
+		transform = (unsigned int)translations.size();
+		translations.push_back(glm::vec3(0.0f));
+		rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		scales.push_back(glm::vec3(1.0f));
+		matrices.push_back(glm::mat4(1.0f));
+		dirty.push_back(0);
+	}
+
+	Set(transform, TRS());
+	return transform;
+}
+
+void TransformStore::Destroy(unsigned int transform)
+{
+	// Left in dirtyList if it is there: composing a freed transformation is harmless.
+	freeTransforms.push_back(transform);
+}
+
+void TransformStore::Set(unsigned int transform, const TRS& value)
+{
+	translations[transform] = value.translation;
+	rotations[transform] = value.rotation;
+	scales[transform] = value.scale;
+	MarkDirty(transform);
+}
+
+void TransformStore::SetMatrix(unsigned int transform, const glm::mat4& matrix)
+{
+	Set(transform, TRS::FromMatrix(matrix));
+}
+
+void TransformStore::Translate(unsigned int transform, const glm::vec3& offset)
+{
+	// T R S * translate(v) = translate(R S v) * T R S
+	translations[transform] += rotations[transform] * (scales[transform] * offset);
+	MarkDirty(transform);
+}
+
+void TransformStore::Rotate(unsigned int transform, const glm::quat& rotation)
+{
+	// Renormalizing keeps rounding errors from growing the quaternion over many edits.
+	rotations[transform] = glm::normalize(rotations[transform] * rotation);
+	MarkDirty(transform);
+}
+
+void TransformStore::Scale(unsigned int transform, const glm::vec3& factors)
+{
+	scales[transform] *= factors;
+	MarkDirty(transform);
+}
+
+const glm::mat4& TransformStore::GetMatrix(unsigned int transform)
+{
+	if (dirty[transform])
+	{
+		matrices[transform] = TRS(translations[transform], rotations[transform], scales[transform]).ToMatrix();
+		dirty[transform] = 0;
+	}
+	return matrices[transform];
+}
+
+void TransformStore::ComposeDirty()
+{
+	// Sorted, the changed transformations form runs of neighbours, each composed by one call to the batched kernel.
+	std::sort(dirtyList.begin(), dirtyList.end());
+
+	size_t begin = 0;
+	while (begin < dirtyList.size())
+	{
+		unsigned int first = dirtyList[begin];
+		size_t end = begin + 1;
+		while (end < dirtyList.size() && dirtyList[end] == first + (end - begin))
+		{
+			end++;
+		}
+
+		MatrixKernels::ComposeTRS(&translations[first], &rotations[first], &scales[first], &matrices[first], end - begin);
+		for (size_t i = begin; i < end; i++)
+		{
+			dirty[dirtyList[i]] = 0;
+		}
+		begin = end;
+	}
+	dirtyList.clear();
+}
+
+void TransformStore::MarkDirty(unsigned int transform)
+{
+	// A moved node changes the picture.
+	RedrawSignal::Request();
+
+	if (!dirty[transform])
+	{
+		dirty[transform] = 1;
+		dirtyList.push_back(transform);
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+/// <summary>
+/// A transformation kept as its parts: translation, rotation and scale, applied in the order scale, rotation, translation.
+/// </summary>
+struct TRS
+{
+	glm::vec3 translation;
+	glm::quat rotation;
+	glm::vec3 scale;
+
+	/// <summary>
+	/// Creates the identity transformation.
+	/// </summary>
+	TRS();
+	TRS(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+	/// <summary>
+	/// Returns the matrix applying the transformation: translation * rotation * scale.
+	/// </summary>
+	glm::mat4 ToMatrix() const;
+
+	/// <summary>
+	/// Splits a matrix made of a translation, a rotation and a scale (no shear or projection) into its parts.
+	/// </summary>
+	static TRS FromMatrix(const glm::mat4& matrix);
+};
+
+/// <summary>
+/// Stores the transformations of scene nodes as separate translation, rotation and scale arrays, composing each one into
+/// a matrix only when it changed. Edits are cheap vector operations that can't accumulate drift in the matrix, and all the
+/// matrices that changed during a frame are composed together in one pass.
+/// Transformations are referred to by the index returned by Create.
+/// </summary>
+class TransformStore
+{
+	public:
+		TransformStore();
+		~TransformStore();
+
+		/// <summary>
+		/// Returns the store shared by every scene node.
+		/// </summary>
+		static TransformStore& Global();
+
+		/// <summary>
+		/// Adds an identity transformation.
+		/// </summary>
+		/// <returns>The index of the transformation.</returns>
+		unsigned int Create();
+		/// <summary>
+		/// Frees a transformation. Its index may be returned by a later Create.
+		/// </summary>
+		void Destroy(unsigned int transform);
+
+		TRS Get(unsigned int transform) const { return TRS(translations[transform], rotations[transform], scales[transform]); }
+		void Set(unsigned int transform, const TRS& value);
+		/// <summary>
+		/// Sets the transformation from a matrix made of a translation, a rotation and a scale.
+		/// </summary>
+		void SetMatrix(unsigned int transform, const glm::mat4& matrix);
+
+		/// <summary>
+		/// Moves along the transformation's own axes, as right multiplying its matrix by a translation would.
+		/// </summary>
+		void Translate(unsigned int transform, const glm::vec3& offset);
+		/// <summary>
+		/// Rotates about the transformation's own axes, as right multiplying its matrix by a rotation would.
+		/// Exact when the scale is uniform; with a non uniform scale, the rotation is applied before the scale.
+		/// </summary>
+		void Rotate(unsigned int transform, const glm::quat& rotation);
+		/// <summary>
+		/// Scales along the transformation's own axes, as right multiplying its matrix by a scale would.
+		/// </summary>
+		void Scale(unsigned int transform, const glm::vec3& factors);
+
+		/// <summary>
+		/// Returns the matrix of the transformation, composing it first if it changed.
+		/// </summary>
+		const glm::mat4& GetMatrix(unsigned int transform);
+
+		/// <summary>
+		/// Composes the matrix of every transformation that changed since it was last composed.
+		/// Call it before reading matrices from several threads at once.
+		/// </summary>
+		void ComposeDirty();
+
+		/// <summary>
+		/// Returns the number of transformations waiting to be composed.
+		/// </summary>
+		size_t GetDirtyCount() const { return dirtyList.size(); }
+
+	private:
+		/// <summary>
+		/// Flags the transformation as changed.
+		/// </summary>
+		void MarkDirty(unsigned int transform);
+
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<glm::mat4> matrices;
+		/// <summary>
+		/// Non zero for transformations whose matrix is out of date. They are also listed in dirtyList.
+		/// </summary>
+		std::vector<unsigned char> dirty;
+		std::vector<unsigned int> dirtyList;
+		std::vector<unsigned int> freeTransforms;
+};
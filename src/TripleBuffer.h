@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+
+/// <summary>
+/// Hands values from one writer thread to one reader thread without locks or waiting. The writer fills the back buffer
+/// and publishes it; the reader switches to the most recently published buffer whenever it wants. Neither side ever
+/// blocks the other, and the reader always sees a complete value, skipping the ones published while it wasn't looking.
+/// </summary>
+template <typename T>
+class TripleBuffer
+{
+	public:
+		TripleBuffer() : back(0), middle(1), front(2) {}
+
+		/// <summary>
+		/// Returns the buffer the writer fills next. It holds an older value, so every field must be written before Publish.
+		/// </summary>
+		T& GetWriteBuffer() { return buffers[back]; }
+
+		/// <summary>
+		/// Makes the write buffer the latest value, and gives the writer another buffer to fill.
+		/// </summary>
+		void Publish()
+		{
+			back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+
+		/// <summary>
+		/// Returns true if a value was published since the reader last switched to one.
+		/// </summary>
+		bool HasNew() const
+		{
+			return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+		}
+
+		/// <summary>
+		/// Switches the read buffer to the latest published value, if there is a newer one.
+		/// </summary>
+		/// <returns>True if the read buffer changed.</returns>
+		bool Update()
+		{
+			if (!HasNew())
+			{
+				return false;
+			}
+
+			front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+			return true;
+		}
+
+		/// <summary>
+		/// Returns the value the reader switched to last. It stays as it is until the next Update.
+		/// </summary>
+		const T& GetReadBuffer() const { return buffers[front]; }
+
+	private:
+		/// <summary>
+		/// The middle index holds a buffer index in its low bits and this flag when it was published but not read yet.
+		/// </summary>
+		static const unsigned int FRESH = 4;
+		static const unsigned int INDEX = 3;
+
+		T buffers[3];
+		/// <summary>
+		/// Owned by the writer.
+		/// </summary>
+		unsigned int back;
+		/// <summary>
+		/// The buffer passed between them, exchanged atomically.
+		/// </summary>
+		std::atomic<unsigned int> middle;
+		/// <summary>
+		/// Owned by the reader.
+		/// </summary>
+		unsigned int front;
+};
@@ -1,5 +1,10 @@
 // Modified from Ben Cook's Udemy OpenGL course https://www.udemy.com/course/graphics-with-modern-opengl/
 #include "Window.h"
+#include "RedrawSignal.h"
+#include <math.h>
+
+// A left button release further than this from its press, in pixels, is a drag rather than a click.
+static const GLfloat CLICK_TOLERANCE = 3.0f;
 
 Window::Window()
 {
@@ -7,9 +12,19 @@ Window::Window()
 	height = 768;
 	deltaX = 0.0f;
 	deltaY = 0.0f;
+	lastX = 0.0f;
+	lastY = 0.0f;
+	initialMouseMove = true;
+	pressX = 0.0f;
+	pressY = 0.0f;
+	clickPending = false;
+	clickX = 0.0f;
+	clickY = 0.0f;
+	pendingInputTime = -1.0;
 
 	for (int i = 0; i < 1024; i++) {
 		keys[i] = 0;
+		keyPresses[i] = 0;
 	}
 }
 
@@ -19,9 +34,19 @@ Window::Window(GLint windowWidth, GLint windowHeight)
 	height = windowHeight;
 	deltaX = 0.0f;
 	deltaY = 0.0f;
+	lastX = 0.0f;
+	lastY = 0.0f;
+	initialMouseMove = true;
+	pressX = 0.0f;
+	pressY = 0.0f;
+	clickPending = false;
+	clickX = 0.0f;
+	clickY = 0.0f;
+	pendingInputTime = -1.0;
 
 	for (int i = 0; i < 1024; i++) {
 		keys[i] = 0;
+		keyPresses[i] = 0;
 	}
 }
 
@@ -78,6 +103,7 @@ void Window::createCallbacks() {
 	glfwSetKeyCallback(mainWindow, handleKeys); // When a key is pressed in window, handle input
 	glfwSetCursorPosCallback(mainWindow, handleMouse);
 	glfwSetMouseButtonCallback(mainWindow, handleMouseButtons);
+	glfwSetWindowRefreshCallback(mainWindow, handleRefresh);
 }
 
 void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int mode) {
@@ -88,9 +114,16 @@ void Window::handleKeys(GLFWwindow* window, int key, int code, int action, int m
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	RedrawSignal::Request();
+
+	if (theWindow->pendingInputTime < 0.0) {
+		theWindow->pendingInputTime = glfwGetTime();
+	}
+
 	if (key >= 0 && key < 1024) {
 		if (action == GLFW_PRESS) {
 			theWindow->keys[key] = true;
+			theWindow->keyPresses[key] = true;
 		}
 		else if (action == GLFW_RELEASE) {
 			theWindow->keys[key] = false;
@@ -109,8 +142,11 @@ void Window::handleMouse(GLFWwindow* window, double x, double y) {
 		theWindow->initialMouseMove = false;
 	}
 
-	theWindow->deltaX = x - theWindow->lastX;
-	theWindow->deltaY = theWindow->lastY - y;
+	// Motion only matters while a button drags the camera
+	if (theWindow->keys[GLFW_MOUSE_BUTTON_LEFT] || theWindow->keys[GLFW_MOUSE_BUTTON_RIGHT] || theWindow->keys[GLFW_MOUSE_BUTTON_MIDDLE]) {
+		theWindow->deltaX += x - theWindow->lastX;
+		theWindow->deltaY += theWindow->lastY - y;
+	}
 
 	theWindow->lastX = x;
 	theWindow->lastY = y;
@@ -120,6 +156,28 @@ void Window::handleMouse(GLFWwindow* window, double x, double y) {
 void Window::handleMouseButtons(GLFWwindow* window, int button, int action, int mods)
 {
 	Window* theWindow = static_cast<Window*>(glfwGetWindowUserPointer(window));
+
+	RedrawSignal::Request();
+
+	if (theWindow->pendingInputTime < 0.0) {
+		theWindow->pendingInputTime = glfwGetTime();
+	}
+
+	if (button == GLFW_MOUSE_BUTTON_LEFT) {
+		double x, y;
+		glfwGetCursorPos(window, &x, &y);
+
+		if (action == GLFW_PRESS) {
+			theWindow->pressX = (GLfloat)x;
+			theWindow->pressY = (GLfloat)y;
+		}
+		else if (action == GLFW_RELEASE && fabs(x - theWindow->pressX) <= CLICK_TOLERANCE && fabs(y - theWindow->pressY) <= CLICK_TOLERANCE) {
+			theWindow->clickPending = true;
+			theWindow->clickX = (GLfloat)x;
+			theWindow->clickY = (GLfloat)y;
+		}
+	}
+
 	if (button >= 0 && button < 1024) {
 		if (action == GLFW_PRESS) {
 			theWindow->keys[button] = true;
@@ -130,6 +188,62 @@ void Window::handleMouseButtons(GLFWwindow* window, int button, int action, int
 	}
 }
 
+void Window::handleRefresh(GLFWwindow*)
+{
+	RedrawSignal::Request();
+}
+
+void Window::consumeMouseDelta(GLfloat& x, GLfloat& y)
+{
+	x = deltaX;
+	y = deltaY;
+	deltaX = 0.0f;
+	deltaY = 0.0f;
+}
+
+bool Window::isInputHeld() const
+{
+	for (size_t i = 0; i < 1024; i++) {
+		if (keys[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Window::consumeClick(GLfloat& x, GLfloat& y)
+{
+	if (!clickPending) {
+		return false;
+	}
+
+	x = clickX;
+	y = clickY;
+	clickPending = false;
+	return true;
+}
+
+bool Window::consumeKeyPress(int key)
+{
+	if (key < 0 || key >= 1024 || !keyPresses[key]) {
+		return false;
+	}
+
+	keyPresses[key] = false;
+	return true;
+}
+
+bool Window::consumeInputTime(double& time)
+{
+	if (pendingInputTime < 0.0) {
+		return false;
+	}
+
+	time = pendingInputTime;
+	pendingInputTime = -1.0;
+	return true;
+}
 
 Window::~Window()
 {
@@ -38,6 +38,15 @@ public:
 	/// <returns>A GLint representing the buffer height</returns>
 	GLint getBufferHeight() { return bufferHeight; }
 
+	/// <summary>
+	/// Gets the window width, in the units of cursor positions
+	/// </summary>
+	GLint getWidth() const { return width; }
+	/// <summary>
+	/// Gets the window height, in the units of cursor positions
+	/// </summary>
+	GLint getHeight() const { return height; }
+
 	/// <summary>
 	/// Determines whether or not the window should stay open
 	/// </summary>
@@ -51,21 +60,49 @@ public:
 	bool* getKeys() { return keys;  }
 
 	/// <summary>
-	/// Gets the change in mouse position on the x-axis
+	/// Returns how far the mouse moved while a mouse button was held, since the last call
+	/// </summary>
+	/// <param name="x">Set to the motion on the x-axis, in pixels</param>
+	/// <param name="y">Set to the motion on the y-axis, in pixels, upwards</param>
+	void consumeMouseDelta(GLfloat& x, GLfloat& y);
+
+	/// <summary>
+	/// Returns the last left click, if one happened since the last call. A click is a press and release of the left
+	/// mouse button without dragging, so zooming with the left button held does not count.
 	/// </summary>
-	/// <returns>A GLfloat</returns>
-	GLfloat getDeltaX() const { return deltaX; }
+	/// <param name="x">Set to the x position of the click, in window coordinates</param>
+	/// <param name="y">Set to the y position of the click, in window coordinates</param>
+	/// <returns>True if there was a click</returns>
+	bool consumeClick(GLfloat& x, GLfloat& y);
+
+	/// <summary>
+	/// Returns true if the key was pressed since the last call for that key, for keys that toggle something once per press.
+	/// </summary>
+	/// <param name="key">The GLFW key code</param>
+	bool consumeKeyPress(int key);
+
+	/// <summary>
+	/// Returns when the oldest key or mouse button event since the last call happened, to measure input latency.
+	/// </summary>
+	/// <param name="time">Set to the glfwGetTime() of the event</param>
+	/// <returns>True if there was an event since the last call</returns>
+	bool consumeInputTime(double& time);
+
 	/// <summary>
-	/// Gets the change in mouse position on the y-axis
+	/// Returns true while any key or mouse button is held down, since held keys move things every frame
 	/// </summary>
-	/// <returns>A GLfloat</returns>
-	GLfloat getDeltaY() const { return deltaY; }
+	bool isInputHeld() const;
 
 	/// <summary>
 	/// Calls glfwSwapBuffers
 	/// </summary>
 	void swapBuffers() { glfwSwapBuffers(mainWindow); }
 
+	/// <summary>
+	/// Sets the text of the window's title bar
+	/// </summary>
+	void setTitle(const char* title) { glfwSetWindowTitle(mainWindow, title); }
+
 	///<summary>
 	/// Deconstructor
 	/// </summary>
@@ -99,6 +136,14 @@ private:
 	/// A boolean array of keyboard and mouse buttons. When a button is pressed, its associated array element will become true
 	/// </summary>
 	bool keys[1024];
+	/// <summary>
+	/// Keys pressed since they were last consumed with consumeKeyPress
+	/// </summary>
+	bool keyPresses[1024];
+	/// <summary>
+	/// glfwGetTime() of the oldest key or mouse button event not consumed yet, negative if there is none
+	/// </summary>
+	double pendingInputTime;
 
 	/// <summary>
 	/// Last position of the mouse on the x-axis
@@ -109,11 +154,11 @@ private:
 	/// </summary>
 	GLfloat lastY;
 	/// <summary>
-	/// The change in the mouse's position on the x-axis
+	/// The change in the mouse's position on the x-axis while a button was held, since it was last consumed
 	/// </summary>
 	GLfloat deltaX;
 	/// <summary>
-	/// The change in the mouse's position on the y-axis
+	/// The change in the mouse's position on the y-axis while a button was held, since it was last consumed
 	/// </summary>
 	GLfloat deltaY;
 
@@ -122,6 +167,18 @@ private:
 	/// </summary>
 	bool initialMouseMove;
 
+	/// <summary>
+	/// Where the left mouse button was last pressed
+	/// </summary>
+	GLfloat pressX;
+	GLfloat pressY;
+	/// <summary>
+	/// Whether a click is waiting to be consumed, and where it happened
+	/// </summary>
+	bool clickPending;
+	GLfloat clickX;
+	GLfloat clickY;
+
 	/// <summary>
 	/// Callback function to handle key presses
 	/// </summary>
@@ -147,6 +204,11 @@ private:
 	/// <param name="mods"></param>
 	static void handleMouseButtons(GLFWwindow* window, int button, int action, int mods);
 	/// <summary>
+	/// Callback function to handle the window needing to be redrawn, e.g. after being uncovered or resized
+	/// </summary>
+	/// <param name="window">The window</param>
+	static void handleRefresh(GLFWwindow* window);
+	/// <summary>
 	/// Calls all callback functions
 	/// </summary>
 	void createCallbacks();
@@ -0,0 +1,133 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int workerCount)
+{
+	if (workerCount == 0)
+	{
+		workerCount = std::thread::hardware_concurrency();
+	}
+	if (workerCount == 0)
+	{
+		// hardware_concurrency is allowed to be unknown.
+		workerCount = 1;
+	}
+
+	this->workerCount = workerCount;
+	currentTask = NULL;
+	currentCount = 0;
+	activeWorkers = 0;
+	pendingWorkers = 0;
+	jobGeneration = 0;
+	stopping = false;
+
+	// Worker 0 is the calling thread, so we only need workerCount - 1 background threads.
+	for (unsigned int i = 1; i < workerCount; i++)
+	{
+		threads.push_back(std::thread(&WorkerPool::WorkerLoop, this, i));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	startCondition.notify_all();
+
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+}
+
+void WorkerPool::ParallelFor(size_t count, const Task& task, size_t minimumSliceSize)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (minimumSliceSize == 0)
+	{
+		minimumSliceSize = 1;
+	}
+
+	// Don't wake more workers than there are slices worth the synchronisation.
+	size_t usefulWorkers = (count + minimumSliceSize - 1) / minimumSliceSize;
+	unsigned int workers = usefulWorkers < workerCount ? (unsigned int)usefulWorkers : workerCount;
+
+	if (workers <= 1)
+	{
+		task(0, count, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		currentCount = count;
+		activeWorkers = workers;
+		pendingWorkers = workers - 1;
+		jobGeneration++;
+	}
+	startCondition.notify_all();
+
+	// The calling thread does its share instead of waiting idle.
+	RunSlice(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this] { return pendingWorkers == 0; });
+	currentTask = NULL;
+}
+
+void WorkerPool::WorkerLoop(unsigned int worker)
+{
+	unsigned long long seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCondition.wait(lock, [&] { return stopping || jobGeneration != seenGeneration; });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			seenGeneration = jobGeneration;
+
+			// This job does not need every worker.
+			if (worker >= activeWorkers)
+			{
+				continue;
+			}
+		}
+
+		RunSlice(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pendingWorkers--;
+			if (pendingWorkers == 0)
+			{
+				doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+void WorkerPool::RunSlice(unsigned int worker)
+{
+	// Contiguous, evenly sized slices. The first (count % workers) slices get one extra item.
+	size_t sliceSize = currentCount / activeWorkers;
+	size_t remainder = currentCount % activeWorkers;
+	size_t begin = worker * sliceSize + (worker < remainder ? worker : remainder);
+	size_t end = begin + sliceSize + (worker < remainder ? 1 : 0);
+
+	if (begin < end)
+	{
+		(*currentTask)(begin, end, worker);
+	}
+}
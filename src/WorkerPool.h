@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class WorkerPool
+{
+	public:
+		/// <summary>
+		/// The function run on each slice: first index, one past the last index, and the index of the worker running it.
+		/// </summary>
+		typedef std::function<void(size_t begin, size_t end, unsigned int worker)> Task;
+
+		/// <summary>
+		/// Creates a pool of persistent worker threads. The calling thread also takes a slice of every job.
+		/// </summary>
+		/// <param name="workerCount">Total number of workers including the caller. 0 uses the number of hardware threads.</param>
+		WorkerPool(unsigned int workerCount = 0);
+		~WorkerPool();
+
+		/// <summary>
+		/// Splits [0, count) into one contiguous slice per worker and runs the task on every slice. Returns once all slices are done.
+		/// Slices are in worker order, so worker 0 gets the first items, worker 1 the next ones, and so on.
+		/// </summary>
+		/// <param name="count">Number of items to process.</param>
+		/// <param name="task">The task run on each slice.</param>
+		/// <param name="minimumSliceSize">Below this many items per worker, fewer workers are used.</param>
+		void ParallelFor(size_t count, const Task& task, size_t minimumSliceSize = 1);
+
+		/// <summary>
+		/// Returns the number of workers, including the calling thread.
+		/// </summary>
+		unsigned int GetWorkerCount() const { return workerCount; }
+
+	private:
+		/// <summary>
+		/// Loop run by each background thread, waiting for jobs.
+		/// </summary>
+		/// <param name="worker">Index of the worker, starting at 1.</param>
+		void WorkerLoop(unsigned int worker);
+
+		/// <summary>
+		/// Runs the slice of the current job belonging to the given worker.
+		/// </summary>
+		void RunSlice(unsigned int worker);
+
+		unsigned int workerCount;
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable startCondition;
+		std::condition_variable doneCondition;
+
+		/// <summary>
+		/// The job being run. Only valid while pendingWorkers is non zero.
+		/// </summary>
+		const Task* currentTask;
+		size_t currentCount;
+		unsigned int activeWorkers;
+		unsigned int pendingWorkers;
+		/// <summary>
+		/// Incremented for every job, so sleeping workers can tell a new job from a spurious wake up.
+		/// </summary>
+		unsigned long long jobGeneration;
+		bool stopping;
+};
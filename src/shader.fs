@@ -3,8 +3,10 @@
 out vec4 FragColor;			
 
 in vec3 vertexColor;			
+in float vertexHighlight;
 
 void main()				
 {					
-	FragColor = vec4(vertexColor, 1.0);					
-}														
\ No newline at end of file
+	// Highlighted (selected) geometry is brightened towards white.
+	FragColor = vec4(mix(vertexColor, vec3(1.0), 0.4 * vertexHighlight), 1.0);
+}
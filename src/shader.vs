@@ -1,19 +1,20 @@
 #version 330 core					
 
 layout (location = 0) in vec3 aPos;									
+// Color (rgb) and selection highlight (a). Comes from a per vertex buffer when the mesh has one,
+// otherwise from the constant attribute value set before the draw.
+layout (location = 1) in vec4 aColor;
 
 out vec3 vertexColor;									
+out float vertexHighlight;
 
 uniform mat4 model;
 uniform mat4 projection;
 uniform mat4 view;
 
-uniform float r;
-uniform float rg;
-uniform float rgb;
-
 void main()											
 {
 	gl_Position = projection * view * model * vec4(aPos.x, aPos.y, aPos.z, 1.0);	
-	vertexColor = vec3(r, rg, rgb);							
-}														
\ No newline at end of file
+	vertexColor = aColor.rgb;
+	vertexHighlight = aColor.a;
+}														
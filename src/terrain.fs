@@ -0,0 +1,27 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec3 worldPosition;
+in float terrainHeight;
+
+// Direction the light comes from, in world space
+const vec3 LIGHT_DIRECTION = normalize(vec3(0.4, 1.0, 0.3));
+const vec3 LOW_COLOR = vec3(0.30, 0.45, 0.20);
+const vec3 HIGH_COLOR = vec3(0.55, 0.50, 0.42);
+const vec3 PEAK_COLOR = vec3(0.92, 0.92, 0.95);
+
+void main()
+{
+	// The terrain has no normals: the faces are lit by the normal of the triangle, from the position's derivatives.
+	vec3 normal = normalize(cross(dFdx(worldPosition), dFdy(worldPosition)));
+	if (normal.y < 0.0)
+	{
+		normal = -normal;
+	}
+	float light = 0.35 + 0.65 * max(dot(normal, LIGHT_DIRECTION), 0.0);
+
+	vec3 color = mix(LOW_COLOR, HIGH_COLOR, smoothstep(0.2, 0.6, terrainHeight));
+	color = mix(color, PEAK_COLOR, smoothstep(0.75, 0.9, terrainHeight));
+	FragColor = vec4(color * light, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 330 core
+
+// Position of the vertex in its chunk, in steps of the chunk's level. Shared by every chunk of the level.
+layout (location = 0) in vec2 aGrid;
+// Height of the vertex, and height of the vertex it folds into at the next level, from 0 to 1.
+layout (location = 1) in vec2 aHeight;
+
+out vec3 worldPosition;
+out float terrainHeight;
+
+uniform mat4 projection;
+uniform mat4 view;
+// Corner of the map (xyz) and distance between samples (w), in world units
+uniform vec4 terrainOrigin;
+uniform float heightScale;
+// First sample of the chunk (xy), and samples per step of its level (z)
+uniform vec4 chunkOffset;
+// Distances from the camera where the vertices start (x) and finish (y) morphing into the next level
+uniform vec4 morphRange;
+uniform vec4 cameraPosition;
+
+void main()
+{
+	// Positions are computed in whole samples before scaling, so neighbouring chunks get exactly the same edge vertices.
+	vec2 samplePosition = chunkOffset.xy + aGrid * chunkOffset.z;
+	vec3 position = vec3(terrainOrigin.x + samplePosition.x * terrainOrigin.w, terrainOrigin.y + aHeight.x * heightScale,
+		terrainOrigin.z + samplePosition.y * terrainOrigin.w);
+	float morph = clamp((distance(position, cameraPosition.xyz) - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+	// Odd vertices slide onto the even vertex before them, which turns the grid into the next level's once fully morphed
+	vec2 grid = aGrid - fract(aGrid * 0.5) * 2.0 * morph;
+	samplePosition = chunkOffset.xy + grid * chunkOffset.z;
+	terrainHeight = mix(aHeight.x, aHeight.y, morph);
+	worldPosition = vec3(terrainOrigin.x + samplePosition.x * terrainOrigin.w, terrainOrigin.y + terrainHeight * heightScale,
+		terrainOrigin.z + samplePosition.y * terrainOrigin.w);
+
+	gl_Position = projection * view * vec4(worldPosition, 1.0);
+}
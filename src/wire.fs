@@ -0,0 +1,75 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec3 geometryColor;
+in float geometryHighlight;
+flat in vec2 corners[3];
+flat in int cornersValid;
+
+// 0: filled triangles, 1: edges only, 2: corners only, 3: filled triangles with their edges drawn over them.
+uniform int renderMode;
+// Width of the edges and diameter of the corners, in pixels.
+uniform float lineWidth;
+uniform float pointSize;
+
+// Distance from p to the line through a and b, in pixels.
+float distanceToEdge(vec2 p, vec2 a, vec2 b)
+{
+	vec2 edge = b - a;
+	float edgeLength = length(edge);
+	if (edgeLength <= 0.0)
+	{
+		return length(p - a);
+	}
+	vec2 toPoint = p - a;
+	return abs(edge.x * toPoint.y - edge.y * toPoint.x) / edgeLength;
+}
+
+void main()
+{
+	// Highlighted (selected) geometry is brightened towards white.
+	vec3 color = mix(geometryColor, vec3(1.0), 0.4 * geometryHighlight);
+
+	if (renderMode == 0 || cornersValid == 0)
+	{
+		// Triangles crossing the camera plane have no edges to measure: they are drawn filled, or not at all.
+		if (renderMode == 1 || renderMode == 2)
+		{
+			discard;
+		}
+		FragColor = vec4(color, 1.0);
+		return;
+	}
+
+	vec2 p = gl_FragCoord.xy;
+
+	if (renderMode == 2)
+	{
+		float cornerDistance = min(min(distance(p, corners[0]), distance(p, corners[1])), distance(p, corners[2]));
+		if (cornerDistance > pointSize * 0.5)
+		{
+			discard;
+		}
+		FragColor = vec4(color, 1.0);
+		return;
+	}
+
+	// Each triangle draws half of the width on its side of a shared edge.
+	float edgeDistance = min(min(distanceToEdge(p, corners[0], corners[1]), distanceToEdge(p, corners[1], corners[2])),
+		distanceToEdge(p, corners[2], corners[0]));
+
+	if (renderMode == 1)
+	{
+		if (edgeDistance > lineWidth * 0.5)
+		{
+			discard;
+		}
+		FragColor = vec4(color, 1.0);
+		return;
+	}
+
+	// Over the fill, the edges are darkened and smoothed over a pixel, which needs no blending.
+	float coverage = 1.0 - smoothstep(lineWidth * 0.5 - 0.5, lineWidth * 0.5 + 0.5, edgeDistance);
+	FragColor = vec4(mix(color, color * 0.25, coverage), 1.0);
+}
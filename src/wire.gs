@@ -0,0 +1,48 @@
+#version 330 core
+
+// Passes each triangle through unchanged, adding the window positions of its corners, so the fragment shader can tell
+// how many pixels a fragment is from the triangle's edges and corners. Lines and points drawn from those distances keep
+// the same width at any depth, and are drawn in the same pass as the filled triangles.
+
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in vec3 vertexColor[];
+in float vertexHighlight[];
+
+out vec3 geometryColor;
+out float geometryHighlight;
+// Corners of the triangle in window coordinates, and 0 if one of them is behind the camera and can't be projected.
+flat out vec2 corners[3];
+flat out int cornersValid;
+
+// The viewport in pixels: x, y, width, height.
+uniform vec4 viewport;
+
+void main()
+{
+	vec2 screen[3];
+	int valid = 1;
+	for (int i = 0; i < 3; i++)
+	{
+		vec4 clip = gl_in[i].gl_Position;
+		if (clip.w <= 0.0)
+		{
+			valid = 0;
+		}
+		screen[i] = viewport.xy + (clip.xy / clip.w * 0.5 + 0.5) * viewport.zw;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		gl_Position = gl_in[i].gl_Position;
+		geometryColor = vertexColor[i];
+		geometryHighlight = vertexHighlight[i];
+		corners[0] = screen[0];
+		corners[1] = screen[1];
+		corners[2] = screen[2];
+		cornersValid = valid;
+		EmitVertex();
+	}
+	EndPrimitive();
+}
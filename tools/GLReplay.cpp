@@ -0,0 +1,635 @@
+// Plays back the GL calls recorded with --gl-capture, without the application, its window or its input, and times
+// them: what the captured frames cost the driver and the GPU alone, to compare drivers, machines, or versions of the
+// renderer on the exact same work.
+// Usage: GLReplay FILE [--loops N]
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include "GLCapture.h"
+
+// Timed passes over the captured frames, unless --loops says otherwise. A first, untimed pass warms the driver up.
+static const int DEFAULT_LOOPS = 10;
+// Vertex attributes a format change resets, as many as GLCapture looks at.
+static const GLuint MAX_ATTRIBUTES = 16;
+
+// Reads the little endian values written by GLCapture. Reading past the end fails, and returns zeros from then on.
+class Reader
+{
+	public:
+		Reader(const std::vector<unsigned char>& bytes) : bytes(bytes), position(0), failed(false) {}
+
+		const unsigned char* ReadBytes(size_t size)
+		{
+			if (failed || bytes.size() - position < size)
+			{
+				failed = true;
+				return NULL;
+			}
+			const unsigned char* data = &bytes[0] + position;
+			position += size;
+			return data;
+		}
+
+		unsigned char ReadByte()
+		{
+			const unsigned char* data = ReadBytes(1);
+			return data != NULL ? data[0] : 0;
+		}
+
+		unsigned int ReadUint()
+		{
+			const unsigned char* data = ReadBytes(4);
+			return data != NULL ? data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24) : 0;
+		}
+
+		int ReadInt() { return (int)ReadUint(); }
+
+		unsigned long long ReadUint64()
+		{
+			unsigned long long low = ReadUint();
+			return low | ((unsigned long long)ReadUint() << 32);
+		}
+
+		GLfloat ReadFloat()
+		{
+			unsigned int bits = ReadUint();
+			GLfloat value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		std::string ReadString()
+		{
+			unsigned int size = ReadUint();
+			const unsigned char* data = ReadBytes(size);
+			return data != NULL ? std::string((const char*)data, size) : std::string();
+		}
+
+		bool Failed() const { return failed; }
+		bool AtEnd() const { return position == bytes.size(); }
+
+	private:
+		const std::vector<unsigned char>& bytes;
+		size_t position;
+		bool failed;
+};
+
+struct VertexAttribute
+{
+	GLuint index;
+	GLuint buffer;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLint stride;
+	unsigned long long offset;
+};
+
+// The format of a vertex array, with the replay's buffers.
+struct VertexArrayFormat
+{
+	GLuint elementBuffer;
+	std::vector<VertexAttribute> attributes;
+};
+
+// A captured program, and where the replay's compilation put each of its captured uniform locations.
+struct Program
+{
+	GLuint program;
+	std::unordered_map<GLint, GLint> locations;
+};
+
+// A call of the captured frames, decoded ahead of the timing, with the replay's objects and uniform locations.
+struct Command
+{
+	GLCaptureOp op;
+	// The buffer, vertex array or program, or the capability, mode, mask, index or usage of the call
+	GLuint object;
+	GLuint usage;
+	GLint location;
+	// Viewport and scissor boxes, or the index count of a draw
+	GLint box[4];
+	// Uniform values, integers as their bits, the clear color or a vertex attribute
+	GLfloat values[16];
+	// Buffer updates, pointing into the file's bytes; data is NULL for an allocation without data
+	const unsigned char* data;
+	size_t offset;
+	size_t size;
+	// Position of a format in Replay::formats
+	size_t format;
+};
+
+struct Replay
+{
+	int width;
+	int height;
+	std::string renderer;
+	unsigned int frameCount;
+	std::vector<Command> commands;
+	std::vector<VertexArrayFormat> formats;
+
+	// The replay's objects for the captured names. A name recycled by the capture maps to a new object from the point
+	// it was saved again; the objects are freed with the context.
+	std::unordered_map<GLuint, GLuint> buffers;
+	std::unordered_map<GLuint, GLuint> vertexArrays;
+	std::unordered_map<GLuint, size_t> programs;
+	std::vector<Program> programList;
+};
+
+// Returns the replay's object for a captured name, or 0 for a name never saved.
+static GLuint Find(const std::unordered_map<GLuint, GLuint>& objects, GLuint name)
+{
+	std::unordered_map<GLuint, GLuint>::const_iterator found = objects.find(name);
+	return found != objects.end() ? found->second : 0;
+}
+
+static bool LoadFile(const char* path, std::vector<unsigned char>& bytes)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	unsigned char chunk[65536];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		bytes.insert(bytes.end(), chunk, chunk + read);
+	}
+	bool failed = ferror(file) != 0;
+	fclose(file);
+	return !failed;
+}
+
+static void ReadFormat(Reader& reader, const Replay& replay, VertexArrayFormat& format)
+{
+	format.elementBuffer = Find(replay.buffers, reader.ReadUint());
+	unsigned int attributeCount = reader.ReadUint();
+	format.attributes.clear();
+	for (unsigned int i = 0; i < attributeCount && !reader.Failed(); i++)
+	{
+		VertexAttribute attribute;
+		attribute.index = reader.ReadUint();
+		attribute.buffer = Find(replay.buffers, reader.ReadUint());
+		attribute.size = reader.ReadInt();
+		attribute.type = reader.ReadUint();
+		attribute.normalized = reader.ReadByte() != 0 ? GL_TRUE : GL_FALSE;
+		attribute.stride = reader.ReadInt();
+		attribute.offset = reader.ReadUint64();
+		format.attributes.push_back(attribute);
+	}
+}
+
+// Sets up a vertex array as the format says, leaving it bound.
+static void ApplyFormat(GLuint vertexArray, const VertexArrayFormat& format)
+{
+	glBindVertexArray(vertexArray);
+	for (GLuint i = 0; i < MAX_ATTRIBUTES; i++)
+	{
+		glDisableVertexAttribArray(i);
+	}
+	for (size_t i = 0; i < format.attributes.size(); i++)
+	{
+		const VertexAttribute& attribute = format.attributes[i];
+		glBindBuffer(GL_ARRAY_BUFFER, attribute.buffer);
+		glVertexAttribPointer(attribute.index, attribute.size, attribute.type, attribute.normalized, attribute.stride, (const void*)(size_t)attribute.offset);
+		glEnableVertexAttribArray(attribute.index);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, format.elementBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Compiles and links a captured program, then gives its uniforms their captured values.
+static bool CreateProgram(Reader& reader, Program& program)
+{
+	program.program = glCreateProgram();
+	unsigned int shaderCount = reader.ReadUint();
+	std::vector<GLuint> shaders;
+	for (unsigned int i = 0; i < shaderCount && !reader.Failed(); i++)
+	{
+		GLenum type = reader.ReadUint();
+		std::string source = reader.ReadString();
+		const GLchar* code = source.c_str();
+
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &code, NULL);
+		glCompileShader(shader);
+		GLint compiled = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (!compiled)
+		{
+			GLchar log[1024] = "";
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			printf("Error compiling a captured shader: '%s'\n", log);
+		}
+		glAttachShader(program.program, shader);
+		shaders.push_back(shader);
+	}
+
+	glLinkProgram(program.program);
+	for (size_t i = 0; i < shaders.size(); i++)
+	{
+		glDeleteShader(shaders[i]);
+	}
+	GLint linked = 0;
+	glGetProgramiv(program.program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		GLchar log[1024] = "";
+		glGetProgramInfoLog(program.program, sizeof(log), NULL, log);
+		printf("Error linking a captured program: '%s'\n", log);
+		return false;
+	}
+
+	glUseProgram(program.program);
+	unsigned int uniformCount = reader.ReadUint();
+	for (unsigned int i = 0; i < uniformCount && !reader.Failed(); i++)
+	{
+		GLint capturedLocation = reader.ReadInt();
+		GLenum type = reader.ReadUint();
+		std::string name = reader.ReadString();
+		unsigned int valueCount = std::min(reader.ReadUint(), 16u);
+		GLfloat values[16];
+		for (unsigned int j = 0; j < valueCount; j++)
+		{
+			values[j] = reader.ReadFloat();
+		}
+
+		GLint location = glGetUniformLocation(program.program, name.c_str());
+		program.locations[capturedLocation] = location;
+		if (location < 0 || valueCount == 0)
+		{
+			continue;
+		}
+
+		GLint integer;
+		memcpy(&integer, values, sizeof(integer));
+		switch (type)
+		{
+			case GL_FLOAT: glUniform1fv(location, 1, values); break;
+			case GL_FLOAT_VEC2: glUniform2fv(location, 1, values); break;
+			case GL_FLOAT_VEC3: glUniform3fv(location, 1, values); break;
+			case GL_FLOAT_VEC4: glUniform4fv(location, 1, values); break;
+			case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, values); break;
+			default: glUniform1i(location, integer); break;
+		}
+	}
+	glUseProgram(0);
+	return true;
+}
+
+// Reads the capture, creating its buffers, vertex arrays and programs as they come, and decodes its calls.
+static bool Decode(const std::vector<unsigned char>& bytes, Replay& replay)
+{
+	Reader reader(bytes);
+	// GLCapture::MAGIC, spelled out so the tool builds without the renderer's sources
+	const unsigned char* magic = reader.ReadBytes(sizeof(GLCapture::MAGIC));
+	if (magic == NULL || memcmp(magic, "GLCS", sizeof(GLCapture::MAGIC)) != 0 || reader.ReadUint() != GLCapture::VERSION)
+	{
+		printf("Not a GL capture, or one from another version\n");
+		return false;
+	}
+	replay.width = reader.ReadInt();
+	replay.height = reader.ReadInt();
+	replay.renderer = reader.ReadString();
+	replay.frameCount = 0;
+
+	// The program the calls are made with, for the uniform locations
+	const Program* current = NULL;
+
+	while (!reader.AtEnd() && !reader.Failed())
+	{
+		Command command = Command();
+		command.op = (GLCaptureOp)reader.ReadByte();
+		switch (command.op)
+		{
+			case GLCaptureOp::CreateBuffer:
+			{
+				GLuint name = reader.ReadUint();
+				GLenum usage = reader.ReadUint();
+				size_t size = (size_t)reader.ReadUint64();
+				const unsigned char* data = reader.ReadBytes(size);
+				GLuint buffer;
+				glGenBuffers(1, &buffer);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+				glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+				replay.buffers[name] = buffer;
+				continue;
+			}
+
+			case GLCaptureOp::CreateVertexArray:
+			{
+				GLuint name = reader.ReadUint();
+				VertexArrayFormat format;
+				ReadFormat(reader, replay, format);
+				GLuint vertexArray;
+				glGenVertexArrays(1, &vertexArray);
+				ApplyFormat(vertexArray, format);
+				glBindVertexArray(0);
+				replay.vertexArrays[name] = vertexArray;
+				continue;
+			}
+
+			case GLCaptureOp::CreateProgram:
+			{
+				GLuint name = reader.ReadUint();
+				Program program;
+				if (!CreateProgram(reader, program))
+				{
+					return false;
+				}
+				replay.programs[name] = replay.programList.size();
+				replay.programList.push_back(program);
+				continue;
+			}
+
+			case GLCaptureOp::BufferData:
+				command.object = Find(replay.buffers, reader.ReadUint());
+				command.usage = reader.ReadUint();
+				command.size = (size_t)reader.ReadUint64();
+				command.data = reader.ReadByte() != 0 ? reader.ReadBytes(command.size) : NULL;
+				break;
+
+			case GLCaptureOp::BufferSubData:
+				command.object = Find(replay.buffers, reader.ReadUint());
+				command.offset = (size_t)reader.ReadUint64();
+				command.size = (size_t)reader.ReadUint64();
+				command.data = reader.ReadBytes(command.size);
+				break;
+
+			case GLCaptureOp::VertexArrayFormat:
+			{
+				command.object = Find(replay.vertexArrays, reader.ReadUint());
+				VertexArrayFormat format;
+				ReadFormat(reader, replay, format);
+				command.format = replay.formats.size();
+				replay.formats.push_back(format);
+				break;
+			}
+
+			case GLCaptureOp::Enable:
+			case GLCaptureOp::Disable:
+			case GLCaptureOp::PrimitiveRestartIndex:
+			case GLCaptureOp::Clear:
+			case GLCaptureOp::PolygonMode:
+				command.object = reader.ReadUint();
+				break;
+
+			case GLCaptureOp::ClearColor:
+				for (int i = 0; i < 4; i++)
+				{
+					command.values[i] = reader.ReadFloat();
+				}
+				break;
+
+			case GLCaptureOp::Viewport:
+			case GLCaptureOp::Scissor:
+				for (int i = 0; i < 4; i++)
+				{
+					command.box[i] = reader.ReadInt();
+				}
+				break;
+
+			case GLCaptureOp::UseProgram:
+			{
+				std::unordered_map<GLuint, size_t>::const_iterator found = replay.programs.find(reader.ReadUint());
+				current = found != replay.programs.end() ? &replay.programList[found->second] : NULL;
+				command.object = current != NULL ? current->program : 0;
+				break;
+			}
+
+			case GLCaptureOp::BindVertexArray:
+				command.object = Find(replay.vertexArrays, reader.ReadUint());
+				break;
+
+			case GLCaptureOp::Uniform1f:
+			case GLCaptureOp::Uniform1i:
+			case GLCaptureOp::Uniform4fv:
+			case GLCaptureOp::UniformMatrix4fv:
+			{
+				GLint location = reader.ReadInt();
+				int count = command.op == GLCaptureOp::UniformMatrix4fv ? 16 : command.op == GLCaptureOp::Uniform4fv ? 4 : 1;
+				for (int i = 0; i < count; i++)
+				{
+					command.values[i] = reader.ReadFloat();
+				}
+
+				command.location = -1;
+				if (current != NULL)
+				{
+					std::unordered_map<GLint, GLint>::const_iterator found = current->locations.find(location);
+					command.location = found != current->locations.end() ? found->second : -1;
+				}
+				break;
+			}
+
+			case GLCaptureOp::VertexAttrib4f:
+				command.object = reader.ReadUint();
+				for (int i = 0; i < 4; i++)
+				{
+					command.values[i] = reader.ReadFloat();
+				}
+				break;
+
+			case GLCaptureOp::DrawElements:
+				command.object = reader.ReadUint();
+				command.box[0] = reader.ReadInt();
+				break;
+
+			case GLCaptureOp::EndFrame:
+				replay.frameCount++;
+				break;
+
+			default:
+				printf("Unknown record %d in the GL capture\n", (int)command.op);
+				return false;
+		}
+		replay.commands.push_back(command);
+	}
+
+	if (reader.Failed())
+	{
+		printf("The GL capture is truncated\n");
+		return false;
+	}
+	glBindVertexArray(0);
+	return true;
+}
+
+// Makes the calls of every captured frame, once.
+static void Execute(const Replay& replay)
+{
+	for (size_t i = 0; i < replay.commands.size(); i++)
+	{
+		const Command& command = replay.commands[i];
+		switch (command.op)
+		{
+			case GLCaptureOp::BufferData:
+				glBindBuffer(GL_COPY_WRITE_BUFFER, command.object);
+				glBufferData(GL_COPY_WRITE_BUFFER, command.size, command.data, command.usage);
+				break;
+			case GLCaptureOp::BufferSubData:
+				glBindBuffer(GL_COPY_WRITE_BUFFER, command.object);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, command.offset, command.size, command.data);
+				break;
+			case GLCaptureOp::VertexArrayFormat:
+				ApplyFormat(command.object, replay.formats[command.format]);
+				break;
+			case GLCaptureOp::Enable: glEnable(command.object); break;
+			case GLCaptureOp::Disable: glDisable(command.object); break;
+			case GLCaptureOp::PrimitiveRestartIndex: glPrimitiveRestartIndex(command.object); break;
+			case GLCaptureOp::ClearColor: glClearColor(command.values[0], command.values[1], command.values[2], command.values[3]); break;
+			case GLCaptureOp::Clear: glClear(command.object); break;
+			case GLCaptureOp::Viewport: glViewport(command.box[0], command.box[1], command.box[2], command.box[3]); break;
+			case GLCaptureOp::Scissor: glScissor(command.box[0], command.box[1], command.box[2], command.box[3]); break;
+			case GLCaptureOp::PolygonMode: glPolygonMode(GL_FRONT_AND_BACK, command.object); break;
+			case GLCaptureOp::UseProgram: glUseProgram(command.object); break;
+			case GLCaptureOp::BindVertexArray: glBindVertexArray(command.object); break;
+			case GLCaptureOp::Uniform1f: glUniform1f(command.location, command.values[0]); break;
+			case GLCaptureOp::Uniform1i:
+			{
+				GLint value;
+				memcpy(&value, command.values, sizeof(value));
+				glUniform1i(command.location, value);
+				break;
+			}
+			case GLCaptureOp::Uniform4fv: glUniform4fv(command.location, 1, command.values); break;
+			case GLCaptureOp::UniformMatrix4fv: glUniformMatrix4fv(command.location, 1, GL_FALSE, command.values); break;
+			case GLCaptureOp::VertexAttrib4f: glVertexAttrib4fv(command.object, command.values); break;
+			case GLCaptureOp::DrawElements: glDrawElements(command.object, command.box[0], GL_UNSIGNED_INT, 0); break;
+			default: break;
+		}
+	}
+}
+
+// Creates the target the frames are drawn into, of the captured window's size, and binds it.
+static bool CreateTarget(int width, int height)
+{
+	GLuint framebuffer, renderbuffers[2];
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(2, renderbuffers);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static double Median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	return values[values.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: GLReplay FILE [--loops N]\n");
+		return 1;
+	}
+	int loops = DEFAULT_LOOPS;
+	for (int i = 2; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], "--loops") == 0)
+		{
+			loops = std::max(atoi(argv[i + 1]), 1);
+		}
+	}
+
+	std::vector<unsigned char> bytes;
+	if (!LoadFile(argv[1], bytes))
+	{
+		printf("Couldn't read %s\n", argv[1]);
+		return 1;
+	}
+
+	// The same context as the application's, in a window never shown: the frames go to a target of their own
+	if (!glfwInit())
+	{
+		printf("Error Initialising GLFW\n");
+		return 1;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "GLReplay", NULL, NULL);
+	if (window == NULL)
+	{
+		printf("Error creating GLFW window!\n");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glewExperimental = GL_TRUE;
+	GLenum error = glewInit();
+	if (error != GLEW_OK)
+	{
+		printf("Error: %s\n", glewGetErrorString(error));
+		glfwTerminate();
+		return 1;
+	}
+
+	Replay replay;
+	if (!Decode(bytes, replay) || !CreateTarget(replay.width, replay.height))
+	{
+		glfwTerminate();
+		return 1;
+	}
+	if (replay.frameCount == 0)
+	{
+		printf("The GL capture holds no frame\n");
+		glfwTerminate();
+		return 1;
+	}
+	printf("Captured on %s, replayed on %s\n", replay.renderer.c_str(), (const char*)glGetString(GL_RENDERER));
+
+	// Later passes start from the buffers and formats the previous pass left, which only matters for what is drawn,
+	// not for what it costs.
+	std::vector<double> frameTimes, submitTimes;
+	for (int loop = 0; loop <= loops; loop++)
+	{
+		glFinish();
+		auto start = std::chrono::steady_clock::now();
+		Execute(replay);
+		auto submitted = std::chrono::steady_clock::now();
+		glFinish();
+		auto done = std::chrono::steady_clock::now();
+
+		if (loop == 0)
+		{
+			GLenum glError = glGetError();
+			if (glError != GL_NO_ERROR)
+			{
+				printf("The replay raised GL error 0x%x\n", glError);
+			}
+			continue;
+		}
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(done - start).count() / replay.frameCount);
+		submitTimes.push_back(std::chrono::duration<double, std::milli>(submitted - start).count() / replay.frameCount);
+	}
+
+	printf("%u frames of %dx%d, %zu calls, %d passes: %.3f ms per frame at best, %.3f ms median, of which %.3f ms submitting\n",
+		replay.frameCount, replay.width, replay.height, replay.commands.size(), loops, *std::min_element(frameTimes.begin(), frameTimes.end()),
+		Median(frameTimes), Median(submitTimes));
+
+	glfwTerminate();
+	return 0;
+}